@@ -1,17 +1,51 @@
 // x86_64-w64-mingw32-g++ clipxtb.cpp -o clipxtb.exe -luser32 -lkernel32 -lcomctl32 -lole32 -lgdi32 -lshell32 -static-libgcc -static-libstdc++ -std=c++17 -s -O2
+// g++ -std=c++17 -O2 clipxtb.cpp -o clipxtb
+//
+// Command line (all optional):
+//   --config=<ini>       settings file instead of xtbclip.ini next to the executable
+//   --clipboard=<file>   read the structure from <file> and write the result back to it instead of
+//                        using the clipboard (the default on Linux is clipboard.xyz in the current
+//                        directory, so the plugin can be driven by scripts; see make clipxtb-demo)
+//   --no-cache           always run xtb and do not store the result
 
+#ifdef _WIN32
 #include <windows.h>
 #include <shellapi.h>
+#include <process.h>
+#include <commctrl.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <sstream>
 #include <vector>
-#include <process.h>
-#include <commctrl.h>
+#include <thread>
 #include <random>
 #include <map>
 
+namespace fs = std::filesystem;
+
+#ifdef _WIN32
+const char PATH_SEP = '\\';
+#else
+const char PATH_SEP = '/';
+#endif
+
 #ifdef _MSC_VER
 #pragma comment(lib, "user32.lib")
 #pragma comment(lib, "kernel32.lib")
@@ -25,8 +59,12 @@ struct Config {
     std::string tmp_path;
     int gfn_type;
     std::string extra_flag;
+    std::string cache_dir;      // result cache; empty = <temp>/xtb_clipboard_cache
+    int cache_max_mb;           // cache size limit, 0 disables the cache
+    int cores;                  // cores shared by the xtb processes of a batch, 0 = all
+    int max_jobs;               // concurrent xtb processes of a batch, 0 = one per core
     
-    Config() : gfn_type(2) {}  // Default values
+    Config() : gfn_type(2), cache_max_mb(256), cores(0), max_jobs(0) {}  // Default values
 };
 
 // Simple INI parser
@@ -79,6 +117,26 @@ public:
                 }
             } else if (key == "extra_flag") {
                 config.extra_flag = value;
+            } else if (key == "cache_dir") {
+                config.cache_dir = value;
+            } else if (key == "cache_max_mb") {
+                try {
+                    config.cache_max_mb = std::max(std::stoi(value), 0);
+                } catch (...) {
+                    std::cerr << "Warning: Invalid cache_max_mb value, using default (256)" << std::endl;
+                }
+            } else if (key == "cores") {
+                try {
+                    config.cores = std::max(std::stoi(value), 0);
+                } catch (...) {
+                    std::cerr << "Warning: Invalid cores value, using all cores" << std::endl;
+                }
+            } else if (key == "max_jobs") {
+                try {
+                    config.max_jobs = std::max(std::stoi(value), 0);
+                } catch (...) {
+                    std::cerr << "Warning: Invalid max_jobs value, using one job per core" << std::endl;
+                }
             }
         }
         
@@ -97,19 +155,794 @@ private:
     }
 };
 
+// Content-addressed cache of finished optimizations, so that optimizing a structure that was
+// already optimized with the same settings returns immediately.
+//
+// The key is a canonical text of the request: the xtb executable (resolved path, size and modification
+// time, so upgrading or replacing xtb starts from an empty cache), element symbols, coordinates rounded
+// to 1e-4 Angstrom, charge, spin, GFN level and the extra flags (whitespace collapsed). The XYZ comment
+// line is not part of the key: callers strip it before optimizing. Each entry is a directory
+// <cache_dir>/<FNV-1a hash of the key>/ holding
+//   key.txt          the full key (compared on lookup, so hash collisions are misses)
+//   xtbopt.xyz       optimized geometry as written by xtb
+//   xtb_output.log   xtb output of the run that produced it
+//   energy.txt       total energy in Eh (absent when it could not be read)
+// The modification time of key.txt is the last use: hits touch it and eviction removes the least
+// recently used entries until the cache fits in cache_max_mb. Hit/miss/eviction counters are kept
+// in <cache_dir>/stats.txt across runs.
+class ResultCache {
+public:
+    struct Entry {
+        std::string geometry;
+        std::string log;
+        double energy = 0.0;
+        bool hasEnergy = false;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;
+        uint64_t evictions = 0;
+    };
+
+    ResultCache(const std::string& dir, uint64_t maxBytes) : dir_(dir), maxBytes_(maxBytes) {
+        if (maxBytes_ > 0) {
+            std::error_code ec;
+            fs::create_directories(dir_, ec);
+            enabled_ = fs::is_directory(dir_, ec);
+            if (!enabled_) {
+                std::cerr << "Warning: Cannot create cache directory " << dir_.string() << ", cache disabled." << std::endl;
+            }
+        }
+    }
+
+    bool enabled() const { return enabled_; }
+    const fs::path& dir() const { return dir_; }
+    fs::path entryPath(const std::string& key) const { return dir_ / hashName(key); }
+
+    // Identifies the xtb build that produces the results: the executable as found on PATH (when
+    // given without a directory) with its size and modification time. Falls back to the name as
+    // given when the file cannot be found.
+    static std::string executableIdentity(const std::string& executable) {
+        std::error_code ec;
+        fs::path resolved(executable);
+        if (!resolved.has_parent_path()) {
+            const char* path = getenv("PATH");
+            std::string dirs = path ? path : "";
+#ifdef _WIN32
+            const char listSep = ';';
+            const std::string suffix = resolved.has_extension() ? "" : ".exe";
+#else
+            const char listSep = ':';
+            const std::string suffix;
+#endif
+            size_t begin = 0;
+            while (begin <= dirs.size()) {
+                size_t end = dirs.find(listSep, begin);
+                if (end == std::string::npos) {
+                    end = dirs.size();
+                }
+                fs::path candidate = fs::path(dirs.substr(begin, end - begin)) / (executable + suffix);
+                if (end > begin && fs::is_regular_file(candidate, ec)) {
+                    resolved = candidate;
+                    break;
+                }
+                begin = end + 1;
+            }
+        }
+        fs::path canonical = fs::canonical(resolved, ec);
+        if (ec || !fs::is_regular_file(canonical, ec)) {
+            return executable;
+        }
+        const uintmax_t size = fs::file_size(canonical, ec);
+        const auto modified = fs::last_write_time(canonical, ec).time_since_epoch().count();
+        return canonical.string() + " " + std::to_string(size) + " " + std::to_string(static_cast<long long>(modified));
+    }
+
+    // Canonical key of an XYZ block (atom count, comment line, atom lines; the comment itself is
+    // ignored) optimized by the xtb build named by engine (see executableIdentity). Returns false
+    // when the block cannot be read, in which case the request is not cached.
+    static bool canonicalKey(const std::string& xyz, const std::string& engine, int charge, int spin, int gfn,
+                             const std::string& flags, std::string& key) {
+        std::istringstream iss(xyz);
+        std::string line;
+        size_t count = 0;
+        if (!std::getline(iss, line) || !parseCount(line, count) || count == 0 || !std::getline(iss, line)) {
+            return false;
+        }
+        std::ostringstream out;
+        out << "clipxtb-cache 2\n";
+        out << "xtb " << engine << "\n";
+        out << "gfn " << gfn << "\n";
+        out << "flags " << collapseSpaces(flags) << "\n";
+        out << "charge " << charge << "\n";
+        out << "spin " << spin << "\n";
+        out << "atoms " << count << "\n";
+        for (size_t i = 0; i < count; ++i) {
+            if (!std::getline(iss, line)) {
+                return false;
+            }
+            std::istringstream atom(line);
+            std::string symbol;
+            double xyzValues[3];
+            if (!(atom >> symbol >> xyzValues[0] >> xyzValues[1] >> xyzValues[2])) {
+                return false;
+            }
+            for (size_t c = 0; c < symbol.size(); ++c) {
+                symbol[c] = static_cast<char>(c == 0 ? toupper(static_cast<unsigned char>(symbol[c]))
+                                                     : tolower(static_cast<unsigned char>(symbol[c])));
+            }
+            out << symbol;
+            for (double value : xyzValues) {
+                char buffer[64];
+                snprintf(buffer, sizeof(buffer), "%.4f", value);
+                // -0.00004 and 0.00004 round to the same position
+                out << " " << (strcmp(buffer, "-0.0000") == 0 ? "0.0000" : buffer);
+            }
+            out << "\n";
+        }
+        key = out.str();
+        return true;
+    }
+
+    bool lookup(const std::string& key, Entry& entry) {
+        if (!enabled_) {
+            return false;
+        }
+        const fs::path entryDir = dir_ / hashName(key);
+        std::string storedKey;
+        if (readFile(entryDir / "key.txt", storedKey) && storedKey == key &&
+            readFile(entryDir / "xtbopt.xyz", entry.geometry)) {
+            readFile(entryDir / "xtb_output.log", entry.log);
+            std::string energy;
+            entry.hasEnergy = readFile(entryDir / "energy.txt", energy) && parseDouble(energy, entry.energy);
+            std::error_code ec;
+            fs::last_write_time(entryDir / "key.txt", fs::file_time_type::clock::now(), ec);
+            ++run_.hits;
+            return true;
+        }
+        ++run_.misses;
+        return false;
+    }
+
+    // Stores an entry (written to a temporary directory first, then renamed into place) and
+    // evicts least recently used entries beyond the size limit.
+    void store(const std::string& key, const Entry& entry) {
+        if (!enabled_) {
+            return;
+        }
+        const std::string name = hashName(key);
+        const fs::path entryDir = dir_ / name;
+        const fs::path tempDir = dir_ / (name + ".tmp" + std::to_string(processId()));
+        std::error_code ec;
+        fs::remove_all(tempDir, ec);
+        fs::create_directories(tempDir, ec);
+        bool written = writeFile(tempDir / "xtbopt.xyz", entry.geometry) &&
+                       writeFile(tempDir / "xtb_output.log", entry.log);
+        if (written && entry.hasEnergy) {
+            char buffer[64];
+            snprintf(buffer, sizeof(buffer), "%.12f\n", entry.energy);
+            written = writeFile(tempDir / "energy.txt", buffer);
+        }
+        // key.txt last: an entry without it is never a hit
+        written = written && writeFile(tempDir / "key.txt", key);
+        if (written) {
+            fs::remove_all(entryDir, ec);
+            fs::rename(tempDir, entryDir, ec);
+            written = !ec;
+        }
+        if (!written) {
+            std::cerr << "Warning: Cannot store result in cache " << dir_.string() << std::endl;
+            fs::remove_all(tempDir, ec);
+            return;
+        }
+        ++run_.stores;
+        evict();
+    }
+
+    // Adds this run's counters to stats.txt and prints a summary
+    void report() {
+        if (!enabled_) {
+            return;
+        }
+        Stats total = loadStats();
+        total.hits += run_.hits;
+        total.misses += run_.misses;
+        total.stores += run_.stores;
+        total.evictions += run_.evictions;
+        std::ofstream out(dir_ / "stats.txt", std::ios::trunc);
+        out << "hits " << total.hits << "\n";
+        out << "misses " << total.misses << "\n";
+        out << "stores " << total.stores << "\n";
+        out << "evictions " << total.evictions << "\n";
+        out.close();
+
+        size_t entries = 0;
+        uint64_t bytes = 0;
+        for (const auto& item : listEntries()) {
+            ++entries;
+            bytes += item.bytes;
+        }
+        const uint64_t lookups = total.hits + total.misses;
+        std::cout << "Cache: " << run_.hits << " hit(s), " << run_.misses << " miss(es) this run; "
+                  << total.hits << " hit(s) of " << lookups << " lookup(s) in total ("
+                  << (lookups ? 100 * total.hits / lookups : 0) << "%), " << total.evictions << " evicted; "
+                  << entries << " entries, " << bytes / 1024 << " KB of " << maxBytes_ / 1024 << " KB in "
+                  << dir_.string() << std::endl;
+    }
+
+private:
+    struct EntryInfo {
+        fs::path path;
+        uint64_t bytes = 0;
+        fs::file_time_type lastUse;
+    };
+
+    static bool parseCount(const std::string& line, size_t& count) {
+        std::istringstream iss(line);
+        long long value = 0;
+        std::string rest;
+        if (!(iss >> value) || value < 0 || (iss >> rest)) {
+            return false;
+        }
+        count = static_cast<size_t>(value);
+        return true;
+    }
+
+    static bool parseDouble(const std::string& text, double& value) {
+        char* end = nullptr;
+        value = strtod(text.c_str(), &end);
+        return end != text.c_str();
+    }
+
+    static std::string collapseSpaces(const std::string& text) {
+        std::istringstream iss(text);
+        std::string word, result;
+        while (iss >> word) {
+            result += (result.empty() ? "" : " ") + word;
+        }
+        return result;
+    }
+
+    static std::string hashName(const std::string& key) {
+        uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : key) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        char buffer[17];
+        snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+        return buffer;
+    }
+
+    static bool isEntryName(const std::string& name) {
+        return name.size() == 16 && std::all_of(name.begin(), name.end(), [](char c) { return isxdigit(static_cast<unsigned char>(c)) != 0; });
+    }
+
+    static long processId() {
+#ifdef _WIN32
+        return static_cast<long>(GetCurrentProcessId());
+#else
+        return static_cast<long>(getpid());
+#endif
+    }
+
+    static bool readFile(const fs::path& path, std::string& content) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    static bool writeFile(const fs::path& path, const std::string& content) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << content;
+        return static_cast<bool>(file);
+    }
+
+    std::vector<EntryInfo> listEntries() const {
+        std::vector<EntryInfo> entries;
+        std::error_code ec;
+        for (fs::directory_iterator it(dir_, ec), end; !ec && it != end; it.increment(ec)) {
+            if (!it->is_directory(ec) || !isEntryName(it->path().filename().string())) {
+                continue;
+            }
+            EntryInfo info;
+            info.path = it->path();
+            info.lastUse = fs::last_write_time(info.path / "key.txt", ec);
+            if (ec) {
+                info.lastUse = fs::file_time_type::min();
+                ec.clear();
+            }
+            for (fs::directory_iterator file(info.path, ec), fileEnd; !ec && file != fileEnd; file.increment(ec)) {
+                const uintmax_t size = file->file_size(ec);
+                if (!ec) {
+                    info.bytes += size;
+                }
+                ec.clear();
+            }
+            ec.clear();
+            entries.push_back(info);
+        }
+        return entries;
+    }
+
+    void evict() {
+        std::vector<EntryInfo> entries = listEntries();
+        uint64_t total = 0;
+        for (const auto& entry : entries) {
+            total += entry.bytes;
+        }
+        if (total <= maxBytes_) {
+            return;
+        }
+        std::sort(entries.begin(), entries.end(),
+                  [](const EntryInfo& a, const EntryInfo& b) { return a.lastUse < b.lastUse; });
+        for (const auto& entry : entries) {
+            if (total <= maxBytes_) {
+                break;
+            }
+            std::error_code ec;
+            fs::remove_all(entry.path, ec);
+            if (!ec) {
+                total -= entry.bytes;
+                ++run_.evictions;
+            }
+        }
+    }
+
+    Stats loadStats() const {
+        Stats stats;
+        std::ifstream in(dir_ / "stats.txt");
+        std::string name;
+        uint64_t value = 0;
+        while (in >> name >> value) {
+            if (name == "hits") {
+                stats.hits = value;
+            } else if (name == "misses") {
+                stats.misses = value;
+            } else if (name == "stores") {
+                stats.stores = value;
+            } else if (name == "evictions") {
+                stats.evictions = value;
+            }
+        }
+        return stats;
+    }
+
+    fs::path dir_;
+    uint64_t maxBytes_;
+    bool enabled_ = false;
+    Stats run_;
+};
+
+// Total energy (Eh) of an xtb optimization: the "energy:" field of the xtbopt.xyz comment line,
+// otherwise the last "TOTAL ENERGY" line of the output.
+bool readXTBEnergy(const std::string& geometry, const std::string& log, double& energy) {
+    std::istringstream iss(geometry);
+    std::string line;
+    if (std::getline(iss, line) && std::getline(iss, line)) {
+        size_t pos = line.find("energy:");
+        if (pos != std::string::npos) {
+            const char* start = line.c_str() + pos + 7;
+            char* end = nullptr;
+            energy = strtod(start, &end);
+            if (end != start) {
+                return true;
+            }
+        }
+    }
+    size_t pos = log.rfind("TOTAL ENERGY");
+    if (pos != std::string::npos) {
+        const char* start = log.c_str() + pos + 12;
+        char* end = nullptr;
+        energy = strtod(start, &end);
+        return end != start;
+    }
+    return false;
+}
+
+// Splits clipboard text into XYZ frames (atom count, comment, atom lines). Blank lines between
+// frames are skipped; returns an empty list when the text is not a sequence of complete frames.
+std::vector<std::string> splitXYZFrames(const std::string& content) {
+    std::vector<std::string> frames;
+    std::istringstream iss(content);
+    std::string line;
+    while (std::getline(iss, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        char* end = nullptr;
+        long count = strtol(line.c_str(), &end, 10);
+        if (count <= 0 || end == line.c_str() || std::string(end).find_first_not_of(" \t\r") != std::string::npos) {
+            return {};
+        }
+        std::string frame = line + "\n";
+        for (long i = 0; i <= count; ++i) {     // comment line + atoms
+            if (!std::getline(iss, line)) {
+                return {};
+            }
+            frame += line + "\n";
+        }
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+// One xtb run: command line, working directory and the number of threads it may use
+struct XTBJob {
+    size_t index = 0;           // caller's index (structure number in a batch)
+    std::string dir;            // working directory, with trailing separator
+    std::string command;
+    int threads = 0;            // OMP_NUM_THREADS / MKL_NUM_THREADS of the process, 0 = inherited
+    bool started = false;
+    int exitCode = -1;
+    double seconds = 0.0;
+};
+
+// A running xtb process. Its stdout and stderr share one pipe, which is read without blocking:
+// overlapped reads on a named pipe (Windows) or O_NONBLOCK (POSIX). The scheduler waits on the
+// pipes of all running processes at once and calls readAvailable() on the one that has output.
+// The output goes to <dir>xtb_output.log and, if requested, to the console.
+class XTBProcess {
+public:
+    XTBProcess(XTBJob& job, bool echo) : job_(job), echo_(echo) {}
+    ~XTBProcess() { closeHandles(); }
+    XTBProcess(const XTBProcess&) = delete;
+    XTBProcess& operator=(const XTBProcess&) = delete;
+
+    bool start() {
+        log_.open(job_.dir + "xtb_output.log", std::ios::binary | std::ios::trunc);
+        started_ = std::chrono::steady_clock::now();
+#ifdef _WIN32
+        static unsigned long sequence = 0;
+        const std::string pipeName = "\\\\.\\pipe\\clipxtb-" + std::to_string(GetCurrentProcessId()) + "-" +
+                                     std::to_string(++sequence);
+        pipe_ = CreateNamedPipeA(pipeName.c_str(), PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                 PIPE_TYPE_BYTE | PIPE_WAIT, 1, 65536, 65536, 0, nullptr);
+        if (pipe_ == INVALID_HANDLE_VALUE) {
+            std::cerr << "Error: Cannot create pipes!" << std::endl;
+            return false;
+        }
+        SECURITY_ATTRIBUTES sa;
+        sa.nLength = sizeof(SECURITY_ATTRIBUTES);
+        sa.bInheritHandle = TRUE;
+        sa.lpSecurityDescriptor = nullptr;
+        HANDLE writeEnd = CreateFileA(pipeName.c_str(), GENERIC_WRITE, 0, &sa, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        event_ = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        if (writeEnd == INVALID_HANDLE_VALUE || !event_) {
+            std::cerr << "Error: Cannot create pipes!" << std::endl;
+            if (writeEnd != INVALID_HANDLE_VALUE) {
+                CloseHandle(writeEnd);
+            }
+            return false;
+        }
+        
+        STARTUPINFOA si;
+        ZeroMemory(&si, sizeof(si));
+        si.cb = sizeof(si);
+        si.hStdOutput = writeEnd;
+        si.hStdError = writeEnd;
+        si.dwFlags |= STARTF_USESTDHANDLES;
+        PROCESS_INFORMATION pi;
+        ZeroMemory(&pi, sizeof(pi));
+        
+        // The child inherits the thread count through the environment; the scheduler starts one
+        // process at a time, so the variables are set around CreateProcess and restored after it
+        const char* threadVariables[] = {"OMP_NUM_THREADS", "MKL_NUM_THREADS"};
+        std::string previous[2];
+        bool hadPrevious[2] = {false, false};
+        if (job_.threads > 0) {
+            for (int i = 0; i < 2; ++i) {
+                char value[64];
+                DWORD length = GetEnvironmentVariableA(threadVariables[i], value, sizeof(value));
+                hadPrevious[i] = length > 0 && length < sizeof(value);
+                previous[i] = hadPrevious[i] ? value : "";
+                SetEnvironmentVariableA(threadVariables[i], std::to_string(job_.threads).c_str());
+            }
+        }
+        BOOL created = CreateProcessA(nullptr, const_cast<char*>(job_.command.c_str()), nullptr, nullptr,
+                                      TRUE, CREATE_NO_WINDOW, nullptr, job_.dir.c_str(), &si, &pi);
+        if (job_.threads > 0) {
+            for (int i = 0; i < 2; ++i) {
+                SetEnvironmentVariableA(threadVariables[i], hadPrevious[i] ? previous[i].c_str() : nullptr);
+            }
+        }
+        // Only the child holds the write end, so the pipe breaks when the child exits
+        CloseHandle(writeEnd);
+        if (!created) {
+            std::cerr << "Error: Cannot start XTB process!" << std::endl;
+            std::cerr << "Make sure XTB is installed and accessible." << std::endl;
+            return false;
+        }
+        CloseHandle(pi.hThread);
+        process_ = pi.hProcess;
+#else
+        int fds[2];
+        if (pipe(fds) != 0) {
+            std::cerr << "Error: Cannot create pipes!" << std::endl;
+            return false;
+        }
+        pid_ = fork();
+        if (pid_ < 0) {
+            std::cerr << "Error: Cannot start XTB process!" << std::endl;
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+        }
+        if (pid_ == 0) {
+            dup2(fds[1], STDOUT_FILENO);
+            dup2(fds[1], STDERR_FILENO);
+            close(fds[0]);
+            close(fds[1]);
+            if (job_.threads > 0) {
+                const std::string threads = std::to_string(job_.threads);
+                setenv("OMP_NUM_THREADS", threads.c_str(), 1);
+                setenv("MKL_NUM_THREADS", threads.c_str(), 1);
+            }
+            if (chdir(job_.dir.c_str()) != 0) {
+                _exit(127);
+            }
+            execl("/bin/sh", "sh", "-c", job_.command.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        close(fds[1]);
+        fd_ = fds[0];
+        fcntl(fd_, F_SETFD, FD_CLOEXEC);
+        fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+#endif
+        job_.started = true;
+        return true;
+    }
+
+#ifdef _WIN32
+    HANDLE waitHandle() const { return event_; }
+#else
+    int waitHandle() const { return fd_; }
+#endif
+
+    // Consumes the output that has arrived (and, on Windows, starts the next read); returns false
+    // once the pipe is closed, i.e. the process has exited
+    bool readAvailable() {
+#ifdef _WIN32
+        DWORD bytesRead = 0;
+        if (pending_) {
+            if (!GetOverlappedResult(pipe_, &overlapped_, &bytesRead, FALSE)) {
+                if (GetLastError() == ERROR_IO_INCOMPLETE) {
+                    return true;
+                }
+                pending_ = false;
+                return false;
+            }
+            pending_ = false;
+            consume(buffer_, bytesRead);
+        }
+        while (true) {
+            ZeroMemory(&overlapped_, sizeof(overlapped_));
+            overlapped_.hEvent = event_;
+            ResetEvent(event_);
+            if (ReadFile(pipe_, buffer_, sizeof(buffer_), &bytesRead, &overlapped_)) {
+                consume(buffer_, bytesRead);
+                continue;
+            }
+            if (GetLastError() == ERROR_IO_PENDING) {
+                pending_ = true;
+                return true;
+            }
+            return false;   // ERROR_BROKEN_PIPE
+        }
+#else
+        while (true) {
+            ssize_t bytesRead = read(fd_, buffer_, sizeof(buffer_));
+            if (bytesRead > 0) {
+                consume(buffer_, static_cast<size_t>(bytesRead));
+            } else if (bytesRead < 0 && errno == EINTR) {
+                continue;
+            } else if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            } else {
+                return false;
+            }
+        }
+#endif
+    }
+
+    // After readAvailable() returned false: collects the exit code
+    void finish() {
+#ifdef _WIN32
+        WaitForSingleObject(process_, INFINITE);
+        DWORD exitCode = 1;
+        GetExitCodeProcess(process_, &exitCode);
+        job_.exitCode = static_cast<int>(exitCode);
+#else
+        int status = 0;
+        while (waitpid(pid_, &status, 0) < 0 && errno == EINTR) {
+        }
+        pid_ = -1;
+        job_.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + (WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+#endif
+        job_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+        log_.close();
+        closeHandles();
+    }
+
+    XTBJob& job() { return job_; }
+
+private:
+    void consume(const char* data, size_t size) {
+        if (echo_) {
+            std::cout.write(data, static_cast<std::streamsize>(size));
+            std::cout.flush();
+        }
+        if (log_.is_open()) {
+            log_.write(data, static_cast<std::streamsize>(size));
+        }
+    }
+
+    void closeHandles() {
+#ifdef _WIN32
+        if (pending_) {
+            CancelIo(pipe_);
+            DWORD ignored = 0;
+            GetOverlappedResult(pipe_, &overlapped_, &ignored, TRUE);
+            pending_ = false;
+        }
+        if (pipe_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(pipe_);
+            pipe_ = INVALID_HANDLE_VALUE;
+        }
+        if (event_) {
+            CloseHandle(event_);
+            event_ = NULL;
+        }
+        if (process_) {
+            CloseHandle(process_);
+            process_ = NULL;
+        }
+#else
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+        if (pid_ > 0) {
+            waitpid(pid_, nullptr, 0);
+            pid_ = -1;
+        }
+#endif
+    }
+
+    XTBJob& job_;
+    bool echo_;
+    std::ofstream log_;
+    std::chrono::steady_clock::time_point started_;
+    char buffer_[4096];
+#ifdef _WIN32
+    HANDLE process_ = NULL;
+    HANDLE pipe_ = INVALID_HANDLE_VALUE;
+    HANDLE event_ = NULL;
+    OVERLAPPED overlapped_;
+    bool pending_ = false;
+#else
+    pid_t pid_ = -1;
+    int fd_ = -1;
+#endif
+};
+
+// Splits `cores` between `parallel` processes; the first cores % parallel get one thread more
+std::vector<int> partitionCores(int cores, size_t parallel) {
+    std::vector<int> threads(parallel, 1);
+    if (parallel == 0 || cores <= static_cast<int>(parallel)) {
+        return threads;
+    }
+    const int base = cores / static_cast<int>(parallel);
+    const int extra = cores % static_cast<int>(parallel);
+    for (size_t i = 0; i < parallel; ++i) {
+        threads[i] = base + (static_cast<int>(i) < extra ? 1 : 0);
+    }
+    return threads;
+}
+
+// Runs the jobs with at most threadsPerSlot.size() processes at a time; a process started in slot i
+// gets threadsPerSlot[i] threads. `finished` is called for every job, including those that could
+// not be started.
+void runXTBJobs(const std::vector<XTBJob*>& jobs, const std::vector<int>& threadsPerSlot, bool echo,
+                const std::function<void(XTBJob&)>& finished) {
+    std::vector<std::unique_ptr<XTBProcess>> slots(std::max<size_t>(threadsPerSlot.size(), 1));
+    size_t next = 0;
+    size_t active = 0;
+    while (next < jobs.size() || active > 0) {
+        for (size_t slot = 0; slot < slots.size() && next < jobs.size(); ++slot) {
+            if (slots[slot]) {
+                continue;
+            }
+            XTBJob& job = *jobs[next++];
+            job.threads = slot < threadsPerSlot.size() ? threadsPerSlot[slot] : 0;
+            std::unique_ptr<XTBProcess> process(new XTBProcess(job, echo));
+            if (!process->start()) {
+                finished(job);
+                continue;
+            }
+            if (!process->readAvailable()) {
+                process->finish();
+                finished(job);
+                continue;
+            }
+            slots[slot] = std::move(process);
+            ++active;
+        }
+        if (active == 0) {
+            continue;
+        }
+        
+        // Wait until any running process has output or has closed its pipe
+        std::vector<size_t> indices;
+#ifdef _WIN32
+        std::vector<HANDLE> handles;
+        for (size_t slot = 0; slot < slots.size(); ++slot) {
+            if (slots[slot]) {
+                indices.push_back(slot);
+                handles.push_back(slots[slot]->waitHandle());
+            }
+        }
+        DWORD signaled = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE, INFINITE);
+        size_t ready = (signaled >= WAIT_OBJECT_0 && signaled < WAIT_OBJECT_0 + handles.size())
+                           ? indices[signaled - WAIT_OBJECT_0] : indices[0];
+        std::vector<size_t> readySlots(1, ready);
+#else
+        std::vector<struct pollfd> fds;
+        for (size_t slot = 0; slot < slots.size(); ++slot) {
+            if (slots[slot]) {
+                indices.push_back(slot);
+                fds.push_back({slots[slot]->waitHandle(), POLLIN, 0});
+            }
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR) {
+            std::cerr << "Error: Cannot wait for XTB output!" << std::endl;
+        }
+        std::vector<size_t> readySlots;
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (fds[i].revents != 0) {
+                readySlots.push_back(indices[i]);
+            }
+        }
+#endif
+        for (size_t slot : readySlots) {
+            if (!slots[slot]->readAvailable()) {
+                slots[slot]->finish();
+                finished(slots[slot]->job());
+                slots[slot].reset();
+                --active;
+            }
+        }
+    }
+}
+
 class XTBOptimizer {
 private:
+#ifdef _WIN32
     HWND hOutputWindow;
     HWND hOutputEdit;
+#endif
     std::string tempDir;
     std::string workDir;
     Config config;
+    std::string configPath;     // --config=
+    std::string clipboardFile;  // --clipboard=, stands in for the clipboard
+    bool useCache;
     
     // Get executable directory
     std::string getExecutableDir() {
+#ifdef _WIN32
         char exePath[MAX_PATH];
         GetModuleFileNameA(NULL, exePath, MAX_PATH);
         std::string path(exePath);
+#else
+        std::error_code ec;
+        std::string path = fs::read_symlink("/proc/self/exe", ec).string();
+#endif
         size_t pos = path.find_last_of("\\/");
         return (pos != std::string::npos) ? path.substr(0, pos + 1) : "";
     }
@@ -117,7 +950,7 @@ private:
     // Load configuration from INI file
     void loadConfig() {
         std::string exeDir = getExecutableDir();
-        std::string iniPath = exeDir + "xtbclip.ini";
+        std::string iniPath = configPath.empty() ? exeDir + "xtbclip.ini" : configPath;
         
         std::cout << "Looking for config file: " << iniPath << std::endl;
         config = INIParser::parseINI(iniPath);
@@ -128,6 +961,9 @@ private:
         std::cout << "  Temp path: " << (config.tmp_path.empty() ? "System temp" : config.tmp_path) << std::endl;
         std::cout << "  GFN type: " << config.gfn_type << std::endl;
         std::cout << "  Extra flags: " << (config.extra_flag.empty() ? "(none)" : config.extra_flag) << std::endl;
+        std::cout << "  Result cache: " << (config.cache_max_mb > 0 && useCache ? getCacheDir() + " (" + std::to_string(config.cache_max_mb) + " MB)" : "disabled") << std::endl;
+        std::cout << "  Batch: " << getBatchCores() << " core(s), "
+                  << (config.max_jobs > 0 ? std::to_string(config.max_jobs) : std::string("one per core")) << " job(s) at a time" << std::endl;
         std::cout << std::endl;
     }
     
@@ -139,14 +975,14 @@ private:
             return true;
         }
         
-        DWORD attributes = GetFileAttributesA(config.xtb_execpath.c_str());
-        if (attributes == INVALID_FILE_ATTRIBUTES) {
+        std::error_code ec;
+        if (!fs::exists(config.xtb_execpath, ec)) {
             std::cerr << "\nERROR: XTB executable not found at: " << config.xtb_execpath << std::endl;
             std::cerr << "Please check the path in xtbclip.ini or leave xtb_execpath empty to use system PATH." << std::endl;
             return false;
         }
         
-        if (attributes & FILE_ATTRIBUTE_DIRECTORY) {
+        if (fs::is_directory(config.xtb_execpath, ec)) {
             std::cerr << "\nERROR: xtb_execpath points to a directory, not a file: " << config.xtb_execpath << std::endl;
             return false;
         }
@@ -162,12 +998,12 @@ private:
             // Ensure path ends with backslash
             std::string path = config.tmp_path;
             if (path.back() != '\\' && path.back() != '/') {
-                path += "\\";
+                path += PATH_SEP;
             }
             
             // Verify directory exists
-            DWORD attributes = GetFileAttributesA(path.c_str());
-            if (attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            std::error_code ec;
+            if (fs::is_directory(path, ec)) {
                 return path;
             } else {
                 std::cerr << "Warning: Configured tmp_path does not exist: " << path << std::endl;
@@ -176,23 +1012,43 @@ private:
         }
         
         // Fallback to system temp
+#ifdef _WIN32
         char tempPath[MAX_PATH];
         GetTempPathA(MAX_PATH, tempPath);
         return std::string(tempPath);
+#else
+        std::error_code ec;
+        std::string path = fs::temp_directory_path(ec).string();
+        return (path.empty() ? std::string("/tmp") : path) + PATH_SEP;
+#endif
+    }
+    
+    // Cores shared by the xtb processes of a batch
+    int getBatchCores() {
+        if (config.cores > 0) {
+            return config.cores;
+        }
+        unsigned int cores = std::thread::hardware_concurrency();
+        return cores > 0 ? static_cast<int>(cores) : 1;
+    }
+    
+    // Result cache directory: cache_dir, or a fixed directory next to the working directory
+    std::string getCacheDir() {
+        return config.cache_dir.empty() ? getTempDir() + "xtb_clipboard_cache" : config.cache_dir;
     }
     
     // Create/ensure working directory exists - Modified to use fixed name
     std::string createWorkingDirectory() {
         std::string baseDir = getTempDir();
-        std::string dirName = "xtb_clipboard_work\\";  // Fixed directory name
+        std::string dirName = std::string("xtb_clipboard_work") + PATH_SEP;  // Fixed directory name
         std::string fullPath = baseDir + dirName;
         
         // Create directory if it doesn't exist (will fail silently if it already exists)
-        CreateDirectoryA(fullPath.c_str(), nullptr);
+        std::error_code ec;
+        fs::create_directories(fullPath, ec);
         
         // Verify directory exists
-        DWORD attributes = GetFileAttributesA(fullPath.c_str());
-        if (attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        if (fs::is_directory(fullPath, ec)) {
             return fullPath;
         }
         
@@ -208,6 +1064,7 @@ private:
         std::cout << "Cleaning working directory..." << std::endl;
         
         // Remove files in the directory
+#ifdef _WIN32
         WIN32_FIND_DATAA findFileData;
         HANDLE hFind = FindFirstFileA((workDir + "*").c_str(), &findFileData);
         
@@ -217,6 +1074,16 @@ private:
                     strcmp(findFileData.cFileName, "..") != 0) {
                     std::string filePath = workDir + findFileData.cFileName;
                     
+                    // Job directories of a batch
+                    if (findFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                        std::error_code removeError;
+                        fs::remove_all(filePath, removeError);
+                        if (removeError) {
+                            std::cout << "Warning: Could not delete directory: " << filePath << std::endl;
+                        }
+                        continue;
+                    }
+                    
                     // Set file attributes to normal to ensure deletion
                     SetFileAttributesA(filePath.c_str(), FILE_ATTRIBUTE_NORMAL);
                     
@@ -227,6 +1094,16 @@ private:
             } while (FindNextFileA(hFind, &findFileData));
             FindClose(hFind);
         }
+#else
+        std::error_code ec;
+        for (fs::directory_iterator it(workDir, ec), end; !ec && it != end; it.increment(ec)) {
+            std::error_code removeError;
+            fs::remove_all(it->path(), removeError);
+            if (removeError) {
+                std::cout << "Warning: Could not delete file: " << it->path().string() << std::endl;
+            }
+        }
+#endif
         
         std::cout << "Working directory cleaned." << std::endl;
     }
@@ -289,6 +1166,7 @@ private:
         return content;
     }
     
+#ifdef _WIN32
     // NEW: Check if clipboard contains files and read XYZ file
     std::string getClipboardFile() {
         if (!OpenClipboard(nullptr)) {
@@ -363,9 +1241,15 @@ private:
         
         return text;
     }
+#endif
     
     // NEW: Smart clipboard reader - tries file first, then text
     std::string getClipboardContent() {
+        if (!clipboardFile.empty()) {
+            std::cout << "Reading XYZ data from " << clipboardFile << std::endl;
+            return readFileContent(clipboardFile);
+        }
+#ifdef _WIN32
         // First, try to read as file
         std::string content = getClipboardFile();
         
@@ -381,12 +1265,19 @@ private:
             std::cout << "Read XYZ data from clipboard text." << std::endl;
             return content;
         }
+#endif
         
         return "";
     }
     
     // Write text to clipboard
     bool setClipboardText(const std::string& text) {
+        if (!clipboardFile.empty()) {
+            std::ofstream file(clipboardFile, std::ios::binary | std::ios::trunc);
+            file << text;
+            return static_cast<bool>(file);
+        }
+#ifdef _WIN32
         if (!OpenClipboard(nullptr)) {
             return false;
         }
@@ -407,6 +1298,9 @@ private:
         CloseClipboard();
         
         return true;
+#else
+        return false;
+#endif
     }
     
     // Check if second line is gview style (charge spin)
@@ -471,10 +1365,18 @@ private:
         return true;
     }
     
-    // Run XTB with specified parameters
-    bool runXTB(const std::string& xyzFile, int charge, int spin) {
-        // Build command
-        std::string xtbExec = config.xtb_execpath.empty() ? "xtb" : config.xtb_execpath;
+    std::string xtbExecutable() const {
+        return config.xtb_execpath.empty() ? "xtb" : config.xtb_execpath;
+    }
+
+    // Cache key component for the configured xtb
+    std::string xtbIdentity() const {
+        return ResultCache::executableIdentity(xtbExecutable());
+    }
+
+    // Command line of one optimization
+    std::string buildXTBCommand(const std::string& xyzFile, int charge, int spin) {
+        std::string xtbExec = xtbExecutable();
         std::string gfnFlag = "--gfn " + std::to_string(config.gfn_type);
         std::string chargeFlag = "--chrg " + std::to_string(charge);
         std::string spinFlag = "--uhf " + std::to_string(spin - 1);
@@ -485,148 +1387,24 @@ private:
         if (!config.extra_flag.empty()) {
             command += " " + config.extra_flag;
         }
+        return command;
+    }
+    
+    // Run XTB with specified parameters
+    bool runXTB(const std::string& xyzFile, int charge, int spin) {
+        XTBJob job;
+        job.dir = workDir;
+        job.command = buildXTBCommand(xyzFile, charge, spin);
         
         std::cout << "\nRunning XTB optimization..." << std::endl;
-        std::cout << "Command: " << command << std::endl;
+        std::cout << "Command: " << job.command << std::endl;
         std::cout << "============================" << std::endl;
         
-        // Create log file path
-        std::string logFile = workDir + "xtb_output.log";
-        std::ofstream logFileStream(logFile);
-        
-        // Setup process
-        SECURITY_ATTRIBUTES sa;
-        sa.nLength = sizeof(SECURITY_ATTRIBUTES);
-        sa.bInheritHandle = TRUE;
-        sa.lpSecurityDescriptor = nullptr;
-        
-        // Create pipes for stdout and stderr
-        HANDLE hStdOutRead, hStdOutWrite;
-        HANDLE hStdErrRead, hStdErrWrite;
-        
-        if (!CreatePipe(&hStdOutRead, &hStdOutWrite, &sa, 0) ||
-            !CreatePipe(&hStdErrRead, &hStdErrWrite, &sa, 0)) {
-            std::cerr << "Error: Cannot create pipes!" << std::endl;
-            return false;
-        }
-        
-        SetHandleInformation(hStdOutRead, HANDLE_FLAG_INHERIT, 0);
-        SetHandleInformation(hStdErrRead, HANDLE_FLAG_INHERIT, 0);
-        
-        // Setup startup info
-        STARTUPINFOA si;
-        ZeroMemory(&si, sizeof(si));
-        si.cb = sizeof(si);
-        si.hStdOutput = hStdOutWrite;
-        si.hStdError = hStdErrWrite;
-        si.dwFlags |= STARTF_USESTDHANDLES;
-        
-        // Process info
-        PROCESS_INFORMATION pi;
-        ZeroMemory(&pi, sizeof(pi));
-        
-        // Set working directory
-        const char* workingDir = workDir.c_str();
-        
-        // Create process
-        if (!CreateProcessA(nullptr, const_cast<char*>(command.c_str()), nullptr, nullptr,
-                           TRUE, CREATE_NO_WINDOW, nullptr, workingDir, &si, &pi)) {
-            std::cerr << "Error: Cannot start XTB process!" << std::endl;
-            std::cerr << "Make sure XTB is installed and accessible." << std::endl;
-            CloseHandle(hStdOutRead);
-            CloseHandle(hStdOutWrite);
-            CloseHandle(hStdErrRead);
-            CloseHandle(hStdErrWrite);
-            return false;
-        }
-        
-        // Close write ends
-        CloseHandle(hStdOutWrite);
-        CloseHandle(hStdErrWrite);
-        
-        // Read output
-        const int BUFFER_SIZE = 4096;
-        char buffer[BUFFER_SIZE];
-        DWORD bytesRead;
-        
-        bool processRunning = true;
-        while (processRunning) {
-            // Check if process is still running
-            DWORD exitCode;
-            GetExitCodeProcess(pi.hProcess, &exitCode);
-            processRunning = (exitCode == STILL_ACTIVE);
-            
-            // Read stdout
-            while (PeekNamedPipe(hStdOutRead, nullptr, 0, nullptr, &bytesRead, nullptr) && bytesRead > 0) {
-                if (ReadFile(hStdOutRead, buffer, BUFFER_SIZE - 1, &bytesRead, nullptr) && bytesRead > 0) {
-                    buffer[bytesRead] = '\0';
-                    std::cout << buffer;
-                    std::cout.flush();
-                    
-                    // Write to log file
-                    if (logFileStream.is_open()) {
-                        logFileStream << buffer;
-                        logFileStream.flush();
-                    }
-                }
-            }
-            
-            // Read stderr
-            while (PeekNamedPipe(hStdErrRead, nullptr, 0, nullptr, &bytesRead, nullptr) && bytesRead > 0) {
-                if (ReadFile(hStdErrRead, buffer, BUFFER_SIZE - 1, &bytesRead, nullptr) && bytesRead > 0) {
-                    buffer[bytesRead] = '\0';
-                    std::cerr << buffer;
-                    std::cerr.flush();
-                    
-                    // Write to log file
-                    if (logFileStream.is_open()) {
-                        logFileStream << buffer;
-                        logFileStream.flush();
-                    }
-                }
-            }
-            
-            // Small delay to prevent CPU spinning
-            if (processRunning) {
-                Sleep(50);
-            }
-        }
-        
-        // Read any remaining output
-        while (ReadFile(hStdOutRead, buffer, BUFFER_SIZE - 1, &bytesRead, nullptr) && bytesRead > 0) {
-            buffer[bytesRead] = '\0';
-            std::cout << buffer;
-            if (logFileStream.is_open()) {
-                logFileStream << buffer;
-            }
-        }
-        
-        while (ReadFile(hStdErrRead, buffer, BUFFER_SIZE - 1, &bytesRead, nullptr) && bytesRead > 0) {
-            buffer[bytesRead] = '\0';
-            std::cerr << buffer;
-            if (logFileStream.is_open()) {
-                logFileStream << buffer;
-            }
-        }
-        
-        // Close log file
-        if (logFileStream.is_open()) {
-            logFileStream.close();
-        }
+        // A single run keeps the thread settings of the environment
+        runXTBJobs({&job}, {0}, true, [](XTBJob&) {});
         
         std::cout << "============================" << std::endl << std::endl;
-        
-        // Get exit code
-        DWORD exitCode;
-        GetExitCodeProcess(pi.hProcess, &exitCode);
-        
-        // Cleanup
-        CloseHandle(hStdOutRead);
-        CloseHandle(hStdErrRead);
-        CloseHandle(pi.hProcess);
-        CloseHandle(pi.hThread);
-        
-        return exitCode == 0;
+        return job.started && job.exitCode == 0;
     }
     
     // Add charge and spin to XYZ format (Gaussian style)
@@ -669,19 +1447,26 @@ private:
             cleanupWorkingDirectory();
             
             // Remove directory
-            if (!RemoveDirectoryA(workDir.c_str())) {
+            std::error_code ec;
+            if (!fs::remove(workDir, ec)) {
                 std::cout << "Warning: Could not remove temporary directory: " << workDir << std::endl;
             }
         }
     }
     
+    std::unique_ptr<ResultCache> cache;
+    
 public:
-    XTBOptimizer() {
+    XTBOptimizer(const std::string& configFile, const std::string& clipboardPath, bool cacheResults)
+        : configPath(configFile), clipboardFile(clipboardPath), useCache(cacheResults) {
         loadConfig();  // Load configuration first
         workDir = createWorkingDirectory();
     }
     
     ~XTBOptimizer() {
+        if (cache) {
+            cache->report();
+        }
         finalCleanup();
     }
     
@@ -714,6 +1499,13 @@ public:
             return false;
         }
         
+        // Several frames (e.g. a conformer ensemble): optimize all of them
+        cache.reset(new ResultCache(getCacheDir(), useCache ? static_cast<uint64_t>(config.cache_max_mb) * 1024 * 1024 : 0));
+        std::vector<std::string> frames = splitXYZFrames(clipboardContent);
+        if (frames.size() > 1) {
+            return processBatch(frames);
+        }
+        
         // Extract pure XYZ and get charge/spin
         int charge, spin;
         std::string pureXYZ = extractPureXYZ(clipboardContent, charge, spin);
@@ -721,6 +1513,49 @@ public:
             return false;
         }
         
+        // Same structure and settings as an earlier run: take the result from the cache
+        std::string cacheKey;
+        const bool cacheable = cache->enabled() &&
+                               ResultCache::canonicalKey(pureXYZ, xtbIdentity(), charge, spin, config.gfn_type,
+                                                         config.extra_flag, cacheKey);
+        ResultCache::Entry result;
+        std::string optimizedFile;
+        if (cacheable && cache->lookup(cacheKey, result)) {
+            optimizedFile = (cache->entryPath(cacheKey) / "xtbopt.xyz").string();
+            std::cout << "Cache hit: this structure was already optimized with the same settings." << std::endl;
+        } else {
+            if (!runOptimization(pureXYZ, charge, spin, optimizedFile, result)) {
+                return false;
+            }
+            if (cacheable) {
+                cache->store(cacheKey, result);
+            }
+        }
+        if (result.hasEnergy) {
+            char energy[64];
+            snprintf(energy, sizeof(energy), "%.10f", result.energy);
+            std::cout << "Total energy: " << energy << " Eh" << std::endl;
+        }
+        
+        // Add charge and spin information to second line (Gaussian style)
+        std::string formattedContent = addChargeSpinToXYZ(result.geometry, charge, spin);
+        
+        // Write results back to clipboard
+        if (setClipboardText(formattedContent)) {
+            std::cout << "SUCCESS: Optimization completed!" << std::endl;
+            std::cout << "Optimized structure (with charge " << charge << " and spin " << spin << ") has been copied to clipboard." << std::endl;
+        } else {
+            std::cout << "WARNING: Optimization completed, but cannot write to clipboard!" << std::endl;
+            std::cout << "Optimized structure file: " << optimizedFile << std::endl;
+        }
+        
+        return true;
+    }
+    
+private:
+    // Runs xtb on one structure in the working directory; fills the geometry, log and energy
+    bool runOptimization(const std::string& pureXYZ, int charge, int spin, std::string& optimizedFile,
+                         ResultCache::Entry& result) {
         // Write to temporary XYZ file
         std::string xyzFile = workDir + "temp_structure.xyz";
         std::ofstream outFile(xyzFile);
@@ -745,9 +1580,9 @@ public:
             workDir + "temp_structure_optimized.xyz"
         };
         
-        std::string optimizedFile;
         for (const auto& file : possibleFiles) {
-            if (GetFileAttributesA(file.c_str()) != INVALID_FILE_ATTRIBUTES) {
+            std::error_code ec;
+            if (fs::exists(file, ec)) {
                 optimizedFile = file;
                 break;
             }
@@ -765,42 +1600,240 @@ public:
             return false;
         }
         
-        std::string optimizedContent((std::istreambuf_iterator<char>(resultFile)),
-                                   std::istreambuf_iterator<char>());
+        result.geometry.assign((std::istreambuf_iterator<char>(resultFile)),
+                               std::istreambuf_iterator<char>());
         resultFile.close();
         
-        // Add charge and spin information to second line (Gaussian style)
-        std::string formattedContent = addChargeSpinToXYZ(optimizedContent, charge, spin);
+        result.log = readFileContent(workDir + "xtb_output.log");
+        result.hasEnergy = readXTBEnergy(result.geometry, result.log, result.energy);
+        return true;
+    }
+    
+    // Optimizes every frame in its own job directory, running several xtb processes at a time with
+    // the cores divided between them, and puts the optimized frames sorted by energy on the clipboard
+    bool processBatch(const std::vector<std::string>& frames) {
+        const auto batchStart = std::chrono::steady_clock::now();
+        std::cout << "Batch of " << frames.size() << " structures." << std::endl;
+        
+        // Charge and spin: GView style line of the first frame, otherwise asked once for all frames
+        int charge = 0, spin = 1;
+        std::vector<std::string> pureFrames;
+        {
+            std::istringstream first(frames[0]);
+            std::string countLine, secondLine;
+            std::getline(first, countLine);
+            std::getline(first, secondLine);
+            if (isGViewStyle(secondLine)) {
+                std::istringstream values(secondLine);
+                values >> charge >> spin;
+                std::cout << "Detected charge: " << charge << ", spin: " << spin << " (applied to all structures)" << std::endl;
+            } else if (!getChargeAndSpin(charge, spin)) {
+                return false;
+            }
+        }
+        for (const auto& frame : frames) {
+            // Comment lines are not passed to xtb
+            size_t countEnd = frame.find('\n');
+            size_t commentEnd = frame.find('\n', countEnd + 1);
+            pureFrames.push_back(frame.substr(0, countEnd + 1) + "\n" + frame.substr(commentEnd + 1));
+        }
         
-        // Write results back to clipboard
-        if (setClipboardText(formattedContent)) {
-            std::cout << "SUCCESS: Optimization completed!" << std::endl;
-            std::cout << "Optimized structure (with charge " << charge << " and spin " << spin << ") has been copied to clipboard." << std::endl;
-        } else {
-            std::cout << "WARNING: Optimization completed, but cannot write to clipboard!" << std::endl;
-            std::cout << "Optimized structure file: " << optimizedFile << std::endl;
+        std::vector<ResultCache::Entry> results(frames.size());
+        std::vector<bool> done(frames.size(), false);
+        std::vector<std::string> keys(frames.size());
+        std::vector<XTBJob> jobs;
+        size_t cacheHits = 0;
+        const std::string engine = cache->enabled() ? xtbIdentity() : "";
+        for (size_t i = 0; i < frames.size(); ++i) {
+            if (cache->enabled() &&
+                ResultCache::canonicalKey(pureFrames[i], engine, charge, spin, config.gfn_type, config.extra_flag,
+                                          keys[i]) &&
+                cache->lookup(keys[i], results[i])) {
+                done[i] = true;
+                ++cacheHits;
+                continue;
+            }
+            
+            char name[32];
+            snprintf(name, sizeof(name), "job_%04zu", i + 1);
+            XTBJob job;
+            job.index = i;
+            job.dir = workDir + name + PATH_SEP;
+            std::error_code ec;
+            fs::create_directories(job.dir, ec);
+            std::ofstream outFile(job.dir + "structure.xyz");
+            if (!outFile.is_open()) {
+                std::cerr << "Error: Cannot create job directory " << job.dir << std::endl;
+                return false;
+            }
+            outFile << pureFrames[i];
+            outFile.close();
+            job.command = buildXTBCommand(job.dir + "structure.xyz", charge, spin);
+            jobs.push_back(job);
+        }
+        if (cacheHits > 0) {
+            std::cout << cacheHits << " structure(s) taken from the result cache." << std::endl;
+        }
+        
+        // One slot per concurrent process; each slot owns a share of the cores
+        const int cores = getBatchCores();
+        size_t parallel = static_cast<size_t>(config.max_jobs > 0 ? config.max_jobs : cores);
+#ifdef _WIN32
+        parallel = std::min<size_t>(parallel, MAXIMUM_WAIT_OBJECTS);
+#endif
+        parallel = std::max<size_t>(std::min(parallel, jobs.size()), 1);
+        const std::vector<int> slotThreads = partitionCores(cores, parallel);
+        
+        size_t failures = 0;
+        size_t finishedJobs = 0;
+        if (!jobs.empty()) {
+            std::cout << "\nRunning " << jobs.size() << " XTB optimization(s), " << parallel << " at a time, "
+                      << slotThreads[0] << " thread(s) each..." << std::endl;
+            std::cout << "Command: " << jobs[0].command << std::endl;
+            std::cout << "============================" << std::endl;
+            
+            std::vector<XTBJob*> queue;
+            for (auto& job : jobs) {
+                queue.push_back(&job);
+            }
+            runXTBJobs(queue, slotThreads, false, [&](XTBJob& job) {
+                ++finishedJobs;
+                std::ostringstream progress;
+                progress << "[" << finishedJobs << "/" << jobs.size() << "] structure " << job.index + 1 << ": ";
+                
+                ResultCache::Entry& result = results[job.index];
+                std::error_code ec;
+                if (job.started && job.exitCode == 0 && fs::exists(job.dir + "xtbopt.xyz", ec)) {
+                    result.geometry = readFileContent(job.dir + "xtbopt.xyz");
+                    result.log = readFileContent(job.dir + "xtb_output.log");
+                    result.hasEnergy = readXTBEnergy(result.geometry, result.log, result.energy);
+                    done[job.index] = !result.geometry.empty();
+                }
+                if (done[job.index]) {
+                    if (result.hasEnergy) {
+                        char energy[64];
+                        snprintf(energy, sizeof(energy), "%.10f Eh", result.energy);
+                        progress << energy;
+                    } else {
+                        progress << "energy not found";
+                    }
+                    if (!keys[job.index].empty()) {
+                        cache->store(keys[job.index], result);
+                    }
+                } else {
+                    ++failures;
+                    progress << "FAILED (" << (job.started ? "exit code " + std::to_string(job.exitCode) : std::string("not started"))
+                             << ", see " << job.dir << "xtb_output.log)";
+                }
+                char timing[64];
+                snprintf(timing, sizeof(timing), " (%.1f s, %d thread(s))", job.seconds, job.threads);
+                std::cout << progress.str() << timing << std::endl;
+            });
+            std::cout << "============================" << std::endl << std::endl;
         }
         
+        // Optimized frames, lowest energy first; frames without an energy go last
+        std::vector<size_t> order;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            if (done[i]) {
+                order.push_back(i);
+            }
+        }
+        if (order.empty()) {
+            std::cerr << "Error: XTB optimization failed for all structures!" << std::endl;
+            return false;
+        }
+        std::stable_sort(order.begin(), order.end(), [&results](size_t a, size_t b) {
+            if (results[a].hasEnergy != results[b].hasEnergy) {
+                return results[a].hasEnergy;
+            }
+            return results[a].hasEnergy && results[a].energy < results[b].energy;
+        });
+        
+        const double HARTREE_TO_KCAL = 627.509;
+        const double lowest = results[order[0]].energy;
+        std::ostringstream ensemble;
+        for (size_t i : order) {
+            std::istringstream geometry(results[i].geometry);
+            std::string line;
+            std::vector<std::string> atoms;
+            std::getline(geometry, line);
+            const std::string countLine = line;
+            std::getline(geometry, line);
+            while (std::getline(geometry, line)) {
+                if (!line.empty() && line.find_first_not_of(" \t\r") != std::string::npos) {
+                    atoms.push_back(line);
+                }
+            }
+            char comment[160];
+            if (results[i].hasEnergy) {
+                snprintf(comment, sizeof(comment), "energy: %.10f Eh, dE = %.3f kcal/mol, structure %zu, charge %d, spin %d",
+                         results[i].energy, (results[i].energy - lowest) * HARTREE_TO_KCAL, i + 1, charge, spin);
+            } else {
+                snprintf(comment, sizeof(comment), "energy: unknown, structure %zu, charge %d, spin %d", i + 1, charge, spin);
+            }
+            ensemble << countLine << "\n" << comment << "\n";
+            for (const auto& atom : atoms) {
+                ensemble << atom << "\n";
+            }
+        }
+        
+        const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+        char summary[200];
+        snprintf(summary, sizeof(summary), "%zu of %zu structures optimized (%zu from cache, %zu failed) in %.1f s, %zu job(s) at a time on %d core(s).",
+                 order.size(), frames.size(), cacheHits, failures, wall, parallel, cores);
+        std::cout << summary << std::endl;
+        if (results[order[0]].hasEnergy) {
+            char energy[64];
+            snprintf(energy, sizeof(energy), "%.10f", lowest);
+            std::cout << "Lowest energy: " << energy << " Eh (structure " << order[0] + 1 << ")" << std::endl;
+        }
+        
+        if (setClipboardText(ensemble.str())) {
+            std::cout << "SUCCESS: Batch optimization completed!" << std::endl;
+            std::cout << "Optimized structures, sorted by energy, have been copied to clipboard." << std::endl;
+        } else {
+            std::cout << "WARNING: Batch optimization completed, but cannot write to clipboard!" << std::endl;
+            std::cout << "Optimized structures are in the job directories under: " << workDir << std::endl;
+        }
         return true;
     }
 };
 
 // Main function
-int main() {
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
     // Set console to UTF-8 for better compatibility
     SetConsoleOutputCP(CP_UTF8);
+    std::string clipboardFile;
+#else
+    std::string clipboardFile = "clipboard.xyz";
+#endif
+    std::string configFile;
+    bool useCache = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--config=", 0) == 0) {
+            configFile = arg.substr(9);
+        } else if (arg.rfind("--clipboard=", 0) == 0) {
+            clipboardFile = arg.substr(12);
+        } else if (arg == "--no-cache") {
+            useCache = false;
+        } else {
+            std::cerr << "Warning: Unknown argument ignored: " << arg << std::endl;
+        }
+    }
     
-    XTBOptimizer optimizer;
-    
-    bool success = optimizer.process();
-    
-    if (!success) {
-        std::cout << "\nPress Enter to exit...";
-        std::cin.get();
-        return 1;
+    bool success;
+    {
+        XTBOptimizer optimizer(configFile, clipboardFile, useCache);
+        success = optimizer.process();
     }
     
+#ifdef _WIN32
+    // Keep the console window open
     std::cout << "\nPress Enter to exit...";
     std::cin.get();
-    return 0;
+#endif
+    return success ? 0 : 1;
 }
\ No newline at end of file
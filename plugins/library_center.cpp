@@ -0,0 +1,126 @@
+// g++ -std=c++17 -O2 -shared -fPIC library_center.cpp -o library_center.so
+// x86_64-w64-mingw32-g++ library_center.cpp -o library_center.dll -shared -static-libgcc -static-libstdc++ -std=c++17 -s -O2
+//
+// Example library plugin (see src/plugin_abi.h for the ABI), equivalent to resident_center.cpp.
+// Loaded into the xyzTrick process with "library=" in its config section; every call receives
+// read-only views of the frames xyzTrick has already parsed from the clipboard. The plugin moves
+// each frame's centroid to the origin and returns the result as a trajectory view: the new
+// coordinates live in plugin-owned arrays, while symbols, comments and cell vectors point straight
+// back into the input, which stays valid until release() returns.
+//
+// config.ini:
+//   [center]
+//   library=plugins\library_center.dll
+//   hotkey=CTRL+ALT+C
+
+#include "../src/plugin_abi.h"
+
+#include <new>
+#include <vector>
+
+namespace {
+
+struct CenteredTrajectory {
+    std::vector<double> coordinates;            // x, y, z of every atom, one SoA block per frame
+    std::vector<xyztrick_frame_view> frames;
+};
+
+const char ERROR_NOT_STRUCTURE[] = "Clipboard does not contain a structure";
+const char ERROR_OUT_OF_MEMORY[] = "Out of memory";
+
+inline double element(const double* base, size_t stride, size_t i) {
+    return *reinterpret_cast<const double*>(reinterpret_cast<const char*>(base) + i * (stride ? stride : sizeof(double)));
+}
+
+void setError(xyztrick_result* result, const char* message, size_t length) {
+    result->kind = XYZTRICK_RESULT_TEXT;
+    result->action = XYZTRICK_ACTION_NONE;
+    result->text = message;
+    result->text_length = length;
+}
+
+int run(const xyztrick_trajectory_view* input, const char*, size_t, xyztrick_result* result) {
+    if (!input || input->frame_count == 0) {
+        setError(result, ERROR_NOT_STRUCTURE, sizeof(ERROR_NOT_STRUCTURE) - 1);
+        return XYZTRICK_STATUS_ERROR;
+    }
+
+    CenteredTrajectory* centered = new (std::nothrow) CenteredTrajectory;
+    if (!centered) {
+        setError(result, ERROR_OUT_OF_MEMORY, sizeof(ERROR_OUT_OF_MEMORY) - 1);
+        return XYZTRICK_STATUS_ERROR;
+    }
+    try {
+        size_t totalAtoms = 0;
+        for (size_t f = 0; f < input->frame_count; ++f) {
+            totalAtoms += input->frames[f].atom_count;
+        }
+        centered->coordinates.resize(3 * totalAtoms);
+        centered->frames.resize(input->frame_count);
+    } catch (const std::bad_alloc&) {
+        delete centered;
+        setError(result, ERROR_OUT_OF_MEMORY, sizeof(ERROR_OUT_OF_MEMORY) - 1);
+        return XYZTRICK_STATUS_ERROR;
+    }
+
+    double* block = centered->coordinates.data();
+    for (size_t f = 0; f < input->frame_count; ++f) {
+        const xyztrick_frame_view& source = input->frames[f];
+        const size_t n = source.atom_count;
+        double cx = 0.0, cy = 0.0, cz = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            cx += element(source.x, source.stride, i);
+            cy += element(source.y, source.stride, i);
+            cz += element(source.z, source.stride, i);
+        }
+        const double count = n == 0 ? 1.0 : static_cast<double>(n);
+        cx /= count;
+        cy /= count;
+        cz /= count;
+
+        double* x = block;
+        double* y = block + n;
+        double* z = block + 2 * n;
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = element(source.x, source.stride, i) - cx;
+            y[i] = element(source.y, source.stride, i) - cy;
+            z[i] = element(source.z, source.stride, i) - cz;
+        }
+        block += 3 * n;
+
+        xyztrick_frame_view& frame = centered->frames[f];
+        frame = source;             // symbols, comment and cell are passed back unchanged
+        frame.x = x;
+        frame.y = y;
+        frame.z = z;
+        frame.charges = nullptr;
+        frame.stride = 0;
+    }
+
+    result->kind = XYZTRICK_RESULT_TRAJECTORY;
+    result->action = XYZTRICK_ACTION_CLIPBOARD;
+    result->trajectory.frame_count = centered->frames.size();
+    result->trajectory.frames = centered->frames.data();
+    result->plugin_data = centered;
+    return XYZTRICK_STATUS_OK;
+}
+
+void release(xyztrick_result* result) {
+    delete static_cast<CenteredTrajectory*>(result->plugin_data);
+    result->plugin_data = nullptr;
+}
+
+const xyztrick_plugin_api API = {
+    XYZTRICK_PLUGIN_ABI_VERSION,
+    sizeof(xyztrick_plugin_api),
+    "library_center",
+    run,
+    release,
+    nullptr,
+};
+
+} // namespace
+
+extern "C" XYZTRICK_PLUGIN_EXPORT const xyztrick_plugin_api* xyztrick_plugin_entry(uint32_t host_abi_version) {
+    return host_abi_version == XYZTRICK_PLUGIN_ABI_VERSION ? &API : nullptr;
+}
@@ -0,0 +1,145 @@
+// g++ -std=c++17 -O2 resident_center.cpp -o resident_center
+// x86_64-w64-mingw32-g++ resident_center.cpp -o resident_center.exe -static-libgcc -static-libstdc++ -std=c++17 -s -O2
+//
+// Example resident plugin (see src/plugin_host.h for the protocol).
+// Started once by xyzTrick with "resident=true" in its config section; every request
+// carries the frames xyzTrick has already parsed from the clipboard. The plugin moves
+// each frame's centroid to the origin and sends the result back to the clipboard.
+//
+// config.ini:
+//   [center]
+//   cmd=plugins\resident_center.exe
+//   hotkey=CTRL+ALT+C
+//   resident=true
+//
+// The protocol only uses stdin/stdout, so the plugin can also be driven by hand:
+//   printf 'REQUEST 1 frames 20\n1\nwater\nO 1.0 2.0 3.0\n\nQUIT\n' | ./resident_center
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace {
+
+struct Atom {
+    std::string symbol;
+    double x, y, z;
+};
+
+struct Frame {
+    std::string comment;
+    std::vector<Atom> atoms;
+    std::vector<Atom> cell;     // Tv rows, written back unchanged
+};
+
+bool parseFrames(const std::string& text, std::vector<Frame>& frames) {
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        char* end = nullptr;
+        long count = std::strtol(line.c_str(), &end, 10);
+        if (end == line.c_str() || count <= 0) {
+            return false;
+        }
+        Frame frame;
+        std::getline(in, frame.comment);
+        for (long i = 0; i < count; ++i) {
+            if (!std::getline(in, line)) {
+                return false;
+            }
+            std::istringstream row(line);
+            Atom atom;
+            if (!(row >> atom.symbol >> atom.x >> atom.y >> atom.z)) {
+                return false;
+            }
+            (atom.symbol == "Tv" ? frame.cell : frame.atoms).push_back(atom);
+        }
+        frames.push_back(frame);
+    }
+    return !frames.empty();
+}
+
+std::string centerFrames(std::vector<Frame>& frames) {
+    std::string out;
+    char row[128];
+    for (Frame& frame : frames) {
+        double cx = 0.0, cy = 0.0, cz = 0.0;
+        for (const Atom& atom : frame.atoms) {
+            cx += atom.x;
+            cy += atom.y;
+            cz += atom.z;
+        }
+        const double n = frame.atoms.empty() ? 1.0 : static_cast<double>(frame.atoms.size());
+        cx /= n;
+        cy /= n;
+        cz /= n;
+
+        out += std::to_string(frame.atoms.size() + frame.cell.size()) + "\n" + frame.comment + "\n";
+        for (const Atom& atom : frame.atoms) {
+            std::snprintf(row, sizeof(row), "%-2s %14.8f %14.8f %14.8f\n", atom.symbol.c_str(), atom.x - cx,
+                          atom.y - cy, atom.z - cz);
+            out += row;
+        }
+        for (const Atom& vector : frame.cell) {
+            std::snprintf(row, sizeof(row), "Tv %14.8f %14.8f %14.8f\n", vector.x, vector.y, vector.z);
+            out += row;
+        }
+    }
+    return out;
+}
+
+void reply(const std::string& id, bool ok, const char* action, const std::string& payload) {
+    std::cout << "RESULT " << id << (ok ? " ok " : " error ") << action << " " << payload.size() << "\n"
+              << payload << "\n";
+    std::cout.flush();
+}
+
+} // namespace
+
+int main() {
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    std::ios::sync_with_stdio(false);
+    std::cout << "XYZTRICK-PLUGIN 1\n";
+    std::cout.flush();
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (line == "QUIT") {
+            break;
+        }
+        std::istringstream header(line);
+        std::string tag, id, kind;
+        size_t bytes = 0;
+        if (!(header >> tag >> id >> kind >> bytes) || tag != "REQUEST") {
+            continue;
+        }
+        std::string payload(bytes, '\0');
+        if (!std::cin.read(&payload[0], static_cast<std::streamsize>(bytes))) {
+            break;
+        }
+        std::cin.ignore(1);     // payload terminator
+
+        std::vector<Frame> frames;
+        if (kind != "frames" || !parseFrames(payload, frames)) {
+            reply(id, false, "none", "Clipboard does not contain a structure");
+            continue;
+        }
+        std::cout << "LOG centered " << frames.size() << " frame(s)\n";
+        reply(id, true, "clipboard", centerFrames(frames));
+    }
+    return 0;
+}
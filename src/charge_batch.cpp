@@ -0,0 +1,647 @@
+#include "charge_batch.h"
+#include "config.h"
+#include "converter.h"
+#include "encoding.h"
+#include "logger.h"
+#include "memory_budget.h"
+#include "output_writers.h"
+#include "threading.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <memory>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XYZTRICK_CHARGE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// 统计按原子块计算：块内的均值、平方和、最小、最大（各 512 个 double）留在缓存中，逐组累加
+const size_t BLOCK_ATOMS = 512;
+// 组数 x 原子数达到此值才分给多个线程，每个线程至少处理这么多
+const size_t PARALLEL_MIN_WORK = 1u << 18;
+
+// 默认输出子目录（避免结果 .chg 混入下次按目录读取的输入）
+const char* const DEFAULT_OUTPUT_SUBDIR = "chg_diff";
+
+size_t chunkCountFor(size_t work) {
+    return std::min<size_t>(hardwareConcurrency(), std::max<size_t>(1, work / PARALLEL_MIN_WORK));
+}
+
+// 把 [0, count) 切成 chunkCount 段，第一段在当前线程执行，其余各用一个工作线程。
+// work 自己处理异常；工作线程没有内存预算，不会抛出 MemoryBudgetExceeded
+void runChunks(size_t count, size_t chunkCount, const std::function<void(size_t, size_t)>& work) {
+    if (count == 0) {
+        return;
+    }
+    chunkCount = std::max<size_t>(1, std::min(chunkCount, count));
+    const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    std::vector<std::unique_ptr<Thread>> workers;
+    for (size_t begin = chunkSize; begin < count; begin += chunkSize) {
+        const size_t end = std::min(count, begin + chunkSize);
+        auto task = [&work, begin, end]() {
+            work(begin, end);
+        };
+        auto worker = std::make_unique<Thread>();
+        if (!worker->start(task)) {
+            // 线程启动失败时在当前线程执行这一段
+            task();
+            continue;
+        }
+        workers.push_back(std::move(worker));
+    }
+    work(0, std::min(count, chunkSize));
+    for (auto& worker : workers) {
+        worker->join();
+    }
+}
+
+// ---------- 核心循环 ----------
+
+// out = a - b，返回 out 的总和
+double subtractCharges(const double* a, const double* b, double* out, size_t n) {
+    size_t i = 0;
+    double total = 0.0;
+#ifdef XYZTRICK_CHARGE_SSE2
+    __m128d sum = _mm_setzero_pd();
+    for (; i + 2 <= n; i += 2) {
+        const __m128d d = _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+        _mm_storeu_pd(out + i, d);
+        sum = _mm_add_pd(sum, d);
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, sum);
+    total = lanes[0] + lanes[1];
+#endif
+    for (; i < n; ++i) {
+        out[i] = a[i] - b[i];
+        total += out[i];
+    }
+    return total;
+}
+
+// 第一遍：逐组累加和、最小值、最大值
+void accumulateRange(const double* row, double* sum, double* minimum, double* maximum, size_t n) {
+    size_t i = 0;
+#ifdef XYZTRICK_CHARGE_SSE2
+    for (; i + 2 <= n; i += 2) {
+        const __m128d v = _mm_loadu_pd(row + i);
+        _mm_storeu_pd(sum + i, _mm_add_pd(_mm_loadu_pd(sum + i), v));
+        _mm_storeu_pd(minimum + i, _mm_min_pd(_mm_loadu_pd(minimum + i), v));
+        _mm_storeu_pd(maximum + i, _mm_max_pd(_mm_loadu_pd(maximum + i), v));
+    }
+#endif
+    for (; i < n; ++i) {
+        sum[i] += row[i];
+        minimum[i] = std::min(minimum[i], row[i]);
+        maximum[i] = std::max(maximum[i], row[i]);
+    }
+}
+
+// 第二遍：离均差平方和（两遍法，比一遍求平方和再减均值平方稳定）
+void accumulateSquares(const double* row, const double* mean, double* squares, size_t n) {
+    size_t i = 0;
+#ifdef XYZTRICK_CHARGE_SSE2
+    for (; i + 2 <= n; i += 2) {
+        const __m128d d = _mm_sub_pd(_mm_loadu_pd(row + i), _mm_loadu_pd(mean + i));
+        _mm_storeu_pd(squares + i, _mm_add_pd(_mm_loadu_pd(squares + i), _mm_mul_pd(d, d)));
+    }
+#endif
+    for (; i < n; ++i) {
+        const double d = row[i] - mean[i];
+        squares[i] += d * d;
+    }
+}
+
+// 原子 [begin, end) 在全部差值上的统计
+void computeStatistics(ChargeDiffResult& result, size_t begin, size_t end) {
+    const size_t n = end - begin;
+    const size_t count = result.differenceCount();
+    double* mean = result.mean.data() + begin;
+    double* stddev = result.stddev.data() + begin;
+    double* minimum = result.minimum.data() + begin;
+    double* maximum = result.maximum.data() + begin;
+
+    const double* first = result.differencesOf(0) + begin;
+    std::copy(first, first + n, mean);
+    std::copy(first, first + n, minimum);
+    std::copy(first, first + n, maximum);
+    for (size_t k = 1; k < count; ++k) {
+        accumulateRange(result.differencesOf(k) + begin, mean, minimum, maximum, n);
+    }
+    const double scale = 1.0 / static_cast<double>(count);
+    for (size_t i = 0; i < n; ++i) {
+        mean[i] *= scale;
+    }
+
+    std::fill(stddev, stddev + n, 0.0);
+    for (size_t k = 0; k < count; ++k) {
+        accumulateSquares(result.differencesOf(k) + begin, mean, stddev, n);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        stddev[i] = std::sqrt(stddev[i] * scale);
+    }
+}
+
+// ---------- 读取 ----------
+
+bool sameSymbols(const Frame& frame, const std::vector<std::string>& symbols) {
+    if (frame.atoms.size() != symbols.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        if (frame.atoms[i].symbol != symbols[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void storeChargeSet(const Frame& frame, ChargeSets& sets, size_t set) {
+    const size_t offset = set * sets.atomCount;
+    for (size_t i = 0; i < sets.atomCount; ++i) {
+        const Atom& atom = frame.atoms[i];
+        sets.x[offset + i] = atom.x;
+        sets.y[offset + i] = atom.y;
+        sets.z[offset + i] = atom.z;
+        sets.charges[offset + i] = atom.charge;
+    }
+}
+
+// 把第 from 组搬到第 to 组（to < from）
+void moveChargeSet(ChargeSets& sets, size_t from, size_t to) {
+    const size_t n = sets.atomCount;
+    for (std::vector<double>* column : {&sets.x, &sets.y, &sets.z, &sets.charges}) {
+        std::copy(column->begin() + from * n, column->begin() + (from + 1) * n, column->begin() + to * n);
+    }
+}
+
+std::string lowerExtension(const std::filesystem::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext;
+}
+
+// ---------- 写出 ----------
+
+bool writeChargeFrame(const OutputWriter& writer, Frame frame, const std::filesystem::path& path) {
+    std::vector<Frame> frames;
+    frames.push_back(std::move(frame));
+    return writeFramesToFile(writer, frames, path.string());
+}
+
+bool writeSummary(const ChargeSets& sets, const ChargeDiffResult& result, ChargeDiffMode mode,
+                  const std::filesystem::path& path) {
+    std::ofstream out(path.string());
+    if (!out) {
+        LOG_ERROR("Failed to create " + path.string());
+        return false;
+    }
+    out << "# Charge differences (" << chargeDiffModeName(mode) << "): " << sets.setCount() << " sets, "
+        << result.differenceCount() << " differences, " << sets.atomCount << " atoms\n";
+    out << "# Difference" << std::string(29, ' ') << "Sum\n";
+    out << std::fixed << std::setprecision(10);
+    for (size_t k = 0; k < result.differenceCount(); ++k) {
+        std::string name = sets.names[result.minuend[k]] + " - " + sets.names[result.subtrahend[k]];
+        out << std::left << std::setw(36) << name << std::right << std::setw(16) << result.sums[k] << "\n";
+    }
+    out << "\n#  Atom  El            Mean          StdDev             Min             Max\n";
+    for (size_t i = 0; i < sets.atomCount; ++i) {
+        out << std::setw(7) << (i + 1) << "  " << std::left << std::setw(2) << sets.symbols[i] << std::right
+            << std::setw(16) << result.mean[i] << std::setw(16) << result.stddev[i] << std::setw(16)
+            << result.minimum[i] << std::setw(16) << result.maximum[i] << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+bool writeChargeLog(const std::vector<Frame>& frames, const GaussianChargeMapping& mapping,
+                    const std::filesystem::path& path) {
+    std::ofstream file(path.string(), std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to open output file for writing: " + path.string());
+        return false;
+    }
+    bool ok = false;
+    {
+        TextSink sink(file);
+        writeGaussianLog(sink, frames, &mapping);
+        ok = sink.flush();
+    }
+    file.close();
+    if (!ok || file.fail()) {
+        LOG_ERROR("Failed to write " + path.string());
+        return false;
+    }
+    return true;
+}
+
+// 单个 CHG 文件 -> 一个或多个日志，mappingText 收集映射表中这个文件的部分
+bool convertChargeChannels(const std::string& path, const std::filesystem::path& directory, size_t limitBytes,
+                           std::string& mappingText) {
+    try {
+        MemoryBudget budget(limitBytes);
+        MemoryBudgetScope budgetScope(budget);
+
+        std::vector<Frame> frames;
+        frames.push_back(readChgFrame(readFileWithEncoding(path)));
+        const Frame& frame = frames.front();
+        if (frame.atoms.empty()) {
+            LOG_ERROR("No atoms read from " + path);
+            return false;
+        }
+
+        const std::string stem = std::filesystem::path(path).stem().string();
+        const std::vector<GaussianChargeMapping> mappings = mapGaussianChargeChannels(frame);
+        bool ok = true;
+        for (size_t g = 0; g < mappings.size(); ++g) {
+            const std::string name = stem + (g == 0 ? std::string() : "_" + std::to_string(g + 1)) + ".log";
+            ok = writeChargeLog(frames, mappings[g], directory / name) && ok;
+
+            mappingText += (g == 0 ? "" : "\n") + name + "\n";
+            for (int section = 0; section < 3; ++section) {
+                const int channel = mappings[g].channels[section];
+                std::string sectionName = gaussianChargeSectionName(section);
+                sectionName.resize(24, ' ');
+                std::string channelName = "None";
+                if (channel >= 0) {
+                    channelName = frame.chargeChannels.empty() ? "charge" : frame.chargeChannels[channel];
+                }
+                mappingText += "  " + sectionName + "<- " + channelName + "\n";
+            }
+        }
+        LOG_INFO("Wrote " + std::to_string(mappings.size()) + " log(s) for " + path + " (" +
+                 std::to_string(frame.chargeChannelCount()) + " charge channels)");
+        return ok;
+    } catch (const MemoryBudgetExceeded& e) {
+        LOG_ERROR("Conversion of " + path + " aborted: " + std::string(e.what()));
+        return false;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception converting " + path + ": " + std::string(e.what()));
+        return false;
+    }
+}
+
+} // namespace
+
+bool parseChargeDiffMode(std::string_view text, ChargeDiffMode& mode) {
+    if (equalsIgnoreCase(text, "reference")) {
+        mode = ChargeDiffMode::Reference;
+    } else if (equalsIgnoreCase(text, "consecutive")) {
+        mode = ChargeDiffMode::Consecutive;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* chargeDiffModeName(ChargeDiffMode mode) {
+    return mode == ChargeDiffMode::Consecutive ? "consecutive" : "reference";
+}
+
+std::vector<std::string> listChargeFiles(const std::string& directory) {
+    std::vector<std::string> files;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec) && lowerExtension(it->path()) == ".chg") {
+            files.push_back(it->path().string());
+        }
+    }
+    if (ec) {
+        LOG_ERROR("Failed to list " + directory + ": " + ec.message());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+bool loadChargeSets(const std::vector<std::string>& paths, ChargeSets& sets) {
+    sets = ChargeSets();
+    try {
+        if (paths.size() < 2) {
+            LOG_ERROR("At least two CHG files are needed for charge differences");
+            return false;
+        }
+
+        // 第一个文件确定原子数与元素顺序
+        Frame first = readChgFrame(readFileWithEncoding(paths[0]));
+        if (first.atoms.empty()) {
+            LOG_ERROR("No atoms read from " + paths[0]);
+            return false;
+        }
+        const size_t setCount = paths.size();
+        sets.atomCount = first.atoms.size();
+        for (const auto& atom : first.atoms) {
+            sets.symbols.push_back(atom.symbol);
+        }
+        for (const auto& path : paths) {
+            sets.names.push_back(std::filesystem::path(path).stem().string());
+        }
+        for (std::vector<double>* column : {&sets.x, &sets.y, &sets.z, &sets.charges}) {
+            column->resize(setCount * sets.atomCount);
+        }
+        storeChargeSet(first, sets, 0);
+
+        // 其余文件按下标分段，每个线程只写自己那几组
+        std::vector<char> loaded(setCount, 0);
+        loaded[0] = 1;
+        runChunks(setCount, hardwareConcurrency(), [&paths, &sets, &loaded](size_t begin, size_t end) {
+            for (size_t s = std::max<size_t>(begin, 1); s < end; ++s) {
+                try {
+                    Frame frame = readChgFrame(readFileWithEncoding(paths[s]));
+                    if (!sameSymbols(frame, sets.symbols)) {
+                        LOG_WARNING("Skipping " + paths[s] + ": " + std::to_string(frame.atoms.size()) +
+                                    " atoms or element order differ from " + sets.names[0]);
+                        continue;
+                    }
+                    storeChargeSet(frame, sets, s);
+                    loaded[s] = 1;
+                } catch (const MemoryBudgetExceeded&) {
+                    throw;
+                } catch (const std::exception& e) {
+                    LOG_ERROR("Exception reading " + paths[s] + ": " + std::string(e.what()));
+                }
+            }
+        });
+
+        size_t kept = 0;
+        std::vector<std::string> names;
+        for (size_t s = 0; s < setCount; ++s) {
+            if (!loaded[s]) {
+                continue;
+            }
+            if (kept != s) {
+                moveChargeSet(sets, s, kept);
+            }
+            names.push_back(sets.names[s]);
+            ++kept;
+        }
+        sets.names = std::move(names);
+        for (std::vector<double>* column : {&sets.x, &sets.y, &sets.z, &sets.charges}) {
+            column->resize(kept * sets.atomCount);
+        }
+
+        LOG_INFO("Loaded " + std::to_string(kept) + " of " + std::to_string(setCount) + " charge sets (" +
+                 std::to_string(sets.atomCount) + " atoms each)");
+        return kept >= 2;
+    } catch (const MemoryBudgetExceeded&) {
+        throw;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception loading charge sets: " + std::string(e.what()));
+        sets = ChargeSets();
+        return false;
+    }
+}
+
+bool computeChargeDifferences(const ChargeSets& sets, ChargeDiffMode mode, size_t reference, ChargeDiffResult& result) {
+    result = ChargeDiffResult();
+    result.atomCount = sets.atomCount;
+    for (size_t s = 0; s < sets.setCount(); ++s) {
+        if (mode == ChargeDiffMode::Reference && s != reference) {
+            result.minuend.push_back(s);
+            result.subtrahend.push_back(reference);
+        } else if (mode == ChargeDiffMode::Consecutive && s > 0) {
+            result.minuend.push_back(s);
+            result.subtrahend.push_back(s - 1);
+        }
+    }
+    const size_t count = result.minuend.size();
+    const size_t n = sets.atomCount;
+    if (count == 0 || n == 0 || (mode == ChargeDiffMode::Reference && reference >= sets.setCount())) {
+        LOG_ERROR("No charge differences to compute");
+        return false;
+    }
+
+    result.differences.resize(count * n);
+    result.sums.resize(count);
+    for (std::vector<double>* column : {&result.mean, &result.stddev, &result.minimum, &result.maximum}) {
+        column->resize(n);
+    }
+
+    const size_t chunks = chunkCountFor(count * n);
+    // 差值：按组分段
+    runChunks(count, chunks, [&sets, &result, n](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            result.sums[k] = subtractCharges(sets.chargesOf(result.minuend[k]), sets.chargesOf(result.subtrahend[k]),
+                                             result.differences.data() + k * n, n);
+        }
+    });
+    // 统计：按原子块分段
+    const size_t blockCount = (n + BLOCK_ATOMS - 1) / BLOCK_ATOMS;
+    runChunks(blockCount, chunks, [&result, n](size_t begin, size_t end) {
+        for (size_t block = begin; block < end; ++block) {
+            computeStatistics(result, block * BLOCK_ATOMS, std::min(n, (block + 1) * BLOCK_ATOMS));
+        }
+    });
+
+    LOG_INFO("Computed " + std::to_string(count) + " charge differences (" + chargeDiffModeName(mode) + ", " +
+             std::to_string(n) + " atoms, " + std::to_string(std::min(chunks, count)) + " threads)");
+    return true;
+}
+
+Frame chargeDifferenceFrame(const ChargeSets& sets, const ChargeDiffResult& result, size_t k) {
+    Frame frame;
+    const size_t n = sets.atomCount;
+    const size_t offset = result.minuend[k] * n;
+    const double* differences = result.differencesOf(k);
+    frame.atoms.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        Atom& atom = frame.atoms[i];
+        atom.symbol = sets.symbols[i];
+        atom.x = sets.x[offset + i];
+        atom.y = sets.y[offset + i];
+        atom.z = sets.z[offset + i];
+        atom.charge = differences[i];
+    }
+    frame.comment = "Charge difference " + sets.names[result.minuend[k]] + " - " + sets.names[result.subtrahend[k]];
+    return frame;
+}
+
+Frame chargeMeanFrame(const ChargeSets& sets, const ChargeDiffResult& result) {
+    Frame frame;
+    frame.atoms.resize(sets.atomCount);
+    for (size_t i = 0; i < sets.atomCount; ++i) {
+        Atom& atom = frame.atoms[i];
+        atom.symbol = sets.symbols[i];
+        atom.x = sets.x[i];
+        atom.y = sets.y[i];
+        atom.z = sets.z[i];
+        atom.charge = result.mean[i];
+    }
+    frame.comment = "Mean charge difference over " + std::to_string(result.differenceCount()) + " pairs";
+    return frame;
+}
+
+bool runChargeDiffBatch(const std::vector<std::string>& inputs, const ChargeDiffOptions& options) {
+    try {
+        std::vector<const OutputWriter*> writers;
+        for (const auto& format : options.formats) {
+            const OutputWriter* writer = findOutputWriter(format);
+            if (!writer) {
+                LOG_ERROR("Unknown output format '" + format + "' (available: " + outputWriterNames() + ")");
+                return false;
+            }
+            writers.push_back(writer);
+        }
+        if (writers.empty()) {
+            LOG_ERROR("No output format given");
+            return false;
+        }
+
+        // 目录展开为其中的 .chg 文件；Reference 模式下指定的参考文件放在第一位
+        std::vector<std::string> paths;
+        for (const auto& input : inputs) {
+            std::error_code ec;
+            if (std::filesystem::is_directory(input, ec)) {
+                std::vector<std::string> files = listChargeFiles(input);
+                paths.insert(paths.end(), files.begin(), files.end());
+            } else {
+                paths.push_back(input);
+            }
+        }
+        if (options.mode == ChargeDiffMode::Reference && !options.reference.empty()) {
+            paths.erase(std::remove_if(paths.begin(), paths.end(), [&options](const std::string& path) {
+                std::error_code ec;
+                return std::filesystem::equivalent(path, options.reference, ec);
+            }), paths.end());
+            paths.insert(paths.begin(), options.reference);
+        }
+        if (paths.size() < 2) {
+            LOG_ERROR("At least two CHG files are needed for charge differences (got " + std::to_string(paths.size()) +
+                      ")");
+            return false;
+        }
+        LOG_INFO("Charge differences over " + std::to_string(paths.size()) + " files (" +
+                 chargeDiffModeName(options.mode) + ")");
+
+        MemoryBudget budget(static_cast<size_t>(g_config.maxMemoryMB) * 1024 * 1024);
+        MemoryBudgetScope budgetScope(budget);
+
+        ChargeSets sets;
+        if (!loadChargeSets(paths, sets)) {
+            return false;
+        }
+        TrackedBytes setBytes;
+        setBytes.update(4 * sets.charges.capacity() * sizeof(double));
+
+        ChargeDiffResult result;
+        if (!computeChargeDifferences(sets, options.mode, 0, result)) {
+            return false;
+        }
+        TrackedBytes resultBytes;
+        resultBytes.update((result.differences.capacity() + 4 * result.atomCount) * sizeof(double));
+
+        std::filesystem::path directory = options.outputDir.empty()
+            ? std::filesystem::path(paths[0]).parent_path() / DEFAULT_OUTPUT_SUBDIR
+            : std::filesystem::path(options.outputDir);
+        std::filesystem::create_directories(directory);
+
+        // 每组差值一个文件，按组分给多个线程写出
+        std::vector<char> written(result.differenceCount(), 0);
+        runChunks(result.differenceCount(), hardwareConcurrency(),
+                  [&sets, &result, &writers, &directory, &written](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                try {
+                    const std::string stem = sets.names[result.minuend[k]] + "_minus_" +
+                                             sets.names[result.subtrahend[k]];
+                    bool ok = true;
+                    for (const OutputWriter* writer : writers) {
+                        ok = writeChargeFrame(*writer, chargeDifferenceFrame(sets, result, k),
+                                              directory / (stem + writer->extension)) && ok;
+                    }
+                    written[k] = ok ? 1 : 0;
+                } catch (const MemoryBudgetExceeded&) {
+                    throw;
+                } catch (const std::exception& e) {
+                    LOG_ERROR("Exception writing charge difference " + std::to_string(k + 1) + ": " +
+                              std::string(e.what()));
+                }
+            }
+        });
+
+        bool allWritten = std::all_of(written.begin(), written.end(), [](char ok) { return ok != 0; });
+        for (const OutputWriter* writer : writers) {
+            allWritten = writeChargeFrame(*writer, chargeMeanFrame(sets, result),
+                                          directory / (std::string("chg_diff_mean") + writer->extension)) &&
+                         allWritten;
+        }
+        allWritten = writeSummary(sets, result, options.mode, directory / "chg_diff_summary.txt") && allWritten;
+
+        LOG_INFO("Wrote " + std::to_string(result.differenceCount()) + " charge differences to " + directory.string());
+        LOG_INFO("Conversion memory: " + budget.summary());
+        return allWritten;
+    } catch (const MemoryBudgetExceeded& e) {
+        LOG_ERROR("Charge difference batch aborted: " + std::string(e.what()));
+        return false;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception in runChargeDiffBatch: " + std::string(e.what()));
+        return false;
+    }
+}
+
+bool runChargeLogBatch(const std::vector<std::string>& inputs, const std::string& outputDir) {
+    try {
+        std::vector<std::string> paths;
+        for (const auto& input : inputs) {
+            std::error_code ec;
+            if (std::filesystem::is_directory(input, ec)) {
+                std::vector<std::string> files = listChargeFiles(input);
+                paths.insert(paths.end(), files.begin(), files.end());
+            } else {
+                paths.push_back(input);
+            }
+        }
+        if (paths.empty()) {
+            LOG_ERROR("No CHG files to convert");
+            return false;
+        }
+
+        std::filesystem::path directory = outputDir.empty() ? std::filesystem::path(paths[0]).parent_path()
+                                                            : std::filesystem::path(outputDir);
+        if (!directory.empty()) {
+            std::filesystem::create_directories(directory);
+        }
+
+        // 按文件分段，各线程的内存预算平分 max_memory_mb
+        const size_t threadCount = std::min<size_t>(hardwareConcurrency(), paths.size());
+        const size_t limitBytes = static_cast<size_t>(g_config.maxMemoryMB) * 1024 * 1024 / threadCount;
+        LOG_INFO("Converting " + std::to_string(paths.size()) + " CHG file(s) to Gaussian logs with " +
+                 std::to_string(threadCount) + " thread(s)");
+        std::vector<std::string> mappingTexts(paths.size());
+        std::vector<char> converted(paths.size(), 0);
+        runChunks(paths.size(), threadCount,
+                  [&paths, &directory, limitBytes, &mappingTexts, &converted](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                converted[i] = convertChargeChannels(paths[i], directory, limitBytes, mappingTexts[i]) ? 1 : 0;
+            }
+        });
+
+        // 映射表按输入顺序写出
+        const std::filesystem::path mappingPath = directory / "chg_log_mapping.txt";
+        std::ofstream mapping(mappingPath.string());
+        if (!mapping) {
+            LOG_ERROR("Failed to create " + mappingPath.string());
+            return false;
+        }
+        mapping << "# Charge channel -> Gaussian log section\n";
+        mapping << "# Preferences: *mulliken* -> Mulliken charges, *hirshfeld* -> APT charges, "
+                   "*adch* -> Mulliken spin densities, others -> next free section\n";
+        for (const auto& text : mappingTexts) {
+            if (!text.empty()) {
+                mapping << "\n" << text;
+            }
+        }
+
+        const size_t convertedCount = static_cast<size_t>(std::count(converted.begin(), converted.end(), 1));
+        LOG_INFO("Converted " + std::to_string(convertedCount) + " of " + std::to_string(paths.size()) +
+                 " CHG file(s) to Gaussian logs in " + directory.string());
+        return convertedCount == paths.size() && static_cast<bool>(mapping);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception in runChargeLogBatch: " + std::string(e.what()));
+        return false;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "core.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 批量电荷差（new_idea/chg_diff.cpp 只能比较两个文件，这里推广到任意多组）：
+// - N 组同一体系的 CHG 电荷读入连续的 SoA 数组：每组的 x/y/z/电荷各占 atomCount 个 double，组与组首尾相接
+// - 按参考组或相邻组求差（差值 = 被减组 - 减组，与 chg_diff 的 chg1 - chg2 相同），并统计每组差值的总和
+//   以及每个原子在全部差值上的均值、标准差、最小值与最大值
+// 核心循环在 x86-64 上用 SSE2 一次处理两个原子；文件读取、差值计算、统计与写出都分给多个线程。
+// 另有多电荷列 CHG 的批量日志转换（runChargeLogBatch），同样按文件分给多个线程。
+
+enum class ChargeDiffMode {
+    Reference,      // 每组 - 参考组
+    Consecutive     // 每组 - 前一组
+};
+
+// "reference" / "consecutive"（不区分大小写），无法识别时返回 false
+bool parseChargeDiffMode(std::string_view text, ChargeDiffMode& mode);
+const char* chargeDiffModeName(ChargeDiffMode mode);
+
+// N 组电荷，第 s 组第 i 个原子位于下标 s * atomCount + i
+struct ChargeSets {
+    size_t atomCount = 0;
+    std::vector<std::string> symbols;       // 各组元素相同，只保存一份
+    std::vector<std::string> names;         // 每组的名称（文件名去扩展名）
+    std::vector<double> x, y, z, charges;
+
+    size_t setCount() const { return names.size(); }
+    const double* chargesOf(size_t set) const { return charges.data() + set * atomCount; }
+};
+
+// 差值与统计，第 k 组差值 = 第 minuend[k] 组 - 第 subtrahend[k] 组
+struct ChargeDiffResult {
+    size_t atomCount = 0;
+    std::vector<size_t> minuend;
+    std::vector<size_t> subtrahend;
+    std::vector<double> differences;        // differenceCount() * atomCount
+    std::vector<double> sums;               // 每组差值的总和
+    std::vector<double> mean, stddev, minimum, maximum;     // 每个原子在全部差值上的统计（总体标准差）
+
+    size_t differenceCount() const { return sums.size(); }
+    const double* differencesOf(size_t k) const { return differences.data() + k * atomCount; }
+};
+
+// 目录中的 .chg 文件，按文件名排序
+std::vector<std::string> listChargeFiles(const std::string& directory);
+
+// 读取 CHG 文件（按文件分给多个线程）。原子数或元素顺序与第一个文件不同的文件被跳过；
+// 读到的组少于两组时返回 false
+bool loadChargeSets(const std::vector<std::string>& paths, ChargeSets& sets);
+
+// Reference 模式下 reference 为参考组下标，其余各组与之求差；Consecutive 模式忽略 reference
+bool computeChargeDifferences(const ChargeSets& sets, ChargeDiffMode mode, size_t reference, ChargeDiffResult& result);
+
+// 第 k 组差值作为一帧：坐标取被减组，电荷为差值
+Frame chargeDifferenceFrame(const ChargeSets& sets, const ChargeDiffResult& result, size_t k);
+// 平均差值作为一帧：坐标取第一组
+Frame chargeMeanFrame(const ChargeSets& sets, const ChargeDiffResult& result);
+
+struct ChargeDiffOptions {
+    ChargeDiffMode mode = ChargeDiffMode::Reference;
+    std::string reference;                      // 参考文件（为空时取第一个输入；Consecutive 模式忽略）
+    std::vector<std::string> formats{"chg"};    // 输出格式（output_writers.h 中的格式名）
+    std::string outputDir;                      // 为空时为第一个输入所在目录下的 chg_diff 子目录
+};
+
+// 命令行入口：inputs 为 .chg 文件或目录（目录取其中全部 .chg 文件）。
+// 每组差值写成 <被减组>_minus_<减组><扩展名>，另写出 chg_diff_mean<扩展名>（平均差值）
+// 与 chg_diff_summary.txt（每组差值的总和、每个原子的统计）。全部写出成功时返回 true
+bool runChargeDiffBatch(const std::vector<std::string>& inputs, const ChargeDiffOptions& options);
+
+// 多电荷列 CHG -> 伪 Gaussian 日志（取代 new_idea/ChargefakeG.sh）：inputs 为 .chg 文件或目录，按文件分给多个线程。
+// 各电荷通道按 mapGaussianChargeChannels 放到 Mulliken / APT / 自旋密度三个位置；超过三个通道时
+// 第一组写成 <文件名>.log，其余依次写成 <文件名>_2.log、<文件名>_3.log…。
+// 另在输出目录写出 chg_log_mapping.txt（每个日志中各位置对应的通道）。
+// outputDir 为空时与第一个输入同目录。全部文件转换成功时返回 true
+bool runChargeLogBatch(const std::vector<std::string>& inputs, const std::string& outputDir);
@@ -0,0 +1,187 @@
+#include "clipboard_watcher.h"
+#include "converter.h"
+#include "logger.h"
+#include <chrono>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+GaussianClipboardWatcher g_clipboardWatcher;
+
+ClipboardFileStamp readClipboardFileStamp(const std::string& path) {
+    ClipboardFileStamp stamp;
+    std::error_code ec;
+    std::filesystem::path filePath(path);
+    auto modified = std::filesystem::last_write_time(filePath, ec);
+    if (ec) {
+        return stamp;
+    }
+    uintmax_t size = std::filesystem::file_size(filePath, ec);
+    if (ec) {
+        return stamp;
+    }
+    stamp.modified = static_cast<int64_t>(modified.time_since_epoch().count());
+    stamp.size = size;
+    stamp.exists = true;
+    return stamp;
+}
+
+GaussianClipboardWatcher::GaussianClipboardWatcher() {}
+
+GaussianClipboardWatcher::~GaussianClipboardWatcher() {
+    stop();
+}
+
+bool GaussianClipboardWatcher::start(const std::string& path) {
+    stop();
+    if (path.empty()) {
+        return false;
+    }
+    m_stop.reset();
+    if (!m_thread.start([this, path]() { run(path); })) {
+        LOG_ERROR("Failed to start Gaussian clipboard watcher");
+        return false;
+    }
+    LOG_INFO("Watching Gaussian clipboard file: " + path);
+    return true;
+}
+
+void GaussianClipboardWatcher::stop() {
+    m_stop.set();
+    m_thread.join();
+}
+
+std::shared_ptr<const ClipboardFileSnapshot> GaussianClipboardWatcher::load(const std::string& path) {
+    ClipboardFileStamp stamp = readClipboardFileStamp(path);
+    {
+        LockGuard lock(m_mutex);
+        if (m_snapshot && m_snapshot->path == path && m_snapshot->stamp == stamp) {
+            m_hits++;
+            LOG_DEBUG("Using pre-parsed Gaussian clipboard (" + std::to_string(m_snapshot->atoms.size()) + " atoms)");
+            return m_snapshot;
+        }
+    }
+
+    // 缓存不存在或已过期（监视未启动、文件刚被改写、路径已更改）：同步解析。
+    // load 在任务队列的工作线程上运行，这里不重启监视线程：start/stop 只由 UI 线程调用，
+    // 路径更改后由重新加载配置时的 startClipboardWatcher 切换
+    m_misses++;
+    try {
+        auto snapshot = parse(path, stamp);
+        store(snapshot);
+        return snapshot;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception loading Gaussian clipboard: " + std::string(e.what()));
+        return nullptr;
+    }
+}
+
+void GaussianClipboardWatcher::run(const std::string& path) {
+#ifdef _WIN32
+    // 监视文件所在目录；目录里其他文件的变化也会唤醒，由 refresh() 按文件状态过滤
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    if (directory.empty()) {
+        directory = ".";
+    }
+    HANDLE change = FindFirstChangeNotificationA(directory.string().c_str(), FALSE,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_FILE_NAME);
+    if (change == INVALID_HANDLE_VALUE) {
+        LOG_WARNING("Change notifications unavailable for " + directory.string() + " (Error: " +
+                    std::to_string(GetLastError()) + "), polling every " + std::to_string(POLL_INTERVAL_MS) + " ms");
+    }
+#endif
+
+    refresh(path);
+
+    while (true) {
+        bool stopRequested = false;
+#ifdef _WIN32
+        if (change != INVALID_HANDLE_VALUE) {
+            HANDLE handles[2] = {static_cast<HANDLE>(m_stop.nativeHandle()), change};
+            DWORD result = WaitForMultipleObjects(2, handles, FALSE, POLL_INTERVAL_MS);
+            if (result == WAIT_OBJECT_0) {
+                stopRequested = true;
+            } else if (result == WAIT_OBJECT_0 + 1) {
+                FindNextChangeNotification(change);
+            } else if (result == WAIT_FAILED) {
+                LOG_WARNING("Waiting for change notification failed, falling back to polling");
+                FindCloseChangeNotification(change);
+                change = INVALID_HANDLE_VALUE;
+            }
+        } else {
+            stopRequested = m_stop.wait(POLL_INTERVAL_MS);
+        }
+#else
+        stopRequested = m_stop.wait(POLL_INTERVAL_MS);
+#endif
+        if (stopRequested) {
+            break;
+        }
+        refresh(path);
+    }
+
+#ifdef _WIN32
+    if (change != INVALID_HANDLE_VALUE) {
+        FindCloseChangeNotification(change);
+    }
+#endif
+}
+
+bool GaussianClipboardWatcher::refresh(const std::string& path) {
+    try {
+        ClipboardFileStamp stamp = readClipboardFileStamp(path);
+        {
+            LockGuard lock(m_mutex);
+            if (m_snapshot && m_snapshot->path == path && m_snapshot->stamp == stamp) {
+                return false;
+            }
+        }
+
+        // GView 可能分几次写完文件：等状态稳定后再读
+        for (int attempt = 0; attempt < 10 && stamp.exists; ++attempt) {
+            if (m_stop.wait(SETTLE_MS)) {
+                return false;
+            }
+            ClipboardFileStamp settled = readClipboardFileStamp(path);
+            if (settled == stamp) {
+                break;
+            }
+            stamp = settled;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto snapshot = parse(path, stamp);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        store(snapshot);
+        m_backgroundParses++;
+        LOG_DEBUG("Gaussian clipboard re-parsed in background: " + std::to_string(snapshot->atoms.size()) +
+                  " atoms in " + std::to_string(elapsed.count()) + " us");
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception refreshing Gaussian clipboard: " + std::string(e.what()));
+        return false;
+    }
+}
+
+std::shared_ptr<const ClipboardFileSnapshot> GaussianClipboardWatcher::parse(const std::string& path,
+                                                                              const ClipboardFileStamp& stamp) {
+    auto snapshot = std::make_shared<ClipboardFileSnapshot>();
+    snapshot->path = path;
+    snapshot->stamp = stamp;
+    if (!stamp.exists) {
+        LOG_DEBUG("Gaussian clipboard file does not exist: " + path);
+        return snapshot;
+    }
+    snapshot->atoms = parseGaussianClipboard(path);
+    if (!snapshot->atoms.empty()) {
+        snapshot->xyz = createXYZString(snapshot->atoms);
+    }
+    return snapshot;
+}
+
+void GaussianClipboardWatcher::store(const std::shared_ptr<const ClipboardFileSnapshot>& snapshot) {
+    LockGuard lock(m_mutex);
+    m_snapshot = snapshot;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "core.h"
+#include "threading.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// GView 剪贴板文件（Clipboard.frg）监视与预解析：
+// - 后台线程监视 gaussian_clipboard_path：Windows 下用目录变更通知唤醒，同时按 POLL_INTERVAL_MS 轮询兜底
+//   （网络盘等无法建立通知时只轮询）
+// - 文件修改时间或大小变化后，在后台重新读取、解析并格式化为 XYZ 文本
+// - 反向热键只需核对文件状态（一次 stat）并复制缓存的结果；缓存过期时才同步解析
+
+// 文件状态（修改时间 + 大小），用于判断缓存是否仍然有效
+struct ClipboardFileStamp {
+    int64_t modified = 0;
+    uintmax_t size = 0;
+    bool exists = false;
+
+    bool operator==(const ClipboardFileStamp& other) const {
+        return exists == other.exists && modified == other.modified && size == other.size;
+    }
+    bool operator!=(const ClipboardFileStamp& other) const { return !(*this == other); }
+};
+
+// 读取文件状态（文件不存在时 exists 为 false）
+ClipboardFileStamp readClipboardFileStamp(const std::string& path);
+
+// 一次解析的结果
+struct ClipboardFileSnapshot {
+    std::string path;
+    ClipboardFileStamp stamp;   // 读取前记录的文件状态
+    std::vector<Atom> atoms;
+    std::string xyz;            // createXYZString 的结果
+};
+
+class GaussianClipboardWatcher {
+public:
+    static constexpr unsigned int POLL_INTERVAL_MS = 500;   // 轮询间隔
+    static constexpr unsigned int SETTLE_MS = 30;           // 检测到变化后等待写入完成再解析
+
+    GaussianClipboardWatcher();
+    ~GaussianClipboardWatcher();
+
+    // 开始监视 path（已在监视其他路径时先停止），启动时立即解析一次。
+    // start/stop 不是线程安全的，只在 UI 线程调用
+    bool start(const std::string& path);
+    void stop();
+    bool running() const { return m_thread.joinable(); }
+
+    // 取得 path 的解析结果：缓存与文件当前状态一致时直接返回；否则同步解析并更新缓存。
+    // 可在任意线程调用；不会启动或切换监视线程。读取失败时返回 nullptr
+    std::shared_ptr<const ClipboardFileSnapshot> load(const std::string& path);
+
+    // 统计：热键命中缓存次数、热键同步解析次数、后台解析次数
+    size_t cacheHits() const { return m_hits.load(); }
+    size_t cacheMisses() const { return m_misses.load(); }
+    size_t backgroundParses() const { return m_backgroundParses.load(); }
+
+private:
+    void run(const std::string& path);
+    // 文件状态变化时重新解析，返回是否更新了缓存
+    bool refresh(const std::string& path);
+    std::shared_ptr<const ClipboardFileSnapshot> parse(const std::string& path, const ClipboardFileStamp& stamp);
+    void store(const std::shared_ptr<const ClipboardFileSnapshot>& snapshot);
+
+    std::shared_ptr<const ClipboardFileSnapshot> m_snapshot;
+    mutable Mutex m_mutex;
+    Event m_stop{true};
+    Thread m_thread;
+    std::atomic<size_t> m_hits{0};
+    std::atomic<size_t> m_misses{0};
+    std::atomic<size_t> m_backgroundParses{0};
+};
+
+// 全局实例（托盘模式下启动；反向热键经它取得解析结果）
+extern GaussianClipboardWatcher g_clipboardWatcher;
@@ -1,15 +1,17 @@
 #include "config.h"
 #include "logger.h"
 #include "core.h"
+#include "periodic.h"
+#include "platform.h"
+#include "plugin_executor.h"
+#include "plugin_host.h"
 #include <fstream>
 #include <iostream>
 #include <algorithm>
 #include <filesystem>
 #include <vector>
 #include <cctype>
-
-// 声明外部函数
-extern void showTrayNotification(const std::string& title, const std::string& message, DWORD iconType = NIIF_INFO);
+#include <cstdlib>
 
 // 全局配置实例
 Config g_config;
@@ -27,6 +29,8 @@ void applyRuntimeDefaults(Config& cfg) {
     std::string exeDir = getExecutableDirectory();
     if (cfg.gviewPath.empty()) cfg.gviewPath = "gview.exe";
     if (cfg.gaussianClipboardPath.empty()) cfg.gaussianClipboardPath = "Clipboard.frg";
+    if (cfg.hotkeyFormat.empty()) cfg.hotkeyFormat = "gaussian_log";
+    if (cfg.hotkeyReverseFormat.empty()) cfg.hotkeyReverseFormat = "xyz";
 
     if (cfg.tempDir.empty()) {
         cfg.tempDir = exeDir.empty() ? "temp" : (exeDir + "\\temp");
@@ -51,6 +55,9 @@ bool writeDefaultConfigFile(const std::string& configFile) {
     outFile << "[main]\n";
     outFile << "hotkey=CTRL+ALT+X\n";
     outFile << "hotkey_reverse=CTRL+ALT+G\n";
+    outFile << "# Output formats: gaussian_log, xyz, extxyz, pdb, mol2, chg, pqr, gjf\n";
+    outFile << "hotkey_format=gaussian_log\n";
+    outFile << "hotkey_reverse_format=xyz\n";
     outFile << "gview_path=gview.exe\n";
     outFile << "gaussian_clipboard_path=Clipboard.frg\n";
     outFile << "temp_dir=" << tempDirPath << "\n";
@@ -66,12 +73,28 @@ bool writeDefaultConfigFile(const std::string& configFile) {
     outFile << "# XYZ Converter Column Definitions (1-based indexing)\n";
     outFile << "element_column=1\n";
     outFile << "xyz_columns=2,3,4\n";
+    outFile << "# Decimal places of coordinates in XYZ output (0-15)\n";
+    outFile << "xyz_precision=6\n";
+    outFile << "# Periodic cells (Tv rows, Lattice=): none, wrap (atoms into the cell), unwrap (whole molecules, continuous trajectory)\n";
+    outFile << "periodic_mode=none\n";
     outFile << "# CHG Format Support (format: Element X Y Z Charge)\n";
     outFile << "try_parse_chg_format=false\n";
+    outFile << "# Optional vdW radii overrides for PQR output (lines of: Element Radius)\n";
+    outFile << "vdw_radii_file=\n";
+    outFile << "# Gaussian input (gjf) output; {name}, {frame} and {comment} are expanded in route, title and chk\n";
+    outFile << "gjf_route=#p B3LYP/6-31G(d) opt\n";
+    outFile << "gjf_title={name} frame {frame}\n";
+    outFile << "gjf_charge=0\n";
+    outFile << "gjf_multiplicity=1\n";
+    outFile << "gjf_chk={name}.chk\n";
+    outFile << "gjf_nproc=0\n";
+    outFile << "gjf_mem=\n";
     outFile << "# Log file viewers\n";
     outFile << "orca_log_viewer=notepad.exe\n";
     outFile << "gaussian_log_viewer=gview.exe\n";
     outFile << "other_log_viewer=notepad.exe\n";
+    outFile << "# Plugins: at most this many plugin processes run at once\n";
+    outFile << "plugin_max_concurrent=4\n";
     outFile.close();
     return true;
 }
@@ -94,6 +117,20 @@ bool parseBoolValue(const std::string& value, bool defaultValue = false) {
     return defaultValue;
 }
 
+// 插件分区对应的插件，还没有时新建
+Plugin& pluginForSection(const std::string& section) {
+    for (auto& plugin : g_config.plugins) {
+        if (plugin.name == section) {
+            return plugin;
+        }
+    }
+    Plugin newPlugin;
+    newPlugin.name = section;
+    g_config.plugins.push_back(newPlugin);
+    return g_config.plugins.back();
+}
+
+#ifdef _WIN32
 bool parseFunctionKey(const std::string& key, UINT& vk) {
     if (key.size() < 2 || key[0] != 'F') {
         return false;
@@ -146,6 +183,32 @@ bool parseNamedVirtualKey(const std::string& key, UINT& vk) {
 
     return false;
 }
+#endif
+
+// 查询环境变量，不存在时返回 false
+bool lookupEnvironmentVariable(const std::string& name, std::string& value) {
+#ifdef _WIN32
+    DWORD required = GetEnvironmentVariableA(name.c_str(), NULL, 0);
+    if (required == 0) {
+        return false;
+    }
+    value.resize(required);
+    DWORD written = GetEnvironmentVariableA(name.c_str(), value.data(), required);
+    if (written == 0) {
+        return false;
+    }
+    // GetEnvironmentVariableA writes without the terminating null when using std::string buffer.
+    value.resize(written);
+    return true;
+#else
+    const char* env = std::getenv(name.c_str());
+    if (env == nullptr) {
+        return false;
+    }
+    value = env;
+    return true;
+#endif
+}
 
 } // namespace
 
@@ -196,22 +259,12 @@ std::string expandEnvironmentVariables(const std::string& input) {
         }
 
         // Query environment variable
-        DWORD required = GetEnvironmentVariableA(var.c_str(), NULL, 0);
-        if (required == 0) {
+        std::string value;
+        if (lookupEnvironmentVariable(var, value)) {
+            out.append(value);
+        } else {
             // not found, keep original %VAR%
             out.append(input.substr(i, end - i + 1));
-        } else {
-            std::string value;
-            value.resize(required);
-            DWORD written = GetEnvironmentVariableA(var.c_str(), value.data(), required);
-            if (written > 0) {
-                // GetEnvironmentVariableA writes without the terminating null when using std::string buffer.
-                value.resize(written);
-                out.append(value);
-            } else {
-                // unexpected; keep original
-                out.append(input.substr(i, end - i + 1));
-            }
         }
 
         i = end + 1;
@@ -353,6 +406,10 @@ bool loadConfig(const std::string& configFile) {
                         g_config.hotkey = value;
                     } else if (key == "hotkey_reverse") {
                         g_config.hotkeyReverse = value;
+                    } else if (key == "hotkey_format") {
+                        g_config.hotkeyFormat = value;
+                    } else if (key == "hotkey_reverse_format") {
+                        g_config.hotkeyReverseFormat = value;
                     } else if (key == "gview_path") {
                         g_config.gviewPath = value;
                     } else if (key == "gaussian_clipboard_path") {
@@ -387,48 +444,78 @@ bool loadConfig(const std::string& configFile) {
                             g_config.yColumn = std::stoi(trim(parts[1]));
                             g_config.zColumn = std::stoi(trim(parts[2]));
                         }
+                    } else if (key == "xyz_precision") {
+                        g_config.xyzPrecision = std::stoi(value);
+                        if (g_config.xyzPrecision < 0 || g_config.xyzPrecision > 15) {
+                            LOG_WARNING("xyz_precision out of range (" + value + "), clamping to 0-15");
+                            g_config.xyzPrecision = std::min(std::max(g_config.xyzPrecision, 0), 15);
+                        }
+                    } else if (key == "periodic_mode") {
+                        PeriodicMode mode;
+                        if (parsePeriodicMode(value, mode)) {
+                            g_config.periodicMode = periodicModeName(mode);
+                        } else {
+                            LOG_WARNING("Unknown periodic_mode: " + value + ", using none");
+                            g_config.periodicMode = "none";
+                        }
                     } else if (key == "try_parse_chg_format") {
                         g_config.tryParseChgFormat = parseBoolValue(value, g_config.tryParseChgFormat);
+                    } else if (key == "vdw_radii_file") {
+                        g_config.vdwRadiiFile = value;
+                    } else if (key == "gjf_route") {
+                        g_config.gjfRoute = value;
+                    } else if (key == "gjf_title") {
+                        g_config.gjfTitle = value;
+                    } else if (key == "gjf_charge") {
+                        g_config.gjfCharge = std::stoi(value);
+                    } else if (key == "gjf_multiplicity") {
+                        g_config.gjfMultiplicity = std::stoi(value);
+                        if (g_config.gjfMultiplicity < 1) {
+                            LOG_WARNING("gjf_multiplicity must be at least 1 (" + value + "), using 1");
+                            g_config.gjfMultiplicity = 1;
+                        }
+                    } else if (key == "gjf_chk") {
+                        g_config.gjfChk = value;
+                    } else if (key == "gjf_nproc") {
+                        g_config.gjfNproc = std::max(std::stoi(value), 0);
+                    } else if (key == "gjf_mem") {
+                        g_config.gjfMem = value;
                     } else if (key == "orca_log_viewer") {
                         g_config.orcaLogViewer = value;
                     } else if (key == "gaussian_log_viewer") {
                         g_config.gaussianLogViewer = value;
                     } else if (key == "other_log_viewer") {
                         g_config.otherLogViewer = value;
+                    } else if (key == "plugin_max_concurrent") {
+                        g_config.pluginMaxConcurrent = std::stoi(value);
+                        if (g_config.pluginMaxConcurrent < 1) {
+                            LOG_WARNING("plugin_max_concurrent must be at least 1 (" + value + "), using 1");
+                            g_config.pluginMaxConcurrent = 1;
+                        }
                     }
                 } else {
                     // 处理插件配置
                     if (key == "cmd") {
-                        // 查找或创建插件
-                        bool found = false;
-                        for (auto& plugin : g_config.plugins) {
-                            if (plugin.name == currentSection) {
-                                plugin.cmd = value;
-                                found = true;
-                                break;
-                            }
-                        }
-                        if (!found) {
-                            Plugin newPlugin;
-                            newPlugin.name = currentSection;
-                            newPlugin.cmd = value;
-                            g_config.plugins.push_back(newPlugin);
-                        }
+                        pluginForSection(currentSection).cmd = value;
                     } else if (key == "hotkey") {
-                        // 查找或创建插件
-                        bool found = false;
-                        for (auto& plugin : g_config.plugins) {
-                            if (plugin.name == currentSection) {
-                                plugin.hotkey = value;
-                                found = true;
-                                break;
-                            }
-                        }
-                        if (!found) {
-                            Plugin newPlugin;
-                            newPlugin.name = currentSection;
-                            newPlugin.hotkey = value;
-                            g_config.plugins.push_back(newPlugin);
+                        pluginForSection(currentSection).hotkey = value;
+                    } else if (key == "resident") {
+                        Plugin& plugin = pluginForSection(currentSection);
+                        plugin.resident = parseBoolValue(value, plugin.resident);
+                    } else if (key == "shared_memory") {
+                        Plugin& plugin = pluginForSection(currentSection);
+                        plugin.sharedMemory = parseBoolValue(value, plugin.sharedMemory);
+                    } else if (key == "library") {
+                        pluginForSection(currentSection).library = value;
+                    } else if (key == "max_concurrent") {
+                        pluginForSection(currentSection).maxConcurrent = static_cast<unsigned int>(std::stoul(value));
+                    } else if (key == "timeout") {
+                        pluginForSection(currentSection).timeoutSeconds = static_cast<unsigned int>(std::stoul(value));
+                    } else if (key == "on_busy") {
+                        Plugin& plugin = pluginForSection(currentSection);
+                        if (!parsePluginBusyPolicy(value, plugin.coalesceRuns)) {
+                            LOG_WARNING("Unknown on_busy for plugin '" + plugin.name + "': " + value + ", using coalesce");
+                            plugin.coalesceRuns = true;
                         }
                     }
                 }
@@ -465,6 +552,9 @@ bool saveConfig(const std::string& configFile) {
         file << "[main]\n";
         file << "hotkey=" << g_config.hotkey << "\n";
         file << "hotkey_reverse=" << g_config.hotkeyReverse << "\n";
+        file << "# Output formats: gaussian_log, xyz, extxyz, pdb, mol2, chg, pqr, gjf\n";
+        file << "hotkey_format=" << g_config.hotkeyFormat << "\n";
+        file << "hotkey_reverse_format=" << g_config.hotkeyReverseFormat << "\n";
         file << "gview_path=" << g_config.gviewPath << "\n";
         file << "gaussian_clipboard_path=" << g_config.gaussianClipboardPath << "\n";
         file << "temp_dir=" << g_config.tempDir << "\n";
@@ -480,21 +570,57 @@ bool saveConfig(const std::string& configFile) {
         file << "# XYZ Converter Column Definitions (1-based indexing)\n";
         file << "element_column=" << g_config.elementColumn << "\n";
         file << "xyz_columns=" << g_config.xColumn << "," << g_config.yColumn << "," << g_config.zColumn << "\n";
+        file << "# Decimal places of coordinates in XYZ output (0-15)\n";
+        file << "xyz_precision=" << g_config.xyzPrecision << "\n";
+        file << "# Periodic cells (Tv rows, Lattice=): none, wrap (atoms into the cell), unwrap (whole molecules, continuous trajectory)\n";
+        file << "periodic_mode=" << g_config.periodicMode << "\n";
         file << "# CHG Format Support (format: Element X Y Z Charge)\n";
         file << "try_parse_chg_format=" << (g_config.tryParseChgFormat ? "true" : "false") << "\n";
+        file << "# Optional vdW radii overrides for PQR output (lines of: Element Radius)\n";
+        file << "vdw_radii_file=" << g_config.vdwRadiiFile << "\n";
+        file << "# Gaussian input (gjf) output; {name}, {frame} and {comment} are expanded in route, title and chk\n";
+        file << "gjf_route=" << g_config.gjfRoute << "\n";
+        file << "gjf_title=" << g_config.gjfTitle << "\n";
+        file << "gjf_charge=" << g_config.gjfCharge << "\n";
+        file << "gjf_multiplicity=" << g_config.gjfMultiplicity << "\n";
+        file << "gjf_chk=" << g_config.gjfChk << "\n";
+        file << "gjf_nproc=" << g_config.gjfNproc << "\n";
+        file << "gjf_mem=" << g_config.gjfMem << "\n";
         file << "# Log file viewers\n";
         file << "orca_log_viewer=" << g_config.orcaLogViewer << "\n";
         file << "gaussian_log_viewer=" << g_config.gaussianLogViewer << "\n";
         file << "other_log_viewer=" << g_config.otherLogViewer << "\n";
+        file << "# Plugins: at most this many plugin processes run at once\n";
+        file << "plugin_max_concurrent=" << g_config.pluginMaxConcurrent << "\n";
         
         // 保存插件配置
         for (const auto& plugin : g_config.plugins) {
             if (plugin.enabled) {
                 file << "\n[" << plugin.name << "]\n";
-                file << "cmd=" << plugin.cmd << "\n";
+                if (!plugin.cmd.empty() || plugin.library.empty()) {
+                    file << "cmd=" << plugin.cmd << "\n";
+                }
+                if (!plugin.library.empty()) {
+                    file << "library=" << plugin.library << "\n";
+                }
                 if (!plugin.hotkey.empty()) {
                     file << "hotkey=" << plugin.hotkey << "\n";
                 }
+                if (plugin.resident) {
+                    file << "resident=true\n";
+                }
+                if (plugin.sharedMemory) {
+                    file << "shared_memory=true\n";
+                }
+                if (plugin.maxConcurrent != 1) {
+                    file << "max_concurrent=" << plugin.maxConcurrent << "\n";
+                }
+                if (plugin.timeoutSeconds > 0) {
+                    file << "timeout=" << plugin.timeoutSeconds << "\n";
+                }
+                if (!plugin.coalesceRuns) {
+                    file << "on_busy=queue\n";
+                }
             }
         }
         
@@ -507,6 +633,7 @@ bool saveConfig(const std::string& configFile) {
     }
 }
 
+#ifdef _WIN32
 // 解析热键字符串
 bool parseHotkey(const std::string& hotkeyStr, UINT& modifiers, UINT& vk) {
     modifiers = 0;
@@ -560,6 +687,8 @@ bool parseHotkey(const std::string& hotkeyStr, UINT& modifiers, UINT& vk) {
     }
 }
 
+#endif
+
 // 重新加载配置
 bool reloadConfiguration() {
     LOG_INFO("Reloading configuration...");
@@ -609,6 +738,7 @@ bool reloadConfiguration() {
 // 获取可执行文件所在目录
 std::string getExecutableDirectory() {
     try {
+#ifdef _WIN32
         char buffer[MAX_PATH];
         DWORD length = GetModuleFileNameA(NULL, buffer, MAX_PATH);
         if (length == 0) {
@@ -617,6 +747,9 @@ std::string getExecutableDirectory() {
         }
         
         std::filesystem::path exePath(buffer);
+#else
+        std::filesystem::path exePath = std::filesystem::read_symlink("/proc/self/exe");
+#endif
         std::string exeDir = exePath.parent_path().string();
         LOG_DEBUG("Executable directory: " + exeDir);
         return exeDir;
@@ -677,47 +810,57 @@ bool removePlugin(const std::string& name) {
 bool executePlugin(const std::string& name) {
     for (const auto& plugin : g_config.plugins) {
         if (plugin.name == name && plugin.enabled) {
+            if (!plugin.library.empty()) {
+                // 库插件同样在后台线程中调用
+                LOG_INFO("Calling plugin library: " + name + " -> " + plugin.library);
+                return submitLibraryPluginCall(plugin.name, plugin.library);
+            }
+            if (plugin.resident) {
+                // 常驻插件在后台线程中调用，结果由调用完成时的通知报告
+                LOG_INFO("Calling resident plugin: " + name + " -> " + plugin.cmd);
+                return submitResidentPluginCall(plugin.name, plugin.cmd, plugin.timeoutSeconds);
+            }
             LOG_INFO("Executing plugin: " + name + " -> " + plugin.cmd);
             
             try {
-                STARTUPINFOA si;
-                PROCESS_INFORMATION pi;
-                ZeroMemory(&si, sizeof(si));
-                si.cb = sizeof(si);
-                ZeroMemory(&pi, sizeof(pi));
-                
-                // CreateProcess 可能会修改命令行缓冲区，因此必须传入可写 buffer
-                std::vector<char> cmdBuf(plugin.cmd.begin(), plugin.cmd.end());
-                cmdBuf.push_back('\0');
-
-                if (CreateProcessA(NULL, cmdBuf.data(), NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) {
-                    CloseHandle(pi.hProcess);
-                    CloseHandle(pi.hThread);
-                    LOG_INFO("Plugin executed successfully: " + name);
-                    // 显示成功的气泡通知
-                    showTrayNotification("Plugin Executed", "Plugin '" + name + "' executed successfully!", NIIF_INFO);
+                // 进程由执行管理器启动并等待结束，启动成功或失败的通知也由它发出；
+                // shared_memory 插件的剪贴板解析与共享内存段发布也在它的工作线程上、启动进程前进行
+                PluginRunLimits limits;
+                limits.maxConcurrent = plugin.maxConcurrent;
+                limits.timeoutSeconds = plugin.timeoutSeconds;
+                limits.coalesce = plugin.coalesceRuns;
+                g_pluginExecutor.setGlobalLimit(static_cast<unsigned int>(g_config.pluginMaxConcurrent));
+                switch (g_pluginExecutor.submit(plugin.name, plugin.cmd, limits, plugin.sharedMemory)) {
+                case PluginExecutor::Submitted::Queued:
                     return true;
-                } else {
-                    DWORD error = GetLastError();
-                    LOG_ERROR("Failed to execute plugin '" + name + "' (Error: " + std::to_string(error) + ")");
-                    // 显示失败的气泡通知
-                    showTrayNotification("Plugin Error", "Failed to execute plugin '" + name + "' (Error: " + std::to_string(error) + ")", NIIF_ERROR);
+                case PluginExecutor::Submitted::Waiting:
+                    notifyUser("Plugin Queued", "Plugin '" + name + "' is busy, the run will start when it finishes",
+                               NotifyLevel::Info);
+                    return true;
+                case PluginExecutor::Submitted::Coalesced:
+                    notifyUser("Plugin Busy", "Plugin '" + name + "' is busy, merged with the pending run", NotifyLevel::Info);
+                    return true;
+                case PluginExecutor::Submitted::Rejected:
+                    notifyUser("Plugin Busy", "Too many pending runs of plugin '" + name + "', trigger dropped",
+                               NotifyLevel::Warning);
                     return false;
                 }
+                return false;
             } catch (const std::exception& e) {
                 LOG_ERROR("Exception executing plugin '" + name + "': " + std::string(e.what()));
                 // 显示异常的气泡通知
-                showTrayNotification("Plugin Exception", "Exception executing plugin '" + name + "': " + std::string(e.what()), NIIF_ERROR);
+                notifyUser("Plugin Exception", "Exception executing plugin '" + name + "': " + std::string(e.what()), NotifyLevel::Error);
                 return false;
             }
         }
     }
     LOG_WARNING("Plugin not found or disabled: " + name);
     // 显示未找到插件的气泡通知
-    showTrayNotification("Plugin Not Found", "Plugin '" + name + "' not found or disabled!", NIIF_WARNING);
+    notifyUser("Plugin Not Found", "Plugin '" + name + "' not found or disabled!", NotifyLevel::Warning);
     return false;
 }
 
+#ifdef _WIN32
 bool registerPluginHotkeys() {
     extern HWND g_hwnd;
     if (!g_hwnd) return false;
@@ -753,4 +896,5 @@ bool unregisterPluginHotkeys() {
         }
     }
     return true;
-}
\ No newline at end of file
+}
+#endif
@@ -2,23 +2,36 @@
 
 #include <string>
 #include <vector>
+#ifdef _WIN32
 #include <windows.h>
+#else
+typedef unsigned int UINT;
+#endif
 
 // 插件结构体
 struct Plugin {
     std::string name;           // 插件名称
     std::string cmd;            // 命令
     std::string hotkey;         // 热键（可选）
+    std::string library;        // 库插件：共享库路径（见 plugin_abi.h），非空时不使用 cmd
     bool enabled;              // 是否启用
+    bool resident;              // 常驻模式：进程只启动一次，经管道收发请求（见 plugin_host.h）
+    bool sharedMemory;          // 启动前把剪贴板中的轨迹发布到共享内存段，段名追加到命令行（见 trajectory_shm.h）
+    unsigned int maxConcurrent; // 同时运行的进程数，0 表示只受 plugin_max_concurrent 限制（见 plugin_executor.h）
+    unsigned int timeoutSeconds; // 运行超时（秒），0 表示不限时
+    bool coalesceRuns;          // on_busy=coalesce：运行中重复触发只保留最后一次；queue：依次排队
     UINT hotkeyId;              // 热键ID（内部使用）
     
-    Plugin() : enabled(true), hotkeyId(0) {}
+    Plugin() : enabled(true), resident(false), sharedMemory(false), maxConcurrent(1), timeoutSeconds(0),
+               coalesceRuns(true), hotkeyId(0) {}
 };
 
 // 配置结构体
 struct Config {
     std::string hotkey = "CTRL+ALT+X";
     std::string hotkeyReverse = "CTRL+ALT+G";
+    std::string hotkeyFormat = "gaussian_log";      // 主热键输出格式（见 output_writers.h）
+    std::string hotkeyReverseFormat = "xyz";        // 反向热键写入剪贴板的格式
     std::string gviewPath = "";
     std::string tempDir = "";
     std::string logFile = "logs/xyz_monitor.log";
@@ -36,9 +49,21 @@ struct Config {
     int xColumn = 2;        // X坐标所在列
     int yColumn = 3;        // Y坐标所在列
     int zColumn = 4;        // Z坐标所在列
+    int xyzPrecision = 6;   // 输出XYZ时坐标的小数位数
+    std::string periodicMode = "none";  // 写出前的周期性处理：none / wrap / unwrap（见 periodic.h）
     
     // CHG格式支持
     bool tryParseChgFormat = false;  // 是否尝试以CHG格式解析剪切板文本
+    std::string vdwRadiiFile = "";   // PQR 输出的范德华半径覆盖文件（"元素 半径" 每行，为空时只用内置表）
+
+    // Gaussian 输入（gjf 输出格式）。route、标题与 %chk 中可用 {name}（输出文件名）、{frame}（帧号）、{comment}
+    std::string gjfRoute = "#p B3LYP/6-31G(d) opt";
+    std::string gjfTitle = "{name} frame {frame}";
+    int gjfCharge = 0;
+    int gjfMultiplicity = 1;
+    std::string gjfChk = "{name}.chk";   // 为空时不写 %chk
+    int gjfNproc = 0;                    // %nprocshared，0 时不写
+    std::string gjfMem = "";             // %mem，为空时不写
     
     // Log文件查看器配置
     std::string orcaLogViewer = "notepad.exe";      // ORCA log文件查看器
@@ -46,6 +71,7 @@ struct Config {
     std::string otherLogViewer = "notepad.exe";    // 其他log文件查看器
     
     // 插件系统
+    int pluginMaxConcurrent = 4;  // 同时运行的普通插件进程总数上限
     std::vector<Plugin> plugins;  // 插件列表
 };
 
@@ -56,7 +82,9 @@ extern Config g_config;
 bool loadConfig(const std::string& configFile);
 bool saveConfig(const std::string& configFile);
 bool reloadConfiguration();
+#ifdef _WIN32
 bool parseHotkey(const std::string& hotkeyStr, UINT& modifiers, UINT& vk);
+#endif
 std::string getExecutableDirectory();
 
 // --------------------
@@ -89,5 +117,7 @@ bool savePlugins();
 bool addPlugin(const std::string& name, const std::string& cmd, const std::string& hotkey = "");
 bool removePlugin(const std::string& name);
 bool executePlugin(const std::string& name);
+#ifdef _WIN32
 bool registerPluginHotkeys();
-bool unregisterPluginHotkeys();
\ No newline at end of file
+bool unregisterPluginHotkeys();
+#endif
\ No newline at end of file
@@ -2,21 +2,250 @@
 #include "logger.h"
 #include "config.h"
 #include "encoding.h"
+#include "periodic.h"
+#include "text_output.h"
+#include "threading.h"
+#include "xml_scan.h"
+#include "xyz_writer.h"
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
-#include <regex>
+#include <charconv>
+#include <cstring>
+#include <memory>
 
 namespace {
 
-size_t skipLeadingBlankLines(const std::vector<std::string>& lines, size_t startIndex) {
-    while (startIndex < lines.size() && trim(lines[startIndex]).empty()) {
+size_t skipLeadingBlankLines(const TextLines& lines, size_t startIndex) {
+    while (startIndex < lines.lineCount() && trimView(lines.line(startIndex)).empty()) {
         ++startIndex;
     }
     return startIndex;
 }
 
+// 坐标行缓冲区大小：固定文本 + 两个整数（各不超过 20 位）+ 三个坐标
+const size_t COORDINATE_ROW_CAPACITY = 96 + 3 * MAX_FIXED_CHARS;
+
+// 一行 Standard orientation 坐标：
+// "      <序号>          <原子序数>           0        <x>    <y>    <z>\n"
+// 返回行长度
+size_t formatStandardOrientationRow(char* row, size_t center, int atomicNum, const Atom& atom) {
+    char* out = appendText(row, "      ");
+    out = appendInteger(out, center);
+    out = appendText(out, "          ");
+    out = appendInteger(out, atomicNum);
+    out = appendText(out, "           0        ");
+    const double coordinates[3] = {atom.x, atom.y, atom.z};
+    for (int axis = 0; axis < 3; ++axis) {
+        if (axis > 0) {
+            out = appendText(out, "    ");
+        }
+        out = appendFixed(out, coordinates[axis], 6, 10);
+    }
+    *out++ = '\n';
+    return static_cast<size_t>(out - row);
+}
+
+// 恢复新建流的默认格式，保证各段输出与单独使用 ostringstream 时一致
+void resetStreamFormat(std::ostream& os) {
+    os.flags(std::ios_base::dec | std::ios_base::skipws);
+    os.precision(6);
+    os.width(0);
+    os.fill(' ');
+}
+
+bool isDigitChar(char ch) {
+    return ch >= '0' && ch <= '9';
+}
+
+bool isRegexSpace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f' || ch == '\v';
+}
+
+// 匹配 [-+]?[0-9]*\.?[0-9]+(?:[eE][-+]?[0-9]+)? ，返回匹配长度（0 表示不匹配）
+size_t matchNumber(std::string_view text) {
+    size_t i = 0;
+    if (i < text.size() && (text[i] == '+' || text[i] == '-')) {
+        ++i;
+    }
+    size_t intStart = i;
+    while (i < text.size() && isDigitChar(text[i])) {
+        ++i;
+    }
+    size_t end = i;
+    if (i < text.size() && text[i] == '.' && i + 1 < text.size() && isDigitChar(text[i + 1])) {
+        i += 1;
+        while (i < text.size() && isDigitChar(text[i])) {
+            ++i;
+        }
+        end = i;
+    } else if (end == intStart) {
+        return 0;
+    }
+    if (end < text.size() && (text[end] == 'e' || text[end] == 'E')) {
+        size_t j = end + 1;
+        if (j < text.size() && (text[j] == '+' || text[j] == '-')) {
+            ++j;
+        }
+        if (j < text.size() && isDigitChar(text[j])) {
+            while (j < text.size() && isDigitChar(text[j])) {
+                ++j;
+            }
+            end = j;
+        }
+    }
+    return end;
+}
+
+// 查找第一个 key\s*=\s*数值，找到时写入 value
+bool findKeyNumber(std::string_view text, std::string_view key, double& value) {
+    size_t pos = text.find(key);
+    while (pos != std::string_view::npos) {
+        size_t i = pos + key.size();
+        while (i < text.size() && isRegexSpace(text[i])) {
+            ++i;
+        }
+        if (i < text.size() && text[i] == '=') {
+            ++i;
+            while (i < text.size() && isRegexSpace(text[i])) {
+                ++i;
+            }
+            size_t length = matchNumber(text.substr(i));
+            if (length > 0) {
+                std::string_view number = text.substr(i, length);
+                if (!parseDouble(number, value)) {
+                    LOG_WARNING("Failed to parse number: " + std::string(number));
+                    value = -1.0;
+                }
+                return true;
+            }
+        }
+        pos = text.find(key, pos + 1);
+    }
+    return false;
+}
+
+// 坐标列布局（列号从 1 开始）
+struct ColumnLayout {
+    int element;
+    int x;
+    int y;
+    int z;
+};
+
+enum class CoordinateParse {
+    Ok,
+    TooFewColumns,      // 列数不足（空行、注释等）
+    InvalidNumber       // 列数够但坐标不是数字
+};
+
+// 取出已切分的列
+CoordinateParse assignCoordinateColumns(const std::string_view* parts, const ColumnLayout& layout, Atom& atom) {
+    if (!parseDouble(parts[layout.x - 1], atom.x) ||
+        !parseDouble(parts[layout.y - 1], atom.y) ||
+        !parseDouble(parts[layout.z - 1], atom.z)) {
+        return CoordinateParse::InvalidNumber;
+    }
+    atom.symbol.assign(parts[layout.element - 1]);
+    return CoordinateParse::Ok;
+}
+
+// 编译期列布局：切分数量和各列下标都是常量，切到最大列即停止，行尾其余内容不再扫描
+template <int E, int X, int Y, int Z>
+CoordinateParse parseCoordinateLineFixed(std::string_view line, const ColumnLayout&, Atom& atom) {
+    constexpr size_t maxCol = static_cast<size_t>(std::max({E, X, Y, Z}));
+    constexpr ColumnLayout layout{E, X, Y, Z};
+    std::string_view parts[maxCol];
+    if (splitWhitespaceViews(line, parts, maxCol) < maxCol) {
+        return CoordinateParse::TooFewColumns;
+    }
+    return assignCoordinateColumns(parts, layout, atom);
+}
+
+// 坐标行最多按这么多列切分（列配置超过此值的行视为无效）
+const size_t MAX_COORDINATE_COLUMNS = 32;
+
+// 运行时列布局（非常见布局时使用）
+CoordinateParse parseCoordinateLineGeneric(std::string_view line, const ColumnLayout& layout, Atom& atom) {
+    const size_t maxCol = static_cast<size_t>(std::max({layout.element, layout.x, layout.y, layout.z}));
+    std::string_view parts[MAX_COORDINATE_COLUMNS];
+    if (maxCol > MAX_COORDINATE_COLUMNS || splitWhitespaceViews(line, parts, maxCol) < maxCol) {
+        return CoordinateParse::TooFewColumns;
+    }
+    return assignCoordinateColumns(parts, layout, atom);
+}
+
+using CoordinateLineParser = CoordinateParse (*)(std::string_view, const ColumnLayout&, Atom&);
+
+// 按列配置选定的坐标行解析器，每次转换选择一次
+struct CoordinateParser {
+    ColumnLayout layout;
+    CoordinateLineParser parseLine;
+
+    CoordinateParse operator()(std::string_view line, Atom& atom) const {
+        return parseLine(line, layout, atom);
+    }
+};
+
+// 有专门实例的常见布局
+struct SpecializedLayout {
+    ColumnLayout layout;
+    CoordinateLineParser parseLine;
+};
+
+const SpecializedLayout SPECIALIZED_LAYOUTS[] = {
+    {{1, 2, 3, 4}, &parseCoordinateLineFixed<1, 2, 3, 4>},     // 元素 X Y Z（默认）
+    {{2, 3, 4, 5}, &parseCoordinateLineFixed<2, 3, 4, 5>},     // 序号 元素 X Y Z
+    {{1, 3, 4, 5}, &parseCoordinateLineFixed<1, 3, 4, 5>},     // 元素 冻结标记 X Y Z（Gaussian 输入）
+    {{2, 4, 5, 6}, &parseCoordinateLineFixed<2, 4, 5, 6>},     // 序号 原子序数 类型 X Y Z（Gaussian 取向表）
+};
+
+// 读取当前列配置并选择解析器
+CoordinateParser selectCoordinateParser() {
+    const ColumnLayout layout{g_config.elementColumn, g_config.xColumn, g_config.yColumn, g_config.zColumn};
+    for (const auto& specialized : SPECIALIZED_LAYOUTS) {
+        if (specialized.layout.element == layout.element && specialized.layout.x == layout.x &&
+            specialized.layout.y == layout.y && specialized.layout.z == layout.z) {
+            return CoordinateParser{layout, specialized.parseLine};
+        }
+    }
+    return CoordinateParser{layout, &parseCoordinateLineGeneric};
+}
+
+bool isValidCoordinateLine(std::string_view line, const CoordinateParser& parser) {
+    Atom atom;
+    return parser(line, atom) == CoordinateParse::Ok;
+}
+
+// 按第一帧的原子数估计帧数，用于预留 frames 容量
+size_t estimateFrameCount(const TextLines& lines, size_t firstLine) {
+    std::string_view header = trimView(lines.line(firstLine));
+    size_t numAtoms = 0;
+    auto result = std::from_chars(header.data(), header.data() + header.size(), numAtoms);
+    if (result.ec != std::errc() || numAtoms == 0) {
+        return 1;
+    }
+    return (lines.lineCount() - firstLine) / (numAtoms + 2) + 1;
+}
+
+// CHG 每行最多读取的电荷列数
+const size_t MAX_CHARGE_CHANNELS = 16;
+
+// 多电荷列 CHG 的表头注释："# Element X Y Z Mulliken Hirshfeld ADCH"，第二列为 X 时取第五列起为通道名
+bool parseChgHeader(std::string_view line, std::vector<std::string>& names) {
+    std::string_view parts[4 + MAX_CHARGE_CHANNELS];
+    size_t count = splitWhitespaceViews(line.substr(1), parts, 4 + MAX_CHARGE_CHANNELS);
+    if (count < 5 || !equalsIgnoreCase(parts[1], "x")) {
+        return false;
+    }
+    names.clear();
+    for (size_t i = 4; i < count; ++i) {
+        names.emplace_back(parts[i]);
+    }
+    return true;
+}
+
 } // namespace
 
 // 解析科学计数法数字
@@ -36,50 +265,38 @@ double parseScientificNumber(const std::string& str) {
 }
 
 // 解析优化信息
-OptimizationInfo parseOptimizationInfo(const std::string& comment) {
+// 逐个查找 "键 = 数值"，匹配规则与正则 Key\s*=\s*([-+]?[0-9]*\.?[0-9]+(?:[eE][-+]?[0-9]+)?) 相同，
+// 但不构造 std::regex，每帧解析不产生堆分配
+OptimizationInfo parseOptimizationInfo(std::string_view comment) {
     OptimizationInfo info;
     
     try {
-        // 定义正则表达式来匹配各种格式
-        std::regex maxfRegex(R"(MaxF\s*=\s*([-+]?[0-9]*\.?[0-9]+(?:[eE][-+]?[0-9]+)?))");
-        std::regex rmsfRegex(R"(RMSF\s*=\s*([-+]?[0-9]*\.?[0-9]+(?:[eE][-+]?[0-9]+)?))");
-        std::regex maxdRegex(R"(MaxD\s*=\s*([-+]?[0-9]*\.?[0-9]+(?:[eE][-+]?[0-9]+)?))");
-        std::regex rmsdRegex(R"(RMSD\s*=\s*([-+]?[0-9]*\.?[0-9]+(?:[eE][-+]?[0-9]+)?))");
-        std::regex energyRegex(R"(E\s*=\s*([-+]?[0-9]*\.?[0-9]+(?:[eE][-+]?[0-9]+)?))");
-        
-        std::smatch match;
-        
         // 匹配最大受力 MaxF=
-        if (std::regex_search(comment, match, maxfRegex)) {
-            info.maxForce = parseScientificNumber(match[1].str());
+        if (findKeyNumber(comment, "MaxF", info.maxForce)) {
             info.hasData = true;
             LOG_DEBUG("Parsed MaxF: " + std::to_string(info.maxForce));
         }
         
         // 匹配方均根受力 RMSF=
-        if (std::regex_search(comment, match, rmsfRegex)) {
-            info.rmsForce = parseScientificNumber(match[1].str());
+        if (findKeyNumber(comment, "RMSF", info.rmsForce)) {
             info.hasData = true;
             LOG_DEBUG("Parsed RMSF: " + std::to_string(info.rmsForce));
         }
         
         // 匹配最大位移 MaxD=
-        if (std::regex_search(comment, match, maxdRegex)) {
-            info.maxDisp = parseScientificNumber(match[1].str());
+        if (findKeyNumber(comment, "MaxD", info.maxDisp)) {
             info.hasData = true;
             LOG_DEBUG("Parsed MaxD: " + std::to_string(info.maxDisp));
         }
         
         // 匹配方均根位移 RMSD=
-        if (std::regex_search(comment, match, rmsdRegex)) {
-            info.rmsDisp = parseScientificNumber(match[1].str());
+        if (findKeyNumber(comment, "RMSD", info.rmsDisp)) {
             info.hasData = true;
             LOG_DEBUG("Parsed RMSD: " + std::to_string(info.rmsDisp));
         }
         
         // 匹配能量 E=
-        if (std::regex_search(comment, match, energyRegex)) {
-            info.energy = parseScientificNumber(match[1].str());
+        if (findKeyNumber(comment, "E", info.energy)) {
             info.hasEnergy = true;
             info.hasData = true;
             LOG_DEBUG("Parsed E: " + std::to_string(info.energy));
@@ -92,41 +309,24 @@ OptimizationInfo parseOptimizationInfo(const std::string& comment) {
     return info;
 }
 
-// 检查是否为有效的坐标行
-bool isValidCoordinateLine(const std::string& line) {
-    if (trim(line).empty()) {
-        return false;
-    }
-
-    std::vector<std::string> parts = splitWhitespace(line);
-    
-    // 需要足够的列来包含element和xyz
-    int maxCol = std::max({g_config.elementColumn, g_config.xColumn, g_config.yColumn, g_config.zColumn});
-    if (parts.size() < static_cast<size_t>(maxCol)) return false;
-    
-    try {
-        // 验证xyz列是否为有效的数字（索引从0开始，所以要减1）
-        double x = std::stod(parts[g_config.xColumn - 1]);
-        double y = std::stod(parts[g_config.yColumn - 1]);
-        double z = std::stod(parts[g_config.zColumn - 1]);
-        (void)x; (void)y; (void)z;
-        return true;
-    } catch (const std::exception&) {
-        return false;
-    }
+// 检查是否为有效的坐标行（单行调用时按当前列配置选择解析器）
+bool isValidCoordinateLine(std::string_view line) {
+    return isValidCoordinateLine(line, selectCoordinateParser());
 }
 
 // 检查是否为简化XYZ格式
-bool isSimplifiedXYZFormat(const std::vector<std::string>& lines) {
-    if (lines.empty()) return false;
+bool isSimplifiedXYZFormat(const TextLines& lines) {
+    if (lines.lineCount() == 0) return false;
     
+    const CoordinateParser parser = selectCoordinateParser();
     size_t checked = 0;
-    for (const auto& line : lines) {
-        if (trim(line).empty()) {
+    for (size_t i = 0; i < lines.lineCount(); ++i) {
+        std::string_view line = lines.line(i);
+        if (trimView(line).empty()) {
             continue;
         }
 
-        if (!isValidCoordinateLine(line)) {
+        if (!isValidCoordinateLine(line, parser)) {
             return false;
         }
 
@@ -141,43 +341,47 @@ bool isSimplifiedXYZFormat(const std::vector<std::string>& lines) {
 
 // 检查是否为XYZ格式
 bool isXYZFormat(const std::string& content) {
+    return isXYZFormat(indexLines(content));
+}
+
+bool isXYZFormat(const TextLines& lines) {
     try {
-        if (content.empty()) {
+        if (lines.content.empty()) {
             LOG_DEBUG("Content is empty");
             return false;
         }
         
-        if (content.find('\0') != std::string::npos) {
+        if (lines.content.find('\0') != std::string::npos) {
             LOG_DEBUG("Content contains binary data");
             return false;
         }
         
-        std::vector<std::string> lines = splitLines(content, true);
-        if (lines.empty()) {
+        if (lines.lineCount() == 0) {
             LOG_DEBUG("No lines found in content");
             return false;
         }
 
         size_t firstLine = skipLeadingBlankLines(lines, 0);
-        if (firstLine >= lines.size()) {
+        if (firstLine >= lines.lineCount()) {
             LOG_DEBUG("No non-empty lines found in content");
             return false;
         }
         
         // 检查是否是标准XYZ格式（第一行是原子数）
         try {
-            int atomCount = std::stoi(trim(lines[firstLine]));
-            if (atomCount > 0 && atomCount <= 10000) {
-                if ((lines.size() - firstLine) < static_cast<size_t>(atomCount + 2)) {
+            int atomCount = std::stoi(std::string(trimView(lines.line(firstLine))));
+            if (atomCount > 0) {
+                if ((lines.lineCount() - firstLine) < static_cast<size_t>(atomCount) + 2) {
                     LOG_DEBUG("Not enough lines for atom count: " + std::to_string(atomCount));
                     return false;
                 }
                 
+                const CoordinateParser parser = selectCoordinateParser();
                 size_t maxCheck = std::min(static_cast<size_t>(5), static_cast<size_t>(atomCount));
                 for (size_t i = 0; i < maxCheck; ++i) {
                     size_t lineIndex = firstLine + 2 + i;
-                    if (lineIndex < lines.size()) {
-                        if (!isValidCoordinateLine(lines[lineIndex])) {
+                    if (lineIndex < lines.lineCount()) {
+                        if (!isValidCoordinateLine(lines.line(lineIndex), parser)) {
                             LOG_DEBUG("Invalid coordinate line at index: " + std::to_string(lineIndex));
                             return false;
                         }
@@ -205,19 +409,22 @@ bool isXYZFormat(const std::string& content) {
 
 // 检查是否为CHG格式
 bool isChgFormat(const std::string& content) {
+    return isChgFormat(indexLines(content));
+}
+
+bool isChgFormat(const TextLines& lines) {
     try {
-        if (content.empty()) {
+        if (lines.content.empty()) {
             LOG_DEBUG("Content is empty");
             return false;
         }
         
-        if (content.find('\0') != std::string::npos) {
+        if (lines.content.find('\0') != std::string::npos) {
             LOG_DEBUG("Content contains binary data");
             return false;
         }
         
-        std::vector<std::string> lines = splitLines(content, true);
-        if (lines.empty()) {
+        if (lines.lineCount() == 0) {
             LOG_DEBUG("No lines found in content");
             return false;
         }
@@ -225,8 +432,8 @@ bool isChgFormat(const std::string& content) {
         int validLines = 0;
         int totalNonEmptyLines = 0;
         
-        for (const std::string& line : lines) {
-            std::string trimmedLine = trim(line);
+        for (size_t i = 0; i < lines.lineCount(); ++i) {
+            std::string_view trimmedLine = trimView(lines.line(i));
             // 跳过空行和注释行
             if (trimmedLine.empty() || trimmedLine[0] == '#') {
                 continue;
@@ -276,134 +483,253 @@ bool isChgFormat(const std::string& content) {
     }
 }
 
-// 读取单帧XYZ数据
-bool readXYZFrame(const std::vector<std::string>& lines, size_t startLine, Frame& frame, size_t& nextStart) {
+namespace {
+
+// 单帧原子数达到此值才分块并行解析（小帧线程开销大于收益）
+const size_t PARALLEL_PARSE_MIN_ATOMS = 65536;
+// 每块至少这么多行
+const size_t PARALLEL_PARSE_MIN_CHUNK = 32768;
+
+// 解析 [begin, end) 范围的原子行，写入 atoms[begin, end)，返回失败行数
+size_t parseAtomRowRange(const TextLines& lines, size_t firstAtomLine, Atom* atoms, size_t begin, size_t end,
+                         const CoordinateParser& parser) {
+    size_t failed = 0;
+    for (size_t i = begin; i < end; ++i) {
+        size_t lineIndex = firstAtomLine + i;
+        CoordinateParse result = parser(lines.line(lineIndex), atoms[i]);
+        if (result != CoordinateParse::Ok) {
+            ++failed;
+            if (result == CoordinateParse::InvalidNumber) {
+                LOG_WARNING("Failed to parse atom at line " + std::to_string(lineIndex) + ": invalid number");
+            }
+        }
+    }
+    return failed;
+}
+
+// 解析一帧的全部原子行（atoms 已按原子数分配）。
+// 大帧按行号切成连续的块，第一块在当前线程解析，其余块各用一个工作线程；
+// 每块只写自己的下标范围，不需要加锁。返回失败行数
+size_t parseAtomRows(const TextLines& lines, size_t firstAtomLine, Atom* atoms, size_t atomCount,
+                     const CoordinateParser& parser) {
+    size_t chunkCount = 1;
+    if (atomCount >= PARALLEL_PARSE_MIN_ATOMS) {
+        chunkCount = std::min<size_t>(hardwareConcurrency(), atomCount / PARALLEL_PARSE_MIN_CHUNK);
+        chunkCount = std::max<size_t>(chunkCount, 1);
+    }
+    if (chunkCount == 1) {
+        return parseAtomRowRange(lines, firstAtomLine, atoms, 0, atomCount, parser);
+    }
+
+    const size_t chunkSize = (atomCount + chunkCount - 1) / chunkCount;
+    std::vector<size_t> failures(chunkCount, 0);
+    std::vector<std::unique_ptr<Thread>> workers;
+    workers.reserve(chunkCount - 1);
+    for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+        size_t begin = chunk * chunkSize;
+        size_t end = std::min(atomCount, begin + chunkSize);
+        size_t* failed = &failures[chunk];
+        auto work = [&lines, firstAtomLine, atoms, begin, end, &parser, failed]() {
+            try {
+                *failed = parseAtomRowRange(lines, firstAtomLine, atoms, begin, end, parser);
+            } catch (const std::exception& e) {
+                LOG_ERROR("Exception parsing atom rows: " + std::string(e.what()));
+                *failed = end - begin;
+            }
+        };
+        auto worker = std::make_unique<Thread>();
+        if (!worker->start(work)) {
+            // 线程启动失败时在当前线程解析这一块
+            work();
+            continue;
+        }
+        workers.push_back(std::move(worker));
+    }
+
+    failures[0] = parseAtomRowRange(lines, firstAtomLine, atoms, 0, std::min(atomCount, chunkSize), parser);
+    for (auto& worker : workers) {
+        worker->join();
+    }
+
+    size_t failed = 0;
+    for (size_t count : failures) {
+        failed += count;
+    }
+    LOG_DEBUG("Parsed " + std::to_string(atomCount) + " atom rows in " + std::to_string(chunkCount) + " chunks");
+    return failed;
+}
+
+bool isCellVectorSymbol(const std::string& symbol) {
+    return symbol.size() == 2 && (symbol[0] == 'T' || symbol[0] == 't') && (symbol[1] == 'v' || symbol[1] == 'V');
+}
+
+// 把 Tv 行从原子中移出，按出现顺序作为晶胞矢量（最多三个，多余的丢弃）
+void extractCellVectors(Frame& frame) {
+    auto isCellRow = [](const Atom& atom) { return isCellVectorSymbol(atom.symbol); };
+    auto first = std::find_if(frame.atoms.begin(), frame.atoms.end(), isCellRow);
+    if (first == frame.atoms.end()) {
+        return;
+    }
+    size_t found = 0;
+    for (auto it = first; it != frame.atoms.end(); ++it) {
+        if (!isCellRow(*it)) {
+            continue;
+        }
+        if (found < 3) {
+            frame.cell.vectors[found][0] = it->x;
+            frame.cell.vectors[found][1] = it->y;
+            frame.cell.vectors[found][2] = it->z;
+        }
+        ++found;
+    }
+    frame.cell.count = static_cast<int>(std::min<size_t>(found, 3));
+    if (found > 3) {
+        LOG_WARNING("Frame has " + std::to_string(found) + " Tv rows; only the first 3 are used");
+    }
+    frame.atoms.erase(std::remove_if(first, frame.atoms.end(), isCellRow), frame.atoms.end());
+}
+
+// 读取单帧XYZ数据（使用调用方选好的坐标行解析器）
+bool readXYZFrame(const TextLines& lines, size_t startLine, Frame& frame, size_t& nextStart,
+                  const CoordinateParser& parser) {
     startLine = skipLeadingBlankLines(lines, startLine);
-    if (startLine >= lines.size()) return false;
+    if (startLine >= lines.lineCount()) return false;
     
     try {
-        int numAtoms = std::stoi(trim(lines[startLine]));
+        int numAtoms = std::stoi(std::string(trimView(lines.line(startLine))));
         if (numAtoms <= 0) return false;
         
-        frame.comment = (startLine + 1 < lines.size()) ? lines[startLine + 1] : "";
+        if (startLine + 1 < lines.lineCount()) {
+            frame.comment.assign(lines.line(startLine + 1));
+        } else {
+            frame.comment.clear();
+        }
         
         // 解析优化信息
         frame.optInfo = parseOptimizationInfo(frame.comment);
         
-        frame.atoms.clear();
-        
-        for (int i = 0; i < numAtoms; ++i) {
-            size_t lineIndex = startLine + 2 + static_cast<size_t>(i);
-            if (lineIndex >= lines.size()) {
-                LOG_WARNING("Frame ended unexpectedly while reading atoms. Expected " + std::to_string(numAtoms) +
-                            ", parsed " + std::to_string(frame.atoms.size()));
-                return false;
-            }
-            
-            std::vector<std::string> parts = splitWhitespace(lines[lineIndex]);
-            int maxCol = std::max({g_config.elementColumn, g_config.xColumn, g_config.yColumn, g_config.zColumn});
-            if (parts.size() >= static_cast<size_t>(maxCol)) {
-                try {
-                    Atom atom;
-                    atom.symbol = parts[g_config.elementColumn - 1];
-                    atom.x = std::stod(parts[g_config.xColumn - 1]);
-                    atom.y = std::stod(parts[g_config.yColumn - 1]);
-                    atom.z = std::stod(parts[g_config.zColumn - 1]);
-                    frame.atoms.push_back(atom);
-                } catch (const std::exception& e) {
-                    LOG_WARNING("Failed to parse atom at line " + std::to_string(lineIndex) + ": " + std::string(e.what()));
-                    continue;
-                }
-            }
+        const size_t atomCount = static_cast<size_t>(numAtoms);
+        const size_t firstAtomLine = startLine + 2;
+        if (firstAtomLine + atomCount > lines.lineCount()) {
+            size_t available = lines.lineCount() > firstAtomLine ? lines.lineCount() - firstAtomLine : 0;
+            LOG_WARNING("Frame ended unexpectedly while reading atoms. Expected " + std::to_string(numAtoms) +
+                        ", found " + std::to_string(available) + " coordinate lines");
+            return false;
         }
         
-        nextStart = startLine + static_cast<size_t>(numAtoms) + 2;
+        // 原子数已知，一次分配到位，各行直接写入对应位置（可分块并行）
+        frame.atoms.clear();
+        frame.atoms.resize(atomCount);
+        size_t failed = parseAtomRows(lines, firstAtomLine, frame.atoms.data(), atomCount, parser);
+        
+        nextStart = firstAtomLine + atomCount;
 
-        if (frame.atoms.size() != static_cast<size_t>(numAtoms)) {
+        if (failed > 0) {
             LOG_WARNING("Parsed atom count does not match header. Expected " + std::to_string(numAtoms) +
-                        ", got " + std::to_string(frame.atoms.size()));
+                        ", got " + std::to_string(atomCount - failed));
+            frame.atoms.clear();
             return false;
         }
 
+        // Tv 行是晶胞矢量，移入 frame.cell；没有 Tv 行时再看扩展 XYZ 的 Lattice=
+        frame.cell = UnitCell();
+        extractCellVectors(frame);
+        if (frame.cell.count == 0 && frame.comment.find("Lattice") != std::string::npos) {
+            parseExtXYZLattice(frame.comment, frame.cell);
+        }
+
         return !frame.atoms.empty();
+    } catch (const MemoryBudgetExceeded&) {
+        throw;
     } catch (const std::exception& e) {
         LOG_ERROR("Exception in readXYZFrame: " + std::string(e.what()));
         return false;
     }
 }
 
+} // namespace
+
+// 读取单帧XYZ数据
+bool readXYZFrame(const TextLines& lines, size_t startLine, Frame& frame, size_t& nextStart) {
+    return readXYZFrame(lines, startLine, frame, nextStart, selectCoordinateParser());
+}
+
 // 读取多帧XYZ数据
 std::vector<Frame> readMultiXYZ(const std::string& content) {
+    return readMultiXYZ(indexLines(content));
+}
+
+std::vector<Frame> readMultiXYZ(const TextLines& lines) {
     std::vector<Frame> frames;
     
     try {
-        std::vector<std::string> lines = splitLines(content, true);
-        
-        if (lines.empty()) {
+        if (lines.lineCount() == 0) {
             LOG_DEBUG("No lines to process");
             return frames;
         }
 
         size_t firstLine = skipLeadingBlankLines(lines, 0);
-        if (firstLine >= lines.size()) {
+        if (firstLine >= lines.lineCount()) {
             LOG_DEBUG("No non-empty lines to process");
             return frames;
         }
         
         try {
-            std::stoi(trim(lines[firstLine]));
+            std::stoi(std::string(trimView(lines.line(firstLine))));
             // 标准格式
             LOG_DEBUG("Processing standard XYZ format");
+            const CoordinateParser parser = selectCoordinateParser();
+            frames.reserve(estimateFrameCount(lines, firstLine));
             size_t lineIndex = firstLine;
-            while (lineIndex < lines.size()) {
+            while (lineIndex < lines.lineCount()) {
                 lineIndex = skipLeadingBlankLines(lines, lineIndex);
-                if (lineIndex >= lines.size()) {
+                if (lineIndex >= lines.lineCount()) {
                     break;
                 }
 
                 Frame frame;
                 size_t nextStart;
-                if (readXYZFrame(lines, lineIndex, frame, nextStart)) {
-                    frames.push_back(frame);
+                if (readXYZFrame(lines, lineIndex, frame, nextStart, parser)) {
+                    frames.push_back(std::move(frame));
                     lineIndex = nextStart;
                 } else {
                     LOG_WARNING("Failed to read frame starting at line: " + std::to_string(lineIndex));
                     break;
                 }
             }
+        } catch (const MemoryBudgetExceeded&) {
+            throw;
         } catch (const std::exception&) {
             // 简化格式：直接处理坐标行
             LOG_DEBUG("Processing simplified XYZ format");
             Frame frame;
             frame.comment = "Simplified XYZ format";
+            frame.atoms.reserve(lines.lineCount());
+            
+            const CoordinateParser parser = selectCoordinateParser();
             
-            for (const std::string& line : lines) {
-                if (trim(line).empty()) {
+            for (size_t i = 0; i < lines.lineCount(); ++i) {
+                std::string_view line = lines.line(i);
+                if (trimView(line).empty()) {
                     continue;
                 }
-                std::vector<std::string> parts = splitWhitespace(line);
-                int maxCol = std::max({g_config.elementColumn, g_config.xColumn, g_config.yColumn, g_config.zColumn});
-                if (parts.size() >= static_cast<size_t>(maxCol)) {
-                    try {
-                        Atom atom;
-                        atom.symbol = parts[g_config.elementColumn - 1];
-                        atom.x = std::stod(parts[g_config.xColumn - 1]);
-                        atom.y = std::stod(parts[g_config.yColumn - 1]);
-                        atom.z = std::stod(parts[g_config.zColumn - 1]);
-                        frame.atoms.push_back(atom);
-                    } catch (const std::exception& e) {
-                        LOG_WARNING("Failed to parse simplified format line: " + std::string(e.what()));
-                        continue;
-                    }
+                Atom atom;
+                CoordinateParse result = parser(line, atom);
+                if (result == CoordinateParse::Ok) {
+                    frame.atoms.push_back(std::move(atom));
+                } else if (result == CoordinateParse::InvalidNumber) {
+                    LOG_WARNING("Failed to parse simplified format line: invalid number");
                 }
             }
             
             if (!frame.atoms.empty()) {
-                frames.push_back(frame);
+                frames.push_back(std::move(frame));
             }
         }
         
         LOG_INFO("Processed " + std::to_string(frames.size()) + " frames");
+    } catch (const MemoryBudgetExceeded&) {
+        throw;
     } catch (const std::exception& e) {
         LOG_ERROR("Exception in readMultiXYZ: " + std::string(e.what()));
     }
@@ -413,59 +739,114 @@ std::vector<Frame> readMultiXYZ(const std::string& content) {
 
 // 读取CHG格式数据
 Frame readChgFrame(const std::string& content) {
+    return readChgFrame(indexLines(content));
+}
+
+Frame readChgFrame(const TextLines& lines) {
     Frame frame;
     frame.comment = "CHG Format (Element X Y Z Charge)";
     
     try {
-        std::vector<std::string> lines = splitLines(content, true);
-        
-        if (lines.empty()) {
+        if (lines.lineCount() == 0) {
             LOG_DEBUG("No lines to process");
             return frame;
         }
         
         LOG_DEBUG("Processing CHG format");
         
-        for (const std::string& line : lines) {
-            std::string trimmedLine = trim(line);
+        frame.atoms.reserve(lines.lineCount());
+        std::string_view parts[4 + MAX_CHARGE_CHANNELS];
+        // 第 0 个之外的电荷先按行存放，读完后再转成按通道存放
+        std::pmr::vector<double> rowCharges{conversionMemoryResource()};
+        std::vector<std::string> headerNames;
+        size_t channelCount = 0;
+        bool missingColumns = false;
+        
+        for (size_t i = 0; i < lines.lineCount(); ++i) {
+            std::string_view trimmedLine = trimView(lines.line(i));
             
-            // 跳过空行和注释行
+            // 跳过空行和注释行（数据行之前的表头注释给出各电荷列的名称）
             if (trimmedLine.empty() || trimmedLine[0] == '#') {
+                if (channelCount == 0 && headerNames.empty() && !trimmedLine.empty()) {
+                    parseChgHeader(trimmedLine, headerNames);
+                }
                 continue;
             }
             
-            std::vector<std::string> parts = splitWhitespace(trimmedLine);
-            // CHG格式：Element X Y Z Charge (至少5列)
-            if (parts.size() >= 5) {
-                try {
-                    // 验证第一列是元素符号
-                    if (parts[0].empty() || !std::isalpha(parts[0][0])) {
-                        LOG_WARNING("Invalid element symbol in CHG line: " + trimmedLine);
-                        continue;
+            // CHG格式：Element X Y Z Charge [Charge2 ...] (至少5列)
+            size_t columns = splitWhitespaceViews(trimmedLine, parts, 4 + MAX_CHARGE_CHANNELS);
+            if (columns >= 5) {
+                // 验证第一列是元素符号
+                if (!std::isalpha(static_cast<unsigned char>(parts[0][0]))) {
+                    LOG_WARNING("Invalid element symbol in CHG line: " + std::string(trimmedLine));
+                    continue;
+                }
+                // 通道数取表头的名称数，没有表头时取第一个数据行的电荷列数
+                if (channelCount == 0) {
+                    channelCount = headerNames.empty() ? columns - 4 : std::min(headerNames.size(), MAX_CHARGE_CHANNELS);
+                    rowCharges.reserve((channelCount - 1) * lines.lineCount());
+                }
+                
+                Atom atom;
+                // 第5列是电荷
+                if (!parseDouble(parts[1], atom.x) || !parseDouble(parts[2], atom.y) ||
+                    !parseDouble(parts[3], atom.z) || !parseDouble(parts[4], atom.charge)) {
+                    LOG_WARNING("Failed to parse CHG format line: " + std::string(trimmedLine) + ", error: invalid number");
+                    continue;
+                }
+                // 其余电荷列，缺少的列按 0 处理
+                size_t rowStart = rowCharges.size();
+                bool valid = true;
+                for (size_t c = 1; c < channelCount; ++c) {
+                    double value = 0.0;
+                    if (4 + c >= columns) {
+                        missingColumns = true;
+                    } else if (!parseDouble(parts[4 + c], value)) {
+                        valid = false;
+                        break;
                     }
-                    
-                    Atom atom;
-                    atom.symbol = parts[0];
-                    atom.x = std::stod(parts[1]);
-                    atom.y = std::stod(parts[2]);
-                    atom.z = std::stod(parts[3]);
-                    atom.charge = std::stod(parts[4]);  // 第5列是电荷
-                    
-                    frame.atoms.push_back(atom);
-                } catch (const std::exception& e) {
-                    LOG_WARNING("Failed to parse CHG format line: " + trimmedLine + ", error: " + std::string(e.what()));
+                    rowCharges.push_back(value);
+                }
+                if (!valid) {
+                    rowCharges.resize(rowStart);
+                    LOG_WARNING("Failed to parse CHG format line: " + std::string(trimmedLine) + ", error: invalid number");
                     continue;
                 }
+                atom.symbol.assign(parts[0]);
+                
+                frame.atoms.push_back(std::move(atom));
             } else {
-                LOG_WARNING("CHG line has insufficient columns: " + trimmedLine);
+                LOG_WARNING("CHG line has insufficient columns: " + std::string(trimmedLine));
             }
         }
         
         if (frame.atoms.empty()) {
             LOG_WARNING("No valid atoms found in CHG format");
+            return frame;
+        }
+        if (missingColumns) {
+            LOG_WARNING("Some CHG lines have fewer charge columns than the header, missing charges set to 0");
+        }
+        
+        if (channelCount > 1 || !headerNames.empty()) {
+            frame.chargeChannels.assign(headerNames.begin(), headerNames.begin() + std::min(headerNames.size(), channelCount));
+            for (size_t c = frame.chargeChannels.size(); c < channelCount; ++c) {
+                frame.chargeChannels.push_back("charge" + std::to_string(c + 1));
+            }
+            const size_t atomCount = frame.atoms.size();
+            frame.extraCharges.resize((channelCount - 1) * atomCount);
+            for (size_t i = 0; i < atomCount; ++i) {
+                for (size_t c = 1; c < channelCount; ++c) {
+                    frame.extraCharges[(c - 1) * atomCount + i] = rowCharges[i * (channelCount - 1) + (c - 1)];
+                }
+            }
+            LOG_INFO("Parsed " + std::to_string(atomCount) + " atoms with " + std::to_string(channelCount) +
+                     " charge channels from CHG format");
         } else {
             LOG_INFO("Parsed " + std::to_string(frame.atoms.size()) + " atoms from CHG format");
         }
+    } catch (const MemoryBudgetExceeded&) {
+        throw;
     } catch (const std::exception& e) {
         LOG_ERROR("Exception in readChgFrame: " + std::string(e.what()));
     }
@@ -473,82 +854,625 @@ Frame readChgFrame(const std::string& content) {
     return frame;
 }
 
+// ========== CP2K ==========
+
+namespace {
+
+// 帧数至少为此值的两倍才按帧分给多个线程解析，每个线程至少解析这么多帧
+const size_t PARALLEL_CP2K_MIN_FRAMES = 64;
+
+// CP2K 长度单位换算到 Å
+const double CP2K_BOHR_TO_ANGSTROM = 0.529177210903;
+
+// 轨迹中一帧的位置：原子行从 atomsOffset 开始，共 atomCount 行
+struct CP2KFrameSpan {
+    size_t atomCount;
+    std::string_view comment;
+    size_t atomsOffset;
+};
+
+size_t skipUtf8Bom(std::string_view text) {
+    return text.size() >= 3 && text.compare(0, 3, "\xEF\xBB\xBF") == 0 ? 3 : 0;
+}
+
+// 从 pos 取一行（去掉行尾 \r），pos 移到下一行开头；已到末尾时返回 false
+bool nextRawLine(std::string_view text, size_t& pos, std::string_view& line) {
+    if (pos >= text.size()) {
+        return false;
+    }
+    const char* start = text.data() + pos;
+    const char* newline = static_cast<const char*>(std::memchr(start, '\n', text.size() - pos));
+    size_t length = newline ? static_cast<size_t>(newline - start) : text.size() - pos;
+    pos += newline ? length + 1 : length;
+    if (length > 0 && start[length - 1] == '\r') {
+        --length;
+    }
+    line = std::string_view(start, length);
+    return true;
+}
+
+// 跳过 count 行（只找换行符，不看内容），不足 count 行时返回 false
+bool skipRawLines(std::string_view text, size_t& pos, size_t count) {
+    for (; count > 0; --count) {
+        if (pos >= text.size()) {
+            return false;
+        }
+        const char* start = text.data() + pos;
+        const char* newline = static_cast<const char*>(std::memchr(start, '\n', text.size() - pos));
+        pos = newline ? static_cast<size_t>(newline - text.data()) + 1 : text.size();
+    }
+    return true;
+}
+
+// 帧头：整行是一个正整数
+bool parseFrameHeader(std::string_view line, size_t& atomCount) {
+    std::string_view header = trimView(line);
+    auto result = std::from_chars(header.data(), header.data() + header.size(), atomCount);
+    return result.ec == std::errc() && result.ptr == header.data() + header.size() && atomCount > 0;
+}
+
+// CP2K 注释行 " i =  100, time =  50.000, E =  -17.17"：步数、时间（fs）、能量（Hartree）
+void parseCP2KComment(std::string_view comment, Frame& frame) {
+    frame.optInfo = parseOptimizationInfo(comment);
+    double value = 0.0;
+    if (findKeyNumber(comment, "i", value) && value >= 0.0) {
+        frame.step = static_cast<long long>(value);
+    }
+    if (findKeyNumber(comment, "time", value)) {
+        frame.time = value;
+        frame.hasTime = true;
+    }
+}
+
+// 解析 [first, last) 帧的原子行（原子数组已分配），有无效行的帧在 failed 中标记
+void parseCP2KFrameRange(std::string_view text, const std::vector<CP2KFrameSpan>& spans, std::vector<Frame>& frames,
+                         std::vector<char>& failed, size_t first, size_t last) {
+    const ColumnLayout layout{1, 2, 3, 4};
+    std::string_view line;
+    for (size_t f = first; f < last; ++f) {
+        size_t pos = spans[f].atomsOffset;
+        Atom* atoms = frames[f].atoms.data();
+        for (size_t i = 0; i < spans[f].atomCount; ++i) {
+            nextRawLine(text, pos, line);
+            if (parseCoordinateLineFixed<1, 2, 3, 4>(line, layout, atoms[i]) != CoordinateParse::Ok) {
+                failed[f] = 1;
+            }
+        }
+    }
+}
+
+// 第一个非空白 token（去掉 "!" "#" 注释）
+std::string_view stripCP2KComment(std::string_view line) {
+    size_t mark = line.find_first_of("!#");
+    return trimView(mark == std::string_view::npos ? line : line.substr(0, mark));
+}
+
+// 原子种类名取元素符号："O1" -> "O"，"H_w" -> "H"，"Fe2" -> "Fe"
+std::string cp2kKindElement(std::string_view kind) {
+    std::string symbol;
+    for (char ch : kind) {
+        if (!std::isalpha(static_cast<unsigned char>(ch)) || symbol.size() == 2) {
+            break;
+        }
+        symbol.push_back(symbol.empty() ? static_cast<char>(std::toupper(static_cast<unsigned char>(ch)))
+                                        : static_cast<char>(std::tolower(static_cast<unsigned char>(ch))));
+    }
+    // 两个字母不构成元素时（如 "OW"）只取第一个字母
+    if (symbol.size() == 2 && getAtomicNumber(symbol) <= 0) {
+        symbol.resize(1);
+    }
+    return symbol.empty() ? std::string(kind) : symbol;
+}
+
+bool parseCP2KLengthUnit(std::string_view unit, double& scale) {
+    if (equalsIgnoreCase(unit, "angstrom")) {
+        scale = 1.0;
+    } else if (equalsIgnoreCase(unit, "bohr")) {
+        scale = CP2K_BOHR_TO_ANGSTROM;
+    } else if (equalsIgnoreCase(unit, "nm")) {
+        scale = 10.0;
+    } else if (equalsIgnoreCase(unit, "pm")) {
+        scale = 0.01;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// 逻辑关键字：单独出现或 .TRUE./T/TRUE/YES/ON 为真
+bool parseCP2KLogical(const std::string_view* parts, size_t count) {
+    if (count < 2) {
+        return true;
+    }
+    std::string_view value = parts[1];
+    return equalsIgnoreCase(value, ".TRUE.") || equalsIgnoreCase(value, "T") || equalsIgnoreCase(value, "TRUE") ||
+           equalsIgnoreCase(value, "YES") || equalsIgnoreCase(value, "ON");
+}
+
+} // namespace
+
+bool isCP2KTrajectory(std::string_view text) {
+    size_t pos = skipUtf8Bom(text);
+    std::string_view header;
+    std::string_view comment;
+    size_t atomCount = 0;
+    if (!nextRawLine(text, pos, header) || !parseFrameHeader(header, atomCount) || !nextRawLine(text, pos, comment)) {
+        return false;
+    }
+    double value = 0.0;
+    return findKeyNumber(comment, "i", value) && findKeyNumber(comment, "time", value);
+}
+
+// 读取 CP2K MD 轨迹：
+// 1. 当前线程只用 memchr 跳行找出各帧边界，同时分配原子数组、解析注释（步数、时间、能量）；
+// 2. 原子行按帧分给多个线程解析，每个线程只写自己的帧，不分配转换内存。
+std::vector<Frame> readCP2KTrajectory(std::string_view text, const UnitCell* cell) {
+    std::vector<Frame> frames;
+    try {
+        std::vector<CP2KFrameSpan> spans;
+        size_t pos = skipUtf8Bom(text);
+        std::string_view line;
+        size_t frameStart = pos;
+        while (nextRawLine(text, pos, line)) {
+            if (trimView(line).empty()) {
+                frameStart = pos;
+                continue;
+            }
+            CP2KFrameSpan span;
+            if (!parseFrameHeader(line, span.atomCount)) {
+                LOG_WARNING("Unexpected line in CP2K trajectory after frame " + std::to_string(spans.size()) + ": " +
+                            std::string(line.substr(0, 80)));
+                break;
+            }
+            if (!nextRawLine(text, pos, span.comment)) {
+                LOG_WARNING("CP2K trajectory ends after the header of frame " + std::to_string(spans.size() + 1));
+                break;
+            }
+            span.atomsOffset = pos;
+            if (!skipRawLines(text, pos, span.atomCount)) {
+                LOG_WARNING("Last CP2K frame is incomplete, ignored");
+                break;
+            }
+            if (spans.empty()) {
+                // 按第一帧的大小预留
+                spans.reserve(text.size() / std::max<size_t>(pos - frameStart, 1) + 1);
+            }
+            spans.push_back(span);
+            frameStart = pos;
+        }
+        if (spans.empty()) {
+            LOG_WARNING("No frames found in CP2K trajectory");
+            return frames;
+        }
+
+        frames.resize(spans.size());
+        size_t totalAtoms = 0;
+        for (size_t f = 0; f < spans.size(); ++f) {
+            Frame& frame = frames[f];
+            frame.atoms.resize(spans[f].atomCount);
+            frame.comment.assign(spans[f].comment);
+            parseCP2KComment(spans[f].comment, frame);
+            if (cell) {
+                frame.cell = *cell;
+            }
+            totalAtoms += spans[f].atomCount;
+        }
+
+        size_t chunkCount = 1;
+        if (totalAtoms >= PARALLEL_PARSE_MIN_ATOMS && spans.size() >= 2 * PARALLEL_CP2K_MIN_FRAMES) {
+            chunkCount = std::min<size_t>(hardwareConcurrency(), spans.size() / PARALLEL_CP2K_MIN_FRAMES);
+            chunkCount = std::max<size_t>(chunkCount, 1);
+        }
+        const size_t chunkSize = (spans.size() + chunkCount - 1) / chunkCount;
+        std::vector<char> failed(spans.size(), 0);
+        std::vector<std::unique_ptr<Thread>> workers;
+        workers.reserve(chunkCount - 1);
+        for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+            size_t first = chunk * chunkSize;
+            size_t last = std::min(spans.size(), first + chunkSize);
+            auto work = [text, &spans, &frames, &failed, first, last]() {
+                try {
+                    parseCP2KFrameRange(text, spans, frames, failed, first, last);
+                } catch (const std::exception& e) {
+                    LOG_ERROR("Exception parsing CP2K frames: " + std::string(e.what()));
+                    std::fill(failed.begin() + first, failed.begin() + last, 1);
+                }
+            };
+            auto worker = std::make_unique<Thread>();
+            if (!worker->start(work)) {
+                // 线程启动失败时在当前线程解析这一段
+                work();
+                continue;
+            }
+            workers.push_back(std::move(worker));
+        }
+        parseCP2KFrameRange(text, spans, frames, failed, 0, std::min(spans.size(), chunkSize));
+        for (auto& worker : workers) {
+            worker->join();
+        }
+
+        // 有无效原子行的帧整帧丢弃，保持与 XYZ 读取一致
+        size_t kept = 0;
+        for (size_t f = 0; f < frames.size(); ++f) {
+            if (failed[f]) {
+                LOG_WARNING("CP2K frame " + std::to_string(f + 1) + " has invalid atom lines, skipped");
+                continue;
+            }
+            if (kept != f) {
+                frames[kept] = std::move(frames[f]);
+            }
+            ++kept;
+        }
+        frames.resize(kept);
+
+        LOG_INFO("Read " + std::to_string(frames.size()) + " CP2K frames (" + std::to_string(totalAtoms) +
+                 " atoms) in " + std::to_string(chunkCount) + " chunks");
+    } catch (const MemoryBudgetExceeded&) {
+        throw;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception in readCP2KTrajectory: " + std::string(e.what()));
+        frames.clear();
+    }
+    return frames;
+}
+
+size_t applyCP2KCellFile(const TextLines& lines, std::vector<Frame>& frames) {
+    // 每行：Step Time Ax Ay Az Bx By Bz Cx Cy Cz Volume，按步数升序
+    std::vector<std::pair<long long, UnitCell>> cells;
+    std::string_view parts[11];
+    for (size_t i = 0; i < lines.lineCount(); ++i) {
+        std::string_view line = trimView(lines.line(i));
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        double step = 0.0;
+        UnitCell cell;
+        bool valid = splitWhitespaceViews(line, parts, 11) == 11 && parseDouble(parts[0], step);
+        for (int k = 0; valid && k < 9; ++k) {
+            valid = parseDouble(parts[2 + k], cell.vectors[k / 3][k % 3]);
+        }
+        if (!valid) {
+            LOG_WARNING("Invalid line in CP2K cell file: " + std::string(line.substr(0, 80)));
+            continue;
+        }
+        cell.count = 3;
+        cells.emplace_back(static_cast<long long>(step), cell);
+    }
+    if (cells.empty()) {
+        return 0;
+    }
+
+    // 每帧取步数不大于本帧的最后一个晶胞；步数未知的帧沿用前一帧
+    size_t assigned = 0;
+    size_t next = 0;
+    const UnitCell* current = nullptr;
+    for (auto& frame : frames) {
+        while (frame.step >= 0 && next < cells.size() && cells[next].first <= frame.step) {
+            current = &cells[next].second;
+            ++next;
+        }
+        if (current) {
+            frame.cell = *current;
+            ++assigned;
+        }
+    }
+    return assigned;
+}
+
+bool isCP2KInput(const TextLines& lines) {
+    for (size_t i = 0; i < lines.lineCount(); ++i) {
+        std::string_view line = stripCP2KComment(lines.line(i));
+        std::string_view keyword;
+        if (splitWhitespaceViews(line, &keyword, 1) == 1 && equalsIgnoreCase(keyword, "&COORD")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Frame readCP2KInput(const TextLines& lines) {
+    Frame frame;
+    frame.comment = "CP2K input (&COORD)";
+
+    try {
+        bool inCoord = false;
+        bool scaled = false;
+        double scale = 1.0;
+        std::string_view parts[4];
+        for (size_t i = 0; i < lines.lineCount(); ++i) {
+            std::string_view line = stripCP2KComment(lines.line(i));
+            size_t count = splitWhitespaceViews(line, parts, 4);
+            if (count == 0) {
+                continue;
+            }
+            if (!inCoord) {
+                inCoord = equalsIgnoreCase(parts[0], "&COORD");
+                continue;
+            }
+            if (parts[0][0] == '&') {
+                // &END COORD：只读第一个 &COORD 段
+                break;
+            }
+            if (equalsIgnoreCase(parts[0], "UNIT")) {
+                if (count < 2 || !parseCP2KLengthUnit(parts[1], scale)) {
+                    LOG_WARNING("Unsupported &COORD unit: " + std::string(line) + ", assuming angstrom");
+                    scale = 1.0;
+                }
+                continue;
+            }
+            if (equalsIgnoreCase(parts[0], "SCALED")) {
+                scaled = parseCP2KLogical(parts, count);
+                continue;
+            }
+
+            Atom atom;
+            if (count < 4 || !parseDouble(parts[1], atom.x) || !parseDouble(parts[2], atom.y) ||
+                !parseDouble(parts[3], atom.z)) {
+                LOG_WARNING("Invalid &COORD line: " + std::string(line));
+                continue;
+            }
+            atom.symbol = cp2kKindElement(parts[0]);
+            frame.atoms.push_back(std::move(atom));
+        }
+
+        if (!parseCP2KCell(lines, frame.cell)) {
+            frame.cell = UnitCell();
+        }
+        if (scaled) {
+            // 分数坐标：r = f·(A, B, C)，UNIT 对分数坐标不起作用
+            if (frame.cell.count != 3) {
+                LOG_WARNING("SCALED coordinates without a 3D &CELL, coordinates kept as fractions");
+            } else {
+                const auto& v = frame.cell.vectors;
+                for (auto& atom : frame.atoms) {
+                    const double f[3] = {atom.x, atom.y, atom.z};
+                    atom.x = f[0] * v[0][0] + f[1] * v[1][0] + f[2] * v[2][0];
+                    atom.y = f[0] * v[0][1] + f[1] * v[1][1] + f[2] * v[2][1];
+                    atom.z = f[0] * v[0][2] + f[1] * v[1][2] + f[2] * v[2][2];
+                }
+            }
+        } else if (scale != 1.0) {
+            for (auto& atom : frame.atoms) {
+                atom.x *= scale;
+                atom.y *= scale;
+                atom.z *= scale;
+            }
+        }
+
+        if (frame.atoms.empty()) {
+            LOG_WARNING("No atoms found in CP2K &COORD section");
+        } else {
+            LOG_INFO("Parsed " + std::to_string(frame.atoms.size()) + " atoms from CP2K input (cell vectors: " +
+                     std::to_string(frame.cell.count) + ")");
+        }
+    } catch (const MemoryBudgetExceeded&) {
+        throw;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception in readCP2KInput: " + std::string(e.what()));
+    }
+
+    return frame;
+}
+
+// ========== Chem3D / CML ==========
+
+namespace {
+
+// 从 <atom> 标签的属性中一次读出元素与坐标，不复制属性：
+// - Chem3D：symbol="C" cartCoords="x y z"
+// - CML：elementType="C" x3="" y3="" z3=""（或 xyz3="x y z"；只有 x2/y2 时 z 取 0）
+bool readXmlAtom(std::string_view attributes, Atom& atom) {
+    std::string_view symbol, triple, x3, y3, z3, x2, y2;
+    size_t pos = 0;
+    std::string_view name;
+    std::string_view value;
+    while (nextXmlAttribute(attributes, pos, name, value)) {
+        if (name == "symbol" || name == "elementType") {
+            symbol = trimView(value);
+        } else if (name == "cartCoords" || name == "xyz3") {
+            triple = value;
+        } else if (name == "x3") {
+            x3 = value;
+        } else if (name == "y3") {
+            y3 = value;
+        } else if (name == "z3") {
+            z3 = value;
+        } else if (name == "x2") {
+            x2 = value;
+        } else if (name == "y2") {
+            y2 = value;
+        }
+    }
+    if (symbol.empty()) {
+        return false;
+    }
+
+    if (!triple.empty()) {
+        std::string_view parts[3];
+        if (splitWhitespaceViews(triple, parts, 3) < 3 || !parseDouble(parts[0], atom.x) ||
+            !parseDouble(parts[1], atom.y) || !parseDouble(parts[2], atom.z)) {
+            return false;
+        }
+    } else if (!x3.empty() && !y3.empty() && !z3.empty()) {
+        if (!parseDouble(trimView(x3), atom.x) || !parseDouble(trimView(y3), atom.y) ||
+            !parseDouble(trimView(z3), atom.z)) {
+            return false;
+        }
+    } else if (!x2.empty() && !y2.empty()) {
+        if (!parseDouble(trimView(x2), atom.x) || !parseDouble(trimView(y2), atom.y)) {
+            return false;
+        }
+        atom.z = 0.0;
+    } else {
+        return false;
+    }
+    atom.symbol.assign(symbol);
+    return true;
+}
+
+bool isXmlAtomTag(const XmlTag& tag) {
+    return tag.kind != XmlTagKind::Close && xmlLocalName(tag.name) == "atom";
+}
+
+} // namespace
+
+bool isXmlStructure(std::string_view text) {
+    size_t first = text.find_first_not_of(" \t\r\n", skipUtf8Bom(text));
+    if (first == std::string_view::npos || text[first] != '<') {
+        return false;
+    }
+    // 第一个 <atom> 带有元素和坐标即可
+    XmlScanner scanner(text);
+    XmlTag tag;
+    while (scanner.next(tag)) {
+        if (isXmlAtomTag(tag)) {
+            Atom atom;
+            return readXmlAtom(tag.attributes, atom);
+        }
+    }
+    return false;
+}
+
+std::vector<Frame> readXmlStructure(std::string_view text) {
+    std::vector<Frame> frames;
+    try {
+        XmlScanner scanner(text);
+        XmlTag tag;
+        Frame current;
+        std::string_view title;
+        int moleculeDepth = 0;
+        size_t skipped = 0;
+
+        auto finishFrame = [&frames, &current, &title]() {
+            if (current.atoms.empty()) {
+                return;
+            }
+            current.comment.assign(title.empty() ? std::string_view("Converted from Chem3D/CML XML") : title);
+            frames.push_back(std::move(current));
+            current = Frame();
+        };
+
+        while (scanner.next(tag)) {
+            std::string_view name = xmlLocalName(tag.name);
+            // 每个最外层 <molecule> 为一帧（CML 中的多个构象）；没有 <molecule> 时全部原子为一帧
+            if (name == "molecule") {
+                if (tag.kind == XmlTagKind::Open && moleculeDepth++ == 0) {
+                    if (!findXmlAttribute(tag.attributes, "title", title) &&
+                        !findXmlAttribute(tag.attributes, "id", title)) {
+                        title = std::string_view();
+                    }
+                } else if (tag.kind == XmlTagKind::Close && moleculeDepth > 0 && --moleculeDepth == 0) {
+                    finishFrame();
+                }
+                continue;
+            }
+            if (name != "atom" || tag.kind == XmlTagKind::Close) {
+                continue;
+            }
+            Atom atom;
+            if (readXmlAtom(tag.attributes, atom)) {
+                current.atoms.push_back(std::move(atom));
+            } else {
+                ++skipped;
+            }
+        }
+        finishFrame();
+
+        if (skipped > 0) {
+            LOG_WARNING("Skipped " + std::to_string(skipped) + " XML atom(s) without element or coordinates");
+        }
+        if (frames.empty()) {
+            LOG_WARNING("No atoms found in Chem3D/CML XML");
+        } else {
+            LOG_INFO("Parsed " + std::to_string(frames.size()) + " frame(s) with " +
+                     std::to_string(frames[0].atoms.size()) + " atoms from Chem3D/CML XML");
+        }
+    } catch (const MemoryBudgetExceeded&) {
+        throw;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception in readXmlStructure: " + std::string(e.what()));
+        frames.clear();
+    }
+    return frames;
+}
+
 // 解析Gaussian clipboard文件
 std::vector<Atom> parseGaussianClipboard(const std::string& filename) {
-    std::vector<Atom> atoms;
-    
     try {
         // 使用编码检测读取文件
         EncodedFileContent fileContent = readFileWithEncoding(filename);
         
         if (fileContent.content.empty()) {
             LOG_ERROR("Cannot open Gaussian clipboard file: " + filename);
-            return atoms;
+            return {};
         }
         
-        // 按行分割内容
-        std::vector<std::string> lines = splitLines(fileContent.content, true);
-        
-        if (lines.empty()) {
+        return parseGaussianClipboardText(fileContent);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception parsing Gaussian clipboard: " + std::string(e.what()));
+        return {};
+    }
+}
+
+// 解析已读入的 Gaussian clipboard 内容（行视图切分，不逐行构造字符串流）
+std::vector<Atom> parseGaussianClipboardText(const TextLines& lines) {
+    std::vector<Atom> atoms;
+    
+    try {
+        if (lines.lineCount() == 0) {
             LOG_ERROR("Empty file or cannot read header");
             return atoms;
         }
         
         // 跳过第一行（头部）
         // 第二行是原子数量
-        if (lines.size() < 2) {
+        if (lines.lineCount() < 2) {
             LOG_ERROR("Cannot read number of atoms");
             return atoms;
         }
         
-        std::string& atomCountLine = lines[1];
-        
-        int numAtoms;
-        try {
-            numAtoms = std::stoi(atomCountLine);
-            LOG_DEBUG("Expected number of atoms: " + std::to_string(numAtoms));
-        } catch (const std::exception& e) {
-            LOG_ERROR("Cannot parse number of atoms: " + atomCountLine);
+        std::string_view atomCountLine = trimView(lines.line(1));
+        int numAtoms = 0;
+        auto countResult = std::from_chars(atomCountLine.data(), atomCountLine.data() + atomCountLine.size(), numAtoms);
+        if (countResult.ec != std::errc() || countResult.ptr == atomCountLine.data()) {
+            LOG_ERROR("Cannot parse number of atoms: " + std::string(atomCountLine));
             return atoms;
         }
+        LOG_DEBUG("Expected number of atoms: " + std::to_string(numAtoms));
+        if (numAtoms > 0) {
+            atoms.reserve(static_cast<size_t>(numAtoms));
+        }
         
-        // 读取原子数据（从第三行开始）
+        // 读取原子数据（从第三行开始）：原子序数 X Y Z [标签]
+        std::string_view parts[4];
         for (int i = 0; i < numAtoms; i++) {
             size_t lineIndex = 2 + static_cast<size_t>(i);
-            if (lineIndex >= lines.size()) {
+            if (lineIndex >= lines.lineCount()) {
                 LOG_WARNING("Expected " + std::to_string(numAtoms) + " atoms, but only found " + std::to_string(i));
                 break;
             }
             
-            std::string& line = lines[lineIndex];
-            
-            std::istringstream iss(line);
-            int atomicNumber;
-            double x, y, z;
-            std::string label;
+            std::string_view line = lines.line(lineIndex);
+            int atomicNumber = 0;
+            Atom atom;
+            bool parsed = splitWhitespaceViews(line, parts, 4) == 4;
+            if (parsed) {
+                auto result = std::from_chars(parts[0].data(), parts[0].data() + parts[0].size(), atomicNumber);
+                parsed = result.ec == std::errc() && result.ptr == parts[0].data() + parts[0].size() &&
+                         parseDouble(parts[1], atom.x) && parseDouble(parts[2], atom.y) && parseDouble(parts[3], atom.z);
+            }
+            if (!parsed) {
+                LOG_WARNING("Cannot parse atom data in line: " + std::string(line));
+                continue;
+            }
             
-            if (iss >> atomicNumber >> x >> y >> z) {
-                // 可选的标签
-                iss >> label;
-                
-                auto it = atomicNumberToSymbol.find(atomicNumber);
-                if (it != atomicNumberToSymbol.end()) {
-                    Atom atom;
-                    atom.symbol = it->second;
-                    atom.x = x;
-                    atom.y = y;
-                    atom.z = z;
-                    atoms.push_back(atom);
-                    
-                    LOG_DEBUG("Added atom " + std::to_string(i + 1) + ": " + atom.symbol + 
-                             " (" + std::to_string(atomicNumber) + ") at (" + 
-                             std::to_string(atom.x) + ", " + std::to_string(atom.y) + ", " + std::to_string(atom.z) + ")");
-                } else {
-                    LOG_WARNING("Unknown atomic number " + std::to_string(atomicNumber) + " in line: " + line);
-                }
-            } else {
-                LOG_WARNING("Cannot parse atom data in line: " + line);
+            auto it = atomicNumberToSymbol.find(atomicNumber);
+            if (it == atomicNumberToSymbol.end()) {
+                LOG_WARNING("Unknown atomic number " + std::to_string(atomicNumber) + " in line: " + std::string(line));
+                continue;
             }
+            atom.symbol = it->second;
+            atoms.push_back(std::move(atom));
         }
         
         LOG_INFO("Parsed " + std::to_string(atoms.size()) + " atoms from Gaussian clipboard");
@@ -559,23 +1483,16 @@ std::vector<Atom> parseGaussianClipboard(const std::string& filename) {
     return atoms;
 }
 
-// 创建XYZ字符串
+// 创建XYZ字符串（坐标小数位数取 xyz_precision）
 std::string createXYZString(const std::vector<Atom>& atoms) {
     try {
-        std::ostringstream oss;
-        
-        oss << atoms.size() << std::endl;
-        oss << "Converted from Gaussian clipboard" << std::endl;
-        
-        for (const auto& atom : atoms) {
-            oss << std::left << std::setw(2) << atom.symbol 
-                << " " << std::right << std::setw(12) << std::fixed << std::setprecision(6) << atom.x
-                << " " << std::right << std::setw(12) << std::fixed << std::setprecision(6) << atom.y
-                << " " << std::right << std::setw(12) << std::fixed << std::setprecision(6) << atom.z
-                << std::endl;
+        std::string output;
+        output.reserve(estimateXYZBytes(atoms.size(), 1, g_config.xyzPrecision));
+        {
+            TextSink sink(output);
+            writeXYZFrame(sink, atoms.data(), atoms.size(), "Converted from Gaussian clipboard", xyzWriteOptionsFromConfig());
         }
-        
-        return oss.str();
+        return output;
     } catch (const std::exception& e) {
         LOG_ERROR("Exception creating XYZ string: " + std::string(e.what()));
         return "";
@@ -583,19 +1500,26 @@ std::string createXYZString(const std::vector<Atom>& atoms) {
 }
 
 // 写入Gaussian LOG头部
-std::string writeGaussianLogHeader() {
-    return " ! Entering Gaussian System? Nops, this line just for Multiwfn analysis.\n"
+void writeGaussianLogHeader(std::ostream& oss, const std::string& remarks) {
+    oss << " ! Entering Gaussian System? Nops, this line just for Multiwfn analysis.\n"
            " ! This file was generated by XYZ Monitor\n"
-           " \n"
+        << remarks
+        << " \n"
            " 0 basis functions\n"
            " 0 alpha electrons\n"
            " 0 beta electrons\n"
            "GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n";
 }
 
-// 写入Gaussian LOG几何结构部分
-std::string writeGaussianLogGeometry(const Frame& frame, int frameNumber, const Frame* previousFrame) {
+std::string writeGaussianLogHeader() {
     std::ostringstream oss;
+    writeGaussianLogHeader(oss);
+    return oss.str();
+}
+
+// 写入Gaussian LOG几何结构部分
+void writeGaussianLogGeometry(std::ostream& oss, const Frame& frame, int frameNumber, const Frame* previousFrame) {
+    resetStreamFormat(oss);
     
     oss << "GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n";
     oss << " \n";
@@ -605,15 +1529,27 @@ std::string writeGaussianLogGeometry(const Frame& frame, int frameNumber, const
     oss << " Number     Number       Type             X           Y           Z\n";
     oss << " ---------------------------------------------------------------------\n";
     
+    // 坐标行直接格式化到栈缓冲区（与 std::fixed/setprecision(6)/setw(10) 输出一致），
+    // 百万原子的帧也只是逐行追加，不经过流的格式化开销
+    char row[COORDINATE_ROW_CAPACITY];
     for (size_t i = 0; i < frame.atoms.size(); ++i) {
         const Atom& atom = frame.atoms[i];
         int atomicNum = getAtomicNumber(atom.symbol);
-        
-        oss << "      " << (i + 1) << "          " << atomicNum 
-            << "           0        " << std::fixed << std::setprecision(6)
-            << std::setw(10) << atom.x << "    "
-            << std::setw(10) << atom.y << "    "
-            << std::setw(10) << atom.z << "\n";
+        size_t length = formatStandardOrientationRow(row, i + 1, atomicNum, atom);
+        oss.write(row, static_cast<std::streamsize>(length));
+    }
+    // 晶胞矢量写成原子序数 -2 的 Tv 行，GView 据此显示晶胞
+    for (int v = 0; v < frame.cell.count; ++v) {
+        Atom vector;
+        vector.x = frame.cell.vectors[v][0];
+        vector.y = frame.cell.vectors[v][1];
+        vector.z = frame.cell.vectors[v][2];
+        size_t length = formatStandardOrientationRow(row, frame.atoms.size() + v + 1, -2, vector);
+        oss.write(row, static_cast<std::streamsize>(length));
+    }
+    if (!frame.atoms.empty()) {
+        // 保持与逐项输出相同的流格式状态（后续收敛信息沿用）
+        oss << std::fixed << std::setprecision(6);
     }
     
     oss << " ---------------------------------------------------------------------\n";
@@ -689,84 +1625,240 @@ std::string writeGaussianLogGeometry(const Frame& frame, int frameNumber, const
     } else {
         oss << " RMS     Displacement     1.000000     " << std::setw(8) << RMS_DISP_THRESHOLD << "     NO\n";
     }
-    
-    return oss.str();
 }
 
-// 写入Gaussian LOG尾部
-std::string writeGaussianLogFooter(const std::vector<Frame>& frames) {
+std::string writeGaussianLogGeometry(const Frame& frame, int frameNumber, const Frame* previousFrame) {
     std::ostringstream oss;
-    
-    oss << "GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n";
-    
-    // 检查是否有电荷数据（任意一个原子的charge不为0）
-    bool hasChargeData = false;
+    writeGaussianLogGeometry(oss, frame, frameNumber, previousFrame);
+    return oss.str();
+}
+
+namespace {
+
+// 通道名对应的首选位置：0 Mulliken、1 APT、2 自旋密度，其他返回 3
+int preferredChargeSection(const std::string& name) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char ch) {
+        return static_cast<char>(std::tolower(ch));
+    });
+    if (lower.find("mulliken") != std::string::npos) {
+        return 0;
+    }
+    if (lower.find("hirshfeld") != std::string::npos) {
+        return 1;
+    }
+    if (lower.find("adch") != std::string::npos) {
+        return 2;
+    }
+    return 3;
+}
+
+// 某位置上的电荷，位置为空或通道不存在时为 0
+double mappedCharge(const Frame& frame, int channel, size_t atom) {
+    if (channel < 0 || static_cast<size_t>(channel) >= frame.chargeChannelCount()) {
+        return 0.0;
+    }
+    return frame.channelCharge(static_cast<size_t>(channel), atom);
+}
+
+bool framesHaveChargeData(const std::vector<Frame>& frames) {
     for (const auto& frame : frames) {
+        if (!frame.chargeChannels.empty()) {
+            return true;
+        }
         for (const auto& atom : frame.atoms) {
             if (atom.charge != 0.0) {
-                hasChargeData = true;
-                break;
+                return true;
             }
         }
-        if (hasChargeData) break;
     }
+    return false;
+}
+
+} // namespace
+
+std::vector<GaussianChargeMapping> mapGaussianChargeChannels(const Frame& frame) {
+    const size_t channelCount = frame.chargeChannelCount();
+    // 有首选位置的通道按位置排在前面，其余保持原顺序
+    std::vector<std::pair<int, int>> order;     // (首选位置, 通道)
+    for (size_t c = 0; c < channelCount; ++c) {
+        const std::string name = c < frame.chargeChannels.size() ? frame.chargeChannels[c] : std::string();
+        order.emplace_back(preferredChargeSection(name), static_cast<int>(c));
+    }
+    std::stable_sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<GaussianChargeMapping> mappings;
+    GaussianChargeMapping current;
+    bool used = false;
+    for (const auto& [preferred, channel] : order) {
+        int section = -1;
+        if (preferred < 3 && current.channels[preferred] < 0) {
+            section = preferred;
+        } else {
+            for (int s = 0; s < 3 && section < 0; ++s) {
+                if (current.channels[s] < 0) {
+                    section = s;
+                }
+            }
+        }
+        // 三个位置都已占用：另起一组
+        if (section < 0) {
+            mappings.push_back(current);
+            current = GaussianChargeMapping();
+            section = preferred < 3 ? preferred : 0;
+        }
+        current.channels[section] = channel;
+        used = true;
+    }
+    if (used) {
+        mappings.push_back(current);
+    }
+    return mappings;
+}
+
+const char* gaussianChargeSectionName(int section) {
+    switch (section) {
+        case 0: return "Mulliken charges";
+        case 1: return "APT charges";
+        case 2: return "Mulliken spin densities";
+        default: return "Other charges";
+    }
+}
+
+// 写入Gaussian LOG尾部
+void writeGaussianLogFooter(std::ostream& oss, const std::vector<Frame>& frames, const GaussianChargeMapping* mapping) {
+    resetStreamFormat(oss);
     
-    // 如果有电荷数据，写入Mulliken charges部分
-    if (hasChargeData) {
+    oss << "GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n";
+    
+    // 如果有电荷数据（任意一个原子的charge不为0，或带命名的电荷通道），写入电荷部分
+    if (framesHaveChargeData(frames)) {
         // 使用最后一帧的原子信息
         const Frame& lastFrame = frames.back();
+        const GaussianChargeMapping sections = mapping ? *mapping : mapGaussianChargeChannels(lastFrame).front();
+        const int mullikenChannel = sections.channels[0];
+        const int aptChannel = sections.channels[1];
+        const int spinChannel = sections.channels[2];
         
         oss << " \n";
         oss << "          Condensed to atoms (all electrons):\n";
         oss << " Mulliken charges and spin densities:\n";
         oss << "               1          2\n";
         
+        double totalCharge = 0.0;
+        double totalSpin = 0.0;
         for (size_t i = 0; i < lastFrame.atoms.size(); ++i) {
             const Atom& atom = lastFrame.atoms[i];
+            const double charge = mappedCharge(lastFrame, mullikenChannel, i);
+            const double spin = mappedCharge(lastFrame, spinChannel, i);
+            totalCharge += charge;
+            totalSpin += spin;
             oss << "     " << std::setw(2) << (i + 1) << "  " 
                 << std::setw(2) << std::left << atom.symbol << std::right << "   "
-                << std::fixed << std::setprecision(6) << std::setw(8) << atom.charge 
-                << "  " << std::setw(8) << 0.0 << "\n";  // spin density设为0
-        }
-        
-        // 计算电荷总和
-        double totalCharge = 0.0;
-        for (const auto& atom : lastFrame.atoms) {
-            totalCharge += atom.charge;
+                << std::fixed << std::setprecision(6) << std::setw(8) << charge 
+                << "  " << std::setw(8) << spin << "\n";
         }
         
         oss << "\n Sum of Mulliken charges =  " << std::fixed << std::setprecision(5) 
-            << std::setw(8) << totalCharge << "   " << std::setw(8) << 0.0 << "\n";
+            << std::setw(8) << totalCharge << "   " << std::setw(8) << totalSpin << "\n";
+        
+        // APT charges 部分只在该位置有通道时写出
+        if (aptChannel >= 0) {
+            oss << "\n\n APT charges:\n";
+            oss << "               1\n";
+            double totalApt = 0.0;
+            for (size_t i = 0; i < lastFrame.atoms.size(); ++i) {
+                const double charge = mappedCharge(lastFrame, aptChannel, i);
+                totalApt += charge;
+                oss << "     " << std::setw(2) << (i + 1) << "  "
+                    << std::setw(2) << std::left << lastFrame.atoms[i].symbol << std::right << "    "
+                    << std::fixed << std::setprecision(6) << std::setw(8) << charge << "\n";
+            }
+            oss << " Sum of APT charges =  " << std::fixed << std::setprecision(5) << std::setw(8) << totalApt << "\n";
+        }
     }
     
     oss << " Normal termination of Gaussian\n";
-    
+}
+
+std::string writeGaussianLogFooter(const std::vector<Frame>& frames) {
+    std::ostringstream oss;
+    writeGaussianLogFooter(oss, frames);
     return oss.str();
 }
 
-// 转换为Gaussian LOG格式
-std::string convertToGaussianLog(const std::vector<Frame>& frames) {
+// 写出完整的 Gaussian LOG（头部、各帧几何结构、尾部）
+void writeGaussianLog(TextSink& sink, const std::vector<Frame>& frames, const GaussianChargeMapping* mapping) {
+    TextSinkStreamBuffer buffer(sink);
+    std::ostream oss(&buffer);
+    
+    // 命名的电荷通道：头部注明各位置对应哪个通道
+    std::string remarks;
+    if (!frames.empty() && !frames.back().chargeChannels.empty()) {
+        const Frame& lastFrame = frames.back();
+        const GaussianChargeMapping sections = mapping ? *mapping : mapGaussianChargeChannels(lastFrame).front();
+        remarks = " ! Charge type mapping:\n";
+        for (int section = 0; section < 3; ++section) {
+            const int channel = sections.channels[section];
+            std::string name = gaussianChargeSectionName(section);
+            name.resize(24, ' ');
+            remarks += " !   " + name + "<- " +
+                       (channel >= 0 && static_cast<size_t>(channel) < lastFrame.chargeChannels.size()
+                            ? lastFrame.chargeChannels[channel] : std::string("None")) + "\n";
+        }
+    }
+    writeGaussianLogHeader(oss, remarks);
+    
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const Frame* previousFrame = (i > 0) ? &frames[i - 1] : nullptr;
+        writeGaussianLogGeometry(oss, frames[i], static_cast<int>(i + 1), previousFrame);
+    }
+    
+    writeGaussianLogFooter(oss, frames, mapping);
+    oss.flush();
+}
+
+// 转换为Gaussian LOG格式，写入 output（先清空，保留已有容量）
+bool writeGaussianLog(const std::vector<Frame>& frames, std::string& output) {
+    output.clear();
     if (frames.empty()) {
         LOG_ERROR("No frames to convert");
-        return "";
+        return false;
     }
     
     try {
-        std::ostringstream oss;
-        
-        oss << writeGaussianLogHeader();
-        
-        for (size_t i = 0; i < frames.size(); ++i) {
-            const Frame* previousFrame = (i > 0) ? &frames[i - 1] : nullptr;
-            oss << writeGaussianLogGeometry(frames[i], static_cast<int>(i + 1), previousFrame);
+        // 按原子总数一次预留输出缓冲区（原子序号位数多时略有余量），写出时间随原子数线性增长；
+        // 输出缓冲区计入内存预算
+        size_t totalAtoms = 0;
+        for (const auto& frame : frames) {
+            totalAtoms += frame.atoms.size();
         }
-        
-        oss << writeGaussianLogFooter(frames);
+        const size_t expectedBytes = estimateGaussianLogBytes(totalAtoms, frames.size());
+        TrackedBytes outputBytes;
+        output.reserve(expectedBytes + expectedBytes / 8);
+        outputBytes.update(output.capacity());
+        {
+            TextSink sink(output);
+            writeGaussianLog(sink, frames);
+        }
+        outputBytes.update(output.capacity());
         
         LOG_DEBUG("Converted " + std::to_string(frames.size()) + " frames to Gaussian log format");
-        return oss.str();
+        return true;
+    } catch (const MemoryBudgetExceeded&) {
+        output.clear();
+        throw;
     } catch (const std::exception& e) {
         LOG_ERROR("Exception in convertToGaussianLog: " + std::string(e.what()));
+        output.clear();
+        return false;
+    }
+}
+
+std::string convertToGaussianLog(const std::vector<Frame>& frames) {
+    std::string output;
+    if (!writeGaussianLog(frames, output)) {
         return "";
     }
-}
\ No newline at end of file
+    return output;
+}
@@ -1,33 +1,84 @@
 #pragma once
 
 #include "core.h"
+#include "text_output.h"
+#include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // 格式检测函数
-bool isValidCoordinateLine(const std::string& line);
-bool isSimplifiedXYZFormat(const std::vector<std::string>& lines);
+// 带 TextLines 参数的重载直接使用已建立的行索引，不再重复分行
+bool isValidCoordinateLine(std::string_view line);
+bool isSimplifiedXYZFormat(const TextLines& lines);
 bool isXYZFormat(const std::string& content);
+bool isXYZFormat(const TextLines& lines);
 bool isChgFormat(const std::string& content);
+bool isChgFormat(const TextLines& lines);
 
 // 优化信息解析函数
-OptimizationInfo parseOptimizationInfo(const std::string& comment);
+OptimizationInfo parseOptimizationInfo(std::string_view comment);
 double parseScientificNumber(const std::string& str);
 
 // XYZ读取函数
-bool readXYZFrame(const std::vector<std::string>& lines, size_t startLine, Frame& frame, size_t& nextStart);
+bool readXYZFrame(const TextLines& lines, size_t startLine, Frame& frame, size_t& nextStart);
 std::vector<Frame> readMultiXYZ(const std::string& content);
+std::vector<Frame> readMultiXYZ(const TextLines& lines);
 
 // CHG格式读取函数
 Frame readChgFrame(const std::string& content);
+Frame readChgFrame(const TextLines& lines);
+
+// CP2K 读取函数
+// MD 轨迹（*-pos-*.xyz）：注释行为 "i = 步数, time = fs, E = Hartree"，可直接在映射的文件上解析
+bool isCP2KTrajectory(std::string_view text);
+// 一次扫描读出全部帧，填入步数、时间与能量；cell 非空时每帧带上该晶胞
+std::vector<Frame> readCP2KTrajectory(std::string_view text, const UnitCell* cell = nullptr);
+// CP2K 晶胞文件（*-1.cell，NPT 模拟输出）：按步数把晶胞赋给各帧，返回带上晶胞的帧数
+size_t applyCP2KCellFile(const TextLines& lines, std::vector<Frame>& frames);
+// 输入文件：第一个 &COORD 段的原子（支持 UNIT、SCALED）与 &CELL 段的晶胞
+bool isCP2KInput(const TextLines& lines);
+Frame readCP2KInput(const TextLines& lines);
+
+// Chem3D / CML 读取函数（XML，流式扫描，不分配属性字符串）
+// 第一个 <atom> 带有元素与坐标（Chem3D 的 symbol/cartCoords 或 CML 的 elementType/x3 y3 z3）时识别为结构 XML
+bool isXmlStructure(std::string_view text);
+// 每个最外层 <molecule> 读成一帧，没有 <molecule> 时全部原子为一帧
+std::vector<Frame> readXmlStructure(std::string_view text);
 
 // Gaussian相关函数
 std::vector<Atom> parseGaussianClipboard(const std::string& filename);
+std::vector<Atom> parseGaussianClipboardText(const TextLines& lines);
 std::string createXYZString(const std::vector<Atom>& atoms);
 
 // Gaussian LOG格式转换
+// 带 std::ostream 参数的重载直接写入调用方的流，返回 std::string 的版本为其包装
+// remarks 为附加的 " ! ..." 注释行（含换行），写在文件开头的说明之后
+void writeGaussianLogHeader(std::ostream& os, const std::string& remarks = "");
 std::string writeGaussianLogHeader();
 // 修改：增加previousFrame参数，用于在当前帧缺少收敛信息时使用前一帧的数据
+void writeGaussianLogGeometry(std::ostream& os, const Frame& frame, int frameNumber, const Frame* previousFrame = nullptr);
 std::string writeGaussianLogGeometry(const Frame& frame, int frameNumber, const Frame* previousFrame = nullptr);
+
+// 日志中可存放原子电荷的三个位置（GView 可按其着色）：
+// channels[0] Mulliken charges、channels[1] APT charges、channels[2] Mulliken spin densities，
+// 值为 Frame 的电荷通道下标，-1 表示该位置为空
+struct GaussianChargeMapping {
+    int channels[3] = {-1, -1, -1};
+};
+// 按通道名分配位置（与 ChargefakeG.sh 相同）：名称含 mulliken / hirshfeld / adch（不区分大小写）的通道
+// 优先放到 Mulliken / APT / 自旋密度，其余依次填空位；超过三个通道时分成多组，每组写成一个日志。
+// 只有一个未命名通道时为 {0, -1, -1}
+std::vector<GaussianChargeMapping> mapGaussianChargeChannels(const Frame& frame);
+// 各位置的名称，用于日志头部与映射表
+const char* gaussianChargeSectionName(int section);
+
+// 电荷取最后一帧；mapping 为空时使用 mapGaussianChargeChannels 的第一组
+void writeGaussianLogFooter(std::ostream& os, const std::vector<Frame>& frames,
+                            const GaussianChargeMapping* mapping = nullptr);
 std::string writeGaussianLogFooter(const std::vector<Frame>& frames);
+// 写出到 sink（多格式写出器共用的入口）；有命名电荷通道时在头部注明各位置对应的通道
+void writeGaussianLog(TextSink& sink, const std::vector<Frame>& frames, const GaussianChargeMapping* mapping = nullptr);
+// 写入 output（清空后复用其容量，供热键流程跨次复用输出缓冲区），失败返回 false
+bool writeGaussianLog(const std::vector<Frame>& frames, std::string& output);
 std::string convertToGaussianLog(const std::vector<Frame>& frames);
\ No newline at end of file
@@ -3,11 +3,16 @@
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 
 namespace {
 
+// 与 "C" locale 下的 std::isspace 相同（程序不切换 locale），逐字符扫描时不再经过 locale 查表
 bool isSpaceChar(unsigned char ch) {
-    return std::isspace(ch) != 0;
+    return ch == ' ' || (ch >= '\t' && ch <= '\r');
 }
 
 } // namespace
@@ -119,17 +124,101 @@ std::vector<std::string> splitLines(const std::string& str, bool keepEmpty) {
     return lines;
 }
 
-// 字符串分割（多个分隔符）
-std::vector<std::string> splitWhitespace(const std::string& str) {
+// 按空白分割（直接扫描，不经过 istringstream）
+std::vector<std::string> splitWhitespace(std::string_view str) {
     std::vector<std::string> tokens;
-    std::istringstream iss(str);
-    std::string token;
-    while (iss >> token) {
-        tokens.push_back(token);
+    size_t i = 0;
+    while (i < str.size()) {
+        while (i < str.size() && isSpaceChar(static_cast<unsigned char>(str[i]))) {
+            ++i;
+        }
+        size_t start = i;
+        while (i < str.size() && !isSpaceChar(static_cast<unsigned char>(str[i]))) {
+            ++i;
+        }
+        if (i > start) {
+            tokens.emplace_back(str.substr(start, i - start));
+        }
     }
     return tokens;
 }
 
+// 按空白分割为视图（不分配内存），最多取 maxTokens 个
+size_t splitWhitespaceViews(std::string_view str, std::string_view* tokens, size_t maxTokens) {
+    size_t count = 0;
+    size_t i = 0;
+    while (i < str.size() && count < maxTokens) {
+        while (i < str.size() && isSpaceChar(static_cast<unsigned char>(str[i]))) {
+            ++i;
+        }
+        size_t start = i;
+        while (i < str.size() && !isSpaceChar(static_cast<unsigned char>(str[i]))) {
+            ++i;
+        }
+        if (i > start) {
+            tokens[count++] = str.substr(start, i - start);
+        }
+    }
+    return count;
+}
+
+// 解析浮点数，接受规则与 std::stod 相同（strtod，只要求前缀是数字）
+bool parseDouble(std::string_view token, double& value) {
+    // 常见的定点/科学计数法数字用 from_chars 整段解析（不依赖 locale，比 strtod 快数倍）；
+    // 没有整段消耗的（前导 +、十六进制、inf 等）或超出范围的交给 strtod，结果与原先一致
+    const char* last = token.data() + token.size();
+    auto parsed = std::from_chars(token.data(), last, value);
+    if (parsed.ec == std::errc() && parsed.ptr == last) {
+        return true;
+    }
+
+    // strtod 需要以 0 结尾的字符串，短数字复制到栈上
+    char buffer[64];
+    std::string longToken;
+    const char* text = buffer;
+    if (token.size() < sizeof(buffer)) {
+        std::memcpy(buffer, token.data(), token.size());
+        buffer[token.size()] = '\0';
+    } else {
+        longToken.assign(token);
+        text = longToken.c_str();
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    double result = std::strtod(text, &end);
+    if (end == text || errno == ERANGE) {
+        return false;
+    }
+    value = result;
+    return true;
+}
+
+// 去除首尾空白（不复制）
+std::string_view trimView(std::string_view str) {
+    size_t first = 0;
+    while (first < str.size() && isSpaceChar(static_cast<unsigned char>(str[first]))) {
+        ++first;
+    }
+    size_t last = str.size();
+    while (last > first && isSpaceChar(static_cast<unsigned char>(str[last - 1]))) {
+        --last;
+    }
+    return str.substr(first, last - first);
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::toupper(static_cast<unsigned char>(a[i])) != std::toupper(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // 获取原子序数
 int getAtomicNumber(const std::string& symbol) {
     std::string processed = symbol;
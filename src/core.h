@@ -1,14 +1,16 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include "memory_budget.h"
 
 // 原子结构体
 struct Atom {
     std::string symbol;
     double x, y, z;
-    double charge = 0.0;  // 电荷（从CHG格式读取，用于Mulliken电荷）
+    double charge = 0.0;  // 电荷（从CHG格式读取，用于Mulliken电荷；多电荷通道时为第 0 个通道）
 };
 
 // 优化信息结构体
@@ -22,11 +24,46 @@ struct OptimizationInfo {
     bool hasData = false;        // 是否包含优化数据
 };
 
-// 帧结构体
+// 周期性晶胞：最多三个平移矢量（Å），来自 Gaussian 的 Tv 行、扩展 XYZ 的 Lattice= 或 CP2K 的 &CELL
+struct UnitCell {
+    double vectors[3][3] = {};   // vectors[i] 为第 i 个平移矢量
+    int count = 0;               // 平移矢量个数，0 表示非周期
+
+    bool periodic3D() const { return count == 3; }
+};
+
+// 帧结构体（原子数组从当前转换的内存资源分配，计入内存预算）
 struct Frame {
-    std::vector<Atom> atoms;
-    std::string comment;
+    std::pmr::vector<Atom> atoms{conversionMemoryResource()};
+    std::pmr::string comment{conversionMemoryResource()};
     OptimizationInfo optInfo;    // 优化信息
+    UnitCell cell;               // 晶胞（Tv 行不计入 atoms）
+    long long step = -1;         // MD 步数（CP2K 注释中的 i =），-1 表示未知
+    double time = 0.0;           // 模拟时间（fs，CP2K 注释中的 time =）
+    bool hasTime = false;
+
+    // 电荷通道（如 Mulliken、Hirshfeld、ADCH）：第 0 个通道为 atoms[i].charge，其余通道按通道连续存放，
+    // 第 c 个通道第 i 个原子位于 extraCharges[(c - 1) * atoms.size() + i]。
+    // chargeChannels 为各通道名称，为空表示只有 atoms[i].charge 一个未命名通道
+    std::vector<std::string> chargeChannels;
+    std::pmr::vector<double> extraCharges{conversionMemoryResource()};
+
+    size_t chargeChannelCount() const { return chargeChannels.empty() ? 1 : chargeChannels.size(); }
+    double channelCharge(size_t channel, size_t atom) const {
+        return channel == 0 ? atoms[atom].charge : extraCharges[(channel - 1) * atoms.size() + atom];
+    }
+};
+
+// 按行索引的文本：换行已统一为 LF，lineStarts 记录每行起始偏移，
+// 末尾额外保存一个哨兵（最后一行结束位置 + 1），解析器按行访问时无需再扫描
+struct TextLines {
+    std::string content;
+    std::pmr::vector<size_t> lineStarts{conversionMemoryResource()};
+
+    size_t lineCount() const { return lineStarts.empty() ? 0 : lineStarts.size() - 1; }
+    std::string_view line(size_t index) const {
+        return std::string_view(content).substr(lineStarts[index], lineStarts[index + 1] - lineStarts[index] - 1);
+    }
 };
 
 // 全局原子序数映射
@@ -37,6 +74,10 @@ extern std::map<int, std::string> atomicNumberToSymbol;
 std::string trim(const std::string& str);
 std::vector<std::string> split(const std::string& str, char delim);
 std::vector<std::string> splitLines(const std::string& str, bool keepEmpty = true);
-std::vector<std::string> splitWhitespace(const std::string& str);
+std::vector<std::string> splitWhitespace(std::string_view str);
+std::string_view trimView(std::string_view str);
+size_t splitWhitespaceViews(std::string_view str, std::string_view* tokens, size_t maxTokens);
+bool parseDouble(std::string_view token, double& value);
+bool equalsIgnoreCase(std::string_view a, std::string_view b);   // 仅比较 ASCII 字母大小写
 int getAtomicNumber(const std::string& symbol);
 size_t calculateMaxChars(int memoryMB);
\ No newline at end of file
@@ -1,8 +1,14 @@
 #include "encoding.h"
 #include "logger.h"
+#include "transcode.h"
 #include <fstream>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 // 计算字节序列中不符合 UTF-8 规则的比例
 static double calculateInvalidUtf8Ratio(const unsigned char* data, size_t length) {
@@ -38,50 +44,218 @@ static double calculateInvalidUtf8Ratio(const unsigned char* data, size_t length
     return static_cast<double>(invalidCount) / length;
 }
 
-TextEncoding detectEncoding(const std::vector<unsigned char>& buffer) {
-    if (buffer.empty()) {
-        return TextEncoding::UNKNOWN;
+namespace {
+
+// 各类换行符出现次数
+struct LineEndingCounts {
+    size_t crlf = 0;
+    size_t lf = 0;
+    size_t cr = 0;
+};
+
+LineEnding lineEndingFromCounts(const LineEndingCounts& counts) {
+    size_t total = counts.crlf + counts.lf + counts.cr;
+    if (total == 0) {
+        return LineEnding::LF; // 默认
+    }
+    
+    if (counts.crlf >= counts.lf && counts.crlf >= counts.cr) {
+        return LineEnding::CRLF;
+    } else if (counts.lf >= counts.crlf && counts.lf >= counts.cr) {
+        return LineEnding::LF;
+    } else {
+        return LineEnding::CR;
+    }
+}
+
+// 8 字节中是否含有指定字节（SWAR）
+inline bool wordHasByte(uint64_t word, unsigned char value) {
+    uint64_t x = word ^ (0x0101010101010101ULL * value);
+    return ((x - 0x0101010101010101ULL) & ~x & 0x8080808080808080ULL) != 0;
+}
+
+// 返回从 data 开始的合法 UTF-8 多字节序列长度，非法返回 0（规则与 calculateInvalidUtf8Ratio 一致）
+inline size_t utf8SequenceLength(const unsigned char* data, size_t remaining) {
+    unsigned char b = data[0];
+    size_t length = 0;
+    if ((b & 0xE0) == 0xC0) {
+        length = 2;
+    } else if ((b & 0xF0) == 0xE0) {
+        length = 3;
+    } else if ((b & 0xF8) == 0xF0) {
+        length = 4;
+    } else {
+        return 0;
+    }
+    if (length > remaining) {
+        return 0;
+    }
+    for (size_t k = 1; k < length; ++k) {
+        if ((data[k] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+// 补齐行索引哨兵：以换行结尾时最后一个起始偏移本身就是哨兵，
+// 否则追加“最后一行结束位置 + 1”（文件末尾换行不产生额外空行）
+void finishLineIndex(TextLines& text) {
+    if (text.content.empty()) {
+        text.lineStarts.clear();
+        return;
+    }
+    if (text.lineStarts.back() != text.content.size()) {
+        text.lineStarts.push_back(text.content.size() + 1);
+    }
+}
+
+// 原地将 CR/CRLF 统一为 LF，并建立行索引
+void normalizeAndIndex(TextLines& text, LineEndingCounts& counts) {
+    std::string& s = text.content;
+    text.lineStarts.clear();
+    if (s.empty()) {
+        return;
+    }
+    
+    text.lineStarts.push_back(0);
+    size_t out = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        char ch = s[i];
+        if (ch == '\r') {
+            if (i + 1 < s.size() && s[i + 1] == '\n') {
+                counts.crlf++;
+                ++i;
+            } else {
+                counts.cr++;
+            }
+            ch = '\n';
+        } else if (ch == '\n') {
+            counts.lf++;
+        }
+        s[out++] = ch;
+        if (ch == '\n') {
+            text.lineStarts.push_back(out);
+        }
+    }
+    s.resize(out);
+    finishLineIndex(text);
+}
+
+// UTF-8 单次扫描：校验 + 复制 + 换行统一 + 行索引，返回非法序列个数
+size_t decodeUtf8Lines(const unsigned char* data, size_t size, TextLines& text, LineEndingCounts& counts) {
+    text.content.resize(size);  // LF 统一只会缩短内容
+    text.lineStarts.clear();
+    text.lineStarts.reserve(size / 32 + 2);
+    text.lineStarts.push_back(0);
+    
+    char* base = &text.content[0];
+    char* dst = base;
+    size_t invalidCount = 0;
+    size_t i = 0;
+    
+    while (i < size) {
+        // 无高位字节、无 CR/LF 的 8 字节整块直接拷贝
+        if (size - i >= 8) {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            if ((word & 0x8080808080808080ULL) == 0 && !wordHasByte(word, '\n') && !wordHasByte(word, '\r')) {
+                std::memcpy(dst, data + i, sizeof(word));
+                dst += sizeof(word);
+                i += sizeof(word);
+                continue;
+            }
+        }
+        
+        unsigned char b = data[i];
+        if (b == '\n' || b == '\r') {
+            if (b == '\n') {
+                counts.lf++;
+                ++i;
+            } else if (i + 1 < size && data[i + 1] == '\n') {
+                counts.crlf++;
+                i += 2;
+            } else {
+                counts.cr++;
+                ++i;
+            }
+            *dst++ = '\n';
+            text.lineStarts.push_back(static_cast<size_t>(dst - base));
+        } else if (b < 0x80) {
+            *dst++ = static_cast<char>(b);
+            ++i;
+        } else {
+            size_t length = utf8SequenceLength(data + i, size - i);
+            if (length == 0) {
+                // 非法字节原样保留，只前进一个字节，避免吞掉后面的换行
+                invalidCount++;
+                length = 1;
+            }
+            std::memcpy(dst, data + i, length);
+            dst += length;
+            i += length;
+        }
     }
     
+    text.content.resize(static_cast<size_t>(dst - base));
+    finishLineIndex(text);
+    return invalidCount;
+}
+
+} // namespace
+
+// 基于 BOM 与 UTF-16 特征的判断，无法判定时返回 UNKNOWN（不做 UTF-8 有效性扫描）
+static TextEncoding detectBomOrUtf16(const unsigned char* data, size_t size) {
     // 检查 BOM
-    if (buffer.size() >= 3 && buffer[0] == 0xEF && buffer[1] == 0xBB && buffer[2] == 0xBF) {
+    if (size >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF) {
         return TextEncoding::UTF8_BOM;
     }
-    if (buffer.size() >= 4 && buffer[0] == 0xFF && buffer[1] == 0xFE && buffer[2] == 0x00 && buffer[3] == 0x00) {
+    if (size >= 4 && data[0] == 0xFF && data[1] == 0xFE && data[2] == 0x00 && data[3] == 0x00) {
         return TextEncoding::UTF32_LE;
     }
-    if (buffer.size() >= 4 && buffer[0] == 0x00 && buffer[1] == 0x00 && buffer[2] == 0xFE && buffer[3] == 0xFF) {
+    if (size >= 4 && data[0] == 0x00 && data[1] == 0x00 && data[2] == 0xFE && data[3] == 0xFF) {
         return TextEncoding::UTF32_BE;
     }
-    if (buffer.size() >= 2 && buffer[0] == 0xFF && buffer[1] == 0xFE) {
+    if (size >= 2 && data[0] == 0xFF && data[1] == 0xFE) {
         return TextEncoding::UTF16_LE;
     }
-    if (buffer.size() >= 2 && buffer[0] == 0xFE && buffer[1] == 0xFF) {
+    if (size >= 2 && data[0] == 0xFE && data[1] == 0xFF) {
         return TextEncoding::UTF16_BE;
     }
     
     // 检查是否包含 null 字节（可能是 UTF-16）
     size_t nullCount = 0;
-    for (size_t i = 0; i < buffer.size() - 1; i += 2) {
-        if (buffer[i] == 0 && buffer[i + 1] != 0) {
+    for (size_t i = 0; i + 1 < size; i += 2) {
+        if (data[i] == 0 && data[i + 1] != 0) {
             nullCount++;
-        } else if (buffer[i + 1] == 0 && buffer[i] != 0) {
+        } else if (data[i + 1] == 0 && data[i] != 0) {
             nullCount++;
         }
     }
     
     // 如果每几个字节就有一个 null 字节，可能是 UTF-16
-    if (buffer.size() > 10 && nullCount > buffer.size() / 16) {
+    if (size > 10 && nullCount > size / 16) {
         // 进一步判断是 LE 还是 BE
-        if (buffer.size() >= 2) {
-            if (buffer[0] != 0 && buffer[1] == 0) {
-                return TextEncoding::UTF16_LE;
-            } else if (buffer[0] == 0 && buffer[1] != 0) {
-                return TextEncoding::UTF16_BE;
-            }
+        if (data[0] != 0 && data[1] == 0) {
+            return TextEncoding::UTF16_LE;
+        } else if (data[0] == 0 && data[1] != 0) {
+            return TextEncoding::UTF16_BE;
         }
     }
     
+    return TextEncoding::UNKNOWN;
+}
+
+TextEncoding detectEncoding(const std::vector<unsigned char>& buffer) {
+    if (buffer.empty()) {
+        return TextEncoding::UNKNOWN;
+    }
+    
+    TextEncoding encoding = detectBomOrUtf16(buffer.data(), buffer.size());
+    if (encoding != TextEncoding::UNKNOWN) {
+        return encoding;
+    }
+    
     // 检查 UTF-8 有效性
     double invalidRatio = calculateInvalidUtf8Ratio(buffer.data(), buffer.size());
     
@@ -95,35 +269,22 @@ TextEncoding detectEncoding(const std::vector<unsigned char>& buffer) {
 }
 
 LineEnding detectLineEnding(const std::string& content) {
-    size_t crlfCount = 0;
-    size_t lfCount = 0;
-    size_t crCount = 0;
+    LineEndingCounts counts;
     
     for (size_t i = 0; i < content.size(); i++) {
         if (content[i] == '\r') {
             if (i + 1 < content.size() && content[i + 1] == '\n') {
-                crlfCount++;
+                counts.crlf++;
                 i++; // 跳过 \n
             } else {
-                crCount++;
+                counts.cr++;
             }
         } else if (content[i] == '\n') {
-            lfCount++;
+            counts.lf++;
         }
     }
     
-    size_t total = crlfCount + lfCount + crCount;
-    if (total == 0) {
-        return LineEnding::LF; // 默认
-    }
-    
-    if (crlfCount >= lfCount && crlfCount >= crCount) {
-        return LineEnding::CRLF;
-    } else if (lfCount >= crlfCount && lfCount >= crCount) {
-        return LineEnding::LF;
-    } else {
-        return LineEnding::CR;
-    }
+    return lineEndingFromCounts(counts);
 }
 
 std::string normalizeLineEndings(const std::string& content, LineEnding target) {
@@ -225,49 +386,21 @@ std::string convertToUtf8(const std::vector<unsigned char>& buffer, TextEncoding
         return "";
     }
     
-    // 如果已经是 UTF-8（无 BOM），直接转换
-    if (encoding == TextEncoding::UTF8 || encoding == TextEncoding::UTF8_BOM) {
-        // 跳过 BOM
-        size_t offset = (encoding == TextEncoding::UTF8_BOM) ? 3 : 0;
-        return std::string(reinterpret_cast<const char*>(buffer.data() + offset), buffer.size() - offset);
+    // UTF-8 / UTF-16 / UTF-32 / 双字节代码页：直接转码到预分配的 UTF-8 缓冲区
+    std::string utf8;
+    if (transcodeToUtf8(buffer.data(), buffer.size(), encoding, utf8)) {
+        return utf8;
     }
     
-    // 使用 Windows API 进行编码转换
-    UINT srcCodePage = CP_ACP;
+#ifdef _WIN32
+    // ANSI：若系统代码页是已知的双字节代码页，同样走查表解码
+    UINT acp = GetACP();
+    if (appendDbcsToUtf8(buffer.data(), buffer.size(), acp, utf8)) {
+        return utf8;
+    }
     
-    switch (encoding) {
-        case TextEncoding::GBK:
-        case TextEncoding::GB2312:
-            srcCodePage = 936; // GBK
-            break;
-        case TextEncoding::BIG5:
-            srcCodePage = 950; // Big5
-            break;
-        case TextEncoding::SHIFT_JIS:
-            srcCodePage = 932; // Shift-JIS
-            break;
-        case TextEncoding::EUC_KR:
-            srcCodePage = 949; // EUC-KR
-            break;
-        case TextEncoding::UTF16_LE:
-            srcCodePage = 1200; // UTF-16 LE
-            break;
-        case TextEncoding::UTF16_BE:
-            srcCodePage = 1201; // UTF-16 BE
-            break;
-        case TextEncoding::UTF32_LE:
-            srcCodePage = 12000; // UTF-32 LE
-            break;
-        case TextEncoding::UTF32_BE:
-            srcCodePage = 12001; // UTF-32 BE
-            break;
-        default:
-            srcCodePage = CP_ACP; // 系统默认 ANSI
-            break;
-    }
-    
-    // 计算目标缓冲区大小
-    int requiredSize = MultiByteToWideChar(srcCodePage, 0, 
+    // 其他代码页回退到 Windows API
+    int requiredSize = MultiByteToWideChar(CP_ACP, 0, 
         reinterpret_cast<const char*>(buffer.data()), 
         static_cast<int>(buffer.size()), 
         NULL, 0);
@@ -278,7 +411,7 @@ std::string convertToUtf8(const std::vector<unsigned char>& buffer, TextEncoding
     }
     
     std::wstring wideBuffer(requiredSize, L'\0');
-    int result = MultiByteToWideChar(srcCodePage, 0, 
+    int result = MultiByteToWideChar(CP_ACP, 0, 
         reinterpret_cast<const char*>(buffer.data()), 
         static_cast<int>(buffer.size()), 
         &wideBuffer[0], requiredSize);
@@ -288,73 +421,80 @@ std::string convertToUtf8(const std::vector<unsigned char>& buffer, TextEncoding
         return "";
     }
     
-    // 从宽字符转换到 UTF-8
-    int utf8Size = WideCharToMultiByte(CP_UTF8, 0, 
-        wideBuffer.c_str(), -1, 
-        NULL, 0, NULL, NULL);
-    
-    if (utf8Size == 0) {
-        LOG_ERROR("Failed to calculate UTF-8 size");
-        return "";
+    appendUtf16ToUtf8(reinterpret_cast<const char16_t*>(wideBuffer.data()), static_cast<size_t>(result), utf8);
+    return utf8;
+#else
+    // 非 Windows 平台没有系统 ANSI 代码页，按 GBK 处理（中文 Windows 常用）
+    if (appendDbcsToUtf8(buffer.data(), buffer.size(), 936, utf8)) {
+        return utf8;
     }
-    
-    std::string utf8Buffer(utf8Size, '\0');
-    result = WideCharToMultiByte(CP_UTF8, 0, 
-        wideBuffer.c_str(), -1, 
-        &utf8Buffer[0], utf8Size, NULL, NULL);
-    
-    if (result == 0) {
-        LOG_ERROR("Failed to convert to UTF-8");
-        return "";
+    LOG_ERROR("Failed to convert ANSI content to UTF-8");
+    return "";
+#endif
+}
+
+EncodedFileContent decodeTextBuffer(const std::vector<unsigned char>& buffer) {
+    EncodedFileContent result;
+    if (buffer.empty()) {
+        return result;
     }
     
-    // 移除结尾的空字符
-    if (!utf8Buffer.empty() && utf8Buffer.back() == '\0') {
-        utf8Buffer.pop_back();
+    // UTF-16 特征只在前 64KB 中采样，避免为检测单独扫描整个文件
+    const size_t SAMPLE_SIZE = 64 * 1024;
+    LineEndingCounts counts;
+    TextEncoding encoding = detectBomOrUtf16(buffer.data(), std::min(buffer.size(), SAMPLE_SIZE));
+    
+    if (encoding == TextEncoding::UNKNOWN) {
+        // 无 BOM 且不像 UTF-16：按 UTF-8 一次完成校验、复制、换行统一和行索引
+        size_t invalidCount = decodeUtf8Lines(buffer.data(), buffer.size(), result, counts);
+        double invalidRatio = static_cast<double>(invalidCount) / buffer.size();
+        if (invalidRatio < 0.01) {
+            result.encoding = TextEncoding::UTF8;
+            result.lineEnding = lineEndingFromCounts(counts);
+            return result;
+        }
+        // 非法字节过多：回退为 ANSI/GBK（中文 Windows 常用）
+        encoding = TextEncoding::ANSI;
+        counts = LineEndingCounts();
     }
     
-    return utf8Buffer;
+    result.encoding = encoding;
+    result.hasBOM = (encoding == TextEncoding::UTF8_BOM);
+    result.content = convertToUtf8(buffer, encoding);
+    normalizeAndIndex(result, counts);
+    result.lineEnding = lineEndingFromCounts(counts);
+    return result;
 }
 
 EncodedFileContent readFileWithEncoding(const std::string& filepath) {
-    EncodedFileContent result;
-    result.encoding = TextEncoding::UNKNOWN;
-    result.lineEnding = LineEnding::UNKNOWN;
-    result.hasBOM = false;
-    result.content = "";
-    
     // 读取原始文件
     std::vector<unsigned char> rawBuffer = readRawFile(filepath);
     
     if (rawBuffer.empty()) {
         LOG_ERROR("Failed to read file: " + filepath);
-        return result;
+        return EncodedFileContent();
     }
     
-    // 检测编码
-    result.encoding = detectEncoding(rawBuffer);
-    result.hasBOM = (result.encoding == TextEncoding::UTF8_BOM);
-    
+    EncodedFileContent result = decodeTextBuffer(rawBuffer);
     LOG_DEBUG("Detected encoding: " + encodingToString(result.encoding) + " for file: " + filepath);
     
-    // 转换为 UTF-8
-    result.content = convertToUtf8(rawBuffer, result.encoding);
-    
     if (result.content.empty()) {
         LOG_ERROR("Failed to convert content to UTF-8: " + filepath);
         return result;
     }
     
-    // 检测换行符
-    result.lineEnding = detectLineEnding(result.content);
     LOG_DEBUG("Detected line ending: " + lineEndingToString(result.lineEnding) + " for file: " + filepath);
-    
-    // 统一换行符为 LF（便于处理）
-    result.content = normalizeLineEndings(result.content, LineEnding::LF);
-    
     return result;
 }
 
+TextLines indexLines(std::string content) {
+    TextLines text;
+    text.content = std::move(content);
+    LineEndingCounts counts;
+    normalizeAndIndex(text, counts);
+    return text;
+}
+
 std::string encodingToString(TextEncoding encoding) {
     switch (encoding) {
         case TextEncoding::UTF8: return "UTF-8";
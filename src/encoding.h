@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core.h"
 #include <string>
 #include <vector>
 
@@ -28,12 +29,11 @@ enum class LineEnding {
     UNKNOWN
 };
 
-// 文件读取结果结构体
-struct EncodedFileContent {
-    std::string content;        // 转换后的 UTF-8 内容
-    TextEncoding encoding;      // 检测到的编码
-    LineEnding lineEnding;     // 换行符类型
-    bool hasBOM;                // 是否有 BOM
+// 文件读取结果结构体（content 为换行已统一为 LF 的 UTF-8 内容，lineStarts 为行索引）
+struct EncodedFileContent : TextLines {
+    TextEncoding encoding = TextEncoding::UNKNOWN;  // 检测到的编码
+    LineEnding lineEnding = LineEnding::UNKNOWN;    // 换行符类型（原始文件中占多数的一种）
+    bool hasBOM = false;                            // 是否有 BOM
 };
 
 // 编码检测和转换函数
@@ -44,10 +44,14 @@ TextEncoding detectEncoding(const std::vector<unsigned char>& buffer);
 // 检测换行符类型
 LineEnding detectLineEnding(const std::string& content);
 
-// 读取文件并自动检测编码，转换为 UTF-8
+// 读取文件并自动检测编码，转换为 UTF-8，统一换行符并建立行索引
+// UTF-8 文件在一次扫描中完成校验、复制、换行统一和行索引；其他编码先转码再原地统一
 // 返回空字符串表示失败
 EncodedFileContent readFileWithEncoding(const std::string& filepath);
 
+// 对内存中的原始字节执行与 readFileWithEncoding 相同的解码流程
+EncodedFileContent decodeTextBuffer(const std::vector<unsigned char>& buffer);
+
 // 读取原始文件内容（不进行编码转换）
 // 返回空 vector 表示失败
 std::vector<unsigned char> readRawFile(const std::string& filepath);
@@ -58,6 +62,10 @@ std::string convertToUtf8(const std::vector<unsigned char>& buffer, TextEncoding
 // 统一换行符：将内容中的换行符统一为 LF
 std::string normalizeLineEndings(const std::string& content, LineEnding target = LineEnding::LF);
 
+// 一次扫描：将已解码的 UTF-8 文本中的 CR/CRLF 原地统一为 LF 并建立行索引
+// （行划分语义与 splitLines(str, true) 一致，用于剪贴板等内存文本）
+TextLines indexLines(std::string content);
+
 // 获取编码名称（用于日志）
 std::string encodingToString(TextEncoding encoding);
 
@@ -0,0 +1,157 @@
+#include "job_queue.h"
+#include "logger.h"
+
+// ========== JobContext ==========
+
+void JobContext::progress(const std::string& stage) {
+    LOG_DEBUG("Job stage: " + stage);
+    if (m_onProgress) {
+        m_onProgress(stage);
+    }
+}
+
+void JobContext::setResult(const std::string& title, const std::string& message, NotifyLevel level) {
+    m_title = title;
+    m_message = message;
+    m_level = level;
+}
+
+// ========== JobQueue ==========
+
+JobQueue::JobQueue() {}
+
+JobQueue::~JobQueue() {
+    stop();
+}
+
+void JobQueue::setHandlers(ProgressHandler onProgress, CompletionHandler onComplete) {
+    m_onProgress = std::move(onProgress);
+    m_onComplete = std::move(onComplete);
+}
+
+bool JobQueue::start() {
+    if (m_thread.joinable()) {
+        return true;
+    }
+    {
+        LockGuard lock(m_mutex);
+        m_stopping = false;
+    }
+    if (!m_thread.start([this]() { run(); })) {
+        LOG_ERROR("Failed to start conversion worker thread");
+        return false;
+    }
+    return true;
+}
+
+void JobQueue::stop() {
+    {
+        LockGuard lock(m_mutex);
+        m_stopping = true;
+        m_pending.clear();
+        if (m_running) {
+            m_running->cancel();
+        }
+    }
+    m_wake.set();
+    m_thread.join();
+}
+
+bool JobQueue::submit(int kind, const std::string& label, JobFunction fn) {
+    {
+        LockGuard lock(m_mutex);
+        for (auto& job : m_pending) {
+            if (job.kind == kind) {
+                // 合并：保留最新的输入
+                job.fn = std::move(fn);
+                job.merged++;
+                LOG_INFO("Merged repeated request into pending job: " + label);
+                return false;
+            }
+        }
+        m_pending.push_back(Job{kind, label, std::move(fn), 0});
+    }
+    m_wake.set();
+    return true;
+}
+
+bool JobQueue::cancelAll() {
+    LockGuard lock(m_mutex);
+    bool any = !m_pending.empty() || m_running;
+    m_pending.clear();
+    if (m_running) {
+        m_running->cancel();
+    }
+    return any;
+}
+
+bool JobQueue::busy() const {
+    LockGuard lock(m_mutex);
+    return m_running || !m_pending.empty();
+}
+
+void JobQueue::run() {
+    while (true) {
+        Job job;
+        std::shared_ptr<JobContext> context;
+        {
+            LockGuard lock(m_mutex);
+            if (m_stopping) {
+                break;
+            }
+            if (!m_pending.empty()) {
+                job = std::move(m_pending.front());
+                m_pending.pop_front();
+                context = std::make_shared<JobContext>();
+                m_running = context;
+            }
+        }
+
+        if (!context) {
+            m_wake.wait();
+            continue;
+        }
+
+        const int kind = job.kind;
+        const std::string label = job.label;
+        if (m_onProgress) {
+            context->m_onProgress = [this, kind, label](const std::string& stage) {
+                m_onProgress(kind, label, stage);
+            };
+        }
+
+        JobReport report;
+        report.kind = kind;
+        report.label = label;
+        report.mergedPresses = job.merged;
+
+        SteadyClock steady;
+        Clock& clock = g_platform.clock ? *g_platform.clock : steady;
+        uint64_t start = clock.nowMicros();
+        try {
+            report.success = job.fn(*context);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Exception in job " + label + ": " + std::string(e.what()));
+            context->setResult("XYZ Monitor", "Error: " + std::string(e.what()), NotifyLevel::Error);
+        } catch (...) {
+            LOG_ERROR("Unknown exception in job " + label);
+            context->setResult("XYZ Monitor", "Unknown error occurred", NotifyLevel::Error);
+        }
+        report.elapsedMicros = clock.nowMicros() - start;
+        report.cancelled = context->isCancelled();
+        report.title = context->resultTitle();
+        report.message = context->resultMessage();
+        report.level = context->resultLevel();
+
+        {
+            LockGuard lock(m_mutex);
+            m_running.reset();
+        }
+
+        LOG_INFO("Job " + label + (report.cancelled ? " cancelled" : (report.success ? " finished" : " failed")) +
+                 " in " + std::to_string(report.elapsedMicros / 1000) + " ms");
+        if (m_onComplete) {
+            m_onComplete(report);
+        }
+    }
+}
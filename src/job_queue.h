@@ -0,0 +1,99 @@
+#pragma once
+
+#include "platform.h"
+#include "threading.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+
+// 热键转换任务队列：UI 线程只负责采集输入并提交任务，解析/转换在工作线程中完成。
+// - 同一类任务最多排队一个：运行期间重复按热键，只保留最后一次的输入
+// - 任务可取消（各阶段之间检查取消标志）
+// - 进度与完成通过回调报告（回调在工作线程中执行，由调用方转发到 UI 线程）
+
+// 单个任务的运行上下文
+class JobContext {
+public:
+    bool isCancelled() const { return m_cancelled.load(); }
+    void cancel() { m_cancelled.store(true); }
+
+    // 报告当前阶段（如 "Parsing"、"Converting"）
+    void progress(const std::string& stage);
+
+    // 设置完成时显示的通知内容
+    void setResult(const std::string& title, const std::string& message, NotifyLevel level = NotifyLevel::Info);
+
+    const std::string& resultTitle() const { return m_title; }
+    const std::string& resultMessage() const { return m_message; }
+    NotifyLevel resultLevel() const { return m_level; }
+
+private:
+    friend class JobQueue;
+
+    std::atomic<bool> m_cancelled{false};
+    std::function<void(const std::string&)> m_onProgress;
+    std::string m_title;
+    std::string m_message;
+    NotifyLevel m_level = NotifyLevel::Info;
+};
+
+// 任务完成报告
+struct JobReport {
+    int kind = 0;
+    std::string label;
+    bool success = false;
+    bool cancelled = false;
+    uint64_t elapsedMicros = 0;
+    int mergedPresses = 0;      // 被合并进该任务的额外提交次数
+    std::string title;
+    std::string message;
+    NotifyLevel level = NotifyLevel::Info;
+};
+
+// 单工作线程任务队列
+class JobQueue {
+public:
+    using JobFunction = std::function<bool(JobContext&)>;
+    using ProgressHandler = std::function<void(int kind, const std::string& label, const std::string& stage)>;
+    using CompletionHandler = std::function<void(const JobReport& report)>;
+
+    JobQueue();
+    ~JobQueue();
+
+    // 回调在工作线程中执行，需在 start() 之前设置
+    void setHandlers(ProgressHandler onProgress, CompletionHandler onComplete);
+
+    bool start();
+    // 取消运行中的任务、丢弃排队任务并等待工作线程退出
+    void stop();
+
+    // 提交任务。若同类任务已在排队，则用新任务替换（合并），返回 false
+    bool submit(int kind, const std::string& label, JobFunction fn);
+
+    // 取消运行中的任务并清空队列，返回是否有任务被取消
+    bool cancelAll();
+
+    bool busy() const;
+
+private:
+    struct Job {
+        int kind = 0;
+        std::string label;
+        JobFunction fn;
+        int merged = 0;
+    };
+
+    void run();
+
+    std::deque<Job> m_pending;
+    std::shared_ptr<JobContext> m_running;
+    ProgressHandler m_onProgress;
+    CompletionHandler m_onComplete;
+    mutable Mutex m_mutex;
+    Event m_wake;
+    Thread m_thread;
+    bool m_stopping = false;
+};
@@ -18,19 +18,15 @@ std::string LogFileHandler::readFirstLines(const std::string& filepath, int line
         return "";
     }
     
-    // 按行分割内容
-    std::vector<std::string> lines = splitLines(fileContent.content, true);
-    
-    std::ostringstream oss;
-    int count = 0;
-    
-    for (const auto& line : lines) {
-        if (count >= lineCount) break;
-        oss << line << "\n";
-        count++;
+    // 行索引已建立：直接截取前 N 行
+    size_t count = std::min(fileContent.lineCount(), static_cast<size_t>(std::max(lineCount, 0)));
+    if (count == 0) {
+        return "";
     }
     
-    return oss.str();
+    std::string result = fileContent.content.substr(0, fileContent.lineStarts[count] - 1);
+    result += "\n";
+    return result;
 }
 
 // 检查是否包含特定字符串
@@ -64,6 +64,8 @@ void Logger::setLogLevel(LogLevel level) {
 void Logger::log(LogLevel level, const std::string& message, const std::string& file, int line) {
     if (level < currentLevel) return;
     
+    LockGuard lock(writeMutex);
+    
     // 获取当前时间
     auto now = std::time(nullptr);
     auto* tm = std::localtime(&now);
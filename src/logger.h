@@ -2,6 +2,7 @@
 
 #include <string>
 #include <fstream>
+#include "threading.h"
 
 // 日志级别枚举
 enum class LogLevel {
@@ -11,13 +12,14 @@ enum class LogLevel {
     ERROR_LEVEL = 3
 };
 
-// 简化的日志类（无mutex，适用于cross-compilation）
+// 简化的日志类（后台清理/转换线程也会写日志，输出由 Mutex 串行化）
 class Logger {
 private:
     std::ofstream logFile;
     LogLevel currentLevel;
     bool logToConsole;
     bool logToFile;
+    Mutex writeMutex;
 
 public:
     Logger();
@@ -27,6 +29,7 @@ public:
     void setLogToConsole(bool enabled);
     void setLogToFile(bool enabled);
     void setLogLevel(LogLevel level);
+    bool isEnabled(LogLevel level) const { return level >= currentLevel; }
     void log(LogLevel level, const std::string& message, const std::string& file = "", int line = 0);
 };
 
@@ -36,8 +39,10 @@ LogLevel stringToLogLevel(const std::string& levelStr);
 // 全局日志实例
 extern Logger g_logger;
 
-// 日志宏定义
-#define LOG_DEBUG(msg) g_logger.log(LogLevel::DEBUG, msg, __FILE__, __LINE__)
-#define LOG_INFO(msg) g_logger.log(LogLevel::INFO, msg)
-#define LOG_WARNING(msg) g_logger.log(LogLevel::WARNING, msg, __FILE__, __LINE__)
-#define LOG_ERROR(msg) g_logger.log(LogLevel::ERROR_LEVEL, msg, __FILE__, __LINE__)
\ No newline at end of file
+// 日志宏定义（级别被过滤时不构造消息字符串）
+#define LOG_AT_LEVEL(level, ...) \
+    do { if (g_logger.isEnabled(level)) g_logger.log(level, __VA_ARGS__); } while (0)
+#define LOG_DEBUG(msg) LOG_AT_LEVEL(LogLevel::DEBUG, msg, __FILE__, __LINE__)
+#define LOG_INFO(msg) LOG_AT_LEVEL(LogLevel::INFO, msg)
+#define LOG_WARNING(msg) LOG_AT_LEVEL(LogLevel::WARNING, msg, __FILE__, __LINE__)
+#define LOG_ERROR(msg) LOG_AT_LEVEL(LogLevel::ERROR_LEVEL, msg, __FILE__, __LINE__)
\ No newline at end of file
@@ -10,7 +10,8 @@
 #include <filesystem>
 #include <algorithm>
 #include <cctype>
-#include <cstring>
+#include <cstdio>
+#include <memory>
 
 // 引入自定义模块
 #include "core.h"
@@ -21,6 +22,17 @@
 #include "version.h"
 #include "logfile_handler.h"
 #include "encoding.h"
+#include "platform.h"
+#include "platform_win32.h"
+#include "pipeline.h"
+#include "plugin_executor.h"
+#include "plugin_host.h"
+#include "charge_batch.h"
+#include "temp_cleanup.h"
+#include "clipboard_watcher.h"
+#include "job_queue.h"
+#include "memory_budget.h"
+#include "periodic.h"
 
 // 解决Windows ERROR宏冲突
 #ifdef ERROR
@@ -32,187 +44,45 @@
 
 // 托盘和菜单常量
 #define WM_TRAYICON (WM_USER + 1)
+#define WM_JOB_PROGRESS (WM_USER + 2)
+#define WM_JOB_DONE (WM_USER + 3)
 #define ID_TRAY_ICON 1001
 #define ID_TRAY_RELOAD 2001
 #define ID_TRAY_EXIT 2002
 #define ID_TRAY_ABOUT 2003
+#define ID_TRAY_CANCEL 2004
+#define ID_TRAY_PLUGIN_STATS 2005
 #define ID_TRAY_PLUGIN_BASE 3000
 
 // 热键ID
 #define HOTKEY_XYZ_TO_GVIEW 1
 #define HOTKEY_GVIEW_TO_XYZ 2
 
-// 线程参数结构体
-struct DeleteFileThreadParams {
-    std::string filepath;
-    int waitSeconds;
-};
-
 // 全局变量
 bool g_running = true;
 NOTIFYICONDATAA g_nid = {};
 HWND g_hwnd = NULL;
 
-namespace {
-
-class ClipboardGuard {
-public:
-    explicit ClipboardGuard(HWND owner) : m_opened(OpenClipboard(owner) != FALSE) {}
+// Win32 平台服务
+Win32ClipboardService g_win32Clipboard;
+Win32ProcessLauncher g_win32Launcher;
+SteadyClock g_steadyClock;
+TempFileCleanupService g_tempCleanup;
 
-    ~ClipboardGuard() {
-        if (m_opened) {
-            CloseClipboard();
-        }
-    }
+// 热键转换任务队列（工作线程）
+JobQueue g_jobQueue;
 
-    bool isOpen() const { return m_opened; }
-
-private:
-    bool m_opened;
+// 任务进度消息（经 PostMessage 传给 UI 线程，由 UI 线程释放）
+struct JobProgressMessage {
+    std::string label;
+    std::string stage;
 };
-
-std::string wideToUtf8(const std::wstring& wide) {
-    if (wide.empty()) {
-        return "";
-    }
-
-    int required = WideCharToMultiByte(CP_UTF8, 0, wide.c_str(), -1, NULL, 0, NULL, NULL);
-    if (required <= 0) {
-        return "";
-    }
-
-    std::string utf8(static_cast<size_t>(required), '\0');
-    int written = WideCharToMultiByte(CP_UTF8, 0, wide.c_str(), -1, utf8.data(), required, NULL, NULL);
-    if (written <= 0) {
-        return "";
-    }
-
-    if (!utf8.empty() && utf8.back() == '\0') {
-        utf8.pop_back();
-    }
-
-    return utf8;
-}
-
-std::wstring utf8ToWide(const std::string& utf8) {
-    if (utf8.empty()) {
-        return L"";
-    }
-
-    int required = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, NULL, 0);
-    if (required <= 0) {
-        return L"";
-    }
-
-    std::wstring wide(static_cast<size_t>(required), L'\0');
-    int written = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, wide.data(), required);
-    if (written <= 0) {
-        return L"";
-    }
-
-    if (!wide.empty() && wide.back() == L'\0') {
-        wide.pop_back();
-    }
-
-    return wide;
-}
-
-std::string ansiToUtf8(const char* ansiText) {
-    if (ansiText == NULL || ansiText[0] == '\0') {
-        return "";
-    }
-
-    int wideSize = MultiByteToWideChar(CP_ACP, 0, ansiText, -1, NULL, 0);
-    if (wideSize <= 0) {
-        return "";
-    }
-
-    std::wstring wide(static_cast<size_t>(wideSize), L'\0');
-    if (MultiByteToWideChar(CP_ACP, 0, ansiText, -1, wide.data(), wideSize) <= 0) {
-        return "";
-    }
-
-    if (!wide.empty() && wide.back() == L'\0') {
-        wide.pop_back();
-    }
-
-    return wideToUtf8(wide);
-}
-
-std::string utf8ToAnsi(const std::string& utf8) {
-    std::wstring wide = utf8ToWide(utf8);
-    if (wide.empty()) {
-        return "";
-    }
-
-    int ansiSize = WideCharToMultiByte(CP_ACP, 0, wide.c_str(), -1, NULL, 0, NULL, NULL);
-    if (ansiSize <= 0) {
-        return "";
-    }
-
-    std::string ansi(static_cast<size_t>(ansiSize), '\0');
-    if (WideCharToMultiByte(CP_ACP, 0, wide.c_str(), -1, ansi.data(), ansiSize, NULL, NULL) <= 0) {
-        return "";
-    }
-
-    if (!ansi.empty() && ansi.back() == '\0') {
-        ansi.pop_back();
-    }
-
-    return ansi;
-}
-
-bool setClipboardTextData(UINT format, const void* data, size_t bytes) {
-    HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, bytes);
-    if (hMem == NULL) {
-        return false;
-    }
-
-    void* pMem = GlobalLock(hMem);
-    if (pMem == NULL) {
-        GlobalFree(hMem);
-        return false;
-    }
-
-    std::memcpy(pMem, data, bytes);
-    GlobalUnlock(hMem);
-
-    if (SetClipboardData(format, hMem) == NULL) {
-        GlobalFree(hMem);
-        return false;
-    }
-
-    return true;
-}
-
-} // namespace
+TrayNotifier g_trayNotifier;
 
 // 前置声明
 bool reregisterHotkeys();
 void cleanupTrayIcon();
-
-// 延时删除文件的线程函数
-DWORD WINAPI DeleteFileThread(LPVOID lpParam) {
-    DeleteFileThreadParams* params = static_cast<DeleteFileThreadParams*>(lpParam);
-    
-    try {
-        Sleep(params->waitSeconds * 1000);
-        
-        if (DeleteFileA(params->filepath.c_str())) {
-            // 成功删除
-        } else {
-            DWORD error = GetLastError();
-            std::cerr << "Failed to delete temporary file: " << params->filepath << " (Error: " << error << ")" << std::endl;
-        }
-    } catch (const std::exception& e) {
-        std::cerr << "Exception in delete file thread: " << e.what() << std::endl;
-    } catch (...) {
-        std::cerr << "Unknown exception in delete file thread" << std::endl;
-    }
-    
-    delete params;
-    return 0;
-}
+void startClipboardWatcher();
 
 // 重新注册热键
 bool reregisterHotkeys() {
@@ -271,6 +141,9 @@ bool reloadConfigurationWithHotkeys() {
             LOG_WARNING("Failed to re-register some plugin hotkeys");
         }
         
+        // gaussian_clipboard_path 可能已更改
+        startClipboardWatcher();
+        
         // 如果热键改变了，重新注册
         if (oldHotkey != g_config.hotkey || oldHotkeyReverse != g_config.hotkeyReverse) {
             if (reregisterHotkeys()) {
@@ -301,6 +174,75 @@ void showTrayNotification(const std::string& title, const std::string& message,
     }
 }
 
+// 更新托盘提示文字（空字符串恢复默认）
+void setTrayTip(const std::string& tip) {
+    if (g_nid.cbSize > 0) {
+        NOTIFYICONDATAA nid = g_nid;
+        nid.uFlags = NIF_TIP;
+        const std::string text = tip.empty() ? "XYZ Monitor - XYZ<->GView Bridge" : tip;
+        strncpy_s(nid.szTip, sizeof(nid.szTip), text.c_str(), _TRUNCATE);
+        Shell_NotifyIconA(NIM_MODIFY, &nid);
+    }
+}
+
+// 格式化耗时（毫秒/秒）
+std::string formatElapsed(uint64_t micros) {
+    char buffer[32];
+    if (micros < 1000000) {
+        snprintf(buffer, sizeof(buffer), "%llu ms", static_cast<unsigned long long>(micros / 1000));
+    } else {
+        snprintf(buffer, sizeof(buffer), "%.2f s", static_cast<double>(micros) / 1000000.0);
+    }
+    return buffer;
+}
+
+// 启动转换工作线程：进度和完成消息转发到 UI 线程
+void startJobQueue() {
+    g_jobQueue.setHandlers(
+        [](int, const std::string& label, const std::string& stage) {
+            JobProgressMessage* message = new JobProgressMessage{label, stage};
+            if (!g_hwnd || !PostMessageA(g_hwnd, WM_JOB_PROGRESS, 0, reinterpret_cast<LPARAM>(message))) {
+                delete message;
+            }
+        },
+        [](const JobReport& report) {
+            JobReport* message = new JobReport(report);
+            if (!g_hwnd || !PostMessageA(g_hwnd, WM_JOB_DONE, 0, reinterpret_cast<LPARAM>(message))) {
+                delete message;
+            }
+        });
+    g_jobQueue.start();
+}
+
+// 任务完成：恢复托盘提示，显示带耗时的通知
+void onJobDone(const JobReport& report) {
+    setTrayTip("");
+    
+    std::string elapsed = formatElapsed(report.elapsedMicros);
+    if (report.cancelled) {
+        showTrayNotification("XYZ Monitor", report.label + " cancelled (" + elapsed + ")", NIIF_INFO);
+        return;
+    }
+    
+    std::string title = report.title.empty() ? report.label : report.title;
+    std::string message = report.message;
+    if (message.empty()) {
+        message = report.success ? "Done" : "Failed, see log for details";
+    }
+    message += " (" + elapsed + ")";
+    if (report.mergedPresses > 0) {
+        message += ", merged " + std::to_string(report.mergedPresses) + " repeated press(es)";
+    }
+    
+    DWORD iconType = NIIF_INFO;
+    if (report.level == NotifyLevel::Warning) {
+        iconType = NIIF_WARNING;
+    } else if (report.level == NotifyLevel::Error || !report.success) {
+        iconType = NIIF_ERROR;
+    }
+    showTrayNotification(title, message, iconType);
+}
+
 // 创建托盘图标
 bool createTrayIcon(HWND hwnd) {
     ZeroMemory(&g_nid, sizeof(g_nid));
@@ -351,11 +293,14 @@ void showTrayMenu(HWND hwnd, POINT pt) {
                         AppendMenuA(hPluginMenu, MF_STRING, ID_TRAY_PLUGIN_BASE + pluginIndex, menuText.c_str());
                     }
                 }
+                AppendMenuA(hPluginMenu, MF_SEPARATOR, 0, NULL);
+                AppendMenuA(hPluginMenu, MF_STRING, ID_TRAY_PLUGIN_STATS, "Statistics...");
                 AppendMenuA(hMenu, MF_POPUP, (UINT_PTR)hPluginMenu, "Plugins");
             }
             AppendMenuA(hMenu, MF_SEPARATOR, 0, NULL);
         }
         
+        AppendMenuA(hMenu, MF_STRING | (g_jobQueue.busy() ? 0 : MF_GRAYED), ID_TRAY_CANCEL, "Cancel Conversion");
         AppendMenuA(hMenu, MF_STRING, ID_TRAY_RELOAD, "Reload Configuration");
         AppendMenuA(hMenu, MF_SEPARATOR, 0, NULL);
         AppendMenuA(hMenu, MF_STRING, ID_TRAY_EXIT, "Exit");
@@ -378,329 +323,34 @@ void cleanupTrayIcon() {
 }
 
 
-// 读取剪贴板内容
-std::string getClipboardText() {
-    try {
-        ClipboardGuard clipboard(NULL);
-        if (!clipboard.isOpen()) {
-            DWORD error = GetLastError();
-            LOG_ERROR("Failed to open clipboard (Error: " + std::to_string(error) + ")");
-            return "";
-        }
-
-        if (IsClipboardFormatAvailable(CF_UNICODETEXT)) {
-            HANDLE hData = GetClipboardData(CF_UNICODETEXT);
-            if (hData != NULL) {
-                wchar_t* wideText = static_cast<wchar_t*>(GlobalLock(hData));
-                if (wideText != NULL) {
-                    std::wstring wide(wideText);
-                    GlobalUnlock(hData);
-
-                    std::string utf8 = wideToUtf8(wide);
-                    LOG_DEBUG("Clipboard text length (Unicode): " + std::to_string(utf8.length()));
-                    return utf8;
-                }
-
-                LOG_ERROR("Failed to lock Unicode clipboard data");
-                return "";
-            }
-        }
-
-        HANDLE hData = GetClipboardData(CF_TEXT);
-        if (hData == NULL) {
-            LOG_DEBUG("No text data in clipboard");
-            return "";
-        }
-
-        char* pszText = static_cast<char*>(GlobalLock(hData));
-        if (pszText == NULL) {
-            LOG_ERROR("Failed to lock clipboard data");
-            return "";
-        }
-
-        std::string text = ansiToUtf8(pszText);
-        GlobalUnlock(hData);
-
-        LOG_DEBUG("Clipboard text length: " + std::to_string(text.length()));
-        return text;
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception reading clipboard: " + std::string(e.what()));
-        return "";
-    }
-}
-
-// 写入剪贴板
-bool writeToClipboard(const std::string& text) {
-    try {
-        ClipboardGuard clipboard(NULL);
-        if (!clipboard.isOpen()) {
-            LOG_ERROR("Cannot open clipboard for writing");
-            return false;
-        }
-
-        if (!EmptyClipboard()) {
-            LOG_ERROR("Cannot empty clipboard");
-            return false;
-        }
-
-        std::wstring wideText = utf8ToWide(text);
-        if (wideText.empty() && !text.empty()) {
-            LOG_ERROR("Cannot convert UTF-8 text to UTF-16 for clipboard");
-            return false;
-        }
-
-        std::wstring wideWithNull = wideText;
-        wideWithNull.push_back(L'\0');
-        if (!setClipboardTextData(CF_UNICODETEXT, wideWithNull.c_str(), wideWithNull.size() * sizeof(wchar_t))) {
-            LOG_ERROR("Cannot set Unicode clipboard data");
-            return false;
-        }
-
-        std::string ansiText = utf8ToAnsi(text);
-        std::string ansiWithNull = ansiText;
-        ansiWithNull.push_back('\0');
-        if (!setClipboardTextData(CF_TEXT, ansiWithNull.c_str(), ansiWithNull.size())) {
-            LOG_WARNING("Failed to set ANSI clipboard data fallback");
-        }
-
-        return true;
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception writing to clipboard: " + std::string(e.what()));
-        return false;
-    }
-}
-
-// 创建临时文件
-std::string createTempFile(const std::string& content) {
-    try {
-        // 使用更稳妥的唯一文件名，避免同一秒内多次触发导致覆盖
-        std::filesystem::path dir;
-        if (!g_config.tempDir.empty()) {
-            // Support env vars and paths relative to config.ini
-            dir = std::filesystem::path(resolveConfigPathForFile(g_config.tempDir));
-        } else {
-            dir = std::filesystem::temp_directory_path();
-        }
-
-        std::filesystem::create_directories(dir);
-
-        const auto now = std::chrono::system_clock::now();
-        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
-        const DWORD tid = GetCurrentThreadId();
-        // Some MinGW toolchains don't expose GetTickCount64() unless _WIN32_WINNT is set.
-        // GetTickCount() is fine for uniqueness here (we already include ms + thread id).
-        const ULONGLONG tick = static_cast<ULONGLONG>(GetTickCount());
-
-        std::ostringstream filename;
-        filename << "molecule_" << ms << "_" << tick << "_" << tid << ".log";
-
-        std::filesystem::path filepath = dir / filename.str();
-        
-        std::ofstream file(filepath.string(), std::ios::binary);
-        if (!file.is_open()) {
-            LOG_ERROR("Failed to create temp file: " + filepath.string());
-            return "";
-        }
-        
-        file << content;
-        file.close();
-        
-        LOG_INFO("Created temporary file: " + filepath.string());
-        return filepath.string();
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception creating temp file: " + std::string(e.what()));
-        return "";
-    }
-}
-
-// 使用GView打开文件
-bool openWithGView(const std::string& filepath) {
-    try {
-        if (g_config.gviewPath.empty()) {
-            LOG_ERROR("GView path not configured!");
-            return false;
-        }
-
-        // Support env vars and relative paths (relative to config.ini)
-        std::string gviewExe = resolveConfigPathForExecutable(g_config.gviewPath);
-        std::string command = "\"" + gviewExe + "\" \"" + filepath + "\"";
-        LOG_DEBUG("Executing command: " + command);
-        
-        STARTUPINFOA si;
-        PROCESS_INFORMATION pi;
-        ZeroMemory(&si, sizeof(si));
-        si.cb = sizeof(si);
-        ZeroMemory(&pi, sizeof(pi));
-        
-        // CreateProcess 可能会修改命令行缓冲区，因此必须传入可写 buffer
-        std::vector<char> cmdBuf(command.begin(), command.end());
-        cmdBuf.push_back('\0');
-
-        if (!CreateProcessA(NULL, cmdBuf.data(), NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) {
-            DWORD error = GetLastError();
-            LOG_ERROR("Failed to launch GView (Error: " + std::to_string(error) + ")");
-            return false;
-        }
-        
-        CloseHandle(pi.hProcess);
-        CloseHandle(pi.hThread);
-        
-        DeleteFileThreadParams* params = new DeleteFileThreadParams;
-        params->filepath = filepath;
-        params->waitSeconds = g_config.waitSeconds;
-        
-        HANDLE hThread = CreateThread(NULL, 0, DeleteFileThread, params, 0, NULL);
-        if (hThread) {
-            CloseHandle(hThread);
-        } else {
-            DWORD error = GetLastError();
-            LOG_ERROR("Failed to create delete thread (Error: " + std::to_string(error) + ")");
-            delete params;
-        }
-        
-        LOG_INFO("Launched GView successfully");
-        return true;
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception launching GView: " + std::string(e.what()));
-        return false;
-    }
-}
-
-// 处理剪贴板内容（XYZ到GView）
-void processClipboardXYZToGView() {
-    LOG_INFO("Processing clipboard (XYZ to GView)...");
-    
-    try {
-        std::string content = getClipboardText();
-        if (content.empty()) {
-            LOG_INFO("Clipboard is empty or not text format.");
-            return;
-        }
-        
-        if (content.length() > g_config.maxClipboardChars) {
-            LOG_WARNING("Clipboard content is too large (" + std::to_string(content.length()) + 
-                       " characters). Limit is " + std::to_string(g_config.maxClipboardChars) + 
-                       " characters (" + std::to_string(g_config.maxMemoryMB) + "MB memory limit).");
-            return;
-        }
-        
-        // 尝试解析格式
-        std::vector<Frame> frames;
-        // 如果启用了CHG格式支持，优先尝试CHG格式
-        if (g_config.tryParseChgFormat && isChgFormat(content)) {
-            LOG_INFO("Detected CHG format in clipboard.");
-            Frame frame = readChgFrame(content);
-            if (!frame.atoms.empty()) {
-                frames.push_back(frame);
-            }
-        } else if (isXYZFormat(content)) {
-            LOG_INFO("Detected XYZ format in clipboard.");
-            frames = readMultiXYZ(content);
-        } else {
-            LOG_INFO("Invalid format in clipboard (not XYZ or CHG).");
-            return;
-        }
-        
-        double estimatedMemoryMB = (content.length() * 8.0) / (1024.0 * 1024.0);
-        LOG_INFO("Processing " + std::to_string(content.length()) + " characters (estimated " + 
-                std::to_string(static_cast<int>(estimatedMemoryMB)) + "MB memory usage)");
-        if (frames.empty()) {
-            LOG_ERROR("Failed to parse XYZ data.");
-            return;
-        }
-        
-        LOG_INFO("Found " + std::to_string(frames.size()) + " frame(s) with " + std::to_string(frames[0].atoms.size()) + " atoms.");
-        
-        std::string gaussianContent = convertToGaussianLog(frames);
-        if (gaussianContent.empty()) {
-            LOG_ERROR("Failed to convert to Gaussian log format.");
-            return;
-        }
-        
-        std::string tempFile = createTempFile(gaussianContent);
-        
-        if (tempFile.empty()) {
-            LOG_ERROR("Failed to create temporary file.");
-            return;
-        }
-        
-        if (openWithGView(tempFile)) {
-            LOG_INFO("Opened with GView successfully.");
-        } else {
-            LOG_ERROR("Failed to open with GView.");
-            if (!DeleteFileA(tempFile.c_str())) {
-                LOG_ERROR("Failed to cleanup temp file: " + tempFile);
-            }
-        }
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception in processClipboardXYZToGView: " + std::string(e.what()));
-    } catch (...) {
-        LOG_ERROR("Unknown exception in processClipboardXYZToGView");
-    }
-}
-
-// 处理GView clipboard到XYZ
-void processGViewClipboardToXYZ() {
-    LOG_INFO("Processing GView clipboard to XYZ...");
-    
-    try {
-        if (g_config.gaussianClipboardPath.empty()) {
-            LOG_ERROR("Gaussian clipboard path not configured!");
-            showTrayNotification("XYZ Monitor", "Error: Gaussian clipboard path not configured!", NIIF_ERROR);
-            return;
-        }
-        
-        // 解析Gaussian clipboard文件（支持 %VAR% 和相对路径：相对于 config.ini）
-        std::vector<Atom> atoms = parseGaussianClipboard(resolveConfigPathForFile(g_config.gaussianClipboardPath));
-        
-        if (atoms.empty()) {
-            LOG_ERROR("No atoms found in Gaussian clipboard file");
-            LOG_INFO("Make sure you have copied a molecule in Gaussian and the path is correct.");
-            showTrayNotification("XYZ Monitor", "No atoms found. Copy a molecule in GaussianView first.", NIIF_WARNING);
-            return;
-        }
-        
-        LOG_INFO("SUCCESS: Parsed " + std::to_string(atoms.size()) + " atoms");
-        
-        // 创建XYZ字符串
-        std::string xyzString = createXYZString(atoms);
-        
-        if (xyzString.empty()) {
-            LOG_ERROR("Failed to create XYZ string");
-            showTrayNotification("XYZ Monitor", "Failed to create XYZ format", NIIF_ERROR);
-            return;
-        }
-        
-        // 写入剪贴板
-        if (writeToClipboard(xyzString)) {
-            LOG_INFO("SUCCESS: XYZ data written to clipboard!");
-            LOG_DEBUG("XYZ content preview (first 200 chars): " + xyzString.substr(0, 200) + "...");
-            
-            // 显示成功通知
-            std::string notifMsg = "Converted " + std::to_string(atoms.size()) + " atoms to XYZ format";
-            showTrayNotification("GView to XYZ Success", notifMsg, NIIF_INFO);
-        } else {
-            LOG_ERROR("Failed to write to clipboard");
-            showTrayNotification("XYZ Monitor", "Failed to write to clipboard", NIIF_ERROR);
-        }
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception in processGViewClipboardToXYZ: " + std::string(e.what()));
-        showTrayNotification("XYZ Monitor", "Error: " + std::string(e.what()), NIIF_ERROR);
-    } catch (...) {
-        LOG_ERROR("Unknown exception in processGViewClipboardToXYZ");
-        showTrayNotification("XYZ Monitor", "Unknown error occurred", NIIF_ERROR);
-    }
-}
-
 // 窗口过程
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
     try {
         switch (uMsg) {
             case WM_HOTKEY:
                 if (wParam == HOTKEY_XYZ_TO_GVIEW) {
-                    processClipboardXYZToGView();
+                    // UI 线程只读取剪贴板，解析和转换交给工作线程；
+                    // 先看剪贴板数据大小，超出限制时不复制
+                    size_t clipboardSize = g_platform.clipboard->peekTextSize();
+                    if (clipboardSize > g_config.maxClipboardChars) {
+                        LOG_WARNING("Clipboard content is too large (" + std::to_string(clipboardSize) +
+                                    " characters). Limit is " + std::to_string(g_config.maxClipboardChars) + " characters.");
+                        showTrayNotification("XYZ Monitor", "Clipboard content is too large", NIIF_WARNING);
+                        return 0;
+                    }
+                    std::string clipboardText = g_platform.clipboard->readText();
+                    if (clipboardText.empty()) {
+                        LOG_INFO("Clipboard is empty or not text format.");
+                    } else {
+                        g_jobQueue.submit(HOTKEY_XYZ_TO_GVIEW, "XYZ to GView",
+                            [text = std::move(clipboardText)](JobContext& ctx) mutable {
+                                return processClipboardTextToGView(std::move(text), &ctx);
+                            });
+                    }
                 } else if (wParam == HOTKEY_GVIEW_TO_XYZ) {
-                    processGViewClipboardToXYZ();
+                    g_jobQueue.submit(HOTKEY_GVIEW_TO_XYZ, "GView to XYZ", [](JobContext& ctx) {
+                        return processGViewClipboardToXYZ(&ctx);
+                    });
                 } else if (wParam >= 100) {
                     // 处理插件热键 (ID从100开始)
                     for (const auto& plugin : g_config.plugins) {
@@ -712,6 +362,18 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                 }
                 return 0;
                 
+            case WM_JOB_PROGRESS: {
+                std::unique_ptr<JobProgressMessage> message(reinterpret_cast<JobProgressMessage*>(lParam));
+                setTrayTip("XYZ Monitor - " + message->label + ": " + message->stage + "...");
+                return 0;
+            }
+                
+            case WM_JOB_DONE: {
+                std::unique_ptr<JobReport> report(reinterpret_cast<JobReport*>(lParam));
+                onJobDone(*report);
+                return 0;
+            }
+                
             case WM_TRAYICON:
                 switch (lParam) {
                     case WM_LBUTTONDBLCLK:
@@ -738,6 +400,24 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                         }
                         break;
                         
+                    case ID_TRAY_CANCEL:
+                        if (g_jobQueue.cancelAll()) {
+                            LOG_INFO("Cancel requested for running conversion");
+                        }
+                        break;
+                        
+                    case ID_TRAY_PLUGIN_STATS:
+                        {
+                            // 普通插件的运行次数、退出码与运行时间分布
+                            const std::string report = g_pluginExecutor.report();
+                            if (!report.empty()) {
+                                LOG_INFO("Plugin statistics:\n" + report);
+                            }
+                            MessageBoxA(hwnd, report.empty() ? "No plugin has been run yet." : report.c_str(),
+                                        "Plugin Statistics", MB_OK | MB_ICONINFORMATION);
+                        }
+                        break;
+                        
                     case ID_TRAY_RELOAD:
                         if (reloadConfigurationWithHotkeys()) {
                             MessageBoxA(hwnd, "Configuration reloaded successfully!", "XYZ Monitor", MB_OK | MB_ICONINFORMATION);
@@ -814,57 +494,31 @@ bool processFileConversion(const std::string& filepath) {
             }
         }
         
-        if (ext != ".xyz" && ext != ".trj" && ext != ".chg") {
+        if (!isStructureFileExtension(ext)) {
             LOG_ERROR("Unsupported file format: " + ext);
             showTrayNotification("XYZ Monitor", "不支持的文件格式: " + ext, NIIF_ERROR);
             return false;
         }
         
-        // 读取文件内容（自动检测编码）
-        EncodedFileContent fileContent = readFileWithEncoding(filepath);
+        MemoryBudget budget(static_cast<size_t>(g_config.maxMemoryMB) * 1024 * 1024);
+        MemoryBudgetScope budgetScope(budget);
         
-        if (fileContent.content.empty()) {
-            LOG_ERROR("Failed to read file or file is empty: " + filepath);
+        // 解析文件格式（XYZ/CHG/CP2K，按内容检测）
+        std::vector<Frame> frames;
+        switch (loadStructureFile(filepath, frames)) {
+        case StructureFileLoad::Ok:
+            break;
+        case StructureFileLoad::ReadFailed:
             showTrayNotification("XYZ Monitor", "无法打开文件: " + filepath, NIIF_ERROR);
             return false;
-        }
-        
-        std::string& content = fileContent.content;
-        
-        LOG_INFO("Read file with encoding: " + encodingToString(fileContent.encoding) + 
-                 ", line ending: " + lineEndingToString(fileContent.lineEnding));
-        
-        // 检查内容长度
-        if (content.length() > g_config.maxClipboardChars) {
-            LOG_WARNING("File content is too large (" + std::to_string(content.length()) + 
-                       " characters). Limit is " + std::to_string(g_config.maxClipboardChars) + 
-                       " characters (" + std::to_string(g_config.maxMemoryMB) + "MB memory limit).");
+        case StructureFileLoad::TooLarge:
             showTrayNotification("XYZ Monitor", "文件内容过大，超出内存限制", NIIF_WARNING);
             return false;
-        }
-        
-        // 解析文件格式
-        std::vector<Frame> frames;
-        // 根据扩展名或内容检测格式
-        if (ext == ".chg" || (g_config.tryParseChgFormat && isChgFormat(content))) {
-            LOG_INFO("Processing CHG format file: " + filepath);
-            Frame frame = readChgFrame(content);
-            if (!frame.atoms.empty()) {
-                frames.push_back(frame);
-            }
-        } else if (isXYZFormat(content)) {
-            LOG_INFO("Processing XYZ format file: " + filepath);
-            frames = readMultiXYZ(content);
-        } else {
-            LOG_ERROR("Invalid file format (not XYZ or CHG): " + filepath);
+        case StructureFileLoad::NotStructure:
+            LOG_ERROR("Invalid file format (not XYZ, CHG, CP2K or Chem3D/CML): " + filepath);
             showTrayNotification("XYZ Monitor", "文件格式无效: " + filepath, NIIF_ERROR);
             return false;
-        }
-        
-        double estimatedMemoryMB = (content.length() * 8.0) / (1024.0 * 1024.0);
-        LOG_INFO("Processing " + std::to_string(content.length()) + " characters from file (estimated " + 
-                std::to_string(static_cast<int>(estimatedMemoryMB)) + "MB memory usage)");
-        if (frames.empty()) {
+        case StructureFileLoad::ParseFailed:
             LOG_ERROR("Failed to parse XYZ data from file: " + filepath);
             showTrayNotification("XYZ Monitor", "解析XYZ数据失败: " + filepath, NIIF_ERROR);
             return false;
@@ -879,6 +533,7 @@ bool processFileConversion(const std::string& filepath) {
             showTrayNotification("XYZ Monitor", "转换为Gaussian格式失败: " + filepath, NIIF_ERROR);
             return false;
         }
+        LOG_INFO("Conversion memory: " + budget.summary());
         
         // 创建临时文件
         std::string tempFile = createTempFile(gaussianContent);
@@ -897,12 +552,14 @@ bool processFileConversion(const std::string& filepath) {
             LOG_ERROR("Failed to open file with GView: " + filepath);
             showTrayNotification("XYZ Monitor", "无法用GView打开文件: " + filepath, NIIF_ERROR);
             // 清理临时文件
-            if (!DeleteFileA(tempFile.c_str())) {
-                LOG_ERROR("Failed to cleanup temp file: " + tempFile);
-            }
+            removeTempFile(tempFile);
             return false;
         }
         
+    } catch (const MemoryBudgetExceeded& e) {
+        LOG_ERROR("Conversion aborted: " + std::string(e.what()));
+        showTrayNotification("XYZ Monitor", "文件内容过大，超出内存限制", NIIF_WARNING);
+        return false;
     } catch (const std::exception& e) {
         LOG_ERROR("Exception in processFileConversion: " + std::string(e.what()));
         showTrayNotification("XYZ Monitor", "处理文件时出错: " + std::string(e.what()), NIIF_ERROR);
@@ -914,11 +571,92 @@ bool processFileConversion(const std::string& filepath) {
     }
 }
 
+// 安装 Win32 平台服务
+void installWin32Platform() {
+    g_platform.clipboard = &g_win32Clipboard;
+    g_platform.launcher = &g_win32Launcher;
+    g_platform.clock = &g_steadyClock;
+    g_platform.tempFiles = &g_tempCleanup;
+    g_platform.notifier = &g_trayNotifier;
+}
+
+// 启动 GView 剪贴板文件监视（反向热键直接使用后台解析好的结果）
+void startClipboardWatcher() {
+    if (g_config.gaussianClipboardPath.empty()) {
+        g_clipboardWatcher.stop();
+        return;
+    }
+    g_clipboardWatcher.start(resolveConfigPathForFile(g_config.gaussianClipboardPath));
+}
+
+// 启动临时文件清理服务（journal 放在临时目录下，启动时清理上次遗留的文件）
+void startTempCleanup() {
+    try {
+        std::filesystem::path journal = std::filesystem::path(getTempDirectory()) / "xyz_cleanup.journal";
+        g_tempCleanup.start(journal.string());
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to start temp file cleanup: " + std::string(e.what()));
+    }
+}
+
 int main(int argc, char* argv[]) {
     try {
-        // 检查是否有文件参数
+        installWin32Platform();
+        
+        // 检查是否有文件参数：
+        //   xyzTrick.exe <文件>                                  转换后用 GView 打开
+        //   xyzTrick.exe <文件> --to=pdb,mol2 [--out-dir=目录]   只解析一次，写出为各指定格式
+        //   xyzTrick.exe <文件|目录>... --to=pqr [--out-dir=目录]  批量转换，多个文件分给多个线程
+        //   --periodic=none|wrap|unwrap                          覆盖配置中的 periodic_mode
+        //   --frames=1-10,15 只写出选中的帧；--split 每帧单独成文件（如 --to=gjf --split 把构象系综拆成逐个输入）
+        //   --route=... --charge=N --multiplicity=N               覆盖配置中的 gjf_route、gjf_charge、gjf_multiplicity
+        //   xyzTrick.exe --chg-diff <目录|文件...> [--reference=文件] [--consecutive] [--to=chg,gaussian_log] [--out-dir=目录]
+        //                                                        批量求 CHG 电荷差
+        //   xyzTrick.exe --chg-log <目录|文件...> [--out-dir=目录]  多电荷列 CHG 批量写成伪 Gaussian 日志
         if (argc > 1) {
             std::string filepath = argv[1];
+            const bool chargeDiff = filepath == "--chg-diff";
+            const bool chargeLog = filepath == "--chg-log";
+            std::vector<std::string> chargeInputs;
+            ChargeDiffOptions chargeOptions;
+            std::vector<std::string> formats;
+            std::string outputDir;
+            ConversionOutput conversionOutput;
+            std::string periodicMode;
+            std::string route, charge, multiplicity;
+            std::vector<std::string> batchInputs{filepath};
+            for (int i = 2; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (chargeDiff && arg.rfind("--reference=", 0) == 0) {
+                    chargeOptions.reference = arg.substr(12);
+                } else if (chargeDiff && arg == "--consecutive") {
+                    chargeOptions.mode = ChargeDiffMode::Consecutive;
+                } else if ((chargeDiff || chargeLog) && arg.rfind("--", 0) != 0) {
+                    chargeInputs.push_back(arg);
+                } else if (arg.rfind("--to=", 0) == 0) {
+                    for (const auto& format : split(arg.substr(5), ',')) {
+                        if (!trim(format).empty()) {
+                            formats.push_back(trim(format));
+                        }
+                    }
+                } else if (arg.rfind("--out-dir=", 0) == 0) {
+                    outputDir = arg.substr(10);
+                } else if (arg.rfind("--periodic=", 0) == 0) {
+                    periodicMode = arg.substr(11);
+                } else if (arg.rfind("--frames=", 0) == 0) {
+                    conversionOutput.frames = arg.substr(9);
+                } else if (arg == "--split") {
+                    conversionOutput.split = true;
+                } else if (arg.rfind("--route=", 0) == 0) {
+                    route = arg.substr(8);
+                } else if (arg.rfind("--charge=", 0) == 0) {
+                    charge = arg.substr(9);
+                } else if (arg.rfind("--multiplicity=", 0) == 0) {
+                    multiplicity = arg.substr(15);
+                } else if (arg.rfind("--", 0) != 0) {
+                    batchInputs.push_back(arg);
+                }
+            }
             LOG_INFO("File parameter received: " + filepath);
             
             // 加载配置
@@ -933,9 +671,57 @@ int main(int argc, char* argv[]) {
             
             g_logger.setLogToConsole(g_config.logToConsole);
             g_logger.setLogToFile(g_config.logToFile);
+
+            if (!periodicMode.empty()) {
+                PeriodicMode mode;
+                if (!parsePeriodicMode(periodicMode, mode)) {
+                    LOG_ERROR("Unknown --periodic value: " + periodicMode + " (expected none, wrap or unwrap)");
+                    return 1;
+                }
+                g_config.periodicMode = periodicModeName(mode);
+            }
+            if (!route.empty()) {
+                g_config.gjfRoute = route;
+            }
+            try {
+                if (!charge.empty()) {
+                    g_config.gjfCharge = std::stoi(charge);
+                }
+                if (!multiplicity.empty()) {
+                    g_config.gjfMultiplicity = std::stoi(multiplicity);
+                }
+            } catch (const std::exception&) {
+                LOG_ERROR("Invalid --charge/--multiplicity value: " + charge + " " + multiplicity);
+                return 1;
+            }
+
+            if (chargeDiff) {
+                if (!formats.empty()) {
+                    chargeOptions.formats = formats;
+                }
+                chargeOptions.outputDir = outputDir;
+                return runChargeDiffBatch(chargeInputs, chargeOptions) ? 0 : 1;
+            }
+            if (chargeLog) {
+                return runChargeLogBatch(chargeInputs, outputDir) ? 0 : 1;
+            }
+            
+            if (!formats.empty()) {
+                conversionOutput.directory = outputDir;
+                std::error_code ec;
+                if (batchInputs.size() > 1 || std::filesystem::is_directory(filepath, ec)) {
+                    return convertFilesToFormats(batchInputs, formats, conversionOutput) ? 0 : 1;
+                }
+                return convertFileToFormats(filepath, formats, conversionOutput) ? 0 : 1;
+            }
+            
+            startTempCleanup();
             
-            // 处理文件转换
+            // 处理文件转换。待删除的临时文件记录在 journal 中：常驻实例在运行时由它接手，
+            // 否则等到删除时间自己删除（仍被占用的留给下次启动）
             bool success = processFileConversion(filepath);
+            g_tempCleanup.finish();
+            g_tempCleanup.stop();
             return success ? 0 : 1;
         }
         
@@ -966,6 +752,8 @@ int main(int argc, char* argv[]) {
         LOG_INFO("  Max Memory: " + std::to_string(g_config.maxMemoryMB) + "MB");
         LOG_INFO("  Max Characters: " + std::to_string(g_config.maxClipboardChars));
         
+        startTempCleanup();
+        
         // 创建隐藏窗口
         WNDCLASSA wc = {};
         wc.lpfnWndProc = WindowProc;
@@ -995,6 +783,9 @@ int main(int argc, char* argv[]) {
             LOG_WARNING("Failed to create tray icon, continuing without it");
         }
         
+        startJobQueue();
+        startClipboardWatcher();
+        
         // 注册全局热键
         if (!reregisterHotkeys()) {
             LOG_ERROR("Failed to register hotkeys");
@@ -1018,12 +809,16 @@ int main(int argc, char* argv[]) {
         }
         
         // 清理
+        g_jobQueue.stop();
+        shutdownPlugins();
+        g_clipboardWatcher.stop();
         UnregisterHotKey(g_hwnd, HOTKEY_XYZ_TO_GVIEW);
         UnregisterHotKey(g_hwnd, HOTKEY_GVIEW_TO_XYZ);
         unregisterPluginHotkeys();
         cleanupTrayIcon();
         DestroyMenuWindow();
         DestroyWindow(g_hwnd);
+        g_tempCleanup.stop();
         
         LOG_INFO("XYZ Monitor stopped.");
         return 0;
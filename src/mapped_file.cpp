@@ -0,0 +1,125 @@
+#include "mapped_file.h"
+#include "logger.h"
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+// ========== Win32 实现 ==========
+
+struct MappedFile::Impl {
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    m_impl->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m_impl->file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("Failed to open file for mapping: " + path + " (error " + std::to_string(GetLastError()) + ")");
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_impl->file, &size) || size.QuadPart <= 0 ||
+        static_cast<unsigned long long>(size.QuadPart) > static_cast<unsigned long long>(SIZE_MAX)) {
+        LOG_WARNING("File is empty or too large to map: " + path);
+        close();
+        return false;
+    }
+    m_impl->mapping = CreateFileMappingA(m_impl->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!m_impl->mapping) {
+        LOG_ERROR("CreateFileMapping failed for " + path + " (error " + std::to_string(GetLastError()) + ")");
+        close();
+        return false;
+    }
+    m_impl->data = static_cast<const char*>(MapViewOfFile(m_impl->mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_impl->data) {
+        LOG_ERROR("MapViewOfFile failed for " + path + " (error " + std::to_string(GetLastError()) + ")");
+        close();
+        return false;
+    }
+    m_impl->size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_impl->data) {
+        UnmapViewOfFile(m_impl->data);
+    }
+    if (m_impl->mapping) {
+        CloseHandle(m_impl->mapping);
+    }
+    if (m_impl->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_impl->file);
+    }
+    *m_impl = Impl();
+}
+
+#else
+
+// ========== POSIX 实现 ==========
+
+struct MappedFile::Impl {
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open file for mapping: " + path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        LOG_WARNING("File is empty or cannot be inspected: " + path);
+        ::close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        LOG_ERROR("mmap failed for " + path);
+        return false;
+    }
+    // 解析器从头到尾顺序扫描
+    madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    m_impl->data = static_cast<const char*>(data);
+    m_impl->size = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_impl->data) {
+        munmap(const_cast<char*>(m_impl->data), m_impl->size);
+    }
+    *m_impl = Impl();
+}
+
+#endif
+
+MappedFile::MappedFile() : m_impl(new Impl) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::isOpen() const {
+    return m_impl->data != nullptr;
+}
+
+std::string_view MappedFile::view() const {
+    return m_impl->data ? std::string_view(m_impl->data, m_impl->size) : std::string_view();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+// 只读内存映射文件：大文件由系统按需分页读入，解析器直接扫描映射区，不复制到堆上，
+// 也不计入转换内存预算。Windows 下用 CreateFileMapping/MapViewOfFile，其他平台用 mmap。
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 映射整个文件，失败（或文件为空）返回 false
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+    // 映射区内容（未打开时为空）
+    std::string_view view() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
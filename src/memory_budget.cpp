@@ -0,0 +1,249 @@
+#include "memory_budget.h"
+#include "core.h"
+#include "logger.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <new>
+#include <sstream>
+
+namespace {
+
+thread_local MemoryBudget* t_currentBudget = nullptr;
+thread_local std::pmr::memory_resource* t_currentArena = nullptr;
+
+// 线程保留的工作区缓冲区（跨转换复用）
+thread_local std::unique_ptr<char[]> t_arenaBuffer;
+thread_local size_t t_arenaSize = 0;
+
+// 工作区初始大小与扩容粒度
+const size_t ARENA_INITIAL_BYTES = 64 * 1024;
+
+// 取得当前线程的工作区缓冲区，返回其大小
+size_t acquireArenaBuffer() {
+    MemoryBudget* budget = currentMemoryBudget();
+    if (budget && t_arenaSize > 0 && budget->used() + t_arenaSize > budget->limit()) {
+        // 保留的缓冲区超出本次预算的余量，先归还，改为按需向预算申请
+        LOG_DEBUG("Releasing conversion arena of " + formatMegabytes(t_arenaSize) + " (over budget headroom)");
+        t_arenaBuffer.reset();
+        t_arenaSize = 0;
+    }
+    if (!t_arenaBuffer) {
+        t_arenaBuffer.reset(new (std::nothrow) char[ARENA_INITIAL_BYTES]);
+        t_arenaSize = t_arenaBuffer ? ARENA_INITIAL_BYTES : 0;
+    }
+    return t_arenaSize;
+}
+
+// Gaussian log 输出的经验大小：每个原子一行坐标（约 70 字节），每帧固定的表头/收敛信息
+const size_t LOG_BYTES_PER_ATOM = 72;
+const size_t LOG_BYTES_PER_FRAME = 1500;
+// XYZ 每帧的原子数行与注释行
+const size_t XYZ_BYTES_PER_FRAME = 160;
+
+// 原子数组从工作区分配，单调资源按倍增申请新块，最坏情况下占用为实际的 2 倍
+const size_t ATOM_GROWTH_FACTOR = 2;
+
+// 输出字符串按倍增扩容，容量最多为实际长度的 2 倍
+const size_t OUTPUT_COPIES = 2;
+
+} // namespace
+
+// ========== MemoryBudgetExceeded ==========
+
+MemoryBudgetExceeded::MemoryBudgetExceeded(size_t requestedBytes, size_t usedBytes, size_t limitBytes)
+    : std::runtime_error("Memory budget exceeded: requested " + formatMegabytes(requestedBytes) +
+                         " with " + formatMegabytes(usedBytes) + " in use (limit " + formatMegabytes(limitBytes) + ")") {}
+
+// ========== MemoryBudget ==========
+
+MemoryBudget::MemoryBudget(size_t limitBytes, std::pmr::memory_resource* upstream)
+    : m_upstream(upstream), m_limit(limitBytes) {}
+
+void MemoryBudget::charge(size_t bytes) {
+    if (m_used + bytes > m_limit) {
+        throw MemoryBudgetExceeded(bytes, m_used, m_limit);
+    }
+    m_used += bytes;
+    if (m_used > m_peak) {
+        m_peak = m_used;
+    }
+}
+
+void MemoryBudget::reserveExternal(size_t bytes) {
+    charge(bytes);
+}
+
+void MemoryBudget::releaseExternal(size_t bytes) {
+    m_used = bytes > m_used ? 0 : m_used - bytes;
+}
+
+void* MemoryBudget::do_allocate(size_t bytes, size_t alignment) {
+    charge(bytes);
+    try {
+        void* p = m_upstream->allocate(bytes, alignment);
+        m_allocations++;
+        return p;
+    } catch (...) {
+        m_used -= bytes;
+        throw;
+    }
+}
+
+void MemoryBudget::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    m_upstream->deallocate(p, bytes, alignment);
+    m_used = bytes > m_used ? 0 : m_used - bytes;
+}
+
+std::string MemoryBudget::summary() const {
+    return "peak " + formatMegabytes(m_peak) + " / limit " + formatMegabytes(m_limit) + ", " +
+           std::to_string(m_allocations) + " allocations";
+}
+
+// ========== MemoryBudgetScope ==========
+
+MemoryBudgetScope::MemoryBudgetScope(MemoryBudget& budget) : m_previous(t_currentBudget) {
+    t_currentBudget = &budget;
+}
+
+MemoryBudgetScope::~MemoryBudgetScope() {
+    t_currentBudget = m_previous;
+}
+
+std::pmr::memory_resource* conversionMemoryResource() {
+    if (t_currentArena) {
+        return t_currentArena;
+    }
+    if (t_currentBudget) {
+        return t_currentBudget;
+    }
+    return std::pmr::new_delete_resource();
+}
+
+MemoryBudget* currentMemoryBudget() {
+    return t_currentBudget;
+}
+
+// ========== TrackedBytes ==========
+
+TrackedBytes::~TrackedBytes() {
+    if (m_budget) {
+        m_budget->releaseExternal(m_bytes);
+    }
+}
+
+void TrackedBytes::update(size_t bytes) {
+    if (!m_budget) {
+        return;
+    }
+    if (bytes > m_bytes) {
+        m_budget->reserveExternal(bytes - m_bytes);
+    } else {
+        m_budget->releaseExternal(m_bytes - bytes);
+    }
+    m_bytes = bytes;
+}
+
+// ========== ConversionArenaScope ==========
+
+void* ConversionArenaScope::OverflowCounter::do_allocate(size_t bytes, size_t alignment) {
+    void* p = m_upstream->allocate(bytes, alignment);
+    m_bytes += bytes;
+    return p;
+}
+
+void ConversionArenaScope::OverflowCounter::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    m_upstream->deallocate(p, bytes, alignment);
+}
+
+ConversionArenaScope::ConversionArenaScope()
+    : m_previous(t_currentArena),
+      m_overflow(conversionMemoryResource()),
+      m_bufferSize(acquireArenaBuffer()),
+      m_resource(t_arenaBuffer.get(), m_bufferSize, &m_overflow) {
+    // 保留缓冲区整体计入预算
+    m_retainedBytes.update(m_bufferSize);
+    t_currentArena = &m_resource;
+}
+
+ConversionArenaScope::~ConversionArenaScope() {
+    t_currentArena = m_previous;
+    m_resource.release();
+
+    // 本次超出了保留缓冲区：按实际用量扩大，下次转换一次到位
+    if (m_overflow.bytes() > 0 && m_bufferSize < RETAIN_LIMIT) {
+        size_t wanted = m_bufferSize + m_overflow.bytes();
+        wanted = (wanted + ARENA_INITIAL_BYTES - 1) / ARENA_INITIAL_BYTES * ARENA_INITIAL_BYTES;
+        wanted = std::min(wanted, RETAIN_LIMIT);
+        t_arenaBuffer.reset();
+        t_arenaBuffer.reset(new (std::nothrow) char[wanted]);
+        t_arenaSize = t_arenaBuffer ? wanted : 0;
+        LOG_DEBUG("Conversion arena grown to " + formatMegabytes(t_arenaSize));
+    }
+}
+
+// ========== 预估 ==========
+
+MemoryEstimate estimateConversionMemory(std::string_view text) {
+    MemoryEstimate estimate;
+    estimate.inputBytes = text.size();
+
+    // 统计行数（memchr 扫描，比解析便宜得多）
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end) {
+        const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+        estimate.lineCount++;
+        if (!nl) {
+            break;
+        }
+        p = static_cast<const char*>(nl) + 1;
+    }
+
+    // 第一行非空内容若为原子数，则按 (原子数 + 2) 行一帧估计帧数
+    size_t pos = text.find_first_not_of(" \t\r\n");
+    size_t header = 0;
+    if (pos != std::string_view::npos) {
+        const char* first = text.data() + pos;
+        auto result = std::from_chars(first, text.data() + text.size(), header);
+        if (result.ec != std::errc() || (result.ptr < end && *result.ptr != '\n' && *result.ptr != '\r' &&
+                                         *result.ptr != ' ' && *result.ptr != '\t')) {
+            header = 0;
+        }
+    }
+
+    if (header > 0) {
+        estimate.atomsPerFrame = header;
+        estimate.frameCount = std::max<size_t>(1, estimate.lineCount / (header + 2));
+    } else {
+        // 简化 XYZ / CHG：每行一个原子，只有一帧
+        estimate.atomsPerFrame = estimate.lineCount;
+        estimate.frameCount = 1;
+    }
+
+    const size_t totalAtoms = estimate.atomsPerFrame * estimate.frameCount;
+    const size_t lineIndexBytes = (estimate.lineCount + 2) * sizeof(size_t);
+    const size_t atomBytes = totalAtoms * sizeof(Atom) * ATOM_GROWTH_FACTOR;
+    const size_t outputBytes = estimateGaussianLogBytes(totalAtoms, estimate.frameCount) * OUTPUT_COPIES;
+
+    estimate.totalBytes = estimate.inputBytes + lineIndexBytes + atomBytes + outputBytes;
+    return estimate;
+}
+
+size_t estimateGaussianLogBytes(size_t totalAtoms, size_t frameCount) {
+    return totalAtoms * LOG_BYTES_PER_ATOM + frameCount * LOG_BYTES_PER_FRAME;
+}
+
+size_t estimateXYZBytes(size_t totalAtoms, size_t frameCount, int precision) {
+    // 元素符号 + 三列坐标（各含分隔空格，列宽 precision + 6）+ 换行
+    const size_t bytesPerAtom = 4 + 3 * (static_cast<size_t>(std::max(precision, 0)) + 7);
+    return totalAtoms * bytesPerAtom + frameCount * XYZ_BYTES_PER_FRAME;
+}
+
+std::string formatMegabytes(size_t bytes) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1) << (static_cast<double>(bytes) / (1024.0 * 1024.0)) << "MB";
+    return oss.str();
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// 转换内存预算：
+// - 转换开始前根据原子数头和输入大小估算峰值，超出 max_memory_mb 直接拒绝
+// - 解析器/写出器的缓冲区通过计数内存资源分配，实时累计；超出预算时抛出 MemoryBudgetExceeded
+// - 转换结束后记录实测峰值
+
+// 超出内存预算（解析器/写出器不应吞掉此异常）
+class MemoryBudgetExceeded : public std::runtime_error {
+public:
+    MemoryBudgetExceeded(size_t requestedBytes, size_t usedBytes, size_t limitBytes);
+};
+
+// 计数内存资源
+class MemoryBudget : public std::pmr::memory_resource {
+public:
+    explicit MemoryBudget(size_t limitBytes, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+    // 记账不经过本资源分配的内存（输入文本、输出字符串等），超出预算时抛出
+    void reserveExternal(size_t bytes);
+    void releaseExternal(size_t bytes);
+
+    size_t limit() const { return m_limit; }
+    size_t used() const { return m_used; }
+    size_t peak() const { return m_peak; }
+    size_t allocationCount() const { return m_allocations; }
+
+    // "peak 12.3MB / limit 500MB, 42 allocations"
+    std::string summary() const;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void charge(size_t bytes);
+
+    std::pmr::memory_resource* m_upstream;
+    size_t m_limit;
+    size_t m_used = 0;
+    size_t m_peak = 0;
+    size_t m_allocations = 0;
+};
+
+// 把预算设为当前线程的转换内存资源（作用域结束时恢复）
+class MemoryBudgetScope {
+public:
+    explicit MemoryBudgetScope(MemoryBudget& budget);
+    ~MemoryBudgetScope();
+    MemoryBudgetScope(const MemoryBudgetScope&) = delete;
+    MemoryBudgetScope& operator=(const MemoryBudgetScope&) = delete;
+
+private:
+    MemoryBudget* m_previous;
+};
+
+// 当前线程的转换内存资源（工作区 > 预算 > new/delete）
+std::pmr::memory_resource* conversionMemoryResource();
+// 当前线程的预算（可能为 nullptr）
+MemoryBudget* currentMemoryBudget();
+
+// 跟踪一块不经过内存资源分配的缓冲区（如 std::string），析构时自动释放记账
+class TrackedBytes {
+public:
+    TrackedBytes() : m_budget(currentMemoryBudget()) {}
+    ~TrackedBytes();
+    TrackedBytes(const TrackedBytes&) = delete;
+    TrackedBytes& operator=(const TrackedBytes&) = delete;
+
+    // 把记账调整为 bytes，超出预算时抛出
+    void update(size_t bytes);
+
+private:
+    MemoryBudget* m_budget;
+    size_t m_bytes = 0;
+};
+
+// 转换工作区：每个线程保留一块缓冲区，转换期间在其上建立单调分配资源
+// （释放为空操作，作用域结束时整体回收）。缓冲区按上一次转换的实际用量增长，
+// 因此重复转换相近规模的数据时，解析器的容器不再向堆申请内存。
+// 须在 MemoryBudgetScope 之后、解析结果之前声明：用工作区分配的对象不能活得比它久。
+class ConversionArenaScope {
+public:
+    ConversionArenaScope();
+    ~ConversionArenaScope();
+    ConversionArenaScope(const ConversionArenaScope&) = delete;
+    ConversionArenaScope& operator=(const ConversionArenaScope&) = delete;
+
+    // 本次转换占用的工作区大小（保留缓冲区 + 超出后向上游申请的部分）
+    size_t footprintBytes() const { return m_bufferSize + m_overflow.bytes(); }
+
+    // 保留缓冲区的上限，超过的部分在转换结束后归还系统
+    static constexpr size_t RETAIN_LIMIT = 64 * 1024 * 1024;
+
+private:
+    // 统计工作区向上游（预算或 new/delete）申请的字节数
+    class OverflowCounter : public std::pmr::memory_resource {
+    public:
+        explicit OverflowCounter(std::pmr::memory_resource* upstream) : m_upstream(upstream) {}
+        size_t bytes() const { return m_bytes; }
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+        std::pmr::memory_resource* m_upstream;
+        size_t m_bytes = 0;
+    };
+
+    std::pmr::memory_resource* m_previous;
+    TrackedBytes m_retainedBytes;
+    OverflowCounter m_overflow;
+    size_t m_bufferSize;
+    std::pmr::monotonic_buffer_resource m_resource;
+};
+
+// 转换内存预估
+struct MemoryEstimate {
+    size_t inputBytes = 0;
+    size_t lineCount = 0;
+    size_t atomsPerFrame = 0;   // 原子数头（没有头时按行数估计）
+    size_t frameCount = 0;
+    size_t totalBytes = 0;      // 预计峰值
+};
+
+// 根据原子数头和输入大小估算 剪贴板文本 -> Gaussian log 转换的峰值内存
+MemoryEstimate estimateConversionMemory(std::string_view text);
+
+// Gaussian log 输出的预计大小（写出器据此一次预留输出缓冲区）
+size_t estimateGaussianLogBytes(size_t totalAtoms, size_t frameCount);
+// XYZ 输出的预计大小（precision 为坐标小数位数）
+size_t estimateXYZBytes(size_t totalAtoms, size_t frameCount, int precision);
+
+// 字节数 -> "12.3MB"
+std::string formatMegabytes(size_t bytes);
@@ -0,0 +1,689 @@
+#include "output_writers.h"
+#include "config.h"
+#include "converter.h"
+#include "logger.h"
+#include "memory_budget.h"
+#include "periodic.h"
+#include "vdw_radii.h"
+#include "xyz_writer.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+// 写出器把一行的全部字段格式化到 sink 的一块连续空间后再提交，
+// 每行的最大长度：固定字段 + 符号/名称（截断到 16 字符）+ 四个数值
+const size_t MAX_FIELD_CHARS = 16;
+const size_t ROW_CAPACITY = 128 + 4 * (MAX_FIXED_CHARS + 1);
+
+// 扩展 XYZ 坐标与电荷的小数位数
+const int EXTXYZ_PRECISION = 8;
+const int EXTXYZ_CHARGE_PRECISION = 6;
+
+// 经验输出大小（每原子一行 + 每帧的头部）
+const size_t EXTXYZ_BYTES_PER_ATOM = 72;
+const size_t EXTXYZ_BYTES_PER_FRAME = 256;
+const size_t PDB_BYTES_PER_ATOM = 81;
+const size_t PDB_BYTES_PER_FRAME = 128;
+const size_t MOL2_BYTES_PER_ATOM = 84;
+const size_t MOL2_BYTES_PER_FRAME = 192;
+const size_t CHG_BYTES_PER_ATOM = 64;
+const size_t PQR_BYTES_PER_ATOM = 84;
+const size_t PQR_BYTES_PER_FRAME = 96;
+const size_t GJF_BYTES_PER_ATOM = 64;
+const size_t GJF_BYTES_PER_FRAME = 256;
+
+// 写到剪贴板等没有文件名的目标时 gjf 模板中 {name} 的取值
+const char* const DEFAULT_OUTPUT_NAME = "xyzTrick";
+
+// PDB 原子序号只有 5 列，超过 99999 时回绕（与常见程序的做法一致）
+const size_t PDB_MAX_SERIAL = 100000;
+
+std::string toLowerAscii(std::string_view text) {
+    std::string lower(text);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char ch) {
+        return static_cast<char>(std::tolower(ch));
+    });
+    return lower;
+}
+
+std::string_view clipField(std::string_view text, size_t maxChars = MAX_FIELD_CHARS) {
+    return text.substr(0, std::min(text.size(), maxChars));
+}
+
+// 左对齐到 width（超宽时不截断）
+char* appendLeft(char* out, std::string_view text, size_t width) {
+    out = appendText(out, text);
+    return text.size() < width ? appendSpaces(out, width - text.size()) : out;
+}
+
+// 右对齐到 width（超宽时不截断）
+char* appendRight(char* out, std::string_view text, size_t width) {
+    if (text.size() < width) {
+        out = appendSpaces(out, width - text.size());
+    }
+    return appendText(out, text);
+}
+
+template <typename Integer>
+char* appendIntegerRight(char* out, Integer value, size_t width) {
+    char digits[24];
+    char* end = appendInteger(digits, value);
+    return appendRight(out, std::string_view(digits, static_cast<size_t>(end - digits)), width);
+}
+
+// 注释等单行文本：换行替换为空格，可选地转义双引号（扩展 XYZ 的引号字符串）
+void writeSingleLine(TextSink& sink, std::string_view text, bool escapeQuotes) {
+    for (char ch : text) {
+        if (ch == '\r' || ch == '\n') {
+            sink.put(' ');
+        } else {
+            if (escapeQuotes && (ch == '"' || ch == '\\')) {
+                sink.put('\\');
+            }
+            sink.put(ch);
+        }
+    }
+}
+
+bool frameHasCharges(const Frame& frame) {
+    return std::any_of(frame.atoms.begin(), frame.atoms.end(), [](const Atom& atom) { return atom.charge != 0.0; });
+}
+
+// ---------- Gaussian log / XYZ ----------
+
+void writeGaussianLogFrames(TextSink& sink, const std::vector<Frame>& frames) {
+    writeGaussianLog(sink, frames);
+}
+
+void writeXYZFrames(TextSink& sink, const std::vector<Frame>& frames) {
+    const XYZWriteOptions options = xyzWriteOptionsFromConfig();
+    for (const auto& frame : frames) {
+        writeXYZFrame(sink, frame, options);
+    }
+}
+
+size_t estimateXYZOutputBytes(size_t totalAtoms, size_t frameCount) {
+    return estimateXYZBytes(totalAtoms, frameCount, g_config.xyzPrecision);
+}
+
+// ---------- 扩展 XYZ ----------
+
+void writeExtXYZKey(TextSink& sink, std::string_view key, double value) {
+    char* out = sink.reserve(64);
+    *out++ = ' ';
+    out = appendText(out, key);
+    *out++ = '=';
+    out = appendShortest(out, value);
+    sink.commit(out);
+}
+
+void writeExtXYZFrames(TextSink& sink, const std::vector<Frame>& frames) {
+    const size_t width = static_cast<size_t>(EXTXYZ_PRECISION) + 8;
+    for (const auto& frame : frames) {
+        const bool charges = frameHasCharges(frame);
+        char* out = sink.reserve(24);
+        out = appendInteger(out, frame.atoms.size());
+        *out++ = '\n';
+        sink.commit(out);
+
+        const bool periodic = frame.cell.periodic3D();
+        if (periodic) {
+            out = sink.reserve(32 + 9 * 32);
+            out = appendText(out, "Lattice=\"");
+            for (int k = 0; k < 9; ++k) {
+                if (k > 0) {
+                    *out++ = ' ';
+                }
+                out = appendShortest(out, frame.cell.vectors[k / 3][k % 3]);
+            }
+            out = appendText(out, "\" ");
+            sink.commit(out);
+        }
+        sink.write(charges ? "Properties=species:S:1:pos:R:3:charge:R:1" : "Properties=species:S:1:pos:R:3");
+        const OptimizationInfo& info = frame.optInfo;
+        if (info.hasEnergy) {
+            writeExtXYZKey(sink, "energy", info.energy);
+        }
+        if (frame.step >= 0) {
+            out = sink.reserve(32);
+            out = appendText(out, " step=");
+            out = appendInteger(out, frame.step);
+            sink.commit(out);
+        }
+        if (frame.hasTime) {
+            writeExtXYZKey(sink, "time", frame.time);
+        }
+        if (info.maxForce >= 0.0) {
+            writeExtXYZKey(sink, "MaxF", info.maxForce);
+        }
+        if (info.rmsForce >= 0.0) {
+            writeExtXYZKey(sink, "RMSF", info.rmsForce);
+        }
+        if (info.maxDisp >= 0.0) {
+            writeExtXYZKey(sink, "MaxD", info.maxDisp);
+        }
+        if (info.rmsDisp >= 0.0) {
+            writeExtXYZKey(sink, "RMSD", info.rmsDisp);
+        }
+        if (!frame.comment.empty()) {
+            sink.write(" comment=\"");
+            writeSingleLine(sink, frame.comment, true);
+            sink.put('"');
+        }
+        sink.write(periodic ? " pbc=\"T T T\"\n" : " pbc=\"F F F\"\n");
+
+        for (const auto& atom : frame.atoms) {
+            out = sink.reserve(ROW_CAPACITY);
+            out = appendLeft(out, clipField(atom.symbol), 2);
+            const double coordinates[3] = {atom.x, atom.y, atom.z};
+            for (double value : coordinates) {
+                *out++ = ' ';
+                out = appendFixed(out, value, EXTXYZ_PRECISION, width);
+            }
+            if (charges) {
+                *out++ = ' ';
+                out = appendFixed(out, atom.charge, EXTXYZ_CHARGE_PRECISION, 10);
+            }
+            *out++ = '\n';
+            sink.commit(out);
+        }
+    }
+}
+
+size_t estimateExtXYZBytes(size_t totalAtoms, size_t frameCount) {
+    return totalAtoms * EXTXYZ_BYTES_PER_ATOM + frameCount * EXTXYZ_BYTES_PER_FRAME;
+}
+
+// ---------- PDB ----------
+
+// 元素符号：大写，最多两个字符
+std::string_view pdbElement(const std::string& symbol, char* buffer) {
+    size_t length = std::min<size_t>(symbol.size(), 2);
+    for (size_t i = 0; i < length; ++i) {
+        buffer[i] = static_cast<char>(std::toupper(static_cast<unsigned char>(symbol[i])));
+    }
+    return std::string_view(buffer, length);
+}
+
+void writePDBFrames(TextSink& sink, const std::vector<Frame>& frames) {
+    for (size_t f = 0; f < frames.size(); ++f) {
+        const Frame& frame = frames[f];
+        if (!frame.comment.empty()) {
+            sink.write("REMARK   1 ");
+            writeSingleLine(sink, clipField(frame.comment, 69), false);
+            sink.put('\n');
+        }
+        char* out;
+        if (frame.cell.periodic3D()) {
+            // "CRYST1<a9.3><b9.3><c9.3><α7.2><β7.2><γ7.2> P 1           1"
+            const CellParameters cell = cellParameters(frame.cell);
+            out = sink.reserve(ROW_CAPACITY);
+            out = appendText(out, "CRYST1");
+            out = appendFixed(out, cell.a, 3, 9);
+            out = appendFixed(out, cell.b, 3, 9);
+            out = appendFixed(out, cell.c, 3, 9);
+            out = appendFixed(out, cell.alpha, 2, 7);
+            out = appendFixed(out, cell.beta, 2, 7);
+            out = appendFixed(out, cell.gamma, 2, 7);
+            out = appendText(out, " P 1           1\n");
+            sink.commit(out);
+        }
+        out = sink.reserve(32);
+        out = appendText(out, "MODEL     ");
+        out = appendIntegerRight(out, f + 1, 4);
+        *out++ = '\n';
+        sink.commit(out);
+
+        // "HETATM<序号5> <名称4> MOL A   1    <x8.3><y8.3><z8.3>  1.00  0.00          <元素2>"
+        for (size_t i = 0; i < frame.atoms.size(); ++i) {
+            const Atom& atom = frame.atoms[i];
+            char elementBuffer[2];
+            std::string_view element = pdbElement(atom.symbol, elementBuffer);
+            out = sink.reserve(ROW_CAPACITY);
+            out = appendText(out, "HETATM");
+            out = appendIntegerRight(out, (i + 1) % PDB_MAX_SERIAL, 5);
+            *out++ = ' ';
+            // 单字母元素的原子名从第 14 列开始
+            if (element.size() < 2) {
+                *out++ = ' ';
+                out = appendLeft(out, element, 3);
+            } else {
+                out = appendLeft(out, element, 4);
+            }
+            out = appendText(out, " MOL A   1    ");
+            out = appendFixed(out, atom.x, 3, 8);
+            out = appendFixed(out, atom.y, 3, 8);
+            out = appendFixed(out, atom.z, 3, 8);
+            out = appendText(out, "  1.00  0.00          ");
+            out = appendRight(out, element, 2);
+            *out++ = '\n';
+            sink.commit(out);
+        }
+        sink.write("ENDMDL\n");
+    }
+    sink.write("END\n");
+}
+
+size_t estimatePDBBytes(size_t totalAtoms, size_t frameCount) {
+    return totalAtoms * PDB_BYTES_PER_ATOM + frameCount * PDB_BYTES_PER_FRAME;
+}
+
+// ---------- mol2 ----------
+
+void writeMol2Frames(TextSink& sink, const std::vector<Frame>& frames) {
+    for (size_t f = 0; f < frames.size(); ++f) {
+        const Frame& frame = frames[f];
+        const bool charges = frameHasCharges(frame);
+
+        sink.write("@<TRIPOS>MOLECULE\n");
+        if (frame.comment.empty()) {
+            char* out = sink.reserve(32);
+            out = appendText(out, "frame ");
+            out = appendInteger(out, f + 1);
+            sink.commit(out);
+        } else {
+            writeSingleLine(sink, frame.comment, false);
+        }
+        char* out = sink.reserve(48);
+        *out++ = '\n';
+        out = appendInteger(out, frame.atoms.size());
+        out = appendText(out, " 0 1 0 0\n");
+        sink.commit(out);
+        sink.write(charges ? "SMALL\nUSER_CHARGES\n\n@<TRIPOS>ATOM\n" : "SMALL\nNO_CHARGES\n\n@<TRIPOS>ATOM\n");
+
+        // "<序号7> <名称8> <x> <y> <z> <类型> 1 MOL <电荷>"，名称为元素符号 + 序号
+        for (size_t i = 0; i < frame.atoms.size(); ++i) {
+            const Atom& atom = frame.atoms[i];
+            std::string_view symbol = clipField(atom.symbol);
+            char name[MAX_FIELD_CHARS + 24];
+            char* nameEnd = appendInteger(appendText(name, symbol), i + 1);
+
+            out = sink.reserve(ROW_CAPACITY);
+            out = appendIntegerRight(out, i + 1, 7);
+            *out++ = ' ';
+            out = appendLeft(out, std::string_view(name, static_cast<size_t>(nameEnd - name)), 8);
+            out = appendFixed(out, atom.x, 4, 11);
+            out = appendFixed(out, atom.y, 4, 11);
+            out = appendFixed(out, atom.z, 4, 11);
+            *out++ = ' ';
+            out = appendLeft(out, symbol, 5);
+            out = appendText(out, "     1  MOL     ");
+            out = appendFixed(out, atom.charge, 4, 10);
+            *out++ = '\n';
+            sink.commit(out);
+        }
+
+        if (frame.cell.periodic3D()) {
+            // "<a> <b> <c> <α> <β> <γ> <空间群> <设置>"，空间群按 P1 写出
+            const CellParameters cell = cellParameters(frame.cell);
+            const double values[6] = {cell.a, cell.b, cell.c, cell.alpha, cell.beta, cell.gamma};
+            sink.write("@<TRIPOS>CRYSIN\n");
+            out = sink.reserve(ROW_CAPACITY);
+            for (double value : values) {
+                out = appendFixed(out, value, 4, 11);
+            }
+            out = appendText(out, "     1     1\n");
+            sink.commit(out);
+        }
+    }
+}
+
+size_t estimateMol2Bytes(size_t totalAtoms, size_t frameCount) {
+    return totalAtoms * MOL2_BYTES_PER_ATOM + frameCount * MOL2_BYTES_PER_FRAME;
+}
+
+// ---------- CHG ----------
+
+// "<元素,左对齐宽 2> <x> <y> <z> <电荷>"：坐标 6 位小数宽 12，电荷 10 位小数宽 14（与 chg_diff 的输出相同）。
+// 有命名的电荷通道时先写表头注释 "# Element X Y Z <通道名>..."，每行依次写出全部通道。
+// CHG 没有帧头，多帧依次写出
+void writeChgFrames(TextSink& sink, const std::vector<Frame>& frames) {
+    for (const auto& frame : frames) {
+        const size_t channels = frame.chargeChannelCount();
+        if (!frame.chargeChannels.empty()) {
+            sink.write("# Element X Y Z");
+            for (const auto& name : frame.chargeChannels) {
+                sink.put(' ');
+                sink.write(name);
+            }
+            sink.put('\n');
+        }
+        for (size_t i = 0; i < frame.atoms.size(); ++i) {
+            const Atom& atom = frame.atoms[i];
+            char* out = sink.reserve(ROW_CAPACITY + channels * (MAX_FIXED_CHARS + 1));
+            out = appendLeft(out, clipField(atom.symbol), 2);
+            const double coordinates[3] = {atom.x, atom.y, atom.z};
+            for (double value : coordinates) {
+                *out++ = ' ';
+                out = appendFixed(out, value, 6, 12);
+            }
+            for (size_t c = 0; c < channels; ++c) {
+                *out++ = ' ';
+                out = appendFixed(out, frame.channelCharge(c, i), 10, 14);
+            }
+            *out++ = '\n';
+            sink.commit(out);
+        }
+    }
+}
+
+size_t estimateChgBytes(size_t totalAtoms, size_t) {
+    // 按一个电荷通道估算，多通道时输出缓冲区在写出过程中增长
+    return totalAtoms * CHG_BYTES_PER_ATOM;
+}
+
+// ---------- PQR ----------
+
+// 与 chg_viewer 的输出逐列相同，VMD 脚本可直接读取：
+// "HETATM<序号5>  <元素,左对齐宽 4>    A   1   <x8.3><y8.3><z8.3><电荷12.8><半径9.4> <元素>"
+// 半径取 configuredVdwRadii()；多帧时每帧一个 MODEL
+void writePQRFrames(TextSink& sink, const std::vector<Frame>& frames) {
+    const std::shared_ptr<const VdwRadii> radii = configuredVdwRadii();
+    const bool models = frames.size() > 1;
+    for (size_t f = 0; f < frames.size(); ++f) {
+        const Frame& frame = frames[f];
+        char* out = sink.reserve(96);
+        out = appendText(out, "REMARK   Generated by xyzTrick, Totally ");
+        out = appendIntegerRight(out, frame.atoms.size(), 8);
+        out = appendText(out, " atoms\n");
+        if (models) {
+            out = appendText(out, "MODEL     ");
+            out = appendIntegerRight(out, f + 1, 4);
+            *out++ = '\n';
+        }
+        sink.commit(out);
+
+        for (size_t i = 0; i < frame.atoms.size(); ++i) {
+            const Atom& atom = frame.atoms[i];
+            std::string_view symbol = clipField(atom.symbol);
+            out = sink.reserve(ROW_CAPACITY + MAX_FIXED_CHARS);
+            out = appendText(out, "HETATM");
+            out = appendIntegerRight(out, (i + 1) % PDB_MAX_SERIAL, 5);
+            out = appendText(out, "  ");
+            out = appendLeft(out, symbol, 4);
+            out = appendText(out, "    A   1   ");
+            out = appendFixed(out, atom.x, 3, 8);
+            out = appendFixed(out, atom.y, 3, 8);
+            out = appendFixed(out, atom.z, 3, 8);
+            out = appendFixed(out, atom.charge, 8, 12);
+            out = appendFixed(out, radii->radius(atom.symbol), 4, 9);
+            *out++ = ' ';
+            out = appendText(out, symbol);
+            *out++ = '\n';
+            sink.commit(out);
+        }
+        if (models) {
+            sink.write("ENDMDL\n");
+        }
+    }
+    sink.write("END\n");
+}
+
+size_t estimatePQRBytes(size_t totalAtoms, size_t frameCount) {
+    return totalAtoms * PQR_BYTES_PER_ATOM + frameCount * PQR_BYTES_PER_FRAME;
+}
+
+// ---------- Gaussian 输入 ----------
+
+// 展开 gjf 模板中的 {name}、{frame}、{comment}（注释只取第一行），其余文本原样写出
+void writeGjfTemplate(TextSink& sink, std::string_view text, const OutputNaming& naming, size_t frameNumber,
+                      const Frame& frame) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t open = text.find('{', pos);
+        if (open == std::string_view::npos) {
+            sink.write(text.substr(pos));
+            return;
+        }
+        sink.write(text.substr(pos, open - pos));
+        size_t close = text.find('}', open);
+        std::string_view key = close == std::string_view::npos ? std::string_view() : text.substr(open + 1, close - open - 1);
+        if (key == "name") {
+            sink.write(naming.name);
+        } else if (key == "frame") {
+            char* out = sink.reserve(24);
+            sink.commit(appendInteger(out, frameNumber));
+        } else if (key == "comment") {
+            std::string_view comment(frame.comment);
+            sink.write(trimView(comment.substr(0, comment.find('\n'))));
+        } else {
+            // 未知占位符原样保留
+            sink.put('{');
+            pos = open + 1;
+            continue;
+        }
+        pos = close + 1;
+    }
+}
+
+// 每帧一个作业：
+//   %chk=... / %nprocshared=N / %mem=...（各自为空时省略）
+//   <route>
+//
+//   <标题>
+//
+//   <电荷> <多重度>
+//   <元素> <x> <y> <z>（坐标 8 位小数）、晶胞的 Tv 行
+//   <空行>
+// 多帧时作业之间以 --Link1-- 分隔
+void writeGaussianInputFramesNamed(TextSink& sink, const std::vector<Frame>& frames, const OutputNaming& naming) {
+    for (size_t f = 0; f < frames.size(); ++f) {
+        const Frame& frame = frames[f];
+        const size_t frameNumber = naming.firstFrame + f;
+        if (f > 0) {
+            sink.write("--Link1--\n");
+        }
+        if (!g_config.gjfChk.empty()) {
+            sink.write("%chk=");
+            writeGjfTemplate(sink, g_config.gjfChk, naming, frameNumber, frame);
+            sink.put('\n');
+        }
+        if (g_config.gjfNproc > 0) {
+            char* out = sink.reserve(48);
+            out = appendText(out, "%nprocshared=");
+            out = appendInteger(out, g_config.gjfNproc);
+            *out++ = '\n';
+            sink.commit(out);
+        }
+        if (!g_config.gjfMem.empty()) {
+            sink.write("%mem=");
+            sink.write(g_config.gjfMem);
+            sink.put('\n');
+        }
+        writeGjfTemplate(sink, g_config.gjfRoute, naming, frameNumber, frame);
+        sink.write("\n\n");
+        // Gaussian 把空标题行当作标题段结束，标题为空时写一个占位
+        const size_t titleStart = sink.bytesWritten();
+        writeGjfTemplate(sink, g_config.gjfTitle, naming, frameNumber, frame);
+        if (sink.bytesWritten() == titleStart) {
+            sink.write("Title");
+        }
+        char* out = sink.reserve(64);
+        out = appendText(out, "\n\n");
+        out = appendInteger(out, g_config.gjfCharge);
+        *out++ = ' ';
+        out = appendInteger(out, g_config.gjfMultiplicity);
+        *out++ = '\n';
+        sink.commit(out);
+
+        for (const auto& atom : frame.atoms) {
+            out = sink.reserve(ROW_CAPACITY);
+            *out++ = ' ';
+            out = appendLeft(out, clipField(atom.symbol), 16);
+            out = appendFixed(out, atom.x, 8, 14);
+            out = appendFixed(out, atom.y, 8, 14);
+            out = appendFixed(out, atom.z, 8, 14);
+            *out++ = '\n';
+            sink.commit(out);
+        }
+        for (int v = 0; v < frame.cell.count; ++v) {
+            out = sink.reserve(ROW_CAPACITY);
+            out = appendText(out, " Tv");
+            out = appendSpaces(out, 14);
+            out = appendFixed(out, frame.cell.vectors[v][0], 8, 14);
+            out = appendFixed(out, frame.cell.vectors[v][1], 8, 14);
+            out = appendFixed(out, frame.cell.vectors[v][2], 8, 14);
+            *out++ = '\n';
+            sink.commit(out);
+        }
+        sink.put('\n');
+    }
+}
+
+void writeGaussianInputFrames(TextSink& sink, const std::vector<Frame>& frames) {
+    writeGaussianInputFramesNamed(sink, frames, OutputNaming{DEFAULT_OUTPUT_NAME, 1});
+}
+
+size_t estimateGaussianInputBytes(size_t totalAtoms, size_t frameCount) {
+    return totalAtoms * GJF_BYTES_PER_ATOM + frameCount * GJF_BYTES_PER_FRAME;
+}
+
+std::vector<OutputWriter>& writerRegistry() {
+    static std::vector<OutputWriter> writers = {
+        {"gaussian_log", ".log", "Gaussian log for GaussView", &writeGaussianLogFrames, &estimateGaussianLogBytes},
+        {"xyz", ".xyz", "XYZ", &writeXYZFrames, &estimateXYZOutputBytes},
+        {"extxyz", ".extxyz", "Extended XYZ", &writeExtXYZFrames, &estimateExtXYZBytes},
+        {"pdb", ".pdb", "PDB (one MODEL per frame)", &writePDBFrames, &estimatePDBBytes},
+        {"mol2", ".mol2", "Tripos mol2", &writeMol2Frames, &estimateMol2Bytes},
+        {"chg", ".chg", "CHG (Element X Y Z Charge)", &writeChgFrames, &estimateChgBytes},
+        {"pqr", ".pqr", "PQR (charges and vdW radii)", &writePQRFrames, &estimatePQRBytes},
+        {"gjf", ".gjf", "Gaussian input", &writeGaussianInputFrames, &estimateGaussianInputBytes,
+         &writeGaussianInputFramesNamed},
+        {"com", ".com", "Gaussian input (.com)", &writeGaussianInputFrames, &estimateGaussianInputBytes,
+         &writeGaussianInputFramesNamed},
+    };
+    return writers;
+}
+
+} // namespace
+
+bool registerOutputWriter(const OutputWriter& writer) {
+    if (writer.name.empty() || !writer.write) {
+        LOG_ERROR("Invalid output writer registration: " + writer.name);
+        return false;
+    }
+    std::vector<OutputWriter>& writers = writerRegistry();
+    for (auto& existing : writers) {
+        if (existing.name == writer.name) {
+            existing = writer;
+            return true;
+        }
+    }
+    writers.push_back(writer);
+    return true;
+}
+
+const OutputWriter* findOutputWriter(std::string_view name) {
+    std::string key = toLowerAscii(name);
+    if (key == "log" || key == "gaussian") {
+        key = "gaussian_log";
+    }
+    for (const auto& writer : writerRegistry()) {
+        if (writer.name == key || writer.extension == key || writer.extension.substr(1) == key) {
+            return &writer;
+        }
+    }
+    return nullptr;
+}
+
+const std::vector<OutputWriter>& outputWriters() {
+    return writerRegistry();
+}
+
+std::string outputWriterNames() {
+    std::string names;
+    for (const auto& writer : writerRegistry()) {
+        if (!names.empty()) {
+            names += ", ";
+        }
+        names += writer.name;
+    }
+    return names;
+}
+
+bool writeFrames(const OutputWriter& writer, const std::vector<Frame>& frames, std::string& output) {
+    output.clear();
+    if (frames.empty()) {
+        LOG_ERROR("No frames to write");
+        return false;
+    }
+
+    try {
+        // 按预计大小一次预留输出缓冲区，计入内存预算
+        size_t totalAtoms = 0;
+        for (const auto& frame : frames) {
+            totalAtoms += frame.atoms.size();
+        }
+        TrackedBytes outputBytes;
+        if (writer.estimateBytes) {
+            output.reserve(writer.estimateBytes(totalAtoms, frames.size()));
+            outputBytes.update(output.capacity());
+        }
+        {
+            TextSink sink(output);
+            writer.write(sink, frames);
+        }
+        outputBytes.update(output.capacity());
+
+        LOG_DEBUG("Wrote " + std::to_string(frames.size()) + " frames (" + std::to_string(totalAtoms) + " atoms) as " +
+                  writer.name);
+        return true;
+    } catch (const MemoryBudgetExceeded&) {
+        output.clear();
+        throw;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception writing " + writer.name + ": " + std::string(e.what()));
+        output.clear();
+        return false;
+    }
+}
+
+void writeFramesToSink(const OutputWriter& writer, TextSink& sink, const std::vector<Frame>& frames,
+                       const OutputNaming& naming) {
+    if (writer.writeNamed) {
+        writer.writeNamed(sink, frames, naming);
+    } else {
+        writer.write(sink, frames);
+    }
+}
+
+bool writeFramesToFile(const OutputWriter& writer, const std::vector<Frame>& frames, const std::string& path,
+                       const OutputNaming* naming) {
+    if (frames.empty()) {
+        LOG_ERROR("No frames to write");
+        return false;
+    }
+
+    try {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOG_ERROR("Failed to open output file for writing: " + path);
+            return false;
+        }
+
+        size_t bytes = 0;
+        bool ok = false;
+        {
+            const std::string stem = std::filesystem::path(path).stem().string();
+            TextSink sink(file);
+            writeFramesToSink(writer, sink, frames, naming ? *naming : OutputNaming{stem, 1});
+            ok = sink.flush();
+            bytes = sink.bytesWritten();
+        }
+        file.close();
+        if (!ok || file.fail()) {
+            LOG_ERROR("Failed to write " + writer.name + " file: " + path);
+            return false;
+        }
+
+        LOG_INFO("Wrote " + std::to_string(frames.size()) + " frames to " + path + " (" + writer.name + ", " +
+                 formatMegabytes(bytes) + ")");
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception writing " + writer.name + " file: " + std::string(e.what()));
+        return false;
+    }
+}
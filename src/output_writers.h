@@ -0,0 +1,60 @@
+#pragma once
+
+#include "core.h"
+#include "text_output.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 输出格式注册表：一次解析得到的帧可写成任意已注册格式。
+// 所有写出器都输出到 TextSink，数值用 text_output.h 的 to_chars 工具格式化。
+// 内置格式：
+//   gaussian_log  伪 Gaussian 输出（GView 打开轨迹用）
+//   xyz           标准 XYZ（坐标小数位数取 xyz_precision）
+//   extxyz        扩展 XYZ（Properties=species:S:1:pos:R:3[:charge:R:1]，能量与收敛数据写成键值）
+//   pdb           多 MODEL 的 PDB（HETATM 记录）
+//   mol2          Tripos mol2（每帧一个 MOLECULE 块，有电荷时写 USER_CHARGES）
+//   chg           CHG（元素 X Y Z 电荷，多帧依次写出）
+//   pqr           PQR（电荷与范德华半径，半径见 vdw_radii.h；多帧时每帧一个 MODEL）
+//   gjf           Gaussian 输入（%chk/资源、route、标题、电荷与多重度取 gjf_* 配置；多帧时以 --Link1-- 分隔）
+//   com           同 gjf，扩展名为 .com
+
+// 写出全部帧；失败时抛出异常（如 MemoryBudgetExceeded）
+using FrameWriterFn = void (*)(TextSink& sink, const std::vector<Frame>& frames);
+// 预计输出大小（用于一次预留输出缓冲区）
+using FrameSizeEstimateFn = size_t (*)(size_t totalAtoms, size_t frameCount);
+
+// 输出的命名信息：name 为输出文件名（不含扩展名），firstFrame 为 frames[0] 在原始轨迹中的帧号（1 起）
+struct OutputNaming {
+    std::string_view name;
+    size_t firstFrame = 1;
+};
+// 需要命名信息的写出（如 gjf 的 %chk=<name>.chk）
+using NamedFrameWriterFn = void (*)(TextSink& sink, const std::vector<Frame>& frames, const OutputNaming& naming);
+
+struct OutputWriter {
+    std::string name;            // 格式名（配置和命令行中使用）
+    std::string extension;       // 输出文件扩展名（含点）
+    std::string description;
+    FrameWriterFn write = nullptr;
+    FrameSizeEstimateFn estimateBytes = nullptr;
+    NamedFrameWriterFn writeNamed = nullptr;    // 非空时写文件优先使用（命名取输出文件名）
+};
+
+// 注册写出器（同名时替换），返回是否成功
+bool registerOutputWriter(const OutputWriter& writer);
+// 按格式名或扩展名查找（不区分大小写，"log"/".pdb" 均可），找不到返回 nullptr
+const OutputWriter* findOutputWriter(std::string_view name);
+// 已注册的全部写出器（按注册顺序）
+const std::vector<OutputWriter>& outputWriters();
+// "gaussian_log, xyz, extxyz, pdb, mol2, chg, pqr, gjf, com"
+std::string outputWriterNames();
+
+// 写入 output（先清空，保留已有容量），输出缓冲区计入内存预算；失败返回 false
+bool writeFrames(const OutputWriter& writer, const std::vector<Frame>& frames, std::string& output);
+// 写出到 sink：写出器有 writeNamed 时带上 naming，否则调用 write
+void writeFramesToSink(const OutputWriter& writer, TextSink& sink, const std::vector<Frame>& frames,
+                       const OutputNaming& naming);
+// 直接写入文件，失败返回 false。naming 为空时命名取 path 的文件名（不含扩展名）
+bool writeFramesToFile(const OutputWriter& writer, const std::vector<Frame>& frames, const std::string& path,
+                       const OutputNaming* naming = nullptr);
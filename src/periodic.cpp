@@ -0,0 +1,789 @@
+#include "periodic.h"
+#include "logger.h"
+#include "threading.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XYZTRICK_PERIODIC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+const double BOHR_TO_ANGSTROM = 0.529177210903;
+
+// 每块原子数：块内坐标转成 SoA（3 x 256 个 double，约 6KB），留在 L1 中计算
+const size_t BLOCK_ATOMS = 256;
+// 原子数 x 帧数达到此值才分给多个线程，每个线程至少处理这么多
+const size_t PARALLEL_MIN_WORK = 1u << 20;
+
+// 判断成键：距离 < 共价半径之和 + 容差（与常见可视化程序的判据一致）
+const double BOND_TOLERANCE = 0.45;
+const double DEFAULT_COVALENT_RADIUS = 1.50;
+
+// 共价半径（Å，Cordero et al. 2008），下标为原子序数，覆盖 H ~ Cm
+const double COVALENT_RADII[] = {
+    0.00,
+    0.31, 0.28, 1.28, 0.96, 0.84, 0.76, 0.71, 0.66, 0.57, 0.58,
+    1.66, 1.41, 1.21, 1.11, 1.07, 1.05, 1.02, 1.06, 2.03, 1.76,
+    1.70, 1.60, 1.53, 1.39, 1.39, 1.32, 1.26, 1.24, 1.32, 1.22,
+    1.22, 1.20, 1.19, 1.20, 1.20, 1.16, 2.20, 1.95, 1.90, 1.75,
+    1.64, 1.54, 1.47, 1.46, 1.42, 1.39, 1.45, 1.44, 1.42, 1.39,
+    1.39, 1.38, 1.39, 1.40, 2.44, 2.15, 2.07, 2.04, 2.03, 2.01,
+    1.99, 1.98, 1.98, 1.96, 1.94, 1.92, 1.92, 1.89, 1.90, 1.87,
+    1.87, 1.75, 1.70, 1.62, 1.51, 1.44, 1.41, 1.36, 1.36, 1.32,
+    1.45, 1.46, 1.48, 1.40, 1.50, 1.50, 2.60, 2.21, 2.15, 2.06,
+    2.00, 1.96, 1.90, 1.87, 1.80, 1.69
+};
+const int COVALENT_RADII_COUNT = static_cast<int>(sizeof(COVALENT_RADII) / sizeof(COVALENT_RADII[0]));
+
+double covalentRadius(int atomicNumber) {
+    if (atomicNumber <= 0 || atomicNumber >= COVALENT_RADII_COUNT) {
+        return DEFAULT_COVALENT_RADIUS;
+    }
+    return COVALENT_RADII[atomicNumber];
+}
+
+// 晶胞矩阵（行为平移矢量）及其逆：笛卡尔 r = f * m，分数 f = r * inv
+struct CellMatrix {
+    double m[3][3];
+    double inv[3][3];
+};
+
+bool buildCellMatrix(const UnitCell& cell, CellMatrix& matrix) {
+    if (!cell.periodic3D()) {
+        return false;
+    }
+    const double (&v)[3][3] = cell.vectors;
+    const double cofactor[3][3] = {
+        {v[1][1] * v[2][2] - v[1][2] * v[2][1], v[0][2] * v[2][1] - v[0][1] * v[2][2], v[0][1] * v[1][2] - v[0][2] * v[1][1]},
+        {v[1][2] * v[2][0] - v[1][0] * v[2][2], v[0][0] * v[2][2] - v[0][2] * v[2][0], v[0][2] * v[1][0] - v[0][0] * v[1][2]},
+        {v[1][0] * v[2][1] - v[1][1] * v[2][0], v[0][1] * v[2][0] - v[0][0] * v[2][1], v[0][0] * v[1][1] - v[0][1] * v[1][0]}
+    };
+    const double det = v[0][0] * cofactor[0][0] + v[0][1] * cofactor[1][0] + v[0][2] * cofactor[2][0];
+    if (!std::isfinite(det) || std::fabs(det) < 1e-8) {
+        return false;
+    }
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            matrix.m[i][j] = v[i][j];
+            matrix.inv[i][j] = cofactor[i][j] / det;
+        }
+    }
+    return true;
+}
+
+// 一块原子的 SoA 坐标
+struct CoordinateBlock {
+    alignas(16) double x[BLOCK_ATOMS];
+    alignas(16) double y[BLOCK_ATOMS];
+    alignas(16) double z[BLOCK_ATOMS];
+};
+
+void gatherBlock(const Atom* atoms, size_t count, CoordinateBlock& block) {
+    for (size_t i = 0; i < count; ++i) {
+        block.x[i] = atoms[i].x;
+        block.y[i] = atoms[i].y;
+        block.z[i] = atoms[i].z;
+    }
+}
+
+void scatterBlock(const CoordinateBlock& block, size_t count, Atom* atoms) {
+    for (size_t i = 0; i < count; ++i) {
+        atoms[i].x = block.x[i];
+        atoms[i].y = block.y[i];
+        atoms[i].z = block.z[i];
+    }
+}
+
+// 标量版本（块尾和没有 SSE2 的平台）
+// 分数坐标取 [0,1)：f - floor(f) 对极小的负数会舍入成 1，归为 0
+inline double wrapFraction(double f) {
+    f -= std::floor(f);
+    return f < 1.0 ? f : 0.0;
+}
+
+inline void wrapScalar(double& x, double& y, double& z, const CellMatrix& c) {
+    const double fa = wrapFraction(x * c.inv[0][0] + y * c.inv[1][0] + z * c.inv[2][0]);
+    const double fb = wrapFraction(x * c.inv[0][1] + y * c.inv[1][1] + z * c.inv[2][1]);
+    const double fc = wrapFraction(x * c.inv[0][2] + y * c.inv[1][2] + z * c.inv[2][2]);
+    x = fa * c.m[0][0] + fb * c.m[1][0] + fc * c.m[2][0];
+    y = fa * c.m[0][1] + fb * c.m[1][1] + fc * c.m[2][1];
+    z = fa * c.m[0][2] + fb * c.m[1][2] + fc * c.m[2][2];
+}
+
+// 把 (x,y,z) 移到离参考点最近的镜像
+inline void nearestImageScalar(double& x, double& y, double& z, double rx, double ry, double rz, const CellMatrix& c) {
+    const double dx = x - rx;
+    const double dy = y - ry;
+    const double dz = z - rz;
+    double fa = dx * c.inv[0][0] + dy * c.inv[1][0] + dz * c.inv[2][0];
+    double fb = dx * c.inv[0][1] + dy * c.inv[1][1] + dz * c.inv[2][1];
+    double fc = dx * c.inv[0][2] + dy * c.inv[1][2] + dz * c.inv[2][2];
+    fa -= std::floor(fa + 0.5);
+    fb -= std::floor(fb + 0.5);
+    fc -= std::floor(fc + 0.5);
+    x = rx + fa * c.m[0][0] + fb * c.m[1][0] + fc * c.m[2][0];
+    y = ry + fa * c.m[0][1] + fb * c.m[1][1] + fc * c.m[2][1];
+    z = rz + fa * c.m[0][2] + fb * c.m[1][2] + fc * c.m[2][2];
+}
+
+#ifdef XYZTRICK_PERIODIC_SSE2
+
+// 向下取整：加减 1.5 * 2^52 得到就近舍入的整数，比原值大时减 1。
+// 对 |v| < 2^51 成立（分数坐标远小于这个范围），不分支，也不经过整数转换
+inline __m128d floorPair(__m128d v) {
+    const __m128d magic = _mm_set1_pd(6755399441055744.0);
+    const __m128d rounded = _mm_sub_pd(_mm_add_pd(v, magic), magic);
+    return _mm_sub_pd(rounded, _mm_and_pd(_mm_cmpgt_pd(rounded, v), _mm_set1_pd(1.0)));
+}
+
+inline __m128d wrapFractionPair(__m128d f) {
+    f = _mm_sub_pd(f, floorPair(f));
+    return _mm_and_pd(f, _mm_cmplt_pd(f, _mm_set1_pd(1.0)));
+}
+
+inline __m128d rowDot(__m128d a, __m128d b, __m128d c, double ka, double kb, double kc) {
+    return _mm_add_pd(_mm_add_pd(_mm_mul_pd(a, _mm_set1_pd(ka)), _mm_mul_pd(b, _mm_set1_pd(kb))),
+                      _mm_mul_pd(c, _mm_set1_pd(kc)));
+}
+
+#endif
+
+// 把块内坐标包进晶胞
+void wrapBlock(CoordinateBlock& block, size_t count, const CellMatrix& c) {
+    size_t i = 0;
+#ifdef XYZTRICK_PERIODIC_SSE2
+    for (; i + 2 <= count; i += 2) {
+        const __m128d x = _mm_load_pd(block.x + i);
+        const __m128d y = _mm_load_pd(block.y + i);
+        const __m128d z = _mm_load_pd(block.z + i);
+        const __m128d fa = wrapFractionPair(rowDot(x, y, z, c.inv[0][0], c.inv[1][0], c.inv[2][0]));
+        const __m128d fb = wrapFractionPair(rowDot(x, y, z, c.inv[0][1], c.inv[1][1], c.inv[2][1]));
+        const __m128d fc = wrapFractionPair(rowDot(x, y, z, c.inv[0][2], c.inv[1][2], c.inv[2][2]));
+        _mm_store_pd(block.x + i, rowDot(fa, fb, fc, c.m[0][0], c.m[1][0], c.m[2][0]));
+        _mm_store_pd(block.y + i, rowDot(fa, fb, fc, c.m[0][1], c.m[1][1], c.m[2][1]));
+        _mm_store_pd(block.z + i, rowDot(fa, fb, fc, c.m[0][2], c.m[1][2], c.m[2][2]));
+    }
+#endif
+    for (; i < count; ++i) {
+        wrapScalar(block.x[i], block.y[i], block.z[i], c);
+    }
+}
+
+// 块内每个坐标移到离 reference 中同一原子最近的镜像
+void nearestImageBlock(CoordinateBlock& block, const CoordinateBlock& reference, size_t count, const CellMatrix& c) {
+    size_t i = 0;
+#ifdef XYZTRICK_PERIODIC_SSE2
+    const __m128d half = _mm_set1_pd(0.5);
+    for (; i + 2 <= count; i += 2) {
+        const __m128d rx = _mm_load_pd(reference.x + i);
+        const __m128d ry = _mm_load_pd(reference.y + i);
+        const __m128d rz = _mm_load_pd(reference.z + i);
+        const __m128d dx = _mm_sub_pd(_mm_load_pd(block.x + i), rx);
+        const __m128d dy = _mm_sub_pd(_mm_load_pd(block.y + i), ry);
+        const __m128d dz = _mm_sub_pd(_mm_load_pd(block.z + i), rz);
+        __m128d fa = rowDot(dx, dy, dz, c.inv[0][0], c.inv[1][0], c.inv[2][0]);
+        __m128d fb = rowDot(dx, dy, dz, c.inv[0][1], c.inv[1][1], c.inv[2][1]);
+        __m128d fc = rowDot(dx, dy, dz, c.inv[0][2], c.inv[1][2], c.inv[2][2]);
+        fa = _mm_sub_pd(fa, floorPair(_mm_add_pd(fa, half)));
+        fb = _mm_sub_pd(fb, floorPair(_mm_add_pd(fb, half)));
+        fc = _mm_sub_pd(fc, floorPair(_mm_add_pd(fc, half)));
+        _mm_store_pd(block.x + i, _mm_add_pd(rx, rowDot(fa, fb, fc, c.m[0][0], c.m[1][0], c.m[2][0])));
+        _mm_store_pd(block.y + i, _mm_add_pd(ry, rowDot(fa, fb, fc, c.m[0][1], c.m[1][1], c.m[2][1])));
+        _mm_store_pd(block.z + i, _mm_add_pd(rz, rowDot(fa, fb, fc, c.m[0][2], c.m[1][2], c.m[2][2])));
+    }
+#endif
+    for (; i < count; ++i) {
+        nearestImageScalar(block.x[i], block.y[i], block.z[i], reference.x[i], reference.y[i], reference.z[i], c);
+    }
+}
+
+void wrapAtomRange(Atom* atoms, size_t begin, size_t end, const CellMatrix& c) {
+    CoordinateBlock block;
+    for (size_t start = begin; start < end; start += BLOCK_ATOMS) {
+        const size_t count = std::min(BLOCK_ATOMS, end - start);
+        gatherBlock(atoms + start, count, block);
+        wrapBlock(block, count, c);
+        scatterBlock(block, count, atoms + start);
+    }
+}
+
+// 展开 [begin, end) 范围内的原子：每一帧取离上一帧（已展开）同一原子最近的镜像。
+// 块在外层、帧在内层，上一帧的结果留在 SoA 块中直接作为下一帧的参考，不再重新收集。
+// usable[f] 为真表示第 f 帧有可用晶胞且原子数与上一帧相同
+void followAtomRange(std::vector<Frame>& frames, const std::vector<CellMatrix>& matrices,
+                     const std::vector<char>& usable, size_t begin, size_t end) {
+    CoordinateBlock blocks[2];
+    for (size_t start = begin; start < end; start += BLOCK_ATOMS) {
+        CoordinateBlock* reference = &blocks[0];
+        CoordinateBlock* current = &blocks[1];
+        size_t referenceCount = 0;
+        bool haveReference = false;
+        for (size_t f = 1; f < frames.size(); ++f) {
+            const size_t frameEnd = std::min(end, frames[f].atoms.size());
+            if (!usable[f] || start >= frameEnd) {
+                haveReference = false;
+                continue;
+            }
+            const size_t count = std::min(BLOCK_ATOMS, frameEnd - start);
+            if (!haveReference || referenceCount != count) {
+                gatherBlock(frames[f - 1].atoms.data() + start, count, *reference);
+            }
+            gatherBlock(frames[f].atoms.data() + start, count, *current);
+            nearestImageBlock(*current, *reference, count, matrices[f]);
+            scatterBlock(*current, count, frames[f].atoms.data() + start);
+            std::swap(reference, current);
+            referenceCount = count;
+            haveReference = true;
+        }
+    }
+}
+
+bool startsWithIgnoreCase(std::string_view text, std::string_view prefix) {
+    return text.size() >= prefix.size() && equalsIgnoreCase(text.substr(0, prefix.size()), prefix);
+}
+
+// CP2K 的 [单位] 标注：返回长度换算到 Å 的系数，未知单位返回 0
+double cp2kLengthScale(std::string_view unit) {
+    if (equalsIgnoreCase(unit, "[angstrom]") || equalsIgnoreCase(unit, "[ang]")) {
+        return 1.0;
+    }
+    if (equalsIgnoreCase(unit, "[bohr]")) {
+        return BOHR_TO_ANGSTROM;
+    }
+    if (equalsIgnoreCase(unit, "[nm]")) {
+        return 10.0;
+    }
+    if (equalsIgnoreCase(unit, "[pm]")) {
+        return 0.01;
+    }
+    return 0.0;
+}
+
+// 关键字后的三个数值（可带 [单位]），长度按 lengthUnits 换算
+bool readCP2KTriple(const std::string_view* tokens, size_t tokenCount, bool lengthUnits, double values[3]) {
+    size_t first = 1;
+    double scale = 1.0;
+    if (tokenCount > 1 && !tokens[1].empty() && tokens[1][0] == '[') {
+        if (lengthUnits) {
+            scale = cp2kLengthScale(tokens[1]);
+            if (scale == 0.0) {
+                LOG_WARNING("Unsupported CP2K unit in &CELL: " + std::string(tokens[1]));
+                return false;
+            }
+        }
+        first = 2;
+    }
+    if (tokenCount < first + 3) {
+        return false;
+    }
+    for (size_t i = 0; i < 3; ++i) {
+        if (!parseDouble(tokens[first + i], values[i])) {
+            return false;
+        }
+        values[i] *= scale;
+    }
+    return true;
+}
+
+} // namespace
+
+bool parsePeriodicMode(std::string_view text, PeriodicMode& mode) {
+    text = trimView(text);
+    if (text.empty() || equalsIgnoreCase(text, "none")) {
+        mode = PeriodicMode::None;
+    } else if (equalsIgnoreCase(text, "wrap")) {
+        mode = PeriodicMode::Wrap;
+    } else if (equalsIgnoreCase(text, "unwrap")) {
+        mode = PeriodicMode::Unwrap;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* periodicModeName(PeriodicMode mode) {
+    switch (mode) {
+        case PeriodicMode::Wrap: return "wrap";
+        case PeriodicMode::Unwrap: return "unwrap";
+        default: return "none";
+    }
+}
+
+CellParameters cellParameters(const UnitCell& cell) {
+    CellParameters parameters;
+    double lengths[3] = {0.0, 0.0, 0.0};
+    for (int i = 0; i < cell.count && i < 3; ++i) {
+        const double* v = cell.vectors[i];
+        lengths[i] = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    }
+    auto angle = [&cell, &lengths](int i, int j) {
+        if (i >= cell.count || j >= cell.count || lengths[i] == 0.0 || lengths[j] == 0.0) {
+            return 90.0;
+        }
+        const double* u = cell.vectors[i];
+        const double* v = cell.vectors[j];
+        double cosine = (u[0] * v[0] + u[1] * v[1] + u[2] * v[2]) / (lengths[i] * lengths[j]);
+        cosine = std::min(1.0, std::max(-1.0, cosine));
+        return std::acos(cosine) * 180.0 / PI;
+    };
+    parameters.a = lengths[0];
+    parameters.b = lengths[1];
+    parameters.c = lengths[2];
+    parameters.alpha = angle(1, 2);
+    parameters.beta = angle(0, 2);
+    parameters.gamma = angle(0, 1);
+    return parameters;
+}
+
+UnitCell cellFromParameters(const CellParameters& parameters) {
+    const double cosAlpha = std::cos(parameters.alpha * PI / 180.0);
+    const double cosBeta = std::cos(parameters.beta * PI / 180.0);
+    const double cosGamma = std::cos(parameters.gamma * PI / 180.0);
+    const double sinGamma = std::sin(parameters.gamma * PI / 180.0);
+
+    UnitCell cell;
+    cell.count = 3;
+    cell.vectors[0][0] = parameters.a;
+    cell.vectors[1][0] = parameters.b * cosGamma;
+    cell.vectors[1][1] = parameters.b * sinGamma;
+    const double cx = parameters.c * cosBeta;
+    const double cy = sinGamma != 0.0 ? parameters.c * (cosAlpha - cosBeta * cosGamma) / sinGamma : 0.0;
+    cell.vectors[2][0] = cx;
+    cell.vectors[2][1] = cy;
+    cell.vectors[2][2] = std::sqrt(std::max(0.0, parameters.c * parameters.c - cx * cx - cy * cy));
+    return cell;
+}
+
+bool parseExtXYZLattice(std::string_view comment, UnitCell& cell) {
+    // 键必须在行首或空白之后（避免匹配 "SuperLattice=" 之类）
+    size_t pos = comment.find("Lattice");
+    while (pos != std::string_view::npos && pos > 0 && !std::isspace(static_cast<unsigned char>(comment[pos - 1]))) {
+        pos = comment.find("Lattice", pos + 1);
+    }
+    if (pos == std::string_view::npos) {
+        return false;
+    }
+    size_t i = pos + 7;
+    while (i < comment.size() && std::isspace(static_cast<unsigned char>(comment[i]))) {
+        ++i;
+    }
+    if (i >= comment.size() || comment[i] != '=') {
+        return false;
+    }
+    ++i;
+    while (i < comment.size() && std::isspace(static_cast<unsigned char>(comment[i]))) {
+        ++i;
+    }
+    if (i >= comment.size() || (comment[i] != '"' && comment[i] != '\'')) {
+        return false;
+    }
+    const char quote = comment[i];
+    size_t close = comment.find(quote, i + 1);
+    if (close == std::string_view::npos) {
+        return false;
+    }
+
+    std::string_view tokens[10];
+    size_t tokenCount = splitWhitespaceViews(comment.substr(i + 1, close - i - 1), tokens, 10);
+    if (tokenCount != 9) {
+        LOG_WARNING("Lattice= needs 9 numbers, found " + std::to_string(tokenCount));
+        return false;
+    }
+    UnitCell parsed;
+    for (size_t k = 0; k < 9; ++k) {
+        if (!parseDouble(tokens[k], parsed.vectors[k / 3][k % 3])) {
+            LOG_WARNING("Invalid number in Lattice=: " + std::string(tokens[k]));
+            return false;
+        }
+    }
+    parsed.count = 3;
+    cell = parsed;
+    return true;
+}
+
+bool parseCP2KCell(const TextLines& lines, UnitCell& cell) {
+    bool inCell = false;
+    bool found = false;
+    int nestedDepth = 0;
+    bool haveVector[3] = {false, false, false};
+    bool haveLengths = false;
+    bool periodicNone = false;
+    UnitCell vectors;
+    CellParameters parameters;
+
+    for (size_t lineIndex = 0; lineIndex < lines.lineCount(); ++lineIndex) {
+        std::string_view text = lines.line(lineIndex);
+        size_t commentPos = text.find_first_of("!#");
+        if (commentPos != std::string_view::npos) {
+            text = text.substr(0, commentPos);
+        }
+        std::string_view tokens[8];
+        size_t tokenCount = splitWhitespaceViews(text, tokens, 8);
+        if (tokenCount == 0) {
+            continue;
+        }
+        const std::string_view keyword = tokens[0];
+
+        if (!inCell) {
+            if (equalsIgnoreCase(keyword, "&CELL")) {
+                inCell = true;
+                found = true;
+            }
+            continue;
+        }
+        if (keyword[0] == '&') {
+            // &CELL_REF 等子段忽略
+            if (startsWithIgnoreCase(keyword, "&END")) {
+                if (nestedDepth == 0) {
+                    break;
+                }
+                --nestedDepth;
+            } else {
+                ++nestedDepth;
+            }
+            continue;
+        }
+        if (nestedDepth > 0) {
+            continue;
+        }
+
+        double values[3];
+        int vectorIndex = equalsIgnoreCase(keyword, "A") ? 0 : equalsIgnoreCase(keyword, "B") ? 1
+                        : equalsIgnoreCase(keyword, "C") ? 2 : -1;
+        if (vectorIndex >= 0) {
+            if (readCP2KTriple(tokens, tokenCount, true, values)) {
+                std::copy(values, values + 3, vectors.vectors[vectorIndex]);
+                haveVector[vectorIndex] = true;
+            } else {
+                LOG_WARNING("Invalid CP2K cell vector line: " + std::string(trimView(text)));
+            }
+        } else if (equalsIgnoreCase(keyword, "ABC")) {
+            if (readCP2KTriple(tokens, tokenCount, true, values)) {
+                parameters.a = values[0];
+                parameters.b = values[1];
+                parameters.c = values[2];
+                haveLengths = true;
+            } else {
+                LOG_WARNING("Invalid CP2K ABC line: " + std::string(trimView(text)));
+            }
+        } else if (equalsIgnoreCase(keyword, "ALPHA_BETA_GAMMA")) {
+            if (readCP2KTriple(tokens, tokenCount, false, values)) {
+                parameters.alpha = values[0];
+                parameters.beta = values[1];
+                parameters.gamma = values[2];
+            } else {
+                LOG_WARNING("Invalid CP2K ALPHA_BETA_GAMMA line: " + std::string(trimView(text)));
+            }
+        } else if (equalsIgnoreCase(keyword, "PERIODIC") && tokenCount > 1) {
+            periodicNone = equalsIgnoreCase(tokens[1], "NONE");
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+    cell = UnitCell();
+    if (periodicNone) {
+        LOG_DEBUG("CP2K cell is non-periodic (PERIODIC NONE)");
+    } else if (haveVector[0] && haveVector[1] && haveVector[2]) {
+        vectors.count = 3;
+        cell = vectors;
+    } else if (haveLengths) {
+        cell = cellFromParameters(parameters);
+    } else {
+        LOG_WARNING("CP2K &CELL section has neither A/B/C nor ABC");
+    }
+    return true;
+}
+
+bool wrapFrame(Frame& frame, const UnitCell& cell) {
+    CellMatrix matrix;
+    if (!buildCellMatrix(cell, matrix)) {
+        return false;
+    }
+    wrapAtomRange(frame.atoms.data(), 0, frame.atoms.size(), matrix);
+    return true;
+}
+
+bool makeMoleculesWhole(Frame& frame, const UnitCell& cell) {
+    CellMatrix matrix;
+    if (!buildCellMatrix(cell, matrix)) {
+        return false;
+    }
+    const size_t atomCount = frame.atoms.size();
+    if (atomCount < 2) {
+        return true;
+    }
+    if (atomCount > UINT32_MAX) {
+        LOG_WARNING("Too many atoms to rebuild molecules: " + std::to_string(atomCount));
+        return false;
+    }
+
+    std::pmr::memory_resource* resource = conversionMemoryResource();
+
+    // 每个原子的共价半径（相邻原子元素相同的居多，缓存上一个符号）
+    std::pmr::vector<double> radii(atomCount, 0.0, resource);
+    double maxRadius = 0.0;
+    const std::string* lastSymbol = nullptr;
+    double lastRadius = DEFAULT_COVALENT_RADIUS;
+    for (size_t i = 0; i < atomCount; ++i) {
+        const std::string& symbol = frame.atoms[i].symbol;
+        if (!lastSymbol || symbol != *lastSymbol) {
+            lastRadius = covalentRadius(getAtomicNumber(symbol));
+            lastSymbol = &symbol;
+        }
+        radii[i] = lastRadius;
+        maxRadius = std::max(maxRadius, lastRadius);
+    }
+    const double cutoff = 2.0 * maxRadius + BOND_TOLERANCE;
+
+    // 分数坐标（[0,1)）
+    std::pmr::vector<double> fractions(atomCount * 3, 0.0, resource);
+    for (size_t i = 0; i < atomCount; ++i) {
+        const Atom& atom = frame.atoms[i];
+        for (int k = 0; k < 3; ++k) {
+            fractions[i * 3 + k] = wrapFraction(atom.x * matrix.inv[0][k] + atom.y * matrix.inv[1][k] +
+                                                atom.z * matrix.inv[2][k]);
+        }
+    }
+
+    // 网格：每个方向的格子厚度不小于截断距离（晶面间距 = 体积 / 另两条边叉积的模），
+    // 相邻 27 个格子即可找到全部键。格子数按原子数封顶，避免真空层很厚时格子过多
+    const double (&v)[3][3] = cell.vectors;
+    const double volume = std::fabs(v[0][0] * (v[1][1] * v[2][2] - v[1][2] * v[2][1]) -
+                                    v[0][1] * (v[1][0] * v[2][2] - v[1][2] * v[2][0]) +
+                                    v[0][2] * (v[1][0] * v[2][1] - v[1][1] * v[2][0]));
+    const size_t maxBinsPerAxis = std::max<size_t>(3, static_cast<size_t>(2.0 * std::cbrt(static_cast<double>(atomCount))));
+    size_t bins[3];
+    for (int k = 0; k < 3; ++k) {
+        const double* p = v[(k + 1) % 3];
+        const double* q = v[(k + 2) % 3];
+        const double cx = p[1] * q[2] - p[2] * q[1];
+        const double cy = p[2] * q[0] - p[0] * q[2];
+        const double cz = p[0] * q[1] - p[1] * q[0];
+        const double spacing = volume / std::sqrt(cx * cx + cy * cy + cz * cz);
+        if (spacing < 2.0 * cutoff) {
+            LOG_DEBUG("Cell is thinner than twice the bond cutoff; bonds across several images may be missed");
+        }
+        bins[k] = std::min(maxBinsPerAxis, std::max<size_t>(1, static_cast<size_t>(spacing / cutoff)));
+    }
+
+    auto binIndex = [&bins](size_t a, size_t b, size_t c) { return (a * bins[1] + b) * bins[2] + c; };
+    auto binOf = [&bins](double f, int axis) {
+        return std::min(bins[axis] - 1, static_cast<size_t>(f * static_cast<double>(bins[axis])));
+    };
+    const size_t binCount = bins[0] * bins[1] * bins[2];
+    std::pmr::vector<uint32_t> binStart(binCount + 1, 0, resource);
+    std::pmr::vector<uint32_t> atomBin(atomCount, 0, resource);
+    for (size_t i = 0; i < atomCount; ++i) {
+        const double* f = &fractions[i * 3];
+        atomBin[i] = static_cast<uint32_t>(binIndex(binOf(f[0], 0), binOf(f[1], 1), binOf(f[2], 2)));
+        ++binStart[atomBin[i] + 1];
+    }
+    for (size_t b = 0; b < binCount; ++b) {
+        binStart[b + 1] += binStart[b];
+    }
+    std::pmr::vector<uint32_t> binAtoms(atomCount, 0, resource);
+    {
+        std::pmr::vector<uint32_t> fill(binStart.begin(), binStart.end() - 1, resource);
+        for (size_t i = 0; i < atomCount; ++i) {
+            binAtoms[fill[atomBin[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    // 每个方向上不重复的相邻格子偏移（格子少于 3 个时 -1/0/+1 会落到同一格）
+    size_t neighbourOffsets[3][3];
+    size_t neighbourCounts[3];
+    for (int k = 0; k < 3; ++k) {
+        neighbourCounts[k] = 0;
+        for (size_t delta : {size_t(0), size_t(1), bins[k] - 1}) {
+            delta %= bins[k];
+            if (std::find(neighbourOffsets[k], neighbourOffsets[k] + neighbourCounts[k], delta) ==
+                neighbourOffsets[k] + neighbourCounts[k]) {
+                neighbourOffsets[k][neighbourCounts[k]++] = delta;
+            }
+        }
+    }
+
+    // 成键原子对（i < j），再整理成邻接表（CSR）
+    std::pmr::vector<uint32_t> bondPairs(resource);
+    bondPairs.reserve(atomCount * 4);
+    for (size_t i = 0; i < atomCount; ++i) {
+        const double* fi = &fractions[i * 3];
+        const size_t home[3] = {binOf(fi[0], 0), binOf(fi[1], 1), binOf(fi[2], 2)};
+        for (size_t da = 0; da < neighbourCounts[0]; ++da) {
+            for (size_t db = 0; db < neighbourCounts[1]; ++db) {
+                for (size_t dc = 0; dc < neighbourCounts[2]; ++dc) {
+                    const size_t bin = binIndex((home[0] + neighbourOffsets[0][da]) % bins[0],
+                                                (home[1] + neighbourOffsets[1][db]) % bins[1],
+                                                (home[2] + neighbourOffsets[2][dc]) % bins[2]);
+                    for (uint32_t slot = binStart[bin]; slot < binStart[bin + 1]; ++slot) {
+                        const uint32_t j = binAtoms[slot];
+                        if (j <= i) {
+                            continue;
+                        }
+                        const double* fj = &fractions[static_cast<size_t>(j) * 3];
+                        double d[3] = {0.0, 0.0, 0.0};
+                        for (int k = 0; k < 3; ++k) {
+                            double delta = fj[k] - fi[k];
+                            delta -= std::floor(delta + 0.5);
+                            d[0] += delta * matrix.m[k][0];
+                            d[1] += delta * matrix.m[k][1];
+                            d[2] += delta * matrix.m[k][2];
+                        }
+                        const double limit = radii[i] + radii[j] + BOND_TOLERANCE;
+                        if (d[0] * d[0] + d[1] * d[1] + d[2] * d[2] < limit * limit) {
+                            bondPairs.push_back(static_cast<uint32_t>(i));
+                            bondPairs.push_back(j);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::pmr::vector<uint32_t> neighbourStart(atomCount + 1, 0, resource);
+    for (size_t p = 0; p < bondPairs.size(); ++p) {
+        ++neighbourStart[bondPairs[p] + 1];
+    }
+    for (size_t i = 0; i < atomCount; ++i) {
+        neighbourStart[i + 1] += neighbourStart[i];
+    }
+    std::pmr::vector<uint32_t> neighbours(bondPairs.size(), 0, resource);
+    {
+        std::pmr::vector<uint32_t> fill(neighbourStart.begin(), neighbourStart.end() - 1, resource);
+        for (size_t p = 0; p < bondPairs.size(); p += 2) {
+            neighbours[fill[bondPairs[p]]++] = bondPairs[p + 1];
+            neighbours[fill[bondPairs[p + 1]]++] = bondPairs[p];
+        }
+    }
+
+    // 从每个分子的第一个原子出发广度优先遍历，成键原子放到离已放置原子最近的镜像
+    std::pmr::vector<char> placed(atomCount, 0, resource);
+    std::pmr::vector<uint32_t> queue(resource);
+    queue.reserve(atomCount);
+    size_t molecules = 0;
+    for (size_t root = 0; root < atomCount; ++root) {
+        if (placed[root]) {
+            continue;
+        }
+        ++molecules;
+        placed[root] = 1;
+        queue.clear();
+        queue.push_back(static_cast<uint32_t>(root));
+        for (size_t head = 0; head < queue.size(); ++head) {
+            const Atom& current = frame.atoms[queue[head]];
+            for (uint32_t slot = neighbourStart[queue[head]]; slot < neighbourStart[queue[head] + 1]; ++slot) {
+                const uint32_t next = neighbours[slot];
+                if (placed[next]) {
+                    continue;
+                }
+                Atom& atom = frame.atoms[next];
+                nearestImageScalar(atom.x, atom.y, atom.z, current.x, current.y, current.z, matrix);
+                placed[next] = 1;
+                queue.push_back(next);
+            }
+        }
+    }
+
+    LOG_DEBUG("Rebuilt " + std::to_string(molecules) + " molecules from " + std::to_string(bondPairs.size() / 2) +
+              " bonds (" + std::to_string(binCount) + " grid cells)");
+    return true;
+}
+
+size_t applyPeriodicMode(std::vector<Frame>& frames, PeriodicMode mode) {
+    if (mode == PeriodicMode::None || frames.empty()) {
+        return 0;
+    }
+
+    try {
+        // 每帧的晶胞矩阵：帧自身没有晶胞时沿用前面最近一帧的
+        std::vector<CellMatrix> matrices(frames.size());
+        std::vector<char> usable(frames.size(), 0);
+        const UnitCell* current = nullptr;
+        size_t maxAtoms = 0;
+        size_t totalAtoms = 0;
+        for (size_t f = 0; f < frames.size(); ++f) {
+            if (frames[f].cell.count > 0) {
+                current = &frames[f].cell;
+            }
+            usable[f] = current && buildCellMatrix(*current, matrices[f]) ? 1 : 0;
+            maxAtoms = std::max(maxAtoms, frames[f].atoms.size());
+            totalAtoms += frames[f].atoms.size();
+        }
+        if (std::find(usable.begin(), usable.end(), 1) == usable.end()) {
+            LOG_DEBUG("No 3D periodic cell; skipping periodic " + std::string(periodicModeName(mode)));
+            return 0;
+        }
+
+        size_t processed = 0;
+        if (mode == PeriodicMode::Unwrap && usable[0]) {
+            makeMoleculesWhole(frames[0], frames[0].cell);
+            ++processed;
+        }
+        for (size_t f = (mode == PeriodicMode::Unwrap ? 1 : 0); f < frames.size(); ++f) {
+            if (usable[f] && (mode == PeriodicMode::Wrap || frames[f].atoms.size() == frames[f - 1].atoms.size())) {
+                ++processed;
+            } else {
+                usable[f] = 0;
+            }
+        }
+
+        // 每个原子只依赖自己（展开时还有上一帧的同一原子），按原子范围分给多个线程，
+        // 每个线程按帧顺序处理自己的范围，不需要同步
+        auto processRange = [&frames, &matrices, &usable, mode](size_t begin, size_t end) {
+            if (mode == PeriodicMode::Unwrap) {
+                followAtomRange(frames, matrices, usable, begin, end);
+                return;
+            }
+            for (size_t f = 0; f < frames.size(); ++f) {
+                const size_t rangeEnd = std::min(end, frames[f].atoms.size());
+                if (usable[f] && begin < rangeEnd) {
+                    wrapAtomRange(frames[f].atoms.data(), begin, rangeEnd, matrices[f]);
+                }
+            }
+        };
+
+        size_t chunkCount = std::min<size_t>(hardwareConcurrency(), totalAtoms / PARALLEL_MIN_WORK);
+        chunkCount = std::min(std::max<size_t>(chunkCount, 1), (maxAtoms + BLOCK_ATOMS - 1) / BLOCK_ATOMS);
+        chunkCount = std::max<size_t>(chunkCount, 1);
+        // 范围边界按块对齐
+        const size_t chunkBlocks = ((maxAtoms + BLOCK_ATOMS - 1) / BLOCK_ATOMS + chunkCount - 1) / chunkCount;
+        const size_t chunkSize = std::max<size_t>(1, chunkBlocks) * BLOCK_ATOMS;
+
+        std::vector<std::unique_ptr<Thread>> workers;
+        for (size_t begin = chunkSize; begin < maxAtoms; begin += chunkSize) {
+            const size_t end = std::min(maxAtoms, begin + chunkSize);
+            auto work = [&processRange, begin, end]() {
+                processRange(begin, end);
+            };
+            auto worker = std::make_unique<Thread>();
+            if (!worker->start(work)) {
+                work();
+                continue;
+            }
+            workers.push_back(std::move(worker));
+        }
+        processRange(0, std::min(maxAtoms, chunkSize));
+        for (auto& worker : workers) {
+            worker->join();
+        }
+
+        LOG_INFO("Periodic " + std::string(periodicModeName(mode)) + ": " + std::to_string(processed) + " of " +
+                 std::to_string(frames.size()) + " frames (" + std::to_string(workers.size() + 1) + " threads)");
+        return processed;
+    } catch (const MemoryBudgetExceeded&) {
+        throw;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception applying periodic " + std::string(periodicModeName(mode)) + ": " + std::string(e.what()));
+        return 0;
+    }
+}
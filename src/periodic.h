@@ -0,0 +1,48 @@
+#pragma once
+
+#include "core.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 周期性体系：
+// - 晶胞来源：XYZ 中的 Tv 行（readXYZFrame 移入 Frame::cell）、扩展 XYZ 注释中的 Lattice="..."、
+//   CP2K 输入的 &CELL 段（A/B/C 矢量或 ABC + ALPHA_BETA_GAMMA）
+// - 包裹（wrap）：每个原子平移进晶胞，分数坐标落在 [0,1)
+// - 展开（unwrap）：第一帧按共价半径成键关系把被边界切开的分子拼完整，
+//   之后各帧每个原子取与上一帧最近的镜像，轨迹连续
+// 坐标按块转成 SoA 后计算（x86-64 上用 SSE2 一次处理两个原子），大轨迹按原子范围分给多个线程。
+// 只有三维周期的晶胞参与包裹/展开，一维、二维的 Tv 只随帧写出。
+
+enum class PeriodicMode {
+    None,
+    Wrap,
+    Unwrap
+};
+
+// "none" / "wrap" / "unwrap"（不区分大小写），无法识别时返回 false
+bool parsePeriodicMode(std::string_view text, PeriodicMode& mode);
+const char* periodicModeName(PeriodicMode mode);
+
+// 晶胞参数：长度（Å）与夹角（度）
+struct CellParameters {
+    double a = 0.0, b = 0.0, c = 0.0;
+    double alpha = 90.0, beta = 90.0, gamma = 90.0;
+};
+
+CellParameters cellParameters(const UnitCell& cell);
+// a 沿 x 轴、b 在 xy 平面内的标准取向
+UnitCell cellFromParameters(const CellParameters& parameters);
+
+// 解析扩展 XYZ 注释中的 Lattice="ax ay az bx by bz cx cy cz"，没有或格式不对时返回 false
+bool parseExtXYZLattice(std::string_view comment, UnitCell& cell);
+// 解析 CP2K 输入中第一个 &CELL 段；PERIODIC NONE 时 cell.count 为 0。没有 &CELL 段返回 false
+bool parseCP2KCell(const TextLines& lines, UnitCell& cell);
+
+// 单帧操作；晶胞不是三维周期或矩阵奇异时返回 false，坐标不变
+bool wrapFrame(Frame& frame, const UnitCell& cell);
+bool makeMoleculesWhole(Frame& frame, const UnitCell& cell);
+
+// 流水线阶段：对全部帧应用 mode。帧自身没有晶胞时沿用前面最近一帧的晶胞。
+// 返回实际处理的帧数
+size_t applyPeriodicMode(std::vector<Frame>& frames, PeriodicMode mode);
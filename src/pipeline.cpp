@@ -0,0 +1,857 @@
+#include "pipeline.h"
+#include "clipboard_watcher.h"
+#include "job_queue.h"
+#include "platform.h"
+#include "config.h"
+#include "converter.h"
+#include "encoding.h"
+#include "logger.h"
+#include "mapped_file.h"
+#include "memory_budget.h"
+#include "output_writers.h"
+#include "periodic.h"
+#include "threading.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+// 临时文件目录
+std::string getTempDirectory() {
+    if (!g_config.tempDir.empty()) {
+        // Support env vars and paths relative to config.ini
+        return resolveConfigPathForFile(g_config.tempDir);
+    }
+    return std::filesystem::temp_directory_path().string();
+}
+
+// 创建临时文件
+std::string createTempFile(const std::string& content, const std::string& extension) {
+    try {
+        // 使用更稳妥的唯一文件名，避免同一秒内多次触发导致覆盖
+        std::filesystem::path dir(getTempDirectory());
+        std::filesystem::create_directories(dir);
+
+        const auto now = std::chrono::system_clock::now();
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+        // 单调时钟 + 进程内序号保证同一毫秒内多次触发也不会重名
+        static std::atomic<unsigned int> sequence{0};
+        const uint64_t tick = g_platform.clock ? g_platform.clock->nowMicros() : 0;
+
+        std::ostringstream filename;
+        filename << "molecule_" << ms << "_" << tick << "_" << sequence.fetch_add(1) << extension;
+
+        std::filesystem::path filepath = dir / filename.str();
+        
+        std::ofstream file(filepath.string(), std::ios::binary);
+        if (!file.is_open()) {
+            LOG_ERROR("Failed to create temp file: " + filepath.string());
+            return "";
+        }
+        
+        file << content;
+        file.close();
+        
+        LOG_INFO("Created temporary file: " + filepath.string());
+        return filepath.string();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception creating temp file: " + std::string(e.what()));
+        return "";
+    }
+}
+
+// 使用GView打开文件
+bool openWithGView(const std::string& filepath) {
+    try {
+        if (g_config.gviewPath.empty()) {
+            LOG_ERROR("GView path not configured!");
+            return false;
+        }
+
+        // Support env vars and relative paths (relative to config.ini)
+        std::string gviewExe = resolveConfigPathForExecutable(g_config.gviewPath);
+        std::string command = "\"" + gviewExe + "\" \"" + filepath + "\"";
+        LOG_DEBUG("Executing command: " + command);
+        
+        if (!g_platform.launcher || !g_platform.launcher->launch(command)) {
+            LOG_ERROR("Failed to launch GView");
+            return false;
+        }
+        
+        if (g_platform.tempFiles) {
+            g_platform.tempFiles->scheduleDelete(filepath, g_config.waitSeconds);
+        }
+        
+        LOG_INFO("Launched GView successfully");
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception launching GView: " + std::string(e.what()));
+        return false;
+    }
+}
+
+// 删除临时文件（打开失败时立即清理）
+bool removeTempFile(const std::string& filepath) {
+    std::error_code ec;
+    if (!std::filesystem::remove(filepath, ec)) {
+        LOG_ERROR("Failed to cleanup temp file: " + filepath);
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+bool jobCancelled(JobContext* ctx) {
+    if (ctx && ctx->isCancelled()) {
+        LOG_INFO("Conversion cancelled.");
+        return true;
+    }
+    return false;
+}
+
+void reportStage(JobContext* ctx, const std::string& stage) {
+    if (ctx) {
+        ctx->progress(stage);
+    }
+}
+
+// 有任务上下文时把通知留给完成消息（附带耗时），否则直接通知
+void reportOutcome(JobContext* ctx, const std::string& title, const std::string& message, NotifyLevel level) {
+    if (ctx) {
+        ctx->setResult(title, message, level);
+    } else {
+        notifyUser(title, message, level);
+    }
+}
+
+// 按格式名取写出器；格式未知时记录警告并改用 fallback
+const OutputWriter& resolveOutputWriter(const std::string& format, const char* fallback) {
+    if (const OutputWriter* writer = findOutputWriter(format)) {
+        return *writer;
+    }
+    LOG_WARNING("Unknown output format '" + format + "' (available: " + outputWriterNames() + "), using " + fallback);
+    return *findOutputWriter(fallback);
+}
+
+enum class StructureParse {
+    Ok,
+    NotStructure,   // 既不是 XYZ 也不是 CHG
+    Failed          // 格式可识别但没有解析出原子
+};
+
+// 写出前按 periodic_mode 处理带晶胞的帧
+void applyConfiguredPeriodicMode(std::vector<Frame>& frames) {
+    PeriodicMode periodicMode = PeriodicMode::None;
+    if (parsePeriodicMode(g_config.periodicMode, periodicMode)) {
+        applyPeriodicMode(frames, periodicMode);
+    }
+}
+
+// 识别并解析 XYZ/CHG/CP2K/Chem3D 文本（forceChg：按 .chg 扩展名直接当作 CHG），source 用于日志
+StructureParse parseStructureFrames(const TextLines& text, bool forceChg, const std::string& source,
+                                    std::vector<Frame>& frames) {
+    if (!forceChg && isXmlStructure(text.content)) {
+        LOG_INFO("Detected Chem3D/CML XML in " + source + ".");
+        frames = readXmlStructure(text.content);
+    } else if (!forceChg && isCP2KInput(text)) {
+        LOG_INFO("Detected CP2K input in " + source + ".");
+        Frame frame = readCP2KInput(text);
+        if (!frame.atoms.empty()) {
+            frames.push_back(std::move(frame));
+        }
+    } else if (!forceChg && isCP2KTrajectory(text.content)) {
+        LOG_INFO("Detected CP2K trajectory in " + source + ".");
+        frames = readCP2KTrajectory(text.content);
+    } else if (forceChg || (g_config.tryParseChgFormat && isChgFormat(text))) {
+        // 如果启用了CHG格式支持，优先尝试CHG格式
+        LOG_INFO("Detected CHG format in " + source + ".");
+        Frame frame = readChgFrame(text);
+        if (!frame.atoms.empty()) {
+            frames.push_back(std::move(frame));
+        }
+    } else if (isXYZFormat(text)) {
+        LOG_INFO("Detected XYZ format in " + source + ".");
+        frames = readMultiXYZ(text);
+    } else {
+        LOG_INFO("Invalid format in " + source + " (not XYZ, CHG, CP2K or Chem3D/CML).");
+        return StructureParse::NotStructure;
+    }
+    if (frames.empty()) {
+        return StructureParse::Failed;
+    }
+
+    applyConfiguredPeriodicMode(frames);
+    return StructureParse::Ok;
+}
+
+// CP2K 轨迹 <project>-pos-<n>.xyz 对应的晶胞文件 <project>-<n>.cell，文件名不符合时返回空路径
+std::filesystem::path cp2kCellFilePath(const std::filesystem::path& trajectory) {
+    const std::string stem = trajectory.stem().string();
+    size_t marker = stem.rfind("-pos-");
+    if (marker == std::string::npos) {
+        return {};
+    }
+    return trajectory.parent_path() / (stem.substr(0, marker) + "-" + stem.substr(marker + 5) + ".cell");
+}
+
+// 映射文件，是 CP2K MD 轨迹时直接在映射区上解析（输入不占堆内存，也不建立行索引）
+StructureFileLoad loadCP2KTrajectoryFile(const MappedFile& mapped, const std::filesystem::path& input,
+                                         std::vector<Frame>& frames) {
+    const size_t limitBytes = static_cast<size_t>(g_config.maxMemoryMB) * 1024 * 1024;
+    MemoryEstimate estimate = estimateConversionMemory(mapped.view());
+    const size_t mappedBytes = estimate.inputBytes + (estimate.lineCount + 2) * sizeof(size_t);
+    const size_t heapBytes = estimate.totalBytes > mappedBytes ? estimate.totalBytes - mappedBytes : 0;
+    LOG_INFO("Detected CP2K trajectory in " + input.filename().string() + " (" + formatMegabytes(estimate.inputBytes) +
+             " mapped, estimated heap " + formatMegabytes(heapBytes) + ")");
+    if (heapBytes > limitBytes) {
+        LOG_WARNING("Estimated memory " + formatMegabytes(heapBytes) + " exceeds max_memory_mb (" +
+                    std::to_string(g_config.maxMemoryMB) + "MB)");
+        return StructureFileLoad::TooLarge;
+    }
+
+    frames = readCP2KTrajectory(mapped.view());
+    if (frames.empty()) {
+        return StructureFileLoad::ParseFailed;
+    }
+
+    std::filesystem::path cellPath = cp2kCellFilePath(input);
+    std::error_code ec;
+    if (!cellPath.empty() && std::filesystem::exists(cellPath, ec)) {
+        EncodedFileContent cellContent = readFileWithEncoding(cellPath.string());
+        size_t assigned = applyCP2KCellFile(cellContent, frames);
+        LOG_INFO("Applied cells from " + cellPath.filename().string() + " to " + std::to_string(assigned) + " frame(s)");
+    }
+    applyConfiguredPeriodicMode(frames);
+    return StructureFileLoad::Ok;
+}
+
+// 热键转换的输出缓冲区，跨次复用（每个工作线程一份）
+thread_local std::string t_logOutput;
+
+// 借用 t_logOutput；容量超过工作区保留上限时在转换结束后释放
+class ReusableLogOutput {
+public:
+    ReusableLogOutput() = default;
+    ~ReusableLogOutput() {
+        if (t_logOutput.capacity() > ConversionArenaScope::RETAIN_LIMIT) {
+            std::string().swap(t_logOutput);
+        } else {
+            t_logOutput.clear();
+        }
+    }
+    ReusableLogOutput(const ReusableLogOutput&) = delete;
+    ReusableLogOutput& operator=(const ReusableLogOutput&) = delete;
+
+    std::string& text() { return t_logOutput; }
+};
+
+} // namespace
+
+// 处理剪贴板内容（XYZ到GView）
+bool processClipboardXYZToGView(JobContext* ctx) {
+    std::string clipboardText = g_platform.clipboard ? g_platform.clipboard->readText() : "";
+    return processClipboardTextToGView(std::move(clipboardText), ctx);
+}
+
+bool processClipboardTextToGView(std::string clipboardText, JobContext* ctx) {
+    LOG_INFO("Processing clipboard (XYZ to GView)...");
+    
+    try {
+        if (clipboardText.empty()) {
+            LOG_INFO("Clipboard is empty or not text format.");
+            return false;
+        }
+        
+        if (clipboardText.length() > g_config.maxClipboardChars) {
+            LOG_WARNING("Clipboard content is too large (" + std::to_string(clipboardText.length()) + 
+                       " characters). Limit is " + std::to_string(g_config.maxClipboardChars) + 
+                       " characters (" + std::to_string(g_config.maxMemoryMB) + "MB memory limit).");
+            reportOutcome(ctx, "XYZ Monitor", "Clipboard content is too large", NotifyLevel::Warning);
+            return false;
+        }
+        
+        // 先按原子数头和输入大小估算峰值，明显超出预算时不开始解析
+        const size_t limitBytes = static_cast<size_t>(g_config.maxMemoryMB) * 1024 * 1024;
+        MemoryEstimate estimate = estimateConversionMemory(clipboardText);
+        LOG_INFO("Processing " + std::to_string(estimate.inputBytes) + " characters (~" +
+                 std::to_string(estimate.frameCount) + " frame(s) x " + std::to_string(estimate.atomsPerFrame) +
+                 " atoms, estimated peak " + formatMegabytes(estimate.totalBytes) + ")");
+        if (estimate.totalBytes > limitBytes) {
+            LOG_WARNING("Estimated memory " + formatMegabytes(estimate.totalBytes) + " exceeds max_memory_mb (" +
+                        std::to_string(g_config.maxMemoryMB) + "MB), conversion rejected.");
+            reportOutcome(ctx, "XYZ Monitor", "Clipboard data needs about " + formatMegabytes(estimate.totalBytes) +
+                          ", above the " + std::to_string(g_config.maxMemoryMB) + "MB limit", NotifyLevel::Warning);
+            return false;
+        }
+        
+        // 解析和写出过程中实际分配的缓冲区计入预算，超出时抛出 MemoryBudgetExceeded
+        MemoryBudget budget(limitBytes);
+        MemoryBudgetScope budgetScope(budget);
+        TrackedBytes inputBytes;
+        inputBytes.update(clipboardText.capacity());
+        
+        // 行索引和原子数组从线程保留的工作区分配，输出写入复用的缓冲区
+        ConversionArenaScope arena;
+        ReusableLogOutput output;
+        
+        reportStage(ctx, "Parsing");
+        
+        // 统一换行并建立行索引（只扫描一次，检测与解析共用）
+        TextLines text = indexLines(std::move(clipboardText));
+        
+        // 尝试解析格式
+        std::vector<Frame> frames;
+        StructureParse parsed = parseStructureFrames(text, false, "clipboard", frames);
+        if (parsed == StructureParse::NotStructure) {
+            reportOutcome(ctx, "XYZ Monitor", "Clipboard is not XYZ or CHG text", NotifyLevel::Warning);
+            return false;
+        }
+        
+        if (parsed == StructureParse::Failed) {
+            LOG_ERROR("Failed to parse XYZ data.");
+            reportOutcome(ctx, "XYZ Monitor", "Failed to parse XYZ data", NotifyLevel::Error);
+            return false;
+        }
+        
+        LOG_INFO("Found " + std::to_string(frames.size()) + " frame(s) with " + std::to_string(frames[0].atoms.size()) + " atoms.");
+        if (jobCancelled(ctx)) {
+            return false;
+        }
+        
+        reportStage(ctx, "Converting");
+        const OutputWriter& writer = resolveOutputWriter(g_config.hotkeyFormat, "gaussian_log");
+        std::string& convertedContent = output.text();
+        if (!writeFrames(writer, frames, convertedContent)) {
+            LOG_ERROR("Failed to convert to " + writer.description + " format.");
+            reportOutcome(ctx, "XYZ Monitor", "Failed to convert to " + writer.description + " format", NotifyLevel::Error);
+            return false;
+        }
+        TrackedBytes outputBytes;
+        outputBytes.update(convertedContent.capacity());
+        LOG_INFO("Conversion memory: " + budget.summary() + ", arena " + formatMegabytes(arena.footprintBytes()) +
+                 " (estimated " + formatMegabytes(estimate.totalBytes) + ")");
+        if (jobCancelled(ctx)) {
+            return false;
+        }
+        
+        reportStage(ctx, "Opening GView");
+        std::string tempFile = createTempFile(convertedContent, writer.extension);
+        
+        if (tempFile.empty()) {
+            LOG_ERROR("Failed to create temporary file.");
+            reportOutcome(ctx, "XYZ Monitor", "Failed to create temporary file", NotifyLevel::Error);
+            return false;
+        }
+        
+        if (openWithGView(tempFile)) {
+            LOG_INFO("Opened with GView successfully.");
+            if (ctx) {
+                ctx->setResult("XYZ to GView", "Opened " + std::to_string(frames.size()) + " frame(s), " +
+                               std::to_string(frames[0].atoms.size()) + " atoms");
+            }
+            return true;
+        }
+        LOG_ERROR("Failed to open with GView.");
+        reportOutcome(ctx, "XYZ Monitor", "Failed to open with GView", NotifyLevel::Error);
+        removeTempFile(tempFile);
+        return false;
+    } catch (const MemoryBudgetExceeded& e) {
+        LOG_ERROR("Conversion aborted: " + std::string(e.what()));
+        reportOutcome(ctx, "XYZ Monitor", "Conversion aborted: memory limit (" + std::to_string(g_config.maxMemoryMB) +
+                      "MB) exceeded", NotifyLevel::Warning);
+        return false;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception in processClipboardXYZToGView: " + std::string(e.what()));
+        reportOutcome(ctx, "XYZ Monitor", "Error: " + std::string(e.what()), NotifyLevel::Error);
+        return false;
+    } catch (...) {
+        LOG_ERROR("Unknown exception in processClipboardXYZToGView");
+        return false;
+    }
+}
+
+// 处理GView clipboard到XYZ
+bool processGViewClipboardToXYZ(JobContext* ctx) {
+    LOG_INFO("Processing GView clipboard to XYZ...");
+    
+    try {
+        if (g_config.gaussianClipboardPath.empty()) {
+            LOG_ERROR("Gaussian clipboard path not configured!");
+            reportOutcome(ctx, "XYZ Monitor", "Error: Gaussian clipboard path not configured!", NotifyLevel::Error);
+            return false;
+        }
+        
+        reportStage(ctx, "Parsing");
+        
+        // 取得Gaussian clipboard文件的解析结果（支持 %VAR% 和相对路径：相对于 config.ini）。
+        // 监视线程已在文件改写后解析并格式化好时直接使用，否则在这里同步解析
+        std::shared_ptr<const ClipboardFileSnapshot> snapshot =
+            g_clipboardWatcher.load(resolveConfigPathForFile(g_config.gaussianClipboardPath));
+        
+        if (!snapshot || snapshot->atoms.empty()) {
+            LOG_ERROR("No atoms found in Gaussian clipboard file");
+            LOG_INFO("Make sure you have copied a molecule in Gaussian and the path is correct.");
+            reportOutcome(ctx, "XYZ Monitor", "No atoms found. Copy a molecule in GaussianView first.", NotifyLevel::Warning);
+            return false;
+        }
+        
+        const std::vector<Atom>& atoms = snapshot->atoms;
+        LOG_INFO("SUCCESS: Parsed " + std::to_string(atoms.size()) + " atoms");
+        if (jobCancelled(ctx)) {
+            return false;
+        }
+        
+        // XYZ字符串随解析结果一起缓存；选择其他格式时在这里写出
+        reportStage(ctx, "Converting");
+        const OutputWriter& writer = resolveOutputWriter(g_config.hotkeyReverseFormat, "xyz");
+        std::string converted;
+        if (writer.name != "xyz") {
+            std::vector<Frame> frames(1);
+            frames[0].atoms.assign(atoms.begin(), atoms.end());
+            frames[0].comment = "Converted from Gaussian clipboard";
+            writeFrames(writer, frames, converted);
+        }
+        const std::string& xyzString = writer.name == "xyz" ? snapshot->xyz : converted;
+        
+        if (xyzString.empty()) {
+            LOG_ERROR("Failed to create " + writer.description + " text");
+            reportOutcome(ctx, "XYZ Monitor", "Failed to create " + writer.description + " format", NotifyLevel::Error);
+            return false;
+        }
+        if (jobCancelled(ctx)) {
+            return false;
+        }
+        
+        // 写入剪贴板
+        if (g_platform.clipboard && g_platform.clipboard->writeText(xyzString)) {
+            LOG_INFO("SUCCESS: " + writer.description + " data written to clipboard!");
+            LOG_DEBUG("Content preview (first 200 chars): " + xyzString.substr(0, 200) + "...");
+            
+            // 显示成功通知
+            std::string notifMsg = "Converted " + std::to_string(atoms.size()) + " atoms to " + writer.description + " format";
+            reportOutcome(ctx, "GView to XYZ Success", notifMsg, NotifyLevel::Info);
+            return true;
+        }
+        LOG_ERROR("Failed to write to clipboard");
+        reportOutcome(ctx, "XYZ Monitor", "Failed to write to clipboard", NotifyLevel::Error);
+        return false;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception in processGViewClipboardToXYZ: " + std::string(e.what()));
+        reportOutcome(ctx, "XYZ Monitor", "Error: " + std::string(e.what()), NotifyLevel::Error);
+        return false;
+    } catch (...) {
+        LOG_ERROR("Unknown exception in processGViewClipboardToXYZ");
+        reportOutcome(ctx, "XYZ Monitor", "Unknown error occurred", NotifyLevel::Error);
+        return false;
+    }
+}
+
+// 导出多帧
+bool exportFrames(const std::vector<Frame>& frames, const std::string& format, const std::string& path) {
+    try {
+        const OutputWriter* writer = findOutputWriter(format);
+        if (!writer) {
+            LOG_ERROR("Unknown output format '" + format + "' (available: " + outputWriterNames() + ")");
+            return false;
+        }
+        if (!path.empty()) {
+            return writeFramesToFile(*writer, frames, path);
+        }
+
+        std::string text;
+        if (!writeFrames(*writer, frames, text)) {
+            return false;
+        }
+        if (!g_platform.clipboard || !g_platform.clipboard->writeText(text)) {
+            LOG_ERROR("Failed to write " + writer->name + " to clipboard");
+            return false;
+        }
+        LOG_INFO("SUCCESS: " + std::to_string(frames.size()) + " frames written to clipboard as " + writer->name);
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception exporting " + format + ": " + std::string(e.what()));
+        return false;
+    }
+}
+
+// 读取结构文件
+StructureFileLoad loadStructureFile(const std::string& path, std::vector<Frame>& frames) {
+    std::filesystem::path input(path);
+    std::string ext = input.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+    if (ext != ".chg") {
+        MappedFile mapped;
+        if (mapped.open(path) && isCP2KTrajectory(mapped.view())) {
+            return loadCP2KTrajectoryFile(mapped, input, frames);
+        }
+    }
+
+    // 读取文件内容（自动检测编码）
+    EncodedFileContent fileContent = readFileWithEncoding(path);
+    if (fileContent.content.empty()) {
+        LOG_ERROR("Failed to read file or file is empty: " + path);
+        return StructureFileLoad::ReadFailed;
+    }
+    LOG_INFO("Read file with encoding: " + encodingToString(fileContent.encoding) +
+             ", line ending: " + lineEndingToString(fileContent.lineEnding));
+
+    if (fileContent.content.length() > g_config.maxClipboardChars) {
+        LOG_WARNING("File content is too large (" + std::to_string(fileContent.content.length()) +
+                    " characters). Limit is " + std::to_string(g_config.maxClipboardChars) +
+                    " characters (" + std::to_string(g_config.maxMemoryMB) + "MB memory limit).");
+        return StructureFileLoad::TooLarge;
+    }
+
+    // 按原子数头和文件大小估算峰值内存
+    const size_t limitBytes = static_cast<size_t>(g_config.maxMemoryMB) * 1024 * 1024;
+    MemoryEstimate estimate = estimateConversionMemory(fileContent.content);
+    LOG_INFO("Processing " + std::to_string(fileContent.content.length()) + " characters from file (estimated peak " +
+             formatMegabytes(estimate.totalBytes) + ")");
+    if (estimate.totalBytes > limitBytes) {
+        LOG_WARNING("Estimated memory " + formatMegabytes(estimate.totalBytes) + " exceeds max_memory_mb (" +
+                    std::to_string(g_config.maxMemoryMB) + "MB)");
+        return StructureFileLoad::TooLarge;
+    }
+
+    TrackedBytes inputBytes;
+    inputBytes.update(fileContent.content.capacity() + fileContent.lineStarts.capacity() * sizeof(size_t));
+    switch (parseStructureFrames(fileContent, ext == ".chg", input.filename().string(), frames)) {
+    case StructureParse::Ok:
+        return StructureFileLoad::Ok;
+    case StructureParse::NotStructure:
+        return StructureFileLoad::NotStructure;
+    case StructureParse::Failed:
+        break;
+    }
+    return StructureFileLoad::ParseFailed;
+}
+
+bool parseStructureText(std::string text, std::vector<Frame>& frames) {
+    TextLines lines = indexLines(std::move(text));
+    return parseStructureFrames(lines, false, "clipboard", frames) == StructureParse::Ok;
+}
+
+// 文件转换为多种格式
+namespace {
+
+// 先确认全部格式都可用，避免解析后才发现
+bool findWriters(const std::vector<std::string>& formats, std::vector<const OutputWriter*>& writers) {
+    for (const auto& format : formats) {
+        const OutputWriter* writer = findOutputWriter(format);
+        if (!writer) {
+            LOG_ERROR("Unknown output format '" + format + "' (available: " + outputWriterNames() + ")");
+            return false;
+        }
+        writers.push_back(writer);
+    }
+    if (writers.empty()) {
+        LOG_ERROR("No output format given");
+        return false;
+    }
+    return true;
+}
+
+// 逐帧写出：每个选中帧单独成文件 <输入文件名>_<帧号><扩展名>，帧号补零到相同宽度。
+// 帧分给 threadCount 个线程，各线程逐个领取下一帧，复制成单帧数组后直接流式写入文件；
+// 每个文件只记 DEBUG 日志，最后汇总一行。
+// 单帧副本的分配器取自所在线程（MemoryBudgetScope 是 thread_local）：调用线程上
+// 记入调用方的预算，工作线程上使用 new/delete，不碰预算（MemoryBudget 不是线程安全的）
+bool writeSplitFrames(const std::vector<Frame>& frames, const std::vector<size_t>& selected,
+                      const std::vector<const OutputWriter*>& writers, const std::filesystem::path& directory,
+                      const std::string& stem, size_t threadCount) {
+    const size_t digits = std::to_string(frames.size()).size();
+    const size_t fileCount = selected.size() * writers.size();
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> failed{0};
+    auto work = [&]() {
+        std::vector<Frame> single(1);
+        std::string name;
+        for (size_t k = next++; k < selected.size(); k = next++) {
+            const size_t frameNumber = selected[k] + 1;
+            std::string number = std::to_string(frameNumber);
+            name = stem + "_" + std::string(digits - number.size(), '0') + number;
+            try {
+                single[0] = frames[selected[k]];
+                for (const OutputWriter* writer : writers) {
+                    const std::filesystem::path path = directory / (name + writer->extension);
+                    std::ofstream file(path.string(), std::ios::binary);
+                    bool ok = file.is_open();
+                    if (ok) {
+                        TextSink sink(file);
+                        writeFramesToSink(*writer, sink, single, OutputNaming{name, frameNumber});
+                        ok = sink.flush();
+                    }
+                    if (ok) {
+                        LOG_DEBUG("Wrote " + path.string());
+                    } else {
+                        LOG_ERROR("Failed to write " + path.string());
+                        ++failed;
+                    }
+                }
+            } catch (const std::exception& e) {
+                LOG_ERROR("Exception writing frame " + std::to_string(frameNumber) + " of " + stem + ": " + e.what());
+                failed += writers.size();
+            }
+        }
+    };
+    std::vector<std::unique_ptr<Thread>> workers;
+    for (size_t t = 1; t < std::min(threadCount, selected.size()); ++t) {
+        auto worker = std::make_unique<Thread>();
+        if (worker->start(work)) {
+            workers.push_back(std::move(worker));
+        }
+    }
+    work();
+    for (auto& worker : workers) {
+        worker->join();
+    }
+
+    LOG_INFO("Wrote " + std::to_string(fileCount - failed) + " of " + std::to_string(fileCount) + " file(s) for " +
+             std::to_string(selected.size()) + " frame(s) of " + stem + " to " +
+             (directory.empty() ? std::string(".") : directory.string()) + " with " +
+             std::to_string(1 + workers.size()) + " thread(s)");
+    return failed == 0;
+}
+
+// 单个文件的解析与写出，在自己的内存预算（limitBytes）内进行；逐帧写出时最多用 threadCount 个线程
+bool convertFileWithWriters(const std::string& inputPath, const std::vector<const OutputWriter*>& writers,
+                            const ConversionOutput& output, size_t limitBytes, size_t threadCount) {
+    try {
+        LOG_INFO("Converting " + inputPath + " to " + std::to_string(writers.size()) + " format(s)");
+        
+        MemoryBudget budget(limitBytes);
+        MemoryBudgetScope budgetScope(budget);
+        std::filesystem::path input(inputPath);
+        std::vector<Frame> frames;
+        if (loadStructureFile(inputPath, frames) != StructureFileLoad::Ok) {
+            LOG_ERROR("Failed to parse structure data from file: " + inputPath);
+            return false;
+        }
+        LOG_INFO("Found " + std::to_string(frames.size()) + " frame(s) with " + std::to_string(frames[0].atoms.size()) + " atoms.");
+
+        std::vector<size_t> selected;
+        if (output.frames.empty()) {
+            selected.resize(frames.size());
+            for (size_t i = 0; i < frames.size(); ++i) {
+                selected[i] = i;
+            }
+        } else if (!parseFrameSelection(output.frames, frames.size(), selected)) {
+            LOG_ERROR("Frame selection '" + output.frames + "' selects no frame of " + inputPath + " (" +
+                      std::to_string(frames.size()) + " frame(s))");
+            return false;
+        }
+        
+        // 各格式直接写文件（不在内存中拼出完整文本）
+        std::filesystem::path directory = output.directory.empty() ? input.parent_path() : std::filesystem::path(output.directory);
+        if (!directory.empty()) {
+            std::filesystem::create_directories(directory);
+        }
+        if (output.split) {
+            bool allWritten = writeSplitFrames(frames, selected, writers, directory, input.stem().string(), threadCount);
+            LOG_INFO("Conversion memory: " + budget.summary());
+            return allWritten;
+        }
+
+        // 只写出部分帧时把选中的帧移到前面
+        if (selected.size() < frames.size()) {
+            for (size_t k = 0; k < selected.size(); ++k) {
+                if (selected[k] != k) {
+                    frames[k] = std::move(frames[selected[k]]);
+                }
+            }
+            frames.erase(frames.begin() + static_cast<std::ptrdiff_t>(selected.size()), frames.end());
+        }
+        bool allWritten = true;
+        for (const OutputWriter* writer : writers) {
+            std::filesystem::path outputPath = directory / (input.stem().string() + writer->extension);
+            std::error_code ec;
+            if (std::filesystem::equivalent(outputPath, input, ec)) {
+                outputPath = directory / (input.stem().string() + "_out" + writer->extension);
+            }
+            const std::string name = outputPath.stem().string();
+            const OutputNaming naming{name, selected.empty() ? 1 : selected[0] + 1};
+            if (!writeFramesToFile(*writer, frames, outputPath.string(), &naming)) {
+                allWritten = false;
+            }
+        }
+        LOG_INFO("Conversion memory: " + budget.summary());
+        return allWritten;
+    } catch (const MemoryBudgetExceeded& e) {
+        LOG_ERROR("Conversion of " + inputPath + " aborted: " + std::string(e.what()));
+        return false;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception converting " + inputPath + ": " + std::string(e.what()));
+        return false;
+    }
+}
+
+} // namespace
+
+bool isStructureFileExtension(const std::string& extension) {
+    static const char* const EXTENSIONS[] = {".xyz", ".trj", ".chg", ".inp", ".restart", ".cml", ".c3xml"};
+    return std::any_of(std::begin(EXTENSIONS), std::end(EXTENSIONS), [&extension](const char* candidate) {
+        return equalsIgnoreCase(extension, candidate);
+    });
+}
+
+bool parseFrameSelection(std::string_view text, size_t frameCount, std::vector<size_t>& indices) {
+    std::vector<bool> chosen(frameCount, false);
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t comma = text.find(',', pos);
+        std::string_view item = trimView(text.substr(pos, comma == std::string_view::npos ? std::string_view::npos : comma - pos));
+        pos = comma == std::string_view::npos ? text.size() + 1 : comma + 1;
+        if (item.empty()) {
+            continue;
+        }
+
+        // "a"、"a-b"、"a-"
+        size_t first = 0;
+        size_t last = 0;
+        size_t dash = item.find('-');
+        std::string_view head = trimView(item.substr(0, dash));
+        auto parsed = std::from_chars(head.data(), head.data() + head.size(), first);
+        if (head.empty() || parsed.ec != std::errc() || parsed.ptr != head.data() + head.size() || first == 0) {
+            LOG_ERROR("Invalid frame selection: " + std::string(item));
+            return false;
+        }
+        if (dash == std::string_view::npos) {
+            last = first;
+        } else {
+            std::string_view tail = trimView(item.substr(dash + 1));
+            if (tail.empty()) {
+                last = frameCount;
+            } else {
+                parsed = std::from_chars(tail.data(), tail.data() + tail.size(), last);
+                if (parsed.ec != std::errc() || parsed.ptr != tail.data() + tail.size() || last < first) {
+                    LOG_ERROR("Invalid frame selection: " + std::string(item));
+                    return false;
+                }
+            }
+        }
+        for (size_t frame = first; frame <= std::min(last, frameCount); ++frame) {
+            chosen[frame - 1] = true;
+        }
+    }
+
+    indices.clear();
+    for (size_t i = 0; i < frameCount; ++i) {
+        if (chosen[i]) {
+            indices.push_back(i);
+        }
+    }
+    return !indices.empty();
+}
+
+bool convertFileToFormats(const std::string& inputPath, const std::vector<std::string>& formats,
+                          const ConversionOutput& output) {
+    std::vector<const OutputWriter*> writers;
+    if (!findWriters(formats, writers)) {
+        return false;
+    }
+    return convertFileWithWriters(inputPath, writers, output,
+                                  static_cast<size_t>(g_config.maxMemoryMB) * 1024 * 1024, hardwareConcurrency());
+}
+
+bool convertFilesToFormats(const std::vector<std::string>& inputs, const std::vector<std::string>& formats,
+                           const ConversionOutput& output) {
+    try {
+        std::vector<const OutputWriter*> writers;
+        if (!findWriters(formats, writers)) {
+            return false;
+        }
+
+        // 目录展开为其中的结构文件（按文件名排序，不递归）
+        std::vector<std::string> paths;
+        for (const auto& input : inputs) {
+            std::error_code ec;
+            if (!std::filesystem::is_directory(input, ec)) {
+                paths.push_back(input);
+                continue;
+            }
+            std::vector<std::string> files;
+            for (std::filesystem::directory_iterator it(input, ec), end; !ec && it != end; it.increment(ec)) {
+                if (it->is_regular_file(ec) && isStructureFileExtension(it->path().extension().string())) {
+                    files.push_back(it->path().string());
+                }
+            }
+            std::sort(files.begin(), files.end());
+            paths.insert(paths.end(), files.begin(), files.end());
+        }
+        if (paths.empty()) {
+            LOG_ERROR("No structure files to convert");
+            return false;
+        }
+
+        // 文件大小不一，工作线程逐个领取下一个文件；各线程的内存预算平分 max_memory_mb
+        const size_t threadCount = std::min<size_t>(hardwareConcurrency(), paths.size());
+        const size_t limitBytes = static_cast<size_t>(g_config.maxMemoryMB) * 1024 * 1024 / threadCount;
+        LOG_INFO("Batch converting " + std::to_string(paths.size()) + " file(s) with " + std::to_string(threadCount) +
+                 " thread(s)");
+        // 逐帧写出时每个文件再分到剩余的核
+        const size_t frameThreads = std::max<size_t>(hardwareConcurrency() / threadCount, 1);
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> failed{0};
+        auto work = [&]() {
+            for (size_t i = next++; i < paths.size(); i = next++) {
+                if (!convertFileWithWriters(paths[i], writers, output, limitBytes, frameThreads)) {
+                    ++failed;
+                }
+            }
+        };
+        std::vector<std::unique_ptr<Thread>> workers;
+        for (size_t t = 1; t < threadCount; ++t) {
+            auto worker = std::make_unique<Thread>();
+            if (worker->start(work)) {
+                workers.push_back(std::move(worker));
+            }
+        }
+        work();
+        for (auto& worker : workers) {
+            worker->join();
+        }
+
+        LOG_INFO("Batch conversion finished: " + std::to_string(paths.size() - failed) + " of " +
+                 std::to_string(paths.size()) + " file(s) converted");
+        return failed == 0;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception in convertFilesToFormats: " + std::string(e.what()));
+        return false;
+    }
+}
+
+// ========== LatencyStats ==========
+
+void LatencyStats::add(uint64_t micros) {
+    m_samples.push_back(micros);
+}
+
+double LatencyStats::percentileMillis(double percentile) const {
+    if (m_samples.empty()) {
+        return 0.0;
+    }
+    std::vector<uint64_t> sorted(m_samples);
+    std::sort(sorted.begin(), sorted.end());
+    // 最近秩法：p50 取第 ceil(0.5*n) 个样本
+    double rank = percentile / 100.0 * static_cast<double>(sorted.size());
+    size_t index = rank <= 1.0 ? 0 : static_cast<size_t>(rank + 0.999999) - 1;
+    index = std::min(index, sorted.size() - 1);
+    return static_cast<double>(sorted[index]) / 1000.0;
+}
+
+std::string LatencyStats::summary() const {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(3);
+    oss << "n=" << m_samples.size()
+        << " p50=" << percentileMillis(50.0) << "ms"
+        << " p90=" << percentileMillis(90.0) << "ms"
+        << " p99=" << percentileMillis(99.0) << "ms"
+        << " max=" << percentileMillis(100.0) << "ms";
+    return oss.str();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+class JobContext;
+struct Frame;
+
+// 热键处理流程（剪贴板 -> GView、GView -> 剪贴板）。
+// 所有系统交互都经过 g_platform，因此在 Linux 上换成内存实现后可以无界面运行。
+
+// 临时文件目录（temp_dir 配置，未配置时为系统临时目录）
+std::string getTempDirectory();
+
+// 把内容写入临时目录下的唯一文件（扩展名为 extension），失败返回空字符串
+std::string createTempFile(const std::string& content, const std::string& extension = ".log");
+
+// 用 GView 打开文件，并按 waitSeconds 安排删除
+bool openWithGView(const std::string& filepath);
+
+// 立即删除临时文件（打开失败时使用）
+bool removeTempFile(const std::string& filepath);
+
+// 剪贴板中的 XYZ/CHG -> hotkey_format 指定的格式（默认 Gaussian log）-> GView
+// ctx 非空时（在任务队列中运行）：各阶段之间检查取消、报告进度，结果通知交给任务完成消息
+bool processClipboardXYZToGView(JobContext* ctx = nullptr);
+// 同上，输入为已读取的剪贴板文本（由 UI 线程在按下热键时采集）
+bool processClipboardTextToGView(std::string clipboardText, JobContext* ctx = nullptr);
+
+// GView 剪贴板文件 -> hotkey_reverse_format 指定的格式（默认 XYZ）-> 剪贴板
+bool processGViewClipboardToXYZ(JobContext* ctx = nullptr);
+
+// 多帧 -> format 格式（见 output_writers.h）：path 非空时直接写入文件，否则写入剪贴板
+bool exportFrames(const std::vector<Frame>& frames, const std::string& format, const std::string& path = "");
+
+enum class StructureFileLoad {
+    Ok,
+    ReadFailed,     // 文件不存在、无法读取或为空
+    TooLarge,       // 超出 max_clipboard_chars 或估算内存超出 max_memory_mb
+    NotStructure,   // 不是可识别的结构格式
+    ParseFailed     // 格式可识别但没有解析出原子
+};
+
+// 读取结构文件（XYZ/CHG/CP2K 轨迹与输入/Chem3D 与 CML）的全部帧，并按 periodic_mode 处理。
+// CP2K MD 轨迹映射后直接解析，文件内容不复制到堆上；同目录下有对应的 *.cell 文件时按步数带上晶胞。
+// 须在调用方的内存预算作用域（MemoryBudgetScope）内调用，frames 在该预算中分配
+StructureFileLoad loadStructureFile(const std::string& path, std::vector<Frame>& frames);
+
+// 解析剪贴板等来源的结构文本（XYZ/CHG/CP2K/Chem3D，CHG 按 try_parse_chg_format 识别），并按 periodic_mode 处理。
+// 不是结构文本或没有解析出原子时返回 false。须在调用方的内存预算作用域内调用
+bool parseStructureText(std::string text, std::vector<Frame>& frames);
+
+// 扩展名（含点，不区分大小写）是否为 loadStructureFile 可读取的结构文件
+bool isStructureFileExtension(const std::string& extension);
+
+// 帧选择："1-10,15,20-"（1 起，"20-" 表示第 20 帧到最后一帧），超出 frameCount 的部分忽略。
+// indices 为选中帧的下标（0 起，升序、不重复）；写法错误或一帧都没选中时返回 false
+bool parseFrameSelection(std::string_view text, size_t frameCount, std::vector<size_t>& indices);
+
+// 文件转换的输出选项
+struct ConversionOutput {
+    std::string directory;      // 为空时与输入同目录
+    std::string frames;         // 帧选择（见 parseFrameSelection），为空时取全部帧
+    bool split = false;         // 每个选中帧单独写成 <输入文件名>_<帧号><格式扩展名>（如构象系综 -> 逐个 gjf）
+};
+
+// 结构文件（XYZ/CHG/CP2K/Chem3D/CML）-> 一种或多种格式，只解析一次。
+// 文件名为 <输入文件名><格式扩展名>；与输入文件同名时在扩展名前加 "_out"。
+// split 时逐帧写出，帧分给多个线程格式化并写入各自的文件。全部写出成功时返回 true
+bool convertFileToFormats(const std::string& inputPath, const std::vector<std::string>& formats,
+                          const ConversionOutput& output = {});
+
+// 批量转换：inputs 为结构文件或目录（目录取其中全部结构文件，不递归），在一个进程中按文件分给多个线程，
+// 每个文件的处理与 convertFileToFormats 相同，各线程的内存预算平分 max_memory_mb。全部成功时返回 true
+bool convertFilesToFormats(const std::vector<std::string>& inputs, const std::vector<std::string>& formats,
+                           const ConversionOutput& output = {});
+
+// 延迟统计（微秒样本，输出毫秒百分位）
+class LatencyStats {
+public:
+    void add(uint64_t micros);
+    size_t count() const { return m_samples.size(); }
+    // percentile 取 0~100
+    double percentileMillis(double percentile) const;
+    // "n=.. p50=..ms p90=..ms p99=..ms max=..ms"
+    std::string summary() const;
+
+private:
+    std::vector<uint64_t> m_samples;
+};
@@ -0,0 +1,30 @@
+#include "platform.h"
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <thread>
+#endif
+
+// 全局平台实例
+Platform g_platform;
+
+uint64_t SteadyClock::nowMicros() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+}
+
+void SteadyClock::sleepMillis(unsigned int milliseconds) {
+#ifdef _WIN32
+    Sleep(milliseconds);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+#endif
+}
+
+void notifyUser(const std::string& title, const std::string& message, NotifyLevel level) {
+    if (g_platform.notifier) {
+        g_platform.notifier->notify(title, message, level);
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// 平台抽象：热键处理流程中用到的剪贴板、进程启动、计时和通知都经过这些接口，
+// Windows 下由 platform_win32.cpp 提供实现，Linux 上可换成 platform_memory.h 中的内存实现。
+
+// 通知级别（对应托盘气泡的 NIIF_INFO / NIIF_WARNING / NIIF_ERROR）
+enum class NotifyLevel {
+    Info,
+    Warning,
+    Error
+};
+
+// 剪贴板（文本统一为 UTF-8；剪贴板中有 Chem3D 结构时 readText 返回其 XML）
+class ClipboardService {
+public:
+    virtual ~ClipboardService() = default;
+    // 读取文本，剪贴板为空或非文本时返回空字符串
+    virtual std::string readText() = 0;
+    // 不复制数据，返回剪贴板文本的大致字符数（未知时返回 0）
+    virtual size_t peekTextSize() { return 0; }
+    virtual bool writeText(const std::string& text) = 0;
+};
+
+// 已启动的子进程（插件执行管理器用它等待、计时和结束进程）。析构只释放句柄，不结束进程
+class ChildProcess {
+public:
+    virtual ~ChildProcess() = default;
+    // 等待进程结束，超时返回 false；结束时 exitCode 为退出码
+    virtual bool wait(unsigned int timeoutMillis, int& exitCode) = 0;
+    // 强制结束进程（连同它启动的子进程）
+    virtual void terminate() = 0;
+};
+
+// 外部进程启动（GView、插件）
+class ProcessLauncher {
+public:
+    virtual ~ProcessLauncher() = default;
+    // 启动命令行，不等待进程结束
+    virtual bool launch(const std::string& commandLine) = 0;
+    // 启动命令行并返回可等待的子进程，失败时返回空指针
+    virtual std::unique_ptr<ChildProcess> start(const std::string& commandLine) = 0;
+};
+
+// 时钟与等待
+class Clock {
+public:
+    virtual ~Clock() = default;
+    // 单调时钟，单位微秒
+    virtual uint64_t nowMicros() = 0;
+    virtual void sleepMillis(unsigned int milliseconds) = 0;
+};
+
+// 临时文件的延时删除
+class TempFileScheduler {
+public:
+    virtual ~TempFileScheduler() = default;
+    virtual void scheduleDelete(const std::string& filepath, int waitSeconds) = 0;
+};
+
+// 用户通知（托盘气泡）
+class Notifier {
+public:
+    virtual ~Notifier() = default;
+    virtual void notify(const std::string& title, const std::string& message, NotifyLevel level) = 0;
+};
+
+// 当前使用的平台服务集合（未设置的服务为 nullptr）
+struct Platform {
+    ClipboardService* clipboard = nullptr;
+    ProcessLauncher* launcher = nullptr;
+    Clock* clock = nullptr;
+    TempFileScheduler* tempFiles = nullptr;
+    Notifier* notifier = nullptr;
+};
+
+// 基于 std::chrono::steady_clock 的时钟（各平台通用）
+class SteadyClock : public Clock {
+public:
+    uint64_t nowMicros() override;
+    void sleepMillis(unsigned int milliseconds) override;
+};
+
+// 全局平台实例
+extern Platform g_platform;
+
+// 经由 g_platform.notifier 发送通知（未设置时只忽略）
+void notifyUser(const std::string& title, const std::string& message, NotifyLevel level = NotifyLevel::Info);
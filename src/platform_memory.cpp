@@ -0,0 +1,127 @@
+#include "platform_memory.h"
+#include "logger.h"
+#include <filesystem>
+
+// ========== MemoryClipboard ==========
+
+std::string MemoryClipboard::readText() {
+    return m_text;
+}
+
+bool MemoryClipboard::writeText(const std::string& text) {
+    m_text = text;
+    ++m_writeCount;
+    return true;
+}
+
+// ========== FakeProcessLauncher ==========
+
+namespace {
+
+class FakeChildProcess : public ChildProcess {
+public:
+    FakeChildProcess(Clock* clock, unsigned int runMillis, int exitCode)
+        : m_clock(clock), m_exitMicros(clock ? clock->nowMicros() + uint64_t(runMillis) * 1000 : 0),
+          m_exitCode(exitCode) {}
+
+    bool wait(unsigned int timeoutMillis, int& exitCode) override {
+        if (m_clock && !m_terminated) {
+            const uint64_t now = m_clock->nowMicros();
+            if (now < m_exitMicros) {
+                const uint64_t remainingMillis = (m_exitMicros - now + 999) / 1000;
+                if (remainingMillis > timeoutMillis) {
+                    m_clock->sleepMillis(timeoutMillis);
+                    return false;
+                }
+                m_clock->sleepMillis(static_cast<unsigned int>(remainingMillis));
+            }
+        }
+        exitCode = m_terminated ? 1 : m_exitCode;
+        return true;
+    }
+
+    void terminate() override { m_terminated = true; }
+
+private:
+    Clock* m_clock;
+    uint64_t m_exitMicros;
+    int m_exitCode;
+    bool m_terminated = false;
+};
+
+} // namespace
+
+bool FakeProcessLauncher::launch(const std::string& commandLine) {
+    {
+        LockGuard lock(m_mutex);
+        m_commands.push_back(commandLine);
+    }
+    if (m_clock && m_launchMillis > 0) {
+        m_clock->sleepMillis(m_launchMillis);
+    }
+    return true;
+}
+
+std::unique_ptr<ChildProcess> FakeProcessLauncher::start(const std::string& commandLine) {
+    launch(commandLine);
+    LockGuard lock(m_mutex);
+    return std::make_unique<FakeChildProcess>(m_clock, m_runMillis, m_exitCode);
+}
+
+void FakeProcessLauncher::setRunBehavior(unsigned int runMillis, int exitCode) {
+    LockGuard lock(m_mutex);
+    m_runMillis = runMillis;
+    m_exitCode = exitCode;
+}
+
+std::vector<std::string> FakeProcessLauncher::commands() const {
+    LockGuard lock(m_mutex);
+    return m_commands;
+}
+
+void FakeProcessLauncher::clear() {
+    LockGuard lock(m_mutex);
+    m_commands.clear();
+}
+
+// ========== RecordingTempFileScheduler ==========
+
+void RecordingTempFileScheduler::scheduleDelete(const std::string& filepath, int waitSeconds) {
+    (void)waitSeconds;
+    m_pending.push_back(filepath);
+}
+
+size_t RecordingTempFileScheduler::flush() {
+    size_t removed = 0;
+    for (const auto& filepath : m_pending) {
+        std::error_code ec;
+        if (std::filesystem::remove(filepath, ec)) {
+            ++removed;
+        } else {
+            LOG_WARNING("Failed to delete temp file: " + filepath);
+        }
+    }
+    m_pending.clear();
+    return removed;
+}
+
+// ========== RecordingNotifier ==========
+
+void RecordingNotifier::notify(const std::string& title, const std::string& message, NotifyLevel level) {
+    {
+        LockGuard lock(m_mutex);
+        m_counts[static_cast<int>(level)]++;
+        m_lastMessage = message;
+    }
+    LOG_DEBUG("Notification [" + title + "]: " + message);
+}
+
+size_t RecordingNotifier::count(NotifyLevel level) const {
+    LockGuard lock(m_mutex);
+    return m_counts[static_cast<int>(level)];
+}
+
+std::string RecordingNotifier::lastMessage() const {
+    LockGuard lock(m_mutex);
+    return m_lastMessage;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "platform.h"
+#include "threading.h"
+#include <string>
+#include <vector>
+
+// 内存平台实现：不依赖 Win32，用于在 Linux 上无界面地驱动热键流程并测量延迟。
+
+// 剪贴板内容保存在字符串中
+class MemoryClipboard : public ClipboardService {
+public:
+    std::string readText() override;
+    size_t peekTextSize() override { return m_text.size(); }
+    bool writeText(const std::string& text) override;
+
+    void setText(const std::string& text) { m_text = text; }
+    const std::string& text() const { return m_text; }
+    size_t writeCount() const { return m_writeCount; }
+
+private:
+    std::string m_text;
+    size_t m_writeCount = 0;
+};
+
+// 只记录命令行，不真正启动进程；可设置模拟的启动耗时。
+// start() 返回的模拟进程在 runMillis 后以 exitCode 退出（经 clock 计时，未给出 clock 时立即退出）
+class FakeProcessLauncher : public ProcessLauncher {
+public:
+    explicit FakeProcessLauncher(Clock* clock = nullptr, unsigned int launchMillis = 0)
+        : m_clock(clock), m_launchMillis(launchMillis) {}
+
+    bool launch(const std::string& commandLine) override;
+    std::unique_ptr<ChildProcess> start(const std::string& commandLine) override;
+
+    void setRunBehavior(unsigned int runMillis, int exitCode);
+
+    // 可在其他线程启动进程时调用，返回副本
+    std::vector<std::string> commands() const;
+    void clear();
+
+private:
+    Clock* m_clock;
+    unsigned int m_launchMillis;
+    unsigned int m_runMillis = 0;
+    int m_exitCode = 0;
+    mutable Mutex m_mutex;
+    std::vector<std::string> m_commands;
+};
+
+// 记录待删除的临时文件，调用 flush() 时立即删除（不等待）
+class RecordingTempFileScheduler : public TempFileScheduler {
+public:
+    void scheduleDelete(const std::string& filepath, int waitSeconds) override;
+
+    size_t pending() const { return m_pending.size(); }
+    // 删除所有记录的文件，返回成功删除的个数
+    size_t flush();
+
+private:
+    std::vector<std::string> m_pending;
+};
+
+// 通知写入日志并计数（普通插件的通知来自执行管理器的工作线程，因此加锁）
+class RecordingNotifier : public Notifier {
+public:
+    void notify(const std::string& title, const std::string& message, NotifyLevel level) override;
+
+    size_t count(NotifyLevel level) const;
+    std::string lastMessage() const;
+
+private:
+    mutable Mutex m_mutex;
+    size_t m_counts[3] = {0, 0, 0};
+    std::string m_lastMessage;
+};
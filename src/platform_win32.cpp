@@ -0,0 +1,367 @@
+#include "platform_win32.h"
+#include "logger.h"
+#include "transcode.h"
+#include <vector>
+#include <cstring>
+#include <cwchar>
+
+// 解决Windows ERROR宏冲突
+#ifdef ERROR
+#undef ERROR
+#endif
+
+// 托盘通知在 main.cpp 中实现
+extern void showTrayNotification(const std::string& title, const std::string& message, DWORD iconType);
+
+namespace {
+
+class ClipboardGuard {
+public:
+    explicit ClipboardGuard(HWND owner) : m_opened(OpenClipboard(owner) != FALSE) {}
+
+    ~ClipboardGuard() {
+        if (m_opened) {
+            CloseClipboard();
+        }
+    }
+
+    bool isOpen() const { return m_opened; }
+
+private:
+    bool m_opened;
+};
+
+std::string wideToUtf8(const wchar_t* wide, size_t length) {
+    std::string utf8;
+    appendUtf16ToUtf8(reinterpret_cast<const char16_t*>(wide), length, utf8);
+    return utf8;
+}
+
+std::wstring utf8ToWide(const std::string& utf8) {
+    if (utf8.empty()) {
+        return L"";
+    }
+
+    // UTF-16 码元数不会超过 UTF-8 字节数，一次分配后直接写入
+    std::wstring wide(utf8.size(), L'\0');
+    size_t written = utf8ToUtf16(utf8.data(), utf8.size(), reinterpret_cast<char16_t*>(&wide[0]));
+    wide.resize(written);
+    return wide;
+}
+
+std::string ansiToUtf8(const char* ansiText) {
+    if (ansiText == NULL || ansiText[0] == '\0') {
+        return "";
+    }
+
+    size_t length = std::strlen(ansiText);
+    std::string utf8;
+    if (appendDbcsToUtf8(reinterpret_cast<const unsigned char*>(ansiText), length, GetACP(), utf8)) {
+        return utf8;
+    }
+
+    int wideSize = MultiByteToWideChar(CP_ACP, 0, ansiText, static_cast<int>(length), NULL, 0);
+    if (wideSize <= 0) {
+        return "";
+    }
+
+    std::wstring wide(static_cast<size_t>(wideSize), L'\0');
+    if (MultiByteToWideChar(CP_ACP, 0, ansiText, static_cast<int>(length), wide.data(), wideSize) <= 0) {
+        return "";
+    }
+
+    return wideToUtf8(wide.data(), wide.size());
+}
+
+std::string utf8ToAnsi(const std::string& utf8) {
+    std::wstring wide = utf8ToWide(utf8);
+    if (wide.empty()) {
+        return "";
+    }
+
+    int ansiSize = WideCharToMultiByte(CP_ACP, 0, wide.c_str(), -1, NULL, 0, NULL, NULL);
+    if (ansiSize <= 0) {
+        return "";
+    }
+
+    std::string ansi(static_cast<size_t>(ansiSize), '\0');
+    if (WideCharToMultiByte(CP_ACP, 0, wide.c_str(), -1, ansi.data(), ansiSize, NULL, NULL) <= 0) {
+        return "";
+    }
+
+    if (!ansi.empty() && ansi.back() == '\0') {
+        ansi.pop_back();
+    }
+
+    return ansi;
+}
+
+bool setClipboardTextData(UINT format, const void* data, size_t bytes) {
+    HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, bytes);
+    if (hMem == NULL) {
+        return false;
+    }
+
+    void* pMem = GlobalLock(hMem);
+    if (pMem == NULL) {
+        GlobalFree(hMem);
+        return false;
+    }
+
+    std::memcpy(pMem, data, bytes);
+    GlobalUnlock(hMem);
+
+    if (SetClipboardData(format, hMem) == NULL) {
+        GlobalFree(hMem);
+        return false;
+    }
+
+    return true;
+}
+
+// UTF-8 直接转码写入剪贴板内存（按 UTF-8 字节数分配，UTF-16 码元数不会超过它）
+bool setClipboardUnicodeText(const std::string& utf8) {
+    HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, (utf8.size() + 1) * sizeof(wchar_t));
+    if (hMem == NULL) {
+        return false;
+    }
+
+    char16_t* pMem = static_cast<char16_t*>(GlobalLock(hMem));
+    if (pMem == NULL) {
+        GlobalFree(hMem);
+        return false;
+    }
+
+    size_t written = utf8ToUtf16(utf8.data(), utf8.size(), pMem);
+    pMem[written] = u'\0';
+    GlobalUnlock(hMem);
+
+    if (SetClipboardData(CF_UNICODETEXT, hMem) == NULL) {
+        GlobalFree(hMem);
+        return false;
+    }
+
+    return true;
+}
+
+// Chem3D 复制结构时放入的注册格式（XML 文本）
+UINT chem3dClipboardFormat() {
+    static const UINT format = RegisterClipboardFormatA("Chem3D");
+    return format;
+}
+
+// 剪贴板已打开时读取 Chem3D 格式的 XML，没有该格式时返回 false
+bool readChem3DClipboard(std::string& xml) {
+    UINT format = chem3dClipboardFormat();
+    if (format == 0 || !IsClipboardFormatAvailable(format)) {
+        return false;
+    }
+    HANDLE hData = GetClipboardData(format);
+    if (hData == NULL) {
+        return false;
+    }
+    const char* data = static_cast<const char*>(GlobalLock(hData));
+    if (data == NULL) {
+        return false;
+    }
+    // GlobalSize 可能大于实际内容，截到第一个 0
+    xml.assign(data, strnlen(data, static_cast<size_t>(GlobalSize(hData))));
+    GlobalUnlock(hData);
+    return !xml.empty();
+}
+
+} // namespace
+
+// 读取剪贴板内容
+std::string Win32ClipboardService::readText() {
+    try {
+        ClipboardGuard clipboard(NULL);
+        if (!clipboard.isOpen()) {
+            DWORD error = GetLastError();
+            LOG_ERROR("Failed to open clipboard (Error: " + std::to_string(error) + ")");
+            return "";
+        }
+
+        // Chem3D 的结构 XML 优先于它同时放入的文本
+        std::string chem3dXml;
+        if (readChem3DClipboard(chem3dXml)) {
+            LOG_DEBUG("Clipboard Chem3D XML length: " + std::to_string(chem3dXml.length()));
+            return chem3dXml;
+        }
+
+        if (IsClipboardFormatAvailable(CF_UNICODETEXT)) {
+            HANDLE hData = GetClipboardData(CF_UNICODETEXT);
+            if (hData != NULL) {
+                wchar_t* wideText = static_cast<wchar_t*>(GlobalLock(hData));
+                if (wideText != NULL) {
+                    // 直接从剪贴板内存解码，不复制中间 wstring
+                    std::string utf8 = wideToUtf8(wideText, std::wcslen(wideText));
+                    GlobalUnlock(hData);
+
+                    LOG_DEBUG("Clipboard text length (Unicode): " + std::to_string(utf8.length()));
+                    return utf8;
+                }
+
+                LOG_ERROR("Failed to lock Unicode clipboard data");
+                return "";
+            }
+        }
+
+        HANDLE hData = GetClipboardData(CF_TEXT);
+        if (hData == NULL) {
+            LOG_DEBUG("No text data in clipboard");
+            return "";
+        }
+
+        char* pszText = static_cast<char*>(GlobalLock(hData));
+        if (pszText == NULL) {
+            LOG_ERROR("Failed to lock clipboard data");
+            return "";
+        }
+
+        std::string text = ansiToUtf8(pszText);
+        GlobalUnlock(hData);
+
+        LOG_DEBUG("Clipboard text length: " + std::to_string(text.length()));
+        return text;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception reading clipboard: " + std::string(e.what()));
+        return "";
+    }
+}
+
+// 剪贴板文本大小（GlobalSize，不复制数据）
+size_t Win32ClipboardService::peekTextSize() {
+    ClipboardGuard clipboard(NULL);
+    if (!clipboard.isOpen()) {
+        return 0;
+    }
+
+    UINT chem3dFormat = chem3dClipboardFormat();
+    if (chem3dFormat != 0 && IsClipboardFormatAvailable(chem3dFormat)) {
+        HANDLE hData = GetClipboardData(chem3dFormat);
+        return hData != NULL ? static_cast<size_t>(GlobalSize(hData)) : 0;
+    }
+
+    if (IsClipboardFormatAvailable(CF_UNICODETEXT)) {
+        HANDLE hData = GetClipboardData(CF_UNICODETEXT);
+        return hData != NULL ? static_cast<size_t>(GlobalSize(hData)) / sizeof(wchar_t) : 0;
+    }
+
+    HANDLE hData = GetClipboardData(CF_TEXT);
+    return hData != NULL ? static_cast<size_t>(GlobalSize(hData)) : 0;
+}
+
+// 写入剪贴板
+bool Win32ClipboardService::writeText(const std::string& text) {
+    try {
+        ClipboardGuard clipboard(NULL);
+        if (!clipboard.isOpen()) {
+            LOG_ERROR("Cannot open clipboard for writing");
+            return false;
+        }
+
+        if (!EmptyClipboard()) {
+            LOG_ERROR("Cannot empty clipboard");
+            return false;
+        }
+
+        if (!setClipboardUnicodeText(text)) {
+            LOG_ERROR("Cannot set Unicode clipboard data");
+            return false;
+        }
+
+        std::string ansiText = utf8ToAnsi(text);
+        std::string ansiWithNull = ansiText;
+        ansiWithNull.push_back('\0');
+        if (!setClipboardTextData(CF_TEXT, ansiWithNull.c_str(), ansiWithNull.size())) {
+            LOG_WARNING("Failed to set ANSI clipboard data fallback");
+        }
+
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception writing to clipboard: " + std::string(e.what()));
+        return false;
+    }
+}
+
+namespace {
+
+class Win32ChildProcess : public ChildProcess {
+public:
+    Win32ChildProcess(HANDLE process, HANDLE job) : m_process(process), m_job(job) {}
+
+    ~Win32ChildProcess() override {
+        CloseHandle(m_process);
+        if (m_job) {
+            CloseHandle(m_job);
+        }
+    }
+
+    bool wait(unsigned int timeoutMillis, int& exitCode) override {
+        if (WaitForSingleObject(m_process, timeoutMillis) != WAIT_OBJECT_0) {
+            return false;
+        }
+        DWORD code = 0;
+        GetExitCodeProcess(m_process, &code);
+        exitCode = static_cast<int>(code);
+        return true;
+    }
+
+    // 插件命令常经 cmd.exe /c 启动，只结束直接子进程会留下真正干活的孙进程，因此结束整个作业
+    void terminate() override {
+        if (!m_job || !TerminateJobObject(m_job, 1)) {
+            TerminateProcess(m_process, 1);
+        }
+    }
+
+private:
+    HANDLE m_process;
+    HANDLE m_job;
+};
+
+} // namespace
+
+bool Win32ProcessLauncher::launch(const std::string& commandLine) {
+    return start(commandLine) != nullptr;
+}
+
+std::unique_ptr<ChildProcess> Win32ProcessLauncher::start(const std::string& commandLine) {
+    STARTUPINFOA si;
+    PROCESS_INFORMATION pi;
+    ZeroMemory(&si, sizeof(si));
+    si.cb = sizeof(si);
+    ZeroMemory(&pi, sizeof(pi));
+    
+    // CreateProcess 可能会修改命令行缓冲区，因此必须传入可写 buffer
+    std::vector<char> cmdBuf(commandLine.begin(), commandLine.end());
+    cmdBuf.push_back('\0');
+
+    // 挂起启动，放入作业对象后再恢复，保证进程在启动子进程之前已在作业中
+    if (!CreateProcessA(NULL, cmdBuf.data(), NULL, NULL, FALSE, CREATE_SUSPENDED, NULL, NULL, &si, &pi)) {
+        DWORD error = GetLastError();
+        LOG_ERROR("Failed to launch process (Error: " + std::to_string(error) + "): " + commandLine);
+        return nullptr;
+    }
+
+    HANDLE job = CreateJobObjectA(NULL, NULL);
+    if (job && !AssignProcessToJobObject(job, pi.hProcess)) {
+        LOG_DEBUG("AssignProcessToJobObject failed (error " + std::to_string(GetLastError()) + "), " +
+                  "terminating will only end the direct child");
+        CloseHandle(job);
+        job = NULL;
+    }
+    ResumeThread(pi.hThread);
+    CloseHandle(pi.hThread);
+    return std::make_unique<Win32ChildProcess>(pi.hProcess, job);
+}
+
+void TrayNotifier::notify(const std::string& title, const std::string& message, NotifyLevel level) {
+    DWORD iconType = NIIF_INFO;
+    if (level == NotifyLevel::Warning) {
+        iconType = NIIF_WARNING;
+    } else if (level == NotifyLevel::Error) {
+        iconType = NIIF_ERROR;
+    }
+    showTrayNotification(title, message, iconType);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "platform.h"
+#include <windows.h>
+#include <shellapi.h>
+
+// Win32 平台实现
+
+// 系统剪贴板（优先 CF_UNICODETEXT，回退 CF_TEXT）
+class Win32ClipboardService : public ClipboardService {
+public:
+    std::string readText() override;
+    size_t peekTextSize() override;
+    bool writeText(const std::string& text) override;
+};
+
+// CreateProcessA 启动，不等待；start() 把进程放入作业对象，结束时连同其子进程一起结束
+class Win32ProcessLauncher : public ProcessLauncher {
+public:
+    bool launch(const std::string& commandLine) override;
+    std::unique_ptr<ChildProcess> start(const std::string& commandLine) override;
+};
+
+// 托盘气泡通知
+class TrayNotifier : public Notifier {
+public:
+    void notify(const std::string& title, const std::string& message, NotifyLevel level) override;
+};
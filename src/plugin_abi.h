@@ -0,0 +1,101 @@
+#pragma once
+
+/*
+ * 库插件 ABI（C 接口，版本 1）：插件编译为共享库（Windows 下 .dll，其他平台 .so），
+ * 在 config.ini 的插件分区中写 library=<路径>，由 xyzTrick 用 LoadLibrary / dlopen 加载到进程内。
+ * 插件只需包含本头文件，不依赖 xyzTrick 的其他源码；C 与 C++ 均可实现。
+ *
+ * 加载：宿主调用导出函数 xyztrick_plugin_entry(宿主 ABI 版本)，插件返回一个静态的 xyztrick_plugin_api
+ *   （版本不兼容时返回 NULL）。api 的 abi_version 必须等于宿主版本，struct_size 不小于宿主的结构大小。
+ * 调用：每次触发时宿主读取剪贴板，能解析为结构时把已解析的轨迹以只读视图传给 run()，否则 input 为 NULL，
+ *   只有剪贴板原文。视图直接指向宿主的坐标数组，不复制也不重新格式化。
+ * 结果：插件在 result 中返回文本或轨迹视图（指向插件自己的数组，也可以直接引用 input 中的数组，
+ *   例如元素符号与注释）。宿主把轨迹视图直接格式化为多帧 XYZ，之后调用 release()（非 NULL 时）。
+ *   input 与 clipboard_text 在 release() 返回前一直有效。
+ * 线程：同一插件的 run() / release() 依次调用，不会并发；调用线程不是 UI 线程。
+ * 卸载：宿主退出或 library= 改变时调用 shutdown()（非 NULL 时）后卸载共享库。
+ * 插件不得让 C++ 异常穿过本接口。示例见 plugins/library_center.cpp。
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define XYZTRICK_PLUGIN_ABI_VERSION 1u
+#define XYZTRICK_PLUGIN_ENTRY_NAME "xyztrick_plugin_entry"
+
+#ifdef _WIN32
+#define XYZTRICK_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define XYZTRICK_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 一帧。第 i 个原子的 x 坐标位于 (const char*)x + i * stride，y、z、charges 相同；
+ * stride 为 0 表示按 double 紧密排列（SoA 数组）。宿主传入的视图指向原子数组（AoS），stride 为一个原子的大小 */
+typedef struct xyztrick_frame_view {
+    size_t atom_count;
+    const double* x;
+    const double* y;
+    const double* z;
+    const double* charges;              /* 可为 NULL；宿主忽略结果中的电荷 */
+    size_t stride;                      /* 字节 */
+    const char* const* symbols;         /* atom_count 个以 '\0' 结尾的元素符号 */
+    const double* cell;                 /* cell_count 个平移矢量（每个 3 个 double，Å），cell_count 为 0 时可为 NULL */
+    int cell_count;
+    const char* comment;                /* 注释行，不一定以 '\0' 结尾 */
+    size_t comment_length;
+} xyztrick_frame_view;
+
+typedef struct xyztrick_trajectory_view {
+    size_t frame_count;
+    const xyztrick_frame_view* frames;
+} xyztrick_trajectory_view;
+
+/* run() 的返回值 */
+enum {
+    XYZTRICK_STATUS_OK = 0,
+    XYZTRICK_STATUS_ERROR = 1           /* result->text 为错误信息 */
+};
+
+/* 结果类型 */
+enum {
+    XYZTRICK_RESULT_NONE = 0,
+    XYZTRICK_RESULT_TEXT = 1,           /* result->text */
+    XYZTRICK_RESULT_TRAJECTORY = 2      /* result->trajectory，宿主写成多帧 XYZ */
+};
+
+/* 结果的去向（与常驻插件的回复动作相同） */
+enum {
+    XYZTRICK_ACTION_NONE = 0,           /* 只记录日志 */
+    XYZTRICK_ACTION_CLIPBOARD = 1,      /* 写回剪贴板 */
+    XYZTRICK_ACTION_NOTIFY = 2          /* 作为通知显示（仅文本） */
+};
+
+/* 宿主调用 run() 前清零 */
+typedef struct xyztrick_result {
+    int kind;
+    int action;
+    const char* text;
+    size_t text_length;
+    xyztrick_trajectory_view trajectory;
+    void* plugin_data;                  /* 插件自用（如结果数组的所有者），release() 时原样传回 */
+} xyztrick_result;
+
+typedef struct xyztrick_plugin_api {
+    uint32_t abi_version;               /* XYZTRICK_PLUGIN_ABI_VERSION */
+    uint32_t struct_size;               /* sizeof(xyztrick_plugin_api)，以后的版本只在末尾追加成员 */
+    const char* name;                   /* 用于日志，可为 NULL */
+    int (*run)(const xyztrick_trajectory_view* input, const char* clipboard_text, size_t clipboard_length,
+               xyztrick_result* result);
+    void (*release)(xyztrick_result* result);      /* 可为 NULL */
+    void (*shutdown)(void);                         /* 可为 NULL */
+} xyztrick_plugin_api;
+
+typedef const xyztrick_plugin_api* (*xyztrick_plugin_entry_fn)(uint32_t host_abi_version);
+
+#ifdef __cplusplus
+}
+#endif
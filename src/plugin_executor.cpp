@@ -0,0 +1,341 @@
+#include "plugin_executor.h"
+#include "logger.h"
+#include "platform.h"
+#include "shared_trajectory.h"
+#include "threading.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <deque>
+#include <sstream>
+
+PluginExecutor g_pluginExecutor;
+
+namespace {
+
+// 等待插件进程时每隔这么久检查一次超时与 stop()
+const unsigned int WAIT_SLICE_MILLIS = 100;
+// 结束超时的插件后等待它退出的时间
+const unsigned int TERMINATE_WAIT_MILLIS = 2000;
+const unsigned int DEFAULT_GLOBAL_LIMIT = 4;
+
+struct PendingRun {
+    std::string name;
+    std::string commandLine;
+    PluginRunLimits limits;
+    bool shareTrajectory = false;
+    uint64_t submittedMicros = 0;
+};
+
+uint64_t nowMicros() {
+    if (g_platform.clock) {
+        return g_platform.clock->nowMicros();
+    }
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+size_t runtimeBucket(double seconds) {
+    size_t bucket = 0;
+    while (bucket + 1 < PLUGIN_RUNTIME_BUCKET_COUNT && seconds >= PLUGIN_RUNTIME_BUCKETS[bucket]) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+std::string formatSeconds(uint64_t micros) {
+    std::ostringstream oss;
+    oss.precision(3);
+    oss << std::fixed << static_cast<double>(micros) / 1e6 << " s";
+    return oss.str();
+}
+
+} // namespace
+
+bool parsePluginBusyPolicy(const std::string& text, bool& coalesce) {
+    std::string lower;
+    for (char ch : text) {
+        lower += static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    }
+    if (lower == "coalesce") {
+        coalesce = true;
+    } else if (lower == "queue") {
+        coalesce = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+struct PluginExecutor::Impl {
+    mutable Mutex mutex;
+    Event wake;                             // 自动复位：每次唤醒一个工作线程
+    std::deque<PendingRun> pending;
+    std::map<std::string, PluginRunStats> stats;
+    std::vector<std::unique_ptr<Thread>> workers;
+    unsigned int globalLimit = DEFAULT_GLOBAL_LIMIT;
+    unsigned int running = 0;
+    std::atomic<bool> stopping{false};
+
+    bool canStart(const PluginRunStats& plugin, const PluginRunLimits& limits) const {
+        return running < globalLimit && (limits.maxConcurrent == 0 || plugin.running < limits.maxConcurrent);
+    }
+
+    // 取出第一个可以启动的排队项（持有 mutex 时调用）
+    bool takeRunnable(PendingRun& run) {
+        for (auto it = pending.begin(); it != pending.end(); ++it) {
+            PluginRunStats& plugin = stats[it->name];
+            if (canStart(plugin, it->limits)) {
+                run = std::move(*it);
+                pending.erase(it);
+                plugin.queued--;
+                plugin.running++;
+                running++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop() {
+        while (true) {
+            PendingRun run;
+            bool taken = false;
+            bool more = false;
+            {
+                LockGuard lock(mutex);
+                if (stopping.load()) {
+                    break;
+                }
+                taken = takeRunnable(run);
+                more = taken && !pending.empty() && running < globalLimit;
+            }
+            if (!taken) {
+                wake.wait();
+                continue;
+            }
+            if (more) {
+                wake.set();     // 可能还有可以启动的排队项，交给其他工作线程
+            }
+            execute(run);
+        }
+        wake.set();             // 把停止信号传给下一个工作线程
+    }
+
+    void execute(PendingRun& run) {
+        // 共享内存段在启动前才发布：读到的是此刻的剪贴板，段一直持有到本函数返回（进程结束）
+        std::unique_ptr<SharedTrajectorySegment> segment;
+        if (run.shareTrajectory) {
+            segment = publishClipboardTrajectory(run.name, run.commandLine);
+        }
+        const uint64_t start = nowMicros();
+        std::unique_ptr<ChildProcess> child = g_platform.launcher ? g_platform.launcher->start(run.commandLine) : nullptr;
+        if (!child) {
+            LOG_ERROR("Failed to execute plugin '" + run.name + "'");
+            notifyUser("Plugin Error", "Failed to execute plugin '" + run.name + "'", NotifyLevel::Error);
+            LockGuard lock(mutex);
+            PluginRunStats& plugin = stats[run.name];
+            plugin.launchFailures++;
+            plugin.running--;
+            running--;
+            return;
+        }
+        LOG_INFO("Plugin started: " + run.name + " (queued " + formatSeconds(start - run.submittedMicros) + ")");
+        notifyUser("Plugin Executed", "Plugin '" + run.name + "' executed successfully!", NotifyLevel::Info);
+
+        const uint64_t deadline = run.limits.timeoutSeconds > 0 ? start + uint64_t(run.limits.timeoutSeconds) * 1000000 : 0;
+        int exitCode = 0;
+        bool exited = false;
+        bool timedOut = false;
+        while (true) {
+            unsigned int slice = WAIT_SLICE_MILLIS;
+            if (deadline) {
+                const uint64_t now = nowMicros();
+                if (now >= deadline) {
+                    child->terminate();
+                    timedOut = true;
+                    exited = child->wait(TERMINATE_WAIT_MILLIS, exitCode);
+                    break;
+                }
+                slice = static_cast<unsigned int>(std::min<uint64_t>(slice, (deadline - now + 999) / 1000));
+            }
+            if (child->wait(slice, exitCode)) {
+                exited = true;
+                break;
+            }
+            if (stopping.load()) {
+                break;
+            }
+        }
+        const uint64_t elapsed = nowMicros() - start;
+
+        if (timedOut) {
+            LOG_WARNING("Plugin '" + run.name + "' timed out after " + formatSeconds(elapsed) + " and was terminated" +
+                        (exited ? "" : " (still exiting)"));
+            notifyUser("Plugin Timeout", "Plugin '" + run.name + "' exceeded " + std::to_string(run.limits.timeoutSeconds) +
+                                             " s and was terminated", NotifyLevel::Warning);
+        } else if (exited) {
+            LOG_INFO("Plugin '" + run.name + "' exited with code " + std::to_string(exitCode) + " after " +
+                     formatSeconds(elapsed));
+            if (exitCode != 0) {
+                notifyUser("Plugin Finished", "Plugin '" + run.name + "' exited with code " + std::to_string(exitCode),
+                           NotifyLevel::Warning);
+            }
+        } else {
+            LOG_INFO("Plugin '" + run.name + "' is still running at shutdown, no longer tracked");
+        }
+
+        LockGuard lock(mutex);
+        PluginRunStats& plugin = stats[run.name];
+        plugin.running--;
+        running--;
+        if (!exited && !timedOut) {
+            return;
+        }
+        plugin.runs++;
+        plugin.runtime.add(elapsed);
+        plugin.runtimeBuckets[runtimeBucket(static_cast<double>(elapsed) / 1e6)]++;
+        if (timedOut) {
+            plugin.timeouts++;
+        } else {
+            plugin.exitCodes[exitCode]++;
+        }
+    }
+};
+
+PluginExecutor::PluginExecutor() : m_impl(std::make_unique<Impl>()) {}
+
+PluginExecutor::~PluginExecutor() {
+    stop();
+}
+
+void PluginExecutor::setGlobalLimit(unsigned int maxConcurrent) {
+    {
+        LockGuard lock(m_impl->mutex);
+        m_impl->globalLimit = std::max(maxConcurrent, 1u);
+    }
+    m_impl->wake.set();
+}
+
+PluginExecutor::Submitted PluginExecutor::submit(const std::string& name, const std::string& commandLine,
+                                                 const PluginRunLimits& limits, bool shareTrajectory) {
+    Submitted result = Submitted::Queued;
+    {
+        LockGuard lock(m_impl->mutex);
+        if (m_impl->stopping.load()) {
+            return Submitted::Rejected;
+        }
+        PluginRunStats& plugin = m_impl->stats[name];
+        plugin.triggers++;
+
+        // 同一插件已有排队项时，按策略合并到最后一个排队项或排在其后
+        auto last = std::find_if(m_impl->pending.rbegin(), m_impl->pending.rend(),
+                                 [&name](const PendingRun& run) { return run.name == name; });
+        if (last != m_impl->pending.rend() && limits.coalesce) {
+            last->commandLine = commandLine;
+            last->limits = limits;
+            last->shareTrajectory = shareTrajectory;
+            plugin.coalesced++;
+            LOG_INFO("Merged repeated trigger into pending run of plugin '" + name + "'");
+            return Submitted::Coalesced;
+        }
+        if (plugin.queued >= MAX_QUEUED_PER_PLUGIN) {
+            plugin.rejected++;
+            LOG_WARNING("Too many pending runs of plugin '" + name + "', trigger dropped");
+            return Submitted::Rejected;
+        }
+        if (last != m_impl->pending.rend() || !m_impl->canStart(plugin, limits)) {
+            result = Submitted::Waiting;
+            LOG_INFO("Plugin '" + name + "' is busy or the plugin limit is reached, run queued");
+        }
+
+        PendingRun run;
+        run.name = name;
+        run.commandLine = commandLine;
+        run.limits = limits;
+        run.shareTrajectory = shareTrajectory;
+        run.submittedMicros = nowMicros();
+        m_impl->pending.push_back(std::move(run));
+        plugin.queued++;
+
+        // 工作线程按需创建，个数不少于全局上限
+        while (m_impl->workers.size() < m_impl->globalLimit) {
+            auto worker = std::make_unique<Thread>();
+            Impl* impl = m_impl.get();
+            if (!worker->start([impl]() { impl->workerLoop(); })) {
+                LOG_ERROR("Failed to start plugin worker thread");
+                break;
+            }
+            m_impl->workers.push_back(std::move(worker));
+        }
+    }
+    m_impl->wake.set();
+    return result;
+}
+
+void PluginExecutor::stop() {
+    std::vector<std::unique_ptr<Thread>> workers;
+    {
+        LockGuard lock(m_impl->mutex);
+        m_impl->stopping.store(true);
+        if (!m_impl->pending.empty()) {
+            LOG_INFO("Dropping " + std::to_string(m_impl->pending.size()) + " queued plugin run(s)");
+        }
+        for (const auto& run : m_impl->pending) {
+            m_impl->stats[run.name].queued--;
+        }
+        m_impl->pending.clear();
+        workers.swap(m_impl->workers);
+    }
+    m_impl->wake.set();
+    for (auto& worker : workers) {
+        worker->join();
+    }
+}
+
+PluginRunStats PluginExecutor::stats(const std::string& name) const {
+    LockGuard lock(m_impl->mutex);
+    auto it = m_impl->stats.find(name);
+    return it != m_impl->stats.end() ? it->second : PluginRunStats();
+}
+
+std::vector<std::string> PluginExecutor::pluginNames() const {
+    LockGuard lock(m_impl->mutex);
+    std::vector<std::string> names;
+    for (const auto& item : m_impl->stats) {
+        names.push_back(item.first);
+    }
+    return names;
+}
+
+std::string PluginExecutor::report() const {
+    LockGuard lock(m_impl->mutex);
+    std::ostringstream oss;
+    for (const auto& item : m_impl->stats) {
+        const PluginRunStats& plugin = item.second;
+        oss << item.first << ": " << plugin.triggers << " trigger(s), " << plugin.runs << " run(s), " << plugin.timeouts
+            << " timed out, " << plugin.launchFailures << " failed to start, " << plugin.coalesced << " merged, "
+            << plugin.rejected << " dropped; running " << plugin.running << ", queued " << plugin.queued << "\n";
+        if (!plugin.exitCodes.empty()) {
+            oss << "  exit codes:";
+            for (const auto& code : plugin.exitCodes) {
+                oss << " " << code.first << " x" << code.second;
+            }
+            oss << "\n";
+        }
+        if (plugin.runtime.count() > 0) {
+            oss << "  run time: " << plugin.runtime.summary() << "\n  histogram:";
+            for (size_t b = 0; b < PLUGIN_RUNTIME_BUCKET_COUNT; ++b) {
+                if (b + 1 < PLUGIN_RUNTIME_BUCKET_COUNT) {
+                    oss << " <" << PLUGIN_RUNTIME_BUCKETS[b] << "s:";
+                } else {
+                    oss << " >=" << PLUGIN_RUNTIME_BUCKETS[b - 1] << "s:";
+                }
+                oss << plugin.runtimeBuckets[b];
+            }
+            oss << "\n";
+        }
+    }
+    return oss.str();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "pipeline.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 普通插件的执行管理：进程经 ProcessLauncher::start 启动并由工作线程等待到结束，
+// - 全局与每个插件各有并发上限，达到上限的触发排队（或与已排队的触发合并）
+// - 可选超时：超时的插件连同其子进程被结束
+// - 每个插件记录运行次数、退出码、运行时间分布，可从托盘菜单查看，退出时写入日志
+
+// 单个插件的执行限制（来自插件分区的 max_concurrent / timeout / on_busy）
+struct PluginRunLimits {
+    unsigned int maxConcurrent = 1;     // 同时运行的进程数，0 表示只受全局上限限制
+    unsigned int timeoutSeconds = 0;    // 0 表示不限时
+    bool coalesce = true;               // 达到上限时重复触发只保留最后一次（否则依次排队）
+};
+
+// "coalesce" / "queue"（不区分大小写），无法识别时返回 false
+bool parsePluginBusyPolicy(const std::string& text, bool& coalesce);
+
+// 运行时间分布的桶上限（秒），最后一个桶收集更长的运行
+const double PLUGIN_RUNTIME_BUCKETS[] = {0.1, 0.3, 1.0, 3.0, 10.0, 30.0, 100.0, 300.0};
+const size_t PLUGIN_RUNTIME_BUCKET_COUNT = sizeof(PLUGIN_RUNTIME_BUCKETS) / sizeof(PLUGIN_RUNTIME_BUCKETS[0]) + 1;
+
+struct PluginRunStats {
+    uint64_t triggers = 0;          // 提交次数
+    uint64_t runs = 0;              // 已结束的运行（含超时）
+    uint64_t coalesced = 0;         // 合并到已排队触发的次数
+    uint64_t rejected = 0;          // 队列已满被丢弃的触发
+    uint64_t launchFailures = 0;
+    uint64_t timeouts = 0;
+    unsigned int running = 0;
+    size_t queued = 0;
+    std::map<int, uint64_t> exitCodes;                  // 正常结束的退出码 -> 次数
+    uint64_t runtimeBuckets[PLUGIN_RUNTIME_BUCKET_COUNT] = {};
+    LatencyStats runtime;                               // 全部结束的运行（含超时）
+};
+
+class PluginExecutor {
+public:
+    // 每个插件排队等待的触发上限（on_busy=queue 时）
+    static const size_t MAX_QUEUED_PER_PLUGIN = 16;
+
+    PluginExecutor();
+    ~PluginExecutor();      // 调用 stop()
+    PluginExecutor(const PluginExecutor&) = delete;
+    PluginExecutor& operator=(const PluginExecutor&) = delete;
+
+    // 全局并发上限（至少为 1），可随时修改
+    void setGlobalLimit(unsigned int maxConcurrent);
+
+    enum class Submitted {
+        Queued,         // 有空位，工作线程立即启动
+        Waiting,        // 插件或全局已达上限，排队等待
+        Coalesced,      // 替换了同一插件已排队的触发
+        Rejected        // 队列已满或已停止
+    };
+    // 提交一次运行，立即返回。shareTrajectory 为 true 时，工作线程在启动进程前才读取剪贴板并发布共享内存段
+    // （publishClipboardTrajectory），被合并或丢弃的触发不做这部分工作；段由该次运行持有，进程结束后释放
+    Submitted submit(const std::string& name, const std::string& commandLine, const PluginRunLimits& limits,
+                     bool shareTrajectory = false);
+
+    // 丢弃排队的触发并停止工作线程；运行中的插件不结束，只是不再等待（程序退出前调用）
+    void stop();
+
+    PluginRunStats stats(const std::string& name) const;
+    std::vector<std::string> pluginNames() const;
+    // 每个插件一段统计（托盘菜单与日志使用），没有任何记录时返回空字符串
+    std::string report() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// 普通插件共用的执行管理器
+extern PluginExecutor g_pluginExecutor;
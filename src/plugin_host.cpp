@@ -0,0 +1,829 @@
+#include "plugin_host.h"
+#include "plugin_executor.h"
+#include "plugin_library.h"
+#include "config.h"
+#include "core.h"
+#include "job_queue.h"
+#include "logger.h"
+#include "memory_budget.h"
+#include "output_writers.h"
+#include "pipeline.h"
+#include "platform.h"
+#include "threading.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t READ_CHUNK = 64 * 1024;
+const unsigned int STARTUP_TIMEOUT_MILLIS = 10000;
+// 协议行（RESULT 头、LOG）的长度上限，防止插件不换行地一直输出
+const size_t MAX_LINE_BYTES = 1024 * 1024;
+// 等待插件输出时每隔这么久检查一次 abort()
+const unsigned int ABORT_CHECK_MILLIS = 100;
+
+enum class ReadStatus {
+    Data,
+    Timeout,
+    Closed      // 管道关闭（插件退出）或读取出错
+};
+
+uint64_t steadyMillis() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// 距 deadline 剩余的毫秒数（deadline 为 0 表示不限时）
+unsigned int remainingMillis(uint64_t deadline) {
+    if (deadline == 0) {
+        return ResidentPlugin::NO_TIMEOUT;
+    }
+    uint64_t now = steadyMillis();
+    return now >= deadline ? 0 : static_cast<unsigned int>(std::min<uint64_t>(deadline - now, 0x7FFFFFFF));
+}
+
+uint64_t deadlineAfter(unsigned int timeoutMillis) {
+    return timeoutMillis == ResidentPlugin::NO_TIMEOUT ? 0 : steadyMillis() + timeoutMillis;
+}
+
+#ifdef _WIN32
+
+// ========== Win32 实现 ==========
+
+struct PluginProcess {
+    HANDLE process = NULL;
+    HANDLE input = NULL;        // 插件标准输入的写端
+    HANDLE output = NULL;       // 插件标准输出的读端
+};
+
+bool spawnProcess(const std::string& commandLine, PluginProcess& child) {
+    SECURITY_ATTRIBUTES sa;
+    sa.nLength = sizeof(sa);
+    sa.lpSecurityDescriptor = NULL;
+    sa.bInheritHandle = TRUE;
+
+    HANDLE stdinRead = NULL, stdinWrite = NULL, stdoutRead = NULL, stdoutWrite = NULL;
+    if (!CreatePipe(&stdinRead, &stdinWrite, &sa, 0)) {
+        LOG_ERROR("CreatePipe failed (error " + std::to_string(GetLastError()) + ")");
+        return false;
+    }
+    if (!CreatePipe(&stdoutRead, &stdoutWrite, &sa, 0)) {
+        LOG_ERROR("CreatePipe failed (error " + std::to_string(GetLastError()) + ")");
+        CloseHandle(stdinRead);
+        CloseHandle(stdinWrite);
+        return false;
+    }
+    // 宿主一侧的管道端不能被插件继承，否则插件退出后读端收不到 EOF
+    SetHandleInformation(stdinWrite, HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(stdoutRead, HANDLE_FLAG_INHERIT, 0);
+
+    STARTUPINFOA si;
+    PROCESS_INFORMATION pi;
+    ZeroMemory(&si, sizeof(si));
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESTDHANDLES;
+    si.hStdInput = stdinRead;
+    si.hStdOutput = stdoutWrite;
+    si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+    ZeroMemory(&pi, sizeof(pi));
+
+    std::vector<char> cmdBuf(commandLine.begin(), commandLine.end());
+    cmdBuf.push_back('\0');
+    BOOL created = CreateProcessA(NULL, cmdBuf.data(), NULL, NULL, TRUE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi);
+    DWORD error = GetLastError();
+    CloseHandle(stdinRead);
+    CloseHandle(stdoutWrite);
+    if (!created) {
+        LOG_ERROR("Failed to launch resident plugin (Error: " + std::to_string(error) + "): " + commandLine);
+        CloseHandle(stdinWrite);
+        CloseHandle(stdoutRead);
+        return false;
+    }
+    CloseHandle(pi.hThread);
+    child.process = pi.hProcess;
+    child.input = stdinWrite;
+    child.output = stdoutRead;
+    return true;
+}
+
+bool writeToProcess(PluginProcess& child, std::string_view data) {
+    while (!data.empty()) {
+        DWORD written = 0;
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(data.size(), 1u << 30));
+        if (!WriteFile(child.input, data.data(), chunk, &written, NULL) || written == 0) {
+            return false;
+        }
+        data.remove_prefix(written);
+    }
+    return true;
+}
+
+// 匿名管道不支持重叠 I/O：先用 PeekNamedPipe 查看是否有数据，没有时让出时间片，
+// 等待超过约 1ms 后改为 Sleep(1)，这样短请求的往返不受定时器精度限制
+ReadStatus readFromProcess(PluginProcess& child, std::string& buffer, unsigned int timeoutMillis) {
+    const uint64_t deadline = deadlineAfter(timeoutMillis);
+    const auto spinUntil = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+    char chunk[READ_CHUNK];
+    while (true) {
+        DWORD available = 0;
+        if (!PeekNamedPipe(child.output, NULL, 0, NULL, &available, NULL)) {
+            return ReadStatus::Closed;
+        }
+        if (available > 0) {
+            DWORD read = 0;
+            if (!ReadFile(child.output, chunk, std::min<DWORD>(available, sizeof(chunk)), &read, NULL) || read == 0) {
+                return ReadStatus::Closed;
+            }
+            buffer.append(chunk, read);
+            return ReadStatus::Data;
+        }
+        if (deadline != 0 && remainingMillis(deadline) == 0) {
+            return ReadStatus::Timeout;
+        }
+        if (std::chrono::steady_clock::now() < spinUntil) {
+            SwitchToThread();
+        } else {
+            Sleep(1);
+        }
+    }
+}
+
+bool processAlive(const PluginProcess& child) {
+    return child.process && WaitForSingleObject(child.process, 0) == WAIT_TIMEOUT;
+}
+
+void closeProcess(PluginProcess& child, unsigned int graceMillis) {
+    if (child.input) {
+        CloseHandle(child.input);
+        child.input = NULL;
+    }
+    if (child.process) {
+        if (WaitForSingleObject(child.process, graceMillis) == WAIT_TIMEOUT) {
+            LOG_WARNING("Resident plugin did not exit, terminating it");
+            TerminateProcess(child.process, 1);
+            WaitForSingleObject(child.process, 1000);
+        }
+        CloseHandle(child.process);
+        child.process = NULL;
+    }
+    if (child.output) {
+        CloseHandle(child.output);
+        child.output = NULL;
+    }
+}
+
+#else
+
+// ========== POSIX 实现 ==========
+
+struct PluginProcess {
+    pid_t pid = -1;
+    int input = -1;             // 插件标准输入的写端
+    int output = -1;            // 插件标准输出的读端
+};
+
+bool spawnProcess(const std::string& commandLine, PluginProcess& child) {
+    // 插件退出后写管道得到 EPIPE 而不是让宿主收到 SIGPIPE
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int toChild[2];
+    int fromChild[2];
+    if (pipe(toChild) != 0) {
+        LOG_ERROR("pipe() failed for resident plugin");
+        return false;
+    }
+    if (pipe(fromChild) != 0) {
+        LOG_ERROR("pipe() failed for resident plugin");
+        close(toChild[0]);
+        close(toChild[1]);
+        return false;
+    }
+    fcntl(toChild[1], F_SETFD, FD_CLOEXEC);
+    fcntl(fromChild[0], F_SETFD, FD_CLOEXEC);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        LOG_ERROR("fork() failed for resident plugin: " + commandLine);
+        close(toChild[0]);
+        close(toChild[1]);
+        close(fromChild[0]);
+        close(fromChild[1]);
+        return false;
+    }
+    if (pid == 0) {
+        // 插件自成进程组，强制结束时连同 sh 启动的子进程一起结束
+        setpgid(0, 0);
+        dup2(toChild[0], STDIN_FILENO);
+        dup2(fromChild[1], STDOUT_FILENO);
+        close(toChild[0]);
+        close(fromChild[1]);
+        execl("/bin/sh", "sh", "-c", commandLine.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    close(toChild[0]);
+    close(fromChild[1]);
+    child.pid = pid;
+    child.input = toChild[1];
+    child.output = fromChild[0];
+    return true;
+}
+
+bool writeToProcess(PluginProcess& child, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t written = write(child.input, data.data(), data.size());
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+ReadStatus readFromProcess(PluginProcess& child, std::string& buffer, unsigned int timeoutMillis) {
+    const uint64_t deadline = deadlineAfter(timeoutMillis);
+    char chunk[READ_CHUNK];
+    while (true) {
+        pollfd fd{child.output, POLLIN, 0};
+        const unsigned int remaining = remainingMillis(deadline);
+        int ready = poll(&fd, 1, remaining == ResidentPlugin::NO_TIMEOUT ? -1 : static_cast<int>(remaining));
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready < 0) {
+            return ReadStatus::Closed;
+        }
+        if (ready == 0) {
+            return ReadStatus::Timeout;
+        }
+        ssize_t count = read(child.output, chunk, sizeof(chunk));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return ReadStatus::Closed;
+        }
+        buffer.append(chunk, static_cast<size_t>(count));
+        return ReadStatus::Data;
+    }
+}
+
+bool processAlive(const PluginProcess& child) {
+    if (child.pid <= 0) {
+        return false;
+    }
+    int status = 0;
+    return waitpid(child.pid, &status, WNOHANG) == 0;
+}
+
+void closeProcess(PluginProcess& child, unsigned int graceMillis) {
+    if (child.input >= 0) {
+        close(child.input);
+        child.input = -1;
+    }
+    if (child.pid > 0) {
+        int status = 0;
+        const uint64_t deadline = steadyMillis() + graceMillis;
+        while (waitpid(child.pid, &status, WNOHANG) == 0) {
+            if (steadyMillis() >= deadline) {
+                LOG_WARNING("Resident plugin did not exit, terminating it");
+                kill(-child.pid, SIGKILL);
+                waitpid(child.pid, &status, 0);
+                break;
+            }
+            sleepMillis(5);
+        }
+        child.pid = -1;
+    }
+    if (child.output >= 0) {
+        close(child.output);
+        child.output = -1;
+    }
+}
+
+#endif
+
+// 十进制非负整数；非数字或超出 size_t 范围时返回 false
+bool parseSize(std::string_view token, size_t& value) {
+    if (token.empty()) {
+        return false;
+    }
+    value = 0;
+    for (char ch : token) {
+        if (ch < '0' || ch > '9') {
+            return false;
+        }
+        const size_t digit = static_cast<size_t>(ch - '0');
+        if (value > (SIZE_MAX - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    return true;
+}
+
+} // namespace
+
+// ========== ResidentPlugin ==========
+
+struct ResidentPlugin::Impl {
+    PluginProcess child;
+    bool started = false;
+    std::string commandLine;
+    std::string buffer;         // 已读取、尚未处理的插件输出
+    uint64_t nextId = 1;
+    uint64_t calls = 0;
+    std::atomic<bool> aborted{false};
+
+    // 再读入一段输出；超时、插件退出或被 abort() 时返回 false
+    bool fill(uint64_t deadline) {
+        while (!aborted.load()) {
+            const unsigned int remaining = remainingMillis(deadline);
+            ReadStatus status = readFromProcess(child, buffer, std::min(remaining, ABORT_CHECK_MILLIS));
+            if (status == ReadStatus::Data) {
+                return true;
+            }
+            if (status == ReadStatus::Closed || remainingMillis(deadline) == 0) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    // 读一行（不含换行符），超时或插件退出时返回 false
+    bool readLine(std::string& line, uint64_t deadline) {
+        size_t scanned = 0;
+        while (true) {
+            size_t newline = buffer.find('\n', scanned);
+            if (newline != std::string::npos) {
+                size_t end = newline > 0 && buffer[newline - 1] == '\r' ? newline - 1 : newline;
+                line.assign(buffer, 0, end);
+                buffer.erase(0, newline + 1);
+                return true;
+            }
+            scanned = buffer.size();
+            if (scanned > MAX_LINE_BYTES) {
+                LOG_ERROR("Resident plugin output line exceeds " + std::to_string(MAX_LINE_BYTES) + " bytes");
+                return false;
+            }
+            if (!fill(deadline)) {
+                return false;
+            }
+        }
+    }
+
+    // 读 count 个字节
+    bool readExact(std::string& out, size_t count, uint64_t deadline) {
+        while (buffer.size() < count) {
+            if (!fill(deadline)) {
+                return false;
+            }
+        }
+        out.assign(buffer, 0, count);
+        buffer.erase(0, count);
+        return true;
+    }
+
+    void terminate(unsigned int graceMillis) {
+        if (started) {
+            closeProcess(child, graceMillis);
+            started = false;
+        }
+        buffer.clear();
+    }
+};
+
+ResidentPlugin::ResidentPlugin() : m_impl(std::make_unique<Impl>()) {}
+
+ResidentPlugin::~ResidentPlugin() {
+    stop();
+}
+
+bool ResidentPlugin::start(const std::string& commandLine, unsigned int timeoutMillis) {
+    stop();
+    m_impl->aborted = false;
+    m_impl->commandLine = commandLine;
+    if (!spawnProcess(commandLine, m_impl->child)) {
+        return false;
+    }
+    m_impl->started = true;
+
+    std::string line;
+    if (!m_impl->readLine(line, deadlineAfter(timeoutMillis))) {
+        LOG_ERROR("Resident plugin did not send a handshake line: " + commandLine);
+        m_impl->terminate(0);
+        return false;
+    }
+    std::string_view tokens[2];
+    size_t version = 0;
+    if (splitWhitespaceViews(line, tokens, 2) < 2 || tokens[0] != "XYZTRICK-PLUGIN" || !parseSize(tokens[1], version) ||
+        version != static_cast<size_t>(RESIDENT_PLUGIN_PROTOCOL_VERSION)) {
+        LOG_ERROR("Unexpected resident plugin handshake '" + line + "' (expected XYZTRICK-PLUGIN " +
+                  std::to_string(RESIDENT_PLUGIN_PROTOCOL_VERSION) + "): " + commandLine);
+        m_impl->terminate(0);
+        return false;
+    }
+    LOG_INFO("Resident plugin started: " + commandLine);
+    return true;
+}
+
+bool ResidentPlugin::running() const {
+    return m_impl->started && processAlive(m_impl->child);
+}
+
+bool ResidentPlugin::call(std::string_view kind, std::string_view payload, PluginReply& reply,
+                          unsigned int timeoutMillis, size_t maxReplyBytes) {
+    if (!m_impl->started) {
+        return false;
+    }
+    const uint64_t deadline = deadlineAfter(timeoutMillis);
+    const std::string id = std::to_string(m_impl->nextId++);
+    std::string header = "REQUEST " + id + " " + std::string(kind) + " " + std::to_string(payload.size()) + "\n";
+    if (!writeToProcess(m_impl->child, header) || !writeToProcess(m_impl->child, payload) ||
+        !writeToProcess(m_impl->child, "\n")) {
+        LOG_ERROR("Failed to send request to resident plugin (plugin exited?)");
+        m_impl->terminate(0);
+        return false;
+    }
+
+    std::string line;
+    while (true) {
+        if (!m_impl->readLine(line, deadline)) {
+            LOG_ERROR(std::string(m_impl->aborted ? "Aborted waiting for" :
+                                  remainingMillis(deadline) == 0 ? "Timed out waiting for" : "No reply from") +
+                      " resident plugin: " + m_impl->commandLine);
+            m_impl->terminate(0);
+            return false;
+        }
+        if (line.compare(0, 4, "LOG ") == 0) {
+            LOG_INFO("[plugin] " + line.substr(4));
+            continue;
+        }
+
+        // RESULT <id> <ok|error> <动作> <字节数>
+        std::string_view tokens[5];
+        size_t bytes = 0;
+        if (splitWhitespaceViews(line, tokens, 5) < 5 || tokens[0] != "RESULT" || !parseSize(tokens[4], bytes)) {
+            LOG_DEBUG("Ignoring resident plugin output: " + line);
+            continue;
+        }
+        if (bytes > maxReplyBytes || bytes == SIZE_MAX) {
+            // 载荷无法跳过（插件可能还在写），只能结束进程
+            LOG_ERROR("Resident plugin reply of " + std::to_string(bytes) + " bytes exceeds the limit of " +
+                      std::to_string(maxReplyBytes) + " bytes: " + m_impl->commandLine);
+            m_impl->terminate(0);
+            return false;
+        }
+        std::string body;
+        if (!m_impl->readExact(body, bytes + 1, deadline) || body.empty() || body.back() != '\n') {
+            LOG_ERROR("Truncated reply from resident plugin: " + m_impl->commandLine);
+            m_impl->terminate(0);
+            return false;
+        }
+        if (tokens[1] != id) {
+            LOG_WARNING("Discarding stale resident plugin reply " + std::string(tokens[1]) + " (waiting for " + id + ")");
+            continue;
+        }
+        body.pop_back();
+        reply.ok = tokens[2] == "ok";
+        reply.action = std::string(tokens[3]);
+        reply.payload = std::move(body);
+        ++m_impl->calls;
+        return true;
+    }
+}
+
+void ResidentPlugin::stop(unsigned int graceMillis) {
+    if (!m_impl->started) {
+        return;
+    }
+    writeToProcess(m_impl->child, "QUIT\n");
+    m_impl->terminate(graceMillis);
+}
+
+void ResidentPlugin::abort() {
+    m_impl->aborted = true;
+}
+
+bool ResidentPlugin::aborted() const {
+    return m_impl->aborted.load();
+}
+
+const std::string& ResidentPlugin::commandLine() const {
+    return m_impl->commandLine;
+}
+
+uint64_t ResidentPlugin::callCount() const {
+    return m_impl->calls;
+}
+
+// ========== 插件注册表 ==========
+
+namespace {
+
+struct ResidentEntry {
+    int kind = 0;               // 后台队列中的任务类别（同一插件的重复触发合并）
+    Mutex callMutex;            // 同一插件的调用依次进行
+    ResidentPlugin plugin;
+};
+
+struct LibraryEntry {
+    int kind = 0;
+    Mutex callMutex;
+    PluginLibrary library;
+};
+
+Mutex g_pluginMutex;
+std::map<std::string, std::shared_ptr<ResidentEntry>> g_residentPlugins;
+std::map<std::string, std::shared_ptr<LibraryEntry>> g_libraryPlugins;
+std::unique_ptr<JobQueue> g_pluginQueue;
+int g_pluginKinds = 0;
+
+template <typename Entry>
+std::shared_ptr<Entry> pluginEntry(std::map<std::string, std::shared_ptr<Entry>>& plugins, const std::string& name) {
+    LockGuard lock(g_pluginMutex);
+    std::shared_ptr<Entry>& entry = plugins[name];
+    if (!entry) {
+        entry = std::make_shared<Entry>();
+        entry->kind = ++g_pluginKinds;
+    }
+    return entry;
+}
+
+void reportStage(JobContext* ctx, const std::string& stage) {
+    if (ctx) {
+        ctx->progress(stage);
+    }
+}
+
+void reportOutcome(JobContext* ctx, const std::string& title, const std::string& message, NotifyLevel level) {
+    if (ctx) {
+        ctx->setResult(title, message, level);
+    } else {
+        notifyUser(title, message, level);
+    }
+}
+
+// 请求载荷：剪贴板能解析为结构时发送解析好的帧（统一写成 XYZ），否则发送原文
+void buildRequest(std::string text, std::string& kind, std::string& payload) {
+    if (text.size() <= g_config.maxClipboardChars) {
+        try {
+            MemoryBudget budget(static_cast<size_t>(g_config.maxMemoryMB) * 1024 * 1024);
+            MemoryBudgetScope budgetScope(budget);
+            std::vector<Frame> frames;
+            if (parseStructureText(text, frames) && writeFrames(*findOutputWriter("xyz"), frames, payload)) {
+                kind = "frames";
+                return;
+            }
+        } catch (const MemoryBudgetExceeded& e) {
+            LOG_WARNING("Sending clipboard text to plugin unparsed: " + std::string(e.what()));
+        }
+    }
+    kind = "text";
+    payload = std::move(text);
+}
+
+// 按回复的动作写回剪贴板或通知
+bool applyReply(const std::string& name, const PluginReply& reply, JobContext* ctx) {
+    const std::string title = "Plugin " + name;
+    if (!reply.ok) {
+        LOG_ERROR("Plugin '" + name + "' failed: " + reply.payload);
+        reportOutcome(ctx, title, reply.payload.empty() ? "Plugin reported an error" : reply.payload,
+                      NotifyLevel::Error);
+        return false;
+    }
+    if (reply.action == "clipboard") {
+        if (!g_platform.clipboard || !g_platform.clipboard->writeText(reply.payload)) {
+            reportOutcome(ctx, title, "Failed to write plugin result to clipboard", NotifyLevel::Error);
+            return false;
+        }
+        reportOutcome(ctx, title, "Result copied to clipboard", NotifyLevel::Info);
+    } else if (reply.action == "notify") {
+        reportOutcome(ctx, title, reply.payload, NotifyLevel::Info);
+    } else {
+        if (!reply.payload.empty()) {
+            LOG_INFO("Plugin '" + name + "': " + reply.payload);
+        }
+        reportOutcome(ctx, title, "Done", NotifyLevel::Info);
+    }
+    return true;
+}
+
+// 在插件后台线程中执行 job；同一 kind 已有任务在排队时合并（合并也返回 true）
+bool submitPluginJob(int kind, const std::string& name, JobQueue::JobFunction job) {
+    LockGuard lock(g_pluginMutex);
+    if (!g_pluginQueue) {
+        g_pluginQueue = std::make_unique<JobQueue>();
+        g_pluginQueue->setHandlers(nullptr, [](const JobReport& report) {
+            if (report.cancelled) {
+                return;
+            }
+            std::string message = report.message.empty() ? (report.success ? "Done" : "Failed, see log for details")
+                                                         : report.message;
+            if (report.mergedPresses > 0) {
+                message += " (merged " + std::to_string(report.mergedPresses) + " repeated press(es))";
+            }
+            notifyUser(report.title.empty() ? report.label : report.title, message,
+                       report.success ? report.level : NotifyLevel::Error);
+        });
+        if (!g_pluginQueue->start()) {
+            g_pluginQueue.reset();
+            return false;
+        }
+    }
+    g_pluginQueue->submit(kind, "Plugin " + name, std::move(job));
+    return true;
+}
+
+} // namespace
+
+bool runResidentPluginCall(const std::string& name, const std::string& commandLine, unsigned int timeoutSeconds,
+                           JobContext* ctx) {
+    const std::string title = "Plugin " + name;
+    try {
+        std::shared_ptr<ResidentEntry> entry = pluginEntry(g_residentPlugins, name);
+        LockGuard callLock(entry->callMutex);
+
+        if (entry->plugin.running() && entry->plugin.commandLine() != commandLine) {
+            LOG_INFO("Command of resident plugin '" + name + "' changed, restarting it");
+            entry->plugin.stop();
+        }
+        if (ctx && ctx->isCancelled()) {
+            return false;
+        }
+        if (!entry->plugin.running()) {
+            reportStage(ctx, "Starting plugin");
+            if (!entry->plugin.start(commandLine, STARTUP_TIMEOUT_MILLIS)) {
+                reportOutcome(ctx, title, "Failed to start resident plugin", NotifyLevel::Error);
+                return false;
+            }
+        }
+
+        reportStage(ctx, "Reading clipboard");
+        std::string text = g_platform.clipboard ? g_platform.clipboard->readText() : "";
+        if (text.empty()) {
+            reportOutcome(ctx, title, "Clipboard is empty", NotifyLevel::Warning);
+            return false;
+        }
+        std::string kind;
+        std::string payload;
+        buildRequest(std::move(text), kind, payload);
+        if (ctx && ctx->isCancelled()) {
+            return false;
+        }
+
+        reportStage(ctx, "Running plugin");
+        const unsigned int callSeconds = timeoutSeconds > 0 ? timeoutSeconds : RESIDENT_CALL_TIMEOUT_SECONDS;
+        const unsigned int callMillis = static_cast<unsigned int>(
+            std::min<uint64_t>(static_cast<uint64_t>(callSeconds) * 1000, ResidentPlugin::NO_TIMEOUT - 1));
+        const size_t maxReplyBytes = std::max<size_t>(g_config.maxClipboardChars, payload.size());
+        const auto start = std::chrono::steady_clock::now();
+        PluginReply reply;
+        if (!entry->plugin.call(kind, payload, reply, callMillis, maxReplyBytes)) {
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::steady_clock::now() - start).count();
+            const bool timedOut = static_cast<uint64_t>(elapsed) >= callMillis;
+            // call() 已结束插件进程；立即重启，下次触发不必再等启动（退出时被 abort() 的除外）
+            if (!entry->plugin.aborted()) {
+                LOG_INFO("Restarting resident plugin '" + name + "'");
+                entry->plugin.start(commandLine, STARTUP_TIMEOUT_MILLIS);
+            }
+            reportOutcome(ctx, title,
+                          timedOut ? "Resident plugin timed out after " + std::to_string(callSeconds) + " s"
+                                   : "Resident plugin failed to reply, see log for details",
+                          NotifyLevel::Error);
+            return false;
+        }
+        const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("Resident plugin '" + name + "' replied in " + std::to_string(micros) + " us (" + kind + ", " +
+                 std::to_string(payload.size()) + " bytes sent, " + std::to_string(reply.payload.size()) +
+                 " bytes received)");
+        return applyReply(name, reply, ctx);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception running resident plugin '" + name + "': " + std::string(e.what()));
+        reportOutcome(ctx, title, "Error: " + std::string(e.what()), NotifyLevel::Error);
+        return false;
+    }
+}
+
+bool submitResidentPluginCall(const std::string& name, const std::string& commandLine, unsigned int timeoutSeconds) {
+    const int kind = pluginEntry(g_residentPlugins, name)->kind;
+    return submitPluginJob(kind, name, [name, commandLine, timeoutSeconds](JobContext& ctx) {
+        return runResidentPluginCall(name, commandLine, timeoutSeconds, &ctx);
+    });
+}
+
+bool runLibraryPluginCall(const std::string& name, const std::string& libraryPath, JobContext* ctx) {
+    const std::string title = "Plugin " + name;
+    try {
+        std::shared_ptr<LibraryEntry> entry = pluginEntry(g_libraryPlugins, name);
+        LockGuard callLock(entry->callMutex);
+
+        if (entry->library.loaded() && entry->library.path() != libraryPath) {
+            LOG_INFO("Library of plugin '" + name + "' changed, reloading it");
+            entry->library.unload();
+        }
+        if (ctx && ctx->isCancelled()) {
+            return false;
+        }
+        if (!entry->library.loaded()) {
+            reportStage(ctx, "Loading plugin");
+            if (!entry->library.load(libraryPath)) {
+                reportOutcome(ctx, title, "Failed to load plugin library", NotifyLevel::Error);
+                return false;
+            }
+        }
+
+        reportStage(ctx, "Reading clipboard");
+        std::string text = g_platform.clipboard ? g_platform.clipboard->readText() : "";
+        if (text.empty()) {
+            reportOutcome(ctx, title, "Clipboard is empty", NotifyLevel::Warning);
+            return false;
+        }
+
+        // 帧只在预算作用域内存在：插件拿到的视图直接指向这些帧，回复格式化完成后才释放
+        PluginReply reply;
+        {
+            MemoryBudget budget(static_cast<size_t>(g_config.maxMemoryMB) * 1024 * 1024);
+            MemoryBudgetScope budgetScope(budget);
+            std::vector<Frame> frames;
+            bool parsed = false;
+            if (text.size() <= g_config.maxClipboardChars) {
+                try {
+                    parsed = parseStructureText(text, frames);
+                } catch (const MemoryBudgetExceeded& e) {
+                    LOG_WARNING("Passing clipboard text to plugin unparsed: " + std::string(e.what()));
+                    frames.clear();
+                }
+            }
+            if (ctx && ctx->isCancelled()) {
+                return false;
+            }
+            reportStage(ctx, "Running plugin");
+            entry->library.call(parsed ? &frames : nullptr, text, reply);
+        }
+        return applyReply(name, reply, ctx);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception running plugin library '" + name + "': " + std::string(e.what()));
+        reportOutcome(ctx, title, "Error: " + std::string(e.what()), NotifyLevel::Error);
+        return false;
+    }
+}
+
+bool submitLibraryPluginCall(const std::string& name, const std::string& libraryPath) {
+    const int kind = pluginEntry(g_libraryPlugins, name)->kind;
+    return submitPluginJob(kind, name, [name, libraryPath](JobContext& ctx) {
+        return runLibraryPluginCall(name, libraryPath, &ctx);
+    });
+}
+
+void shutdownPlugins() {
+    std::unique_ptr<JobQueue> queue;
+    std::map<std::string, std::shared_ptr<ResidentEntry>> residents;
+    std::map<std::string, std::shared_ptr<LibraryEntry>> libraries;
+    {
+        LockGuard lock(g_pluginMutex);
+        queue = std::move(g_pluginQueue);
+        residents.swap(g_residentPlugins);
+        libraries.swap(g_libraryPlugins);
+    }
+    // 正在等待回复的调用先放弃等待，工作线程才能退出
+    for (auto& item : residents) {
+        item.second->plugin.abort();
+    }
+    if (queue) {
+        queue->stop();
+    }
+    for (auto& item : residents) {
+        LockGuard callLock(item.second->callMutex);
+        item.second->plugin.stop();
+    }
+    // 库插件在队列停止后卸载，此时不会再有调用进入插件代码
+    for (auto& item : libraries) {
+        LockGuard callLock(item.second->callMutex);
+        item.second->library.unload();
+    }
+    // 普通插件：丢弃排队的触发，运行中的进程不结束；统计写入日志
+    g_pluginExecutor.stop();
+    const std::string report = g_pluginExecutor.report();
+    if (!report.empty()) {
+        LOG_INFO("Plugin statistics:\n" + report);
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+class JobContext;
+
+// 常驻插件：插件进程只启动一次，之后每次触发经标准输入/输出管道发送请求、接收结果，
+// 省去每次按热键时的进程启动、插件读取配置与剪贴板的开销。
+//
+// 协议（版本 1，全部为 UTF-8 文本，行以 LF 结尾，载荷按字节数分帧）：
+//   插件启动后先输出一行        XYZTRICK-PLUGIN 1
+//   宿主发送请求                REQUEST <id> <类型> <字节数>\n<载荷>\n
+//     类型 frames：载荷为宿主已解析好的全部帧（多帧 XYZ，带晶胞时含 Tv 行）
+//     类型 text：剪贴板不是结构文本，载荷为剪贴板原文
+//   插件回复                    RESULT <id> <ok|error> <动作> <字节数>\n<载荷>\n
+//     动作 clipboard：载荷写回剪贴板；notify：载荷作为通知显示；none：只记录日志
+//     error 时载荷为错误信息
+//   回复之前插件可输出任意条    LOG <文本>\n    （写入宿主日志）
+//   宿主退出或插件命令变化时发送 QUIT\n，插件应随即退出（未退出时强制结束）
+// 插件的标准错误不重定向。plugins/resident_center.cpp 是按该协议实现的示例插件（可在 Linux 上编译测试）。
+
+const int RESIDENT_PLUGIN_PROTOCOL_VERSION = 1;
+// 插件分区没有给出 timeout= 时，常驻插件每次调用的超时（秒）
+const unsigned int RESIDENT_CALL_TIMEOUT_SECONDS = 60;
+
+// 插件的一次回复
+struct PluginReply {
+    bool ok = false;
+    std::string action;         // clipboard / notify / none
+    std::string payload;
+};
+
+// 一个常驻插件进程（Windows 下 CreateProcess + 匿名管道，其他平台 fork/exec "/bin/sh -c"）
+class ResidentPlugin {
+public:
+    static const unsigned int NO_TIMEOUT = 0xFFFFFFFFu;
+
+    ResidentPlugin();
+    ~ResidentPlugin();      // 仍在运行时调用 stop()
+    ResidentPlugin(const ResidentPlugin&) = delete;
+    ResidentPlugin& operator=(const ResidentPlugin&) = delete;
+
+    // 启动插件并等待握手行，超时、版本不符或进程提前退出时返回 false
+    bool start(const std::string& commandLine, unsigned int timeoutMillis);
+    bool running() const;
+    // 发送一次请求并等待回复。超时、进程退出或回复载荷超过 maxReplyBytes 时结束进程并返回 false
+    bool call(std::string_view kind, std::string_view payload, PluginReply& reply, unsigned int timeoutMillis,
+              size_t maxReplyBytes);
+    // 发送 QUIT，等待 graceMillis 后仍未退出则强制结束
+    void stop(unsigned int graceMillis = 1000);
+    // 让正在等待回复的 call() 尽快放弃（可从其他线程调用），之后需重新 start()
+    void abort();
+    // 调用过 abort() 且之后还没有重新 start()
+    bool aborted() const;
+
+    const std::string& commandLine() const;
+    uint64_t callCount() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// 同步执行一次常驻插件调用（name 对应 config.ini 中的插件分区）：
+// 首次调用或插件进程已退出时启动进程，命令行变化时重启；读取剪贴板，能解析为结构时发送已解析的帧，
+// 否则发送原文；按回复的动作写回剪贴板或通知。回复超过 timeoutSeconds（0 表示
+// RESIDENT_CALL_TIMEOUT_SECONDS）或大于 max_clipboard_chars 时结束插件并立即重启，供下次触发使用。
+// ctx 非空时报告阶段，结果通知交给任务完成消息
+bool runResidentPluginCall(const std::string& name, const std::string& commandLine, unsigned int timeoutSeconds = 0,
+                           JobContext* ctx = nullptr);
+
+// 在后台线程中执行 runResidentPluginCall，立即返回。同一插件已有调用在排队时合并为最后一次
+bool submitResidentPluginCall(const std::string& name, const std::string& commandLine, unsigned int timeoutSeconds);
+
+// 同步执行一次库插件调用（见 plugin_library.h）：首次调用时加载共享库，路径变化时重新加载；
+// 剪贴板能解析为结构时把解析好的帧以只读视图交给插件，回复的处理与常驻插件相同
+bool runLibraryPluginCall(const std::string& name, const std::string& libraryPath, JobContext* ctx = nullptr);
+
+// 在后台线程（与常驻插件共用）中执行 runLibraryPluginCall，立即返回
+bool submitLibraryPluginCall(const std::string& name, const std::string& libraryPath);
+
+// 停止后台线程，让全部常驻插件退出、卸载库插件，停止普通插件的执行管理器并记录其统计（程序退出前调用）
+void shutdownPlugins();
@@ -0,0 +1,315 @@
+#include "plugin_library.h"
+#include "config.h"
+#include "logger.h"
+#include "memory_budget.h"
+#include "xyz_writer.h"
+#include <chrono>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace {
+
+uint64_t elapsedMicros(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                     std::chrono::steady_clock::now() - start).count());
+}
+
+#ifdef _WIN32
+
+typedef HMODULE LibraryHandle;
+
+LibraryHandle openLibrary(const std::string& path, std::string& error) {
+    HMODULE module = LoadLibraryA(path.c_str());
+    if (!module) {
+        error = "LoadLibrary failed (error " + std::to_string(GetLastError()) + ")";
+    }
+    return module;
+}
+
+void* findSymbol(LibraryHandle library, const char* name) {
+    return reinterpret_cast<void*>(GetProcAddress(library, name));
+}
+
+void closeLibrary(LibraryHandle library) {
+    FreeLibrary(library);
+}
+
+#else
+
+typedef void* LibraryHandle;
+
+LibraryHandle openLibrary(const std::string& path, std::string& error) {
+    // 不含路径分隔符的名称会按系统库搜索路径查找，与 LoadLibrary 从当前目录加载的行为不同
+    std::string target = path.find('/') == std::string::npos ? "./" + path : path;
+    void* library = dlopen(target.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!library) {
+        const char* message = dlerror();
+        error = message ? message : "dlopen failed";
+    }
+    return library;
+}
+
+void* findSymbol(LibraryHandle library, const char* name) {
+    return dlsym(library, name);
+}
+
+void closeLibrary(LibraryHandle library) {
+    dlclose(library);
+}
+
+#endif
+
+const char* actionName(int action) {
+    switch (action) {
+        case XYZTRICK_ACTION_CLIPBOARD:
+            return "clipboard";
+        case XYZTRICK_ACTION_NOTIFY:
+            return "notify";
+        default:
+            return "none";
+    }
+}
+
+// 第 i 个元素（stride 为 0 时按 double 紧密排列）
+inline double strided(const double* base, size_t stride, size_t i) {
+    return *reinterpret_cast<const double*>(reinterpret_cast<const char*>(base) + i * stride);
+}
+
+bool frameViewComplete(const xyztrick_frame_view& frame) {
+    if (frame.atom_count > 0 && (!frame.x || !frame.y || !frame.z || !frame.symbols)) {
+        return false;
+    }
+    if (frame.cell_count < 0 || frame.cell_count > 3 || (frame.cell_count > 0 && !frame.cell)) {
+        return false;
+    }
+    return frame.comment || frame.comment_length == 0;
+}
+
+// 宿主传给插件的视图：坐标与电荷直接指向原子数组，只为元素符号建一个指针表
+struct InputViews {
+    std::vector<xyztrick_frame_view> frames;
+    std::vector<const char*> symbols;
+    xyztrick_trajectory_view trajectory{};
+
+    void build(const std::vector<Frame>& source) {
+        size_t totalAtoms = 0;
+        for (const auto& frame : source) {
+            totalAtoms += frame.atoms.size();
+        }
+        frames.resize(source.size());
+        symbols.resize(totalAtoms);
+
+        const char** symbol = symbols.data();
+        for (size_t f = 0; f < source.size(); ++f) {
+            const Frame& frame = source[f];
+            xyztrick_frame_view& view = frames[f];
+            view = xyztrick_frame_view{};
+            view.atom_count = frame.atoms.size();
+            if (!frame.atoms.empty()) {
+                const Atom& first = frame.atoms.front();
+                view.x = &first.x;
+                view.y = &first.y;
+                view.z = &first.z;
+                view.charges = &first.charge;
+                view.stride = sizeof(Atom);
+                view.symbols = symbol;
+                for (const Atom& atom : frame.atoms) {
+                    *symbol++ = atom.symbol.c_str();
+                }
+            }
+            view.cell_count = frame.cell.count;
+            view.cell = frame.cell.count > 0 ? &frame.cell.vectors[0][0] : nullptr;
+            view.comment = frame.comment.data();
+            view.comment_length = frame.comment.size();
+        }
+        trajectory.frame_count = frames.size();
+        trajectory.frames = frames.data();
+    }
+};
+
+} // namespace
+
+bool writeTrajectoryView(const xyztrick_trajectory_view& trajectory, std::string& output) {
+    output.clear();
+    if (trajectory.frame_count == 0 || !trajectory.frames) {
+        return false;
+    }
+    size_t totalRows = 0;
+    for (size_t f = 0; f < trajectory.frame_count; ++f) {
+        const xyztrick_frame_view& frame = trajectory.frames[f];
+        if (!frameViewComplete(frame)) {
+            LOG_ERROR("Plugin returned an incomplete frame view (frame " + std::to_string(f + 1) + ")");
+            return false;
+        }
+        totalRows += frame.atom_count + static_cast<size_t>(frame.cell_count);
+    }
+
+    const XYZWriteOptions options = xyzWriteOptionsFromConfig();
+    TrackedBytes outputBytes;
+    output.reserve(estimateXYZBytes(totalRows, trajectory.frame_count, options.precision));
+    outputBytes.update(output.capacity());
+    {
+        TextSink sink(output);
+        for (size_t f = 0; f < trajectory.frame_count; ++f) {
+            const xyztrick_frame_view& frame = trajectory.frames[f];
+            const size_t stride = frame.stride == 0 ? sizeof(double) : frame.stride;
+            writeXYZHeader(sink, frame.atom_count + static_cast<size_t>(frame.cell_count),
+                           std::string_view(frame.comment ? frame.comment : "", frame.comment_length));
+            for (size_t i = 0; i < frame.atom_count; ++i) {
+                const char* symbol = frame.symbols[i];
+                writeXYZAtomRow(sink, symbol ? symbol : "X", strided(frame.x, stride, i), strided(frame.y, stride, i),
+                                strided(frame.z, stride, i), options);
+            }
+            for (int v = 0; v < frame.cell_count; ++v) {
+                const double* vector = frame.cell + 3 * v;
+                writeXYZAtomRow(sink, "Tv", vector[0], vector[1], vector[2], options);
+            }
+        }
+    }
+    outputBytes.update(output.capacity());
+    return true;
+}
+
+struct PluginLibrary::Impl {
+    LibraryHandle handle = nullptr;
+    const xyztrick_plugin_api* api = nullptr;
+    std::string path;
+    uint64_t loadMicros = 0;
+    LatencyStats latency;
+    InputViews views;           // 保留容量，重复调用时不再分配
+};
+
+PluginLibrary::PluginLibrary() : m_impl(std::make_unique<Impl>()) {}
+
+PluginLibrary::~PluginLibrary() {
+    unload();
+}
+
+bool PluginLibrary::load(const std::string& path) {
+    unload();
+    const auto start = std::chrono::steady_clock::now();
+    std::string error;
+    LibraryHandle handle = openLibrary(path, error);
+    if (!handle) {
+        LOG_ERROR("Failed to load plugin library " + path + ": " + error);
+        return false;
+    }
+
+    auto entry = reinterpret_cast<xyztrick_plugin_entry_fn>(findSymbol(handle, XYZTRICK_PLUGIN_ENTRY_NAME));
+    if (!entry) {
+        LOG_ERROR("Plugin library " + path + " does not export " + std::string(XYZTRICK_PLUGIN_ENTRY_NAME));
+        closeLibrary(handle);
+        return false;
+    }
+    const xyztrick_plugin_api* api = entry(XYZTRICK_PLUGIN_ABI_VERSION);
+    if (!api || api->abi_version != XYZTRICK_PLUGIN_ABI_VERSION || api->struct_size < sizeof(xyztrick_plugin_api) ||
+        !api->run) {
+        LOG_ERROR("Plugin library " + path + " does not support plugin ABI version " +
+                  std::to_string(XYZTRICK_PLUGIN_ABI_VERSION) +
+                  (api ? " (reports version " + std::to_string(api->abi_version) + ")" : ""));
+        closeLibrary(handle);
+        return false;
+    }
+
+    m_impl->handle = handle;
+    m_impl->api = api;
+    m_impl->path = path;
+    m_impl->loadMicros = elapsedMicros(start);
+    m_impl->latency = LatencyStats();
+    LOG_INFO("Loaded plugin library " + path + " (" + name() + ", ABI " + std::to_string(api->abi_version) + ") in " +
+             std::to_string(m_impl->loadMicros) + " us");
+    return true;
+}
+
+bool PluginLibrary::loaded() const {
+    return m_impl->api != nullptr;
+}
+
+void PluginLibrary::unload() {
+    if (!m_impl->handle) {
+        return;
+    }
+    if (m_impl->api->shutdown) {
+        m_impl->api->shutdown();
+    }
+    if (m_impl->latency.count() > 0) {
+        LOG_INFO("Unloading plugin library " + m_impl->path + ", calls: " + m_impl->latency.summary());
+    }
+    closeLibrary(m_impl->handle);
+    m_impl->handle = nullptr;
+    m_impl->api = nullptr;
+}
+
+bool PluginLibrary::call(const std::vector<Frame>* frames, std::string_view clipboardText, PluginReply& reply) {
+    reply = PluginReply();
+    if (!m_impl->api) {
+        reply.payload = "Plugin library is not loaded";
+        return false;
+    }
+    const xyztrick_plugin_api& api = *m_impl->api;
+    const auto start = std::chrono::steady_clock::now();
+
+    const xyztrick_trajectory_view* input = nullptr;
+    if (frames && !frames->empty()) {
+        m_impl->views.build(*frames);
+        input = &m_impl->views.trajectory;
+    }
+    xyztrick_result result{};
+    const int status = api.run(input, clipboardText.data(), clipboardText.size(), &result);
+    const uint64_t runMicros = elapsedMicros(start);
+
+    // 结果中的数组属于插件，格式化完成后才能 release()
+    try {
+        reply.ok = status == XYZTRICK_STATUS_OK;
+        reply.action = actionName(result.action);
+        if (!reply.ok || result.kind == XYZTRICK_RESULT_TEXT) {
+            if (result.text) {
+                reply.payload.assign(result.text, result.text_length);
+            }
+        } else if (result.kind == XYZTRICK_RESULT_TRAJECTORY) {
+            if (!writeTrajectoryView(result.trajectory, reply.payload)) {
+                reply.ok = false;
+                reply.payload = "Plugin returned an invalid trajectory";
+            }
+        }
+    } catch (const std::exception&) {
+        if (api.release) {
+            api.release(&result);
+        }
+        throw;
+    }
+    if (api.release) {
+        api.release(&result);
+    }
+
+    const uint64_t totalMicros = elapsedMicros(start);
+    m_impl->latency.add(totalMicros);
+    LOG_INFO("Plugin library '" + name() + "' returned in " + std::to_string(totalMicros) + " us (run " +
+             std::to_string(runMicros) + " us, " + (input ? std::to_string(input->frame_count) + " frame(s)" : "text") +
+             " in, " + std::to_string(reply.payload.size()) + " bytes out)");
+    return true;
+}
+
+const std::string& PluginLibrary::path() const {
+    return m_impl->path;
+}
+
+std::string PluginLibrary::name() const {
+    if (m_impl->api && m_impl->api->name) {
+        return m_impl->api->name;
+    }
+    return std::filesystem::path(m_impl->path).filename().string();
+}
+
+uint64_t PluginLibrary::loadMicros() const {
+    return m_impl->loadMicros;
+}
+
+const LatencyStats& PluginLibrary::callLatency() const {
+    return m_impl->latency;
+}
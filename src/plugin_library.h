@@ -0,0 +1,44 @@
+#pragma once
+
+#include "core.h"
+#include "pipeline.h"
+#include "plugin_abi.h"
+#include "plugin_host.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 库插件：按 plugin_abi.h 的 C 接口加载到进程内的共享库（Windows 下 LoadLibrary，其他平台 dlopen）。
+// 与常驻插件相比没有进程间通信：已解析的帧以指向原子数组的只读视图交给插件，
+// 插件返回的轨迹视图直接格式化为 XYZ，中间不经过文本往返。
+class PluginLibrary {
+public:
+    PluginLibrary();
+    ~PluginLibrary();       // 已加载时调用 unload()
+    PluginLibrary(const PluginLibrary&) = delete;
+    PluginLibrary& operator=(const PluginLibrary&) = delete;
+
+    // 加载共享库、取得入口并检查 ABI 版本；日志中记录加载耗时
+    bool load(const std::string& path);
+    bool loaded() const;
+    // 调用插件的 shutdown() 后卸载，日志中记录调用次数与延迟百分位
+    void unload();
+
+    // 调用一次插件。frames 为空指针时只传剪贴板原文。结果按 PluginReply 返回：
+    // 文本结果复制到 payload，轨迹结果直接写成多帧 XYZ（精度见 xyz_precision）
+    bool call(const std::vector<Frame>* frames, std::string_view clipboardText, PluginReply& reply);
+
+    const std::string& path() const;
+    std::string name() const;               // 插件自报的名称，未提供时为文件名
+    uint64_t loadMicros() const;
+    const LatencyStats& callLatency() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// 轨迹视图（结果）-> 多帧 XYZ，写入 output（先清空）。视图不完整（数组为空指针等）时返回 false
+bool writeTrajectoryView(const xyztrick_trajectory_view& trajectory, std::string& output);
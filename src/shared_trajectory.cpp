@@ -0,0 +1,281 @@
+#include "shared_trajectory.h"
+#include "config.h"
+#include "logger.h"
+#include "memory_budget.h"
+#include "pipeline.h"
+#include "platform.h"
+#include "trajectory_shm.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using xyztrick::SharedTrajectoryFrame;
+using xyztrick::SharedTrajectoryHeader;
+
+namespace {
+
+uint64_t alignUp(uint64_t value) {
+    return (value + 7) & ~static_cast<uint64_t>(7);
+}
+
+// 按帧计算段内各区的偏移
+SharedTrajectoryHeader layoutFor(const std::vector<Frame>& frames) {
+    SharedTrajectoryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, xyztrick::SHARED_TRAJECTORY_MAGIC, sizeof(header.magic));
+    header.version = xyztrick::SHARED_TRAJECTORY_VERSION;
+    header.headerBytes = sizeof(SharedTrajectoryHeader);
+    header.frameCount = frames.size();
+    for (const auto& frame : frames) {
+        header.atomCount += frame.atoms.size();
+        header.commentBytes += frame.comment.size();
+    }
+    header.framesOffset = sizeof(SharedTrajectoryHeader);
+    header.xOffset = header.framesOffset + header.frameCount * sizeof(SharedTrajectoryFrame);
+    header.yOffset = header.xOffset + header.atomCount * sizeof(double);
+    header.zOffset = header.yOffset + header.atomCount * sizeof(double);
+    header.elementsOffset = header.zOffset + header.atomCount * sizeof(double);
+    header.commentsOffset = alignUp(header.elementsOffset + header.atomCount * sizeof(int32_t));
+    header.totalBytes = header.commentsOffset + header.commentBytes;
+    return header;
+}
+
+int32_t elementId(const std::string& symbol, std::vector<std::pair<std::string_view, int32_t>>& known) {
+    for (const auto& entry : known) {
+        if (entry.first == symbol) {
+            return entry.second;
+        }
+    }
+    const int32_t id = std::max(getAtomicNumber(symbol), 0);
+    known.emplace_back(symbol, id);
+    return id;
+}
+
+// 把帧写入已映射的段：逐原子拆成 x/y/z 与原子序数四个连续数组
+void fillSegment(char* base, const SharedTrajectoryHeader& header, const std::vector<Frame>& frames) {
+    std::memcpy(base, &header, sizeof(header));
+    auto* records = reinterpret_cast<SharedTrajectoryFrame*>(base + header.framesOffset);
+    auto* x = reinterpret_cast<double*>(base + header.xOffset);
+    auto* y = reinterpret_cast<double*>(base + header.yOffset);
+    auto* z = reinterpret_cast<double*>(base + header.zOffset);
+    auto* elements = reinterpret_cast<int32_t*>(base + header.elementsOffset);
+    char* comments = base + header.commentsOffset;
+
+    uint64_t atom = 0;
+    uint64_t commentOffset = 0;
+    // 一个体系中的元素种类很少：已查过的符号线性查找，新符号才走 getAtomicNumber
+    std::vector<std::pair<std::string_view, int32_t>> known;
+    for (size_t f = 0; f < frames.size(); ++f) {
+        const Frame& frame = frames[f];
+        SharedTrajectoryFrame& record = records[f];
+        std::memset(&record, 0, sizeof(record));
+        record.firstAtom = atom;
+        record.atomCount = frame.atoms.size();
+        record.commentOffset = commentOffset;
+        record.commentLength = frame.comment.size();
+        record.cellCount = frame.cell.count;
+        std::memcpy(record.cell, frame.cell.vectors, sizeof(record.cell));
+
+        for (const Atom& source : frame.atoms) {
+            x[atom] = source.x;
+            y[atom] = source.y;
+            z[atom] = source.z;
+            elements[atom] = elementId(source.symbol, known);
+            ++atom;
+        }
+        if (!frame.comment.empty()) {
+            std::memcpy(comments + commentOffset, frame.comment.data(), frame.comment.size());
+        }
+        commentOffset += frame.comment.size();
+    }
+}
+
+#ifdef _WIN32
+
+struct SegmentHandle {
+    HANDLE mapping = NULL;
+};
+
+char* createSegment(const std::string& name, uint64_t bytes, SegmentHandle& segment) {
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, static_cast<DWORD>(bytes >> 32),
+                                        static_cast<DWORD>(bytes & 0xFFFFFFFFu), name.c_str());
+    if (!mapping) {
+        LOG_ERROR("CreateFileMapping failed for " + name + " (error " + std::to_string(GetLastError()) + ")");
+        return nullptr;
+    }
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        LOG_ERROR("Shared memory segment already exists: " + name);
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(bytes));
+    if (!view) {
+        LOG_ERROR("MapViewOfFile failed for " + name + " (error " + std::to_string(GetLastError()) + ")");
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    segment.mapping = mapping;
+    return static_cast<char*>(view);
+}
+
+// 写完后只解除映射，保留句柄使段继续存在
+void finishSegment(char* view, uint64_t) {
+    UnmapViewOfFile(view);
+}
+
+void destroySegment(const std::string&, SegmentHandle& segment) {
+    if (segment.mapping) {
+        CloseHandle(segment.mapping);
+        segment.mapping = NULL;
+    }
+}
+
+#else
+
+struct SegmentHandle {};
+
+char* createSegment(const std::string& name, uint64_t bytes, SegmentHandle&) {
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        LOG_ERROR("shm_open failed for " + name + ": " + std::strerror(errno));
+        return nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        LOG_ERROR("ftruncate failed for " + name + ": " + std::strerror(errno));
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(bytes), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        LOG_ERROR("mmap failed for " + name + ": " + std::strerror(errno));
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+    return static_cast<char*>(view);
+}
+
+void finishSegment(char* view, uint64_t bytes) {
+    munmap(view, static_cast<size_t>(bytes));
+}
+
+void destroySegment(const std::string& name, SegmentHandle&) {
+    shm_unlink(name.c_str());
+}
+
+#endif
+
+std::atomic<unsigned int> g_segmentSequence{0};
+
+} // namespace
+
+struct SharedTrajectorySegment::Impl {
+    SegmentHandle handle;
+    std::string name;
+    size_t size = 0;
+    bool published = false;
+};
+
+SharedTrajectorySegment::SharedTrajectorySegment() : m_impl(std::make_unique<Impl>()) {}
+
+SharedTrajectorySegment::~SharedTrajectorySegment() {
+    close();
+}
+
+bool SharedTrajectorySegment::publish(const std::string& name, const std::vector<Frame>& frames) {
+    close();
+    const SharedTrajectoryHeader header = layoutFor(frames);
+    TrackedBytes segmentBytes;
+    segmentBytes.update(static_cast<size_t>(header.totalBytes));
+
+    char* view = createSegment(name, header.totalBytes, m_impl->handle);
+    if (!view) {
+        return false;
+    }
+    fillSegment(view, header, frames);
+    finishSegment(view, header.totalBytes);
+
+    m_impl->name = name;
+    m_impl->size = static_cast<size_t>(header.totalBytes);
+    m_impl->published = true;
+    return true;
+}
+
+void SharedTrajectorySegment::close() {
+    if (!m_impl->published) {
+        return;
+    }
+    destroySegment(m_impl->name, m_impl->handle);
+    m_impl->published = false;
+    m_impl->size = 0;
+}
+
+bool SharedTrajectorySegment::published() const {
+    return m_impl->published;
+}
+
+const std::string& SharedTrajectorySegment::name() const {
+    return m_impl->name;
+}
+
+size_t SharedTrajectorySegment::size() const {
+    return m_impl->size;
+}
+
+std::string newSharedTrajectoryName() {
+#ifdef _WIN32
+    const std::string prefix = "Local\\xyzTrick-";
+    const unsigned long pid = GetCurrentProcessId();
+#else
+    const std::string prefix = "/xyzTrick-";
+    const unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+    return prefix + std::to_string(pid) + "-" + std::to_string(++g_segmentSequence);
+}
+
+std::unique_ptr<SharedTrajectorySegment> publishClipboardTrajectory(const std::string& pluginName,
+                                                                    std::string& commandLine) {
+    try {
+        std::string text = g_platform.clipboard ? g_platform.clipboard->readText() : "";
+        if (text.empty() || text.size() > g_config.maxClipboardChars) {
+            LOG_WARNING("Clipboard is empty or too large, plugin '" + pluginName + "' starts without shared memory");
+            return nullptr;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        auto segment = std::make_unique<SharedTrajectorySegment>();
+        {
+            MemoryBudget budget(static_cast<size_t>(g_config.maxMemoryMB) * 1024 * 1024);
+            MemoryBudgetScope budgetScope(budget);
+            std::vector<Frame> frames;
+            if (!parseStructureText(std::move(text), frames)) {
+                LOG_INFO("Clipboard is not a structure, plugin '" + pluginName + "' starts without shared memory");
+                return nullptr;
+            }
+            if (!segment->publish(newSharedTrajectoryName(), frames)) {
+                return nullptr;
+            }
+        }
+        const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("Published trajectory for plugin '" + pluginName + "' to " + segment->name() + " (" +
+                 formatMegabytes(segment->size()) + ", " + std::to_string(micros) + " us)");
+
+        commandLine += " " + std::string(xyztrick::SHARED_TRAJECTORY_ARGUMENT) + segment->name();
+        return segment;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to publish trajectory for plugin '" + pluginName + "': " + std::string(e.what()));
+        return nullptr;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "core.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// 共享内存轨迹的发布端（段布局与插件使用的读取器见 trajectory_shm.h）：
+// Windows 下为页面文件支持的命名文件映射（Local\ 命名空间），其他平台为 POSIX 共享内存（shm_open）。
+// Windows 下段在最后一个句柄关闭时消失，因此发布端一直持有句柄，直到 close()。
+class SharedTrajectorySegment {
+public:
+    SharedTrajectorySegment();
+    ~SharedTrajectorySegment();     // 调用 close()
+    SharedTrajectorySegment(const SharedTrajectorySegment&) = delete;
+    SharedTrajectorySegment& operator=(const SharedTrajectorySegment&) = delete;
+
+    // 创建名为 name 的段并写入全部帧（先关闭已发布的段）。同名段已存在或创建失败时返回 false；
+    // 段大小计入当前内存预算，超出时抛出 MemoryBudgetExceeded
+    bool publish(const std::string& name, const std::vector<Frame>& frames);
+    // 释放段（POSIX 下同时 shm_unlink，已打开的读取方不受影响）
+    void close();
+
+    bool published() const;
+    const std::string& name() const;
+    size_t size() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// 新的段名，含进程号与序号（Windows 下为 "Local\xyzTrick-..."，其他平台为 "/xyzTrick-..."）
+std::string newSharedTrajectoryName();
+
+// 普通插件启动前调用：读取并解析剪贴板，发布到新的共享内存段，成功时在 commandLine 末尾追加
+// --xyztrick-shm=<段名> 并返回该段（调用方持有到插件进程结束）。剪贴板不是结构文本或发布失败时
+// 不修改 commandLine 并返回空指针（插件照常启动，可自行读取剪贴板）
+std::unique_ptr<SharedTrajectorySegment> publishClipboardTrajectory(const std::string& pluginName,
+                                                                    std::string& commandLine);
@@ -0,0 +1,356 @@
+#include "temp_cleanup.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+// journal 格式（文本，每行一条，只追加）：
+//   +<到期Unix毫秒>\t<路径>   新增待删除文件
+//   -\t<路径>                 已删除（或文件已不存在）
+// 重放得到仍未删除的文件集合。所有进程读写 journal 前都先锁住 <journal>.lock；
+// 持有 <journal>.owner 的进程接手集合中不属于自己的记录，并在记录堆积时用集合重写 journal。
+
+int64_t currentUnixMillis() {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+}
+
+namespace {
+
+// 删除文件；文件已不存在也视为成功
+bool deleteTempFile(const std::string& path) {
+    std::error_code ec;
+    if (std::filesystem::remove(std::filesystem::path(path), ec)) {
+        return true;
+    }
+    if (ec) {
+        return false;
+    }
+    // remove 返回 false 且无错误：文件不存在
+    return true;
+}
+
+int64_t retryDelayMillis(int attempts) {
+    int64_t delay = TempFileCleanupService::RETRY_BASE_MS;
+    for (int i = 1; i < attempts && delay < TempFileCleanupService::RETRY_MAX_MS; ++i) {
+        delay *= 2;
+    }
+    return std::min(delay, TempFileCleanupService::RETRY_MAX_MS);
+}
+
+// 重放 journal，返回仍未删除的路径及其到期时间；lineCount 为 journal 的记录行数
+std::map<std::string, int64_t> readJournal(const std::string& journalPath, size_t& lineCount) {
+    std::map<std::string, int64_t> pending;
+    lineCount = 0;
+    std::ifstream journal(std::filesystem::path(journalPath), std::ios::binary);
+    if (!journal.is_open()) {
+        return pending;
+    }
+
+    // 同一路径以最后一条记录为准
+    std::string line;
+    while (std::getline(journal, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        size_t tab = line.find('\t');
+        if (line.size() < 2 || tab == std::string::npos) {
+            continue;
+        }
+        lineCount++;
+        std::string path = line.substr(tab + 1);
+        if (line[0] == '+') {
+            try {
+                pending[path] = std::stoll(line.substr(1, tab - 1));
+            } catch (const std::exception&) {
+                continue;
+            }
+        } else if (line[0] == '-') {
+            pending.erase(path);
+        }
+    }
+    return pending;
+}
+
+// 用待删除集合重写 journal（先写临时文件再替换）；集合为空时删除 journal
+void writeJournal(const std::string& journalPath, const std::map<std::string, int64_t>& pending) {
+    try {
+        std::filesystem::path path(journalPath);
+        if (pending.empty()) {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+            return;
+        }
+
+        std::filesystem::path tmpPath = path;
+        tmpPath += ".tmp";
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                LOG_WARNING("Failed to write cleanup journal: " + tmpPath.string());
+                return;
+            }
+            for (const auto& item : pending) {
+                out << '+' << item.second << '\t' << item.first << '\n';
+            }
+        }
+        std::filesystem::rename(tmpPath, path);
+    } catch (const std::exception& e) {
+        LOG_WARNING("Failed to compact cleanup journal: " + std::string(e.what()));
+    }
+}
+
+} // namespace
+
+TempFileCleanupService::TempFileCleanupService() {}
+
+TempFileCleanupService::~TempFileCleanupService() {
+    stop();
+}
+
+bool TempFileCleanupService::start(const std::string& journalPath) {
+    if (m_thread.joinable()) {
+        return true;
+    }
+
+    {
+        LockGuard lock(m_mutex);
+        m_stopping = false;
+        m_journalPath = journalPath;
+        if (!m_journalPath.empty()) {
+            std::error_code ec;
+            std::filesystem::path parent = std::filesystem::path(m_journalPath).parent_path();
+            if (!parent.empty()) {
+                std::filesystem::create_directories(parent, ec);
+            }
+            pollJournal();
+            if (!m_owner.locked()) {
+                LOG_DEBUG("Cleanup journal is owned by another instance; pending deletions are handed off to it");
+            }
+        }
+    }
+
+    if (!m_thread.start([this]() { run(); })) {
+        LOG_ERROR("Failed to start temp file cleanup thread");
+        return false;
+    }
+    LOG_DEBUG("Temp file cleanup service started (" + std::to_string(pendingCount()) + " pending)");
+    return true;
+}
+
+void TempFileCleanupService::finish() {
+    size_t waiting = 0;
+    {
+        LockGuard lock(m_mutex);
+        if (!m_journalPath.empty() && !m_owner.locked()) {
+            // 常驻实例持有 journal：记录都已追加，它在下一次重读 journal 时接手
+            if (m_unattempted > 0) {
+                LOG_INFO("Handing off " + std::to_string(m_unattempted) +
+                         " pending temp file deletion(s) to the resident instance");
+            }
+            return;
+        }
+        waiting = m_unattempted;
+    }
+    if (waiting == 0 || !m_thread.joinable()) {
+        return;
+    }
+
+    LOG_INFO("Waiting for " + std::to_string(waiting) + " temp file(s) to reach their deletion time");
+    while (true) {
+        {
+            LockGuard lock(m_mutex);
+            if (m_unattempted == 0 || (!m_journalPath.empty() && !m_owner.locked())) {
+                return;
+            }
+        }
+        m_attempted.wait(static_cast<unsigned int>(JOURNAL_POLL_MS));
+    }
+}
+
+void TempFileCleanupService::stop() {
+    {
+        LockGuard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.set();
+    m_thread.join();
+
+    LockGuard lock(m_mutex);
+    m_owner.unlock();
+}
+
+void TempFileCleanupService::scheduleDelete(const std::string& filepath, int waitSeconds) {
+    Entry entry;
+    entry.dueMillis = currentUnixMillis() + static_cast<int64_t>(std::max(0, waitSeconds)) * 1000;
+    entry.path = filepath;
+    entry.attempts = 0;
+
+    {
+        LockGuard lock(m_mutex);
+        appendJournal('+', entry);
+        push(entry);
+    }
+    m_wake.set();
+}
+
+size_t TempFileCleanupService::pendingCount() const {
+    LockGuard lock(m_mutex);
+    return m_queue.size();
+}
+
+void TempFileCleanupService::run() {
+    std::vector<Entry> batch;
+    int64_t nextPoll = currentUnixMillis() + JOURNAL_POLL_MS;
+    while (true) {
+        if (currentUnixMillis() >= nextPoll) {
+            LockGuard lock(m_mutex);
+            if (!m_journalPath.empty()) {
+                pollJournal();
+            }
+            nextPoll = currentUnixMillis() + JOURNAL_POLL_MS;
+        }
+
+        unsigned int waitMillis = takeDueBatch(batch);
+        if (waitMillis == 0 && batch.empty()) {
+            break;  // 停止
+        }
+
+        if (batch.empty()) {
+            // 有 journal 时至少每 JOURNAL_POLL_MS 醒来一次，接手其他进程追加的记录
+            int64_t untilPoll = std::max<int64_t>(nextPoll - currentUnixMillis(), 1);
+            if (!m_journalPath.empty() && static_cast<int64_t>(waitMillis) > untilPoll) {
+                waitMillis = static_cast<unsigned int>(untilPoll);
+            }
+            m_wake.wait(waitMillis);
+            continue;
+        }
+
+        int deleted = 0;
+        int retried = 0;
+        for (auto& entry : batch) {
+            bool firstAttempt = entry.attempts == 0;
+            entry.attempts++;
+            LockGuard lock(m_mutex);
+            if (firstAttempt) {
+                m_unattempted--;
+            }
+            if (deleteTempFile(entry.path)) {
+                deleted++;
+                appendJournal('-', entry);
+                m_tracked.erase(entry.path);
+                continue;
+            }
+
+            if (entry.attempts >= MAX_ATTEMPTS) {
+                // 保留在 journal 中，下次启动再清理
+                LOG_WARNING("Giving up deleting temp file for now (still in use): " + entry.path);
+                continue;
+            }
+
+            retried++;
+            entry.dueMillis = currentUnixMillis() + retryDelayMillis(entry.attempts);
+            m_queue.push(entry);
+        }
+
+        LOG_DEBUG("Temp cleanup batch: " + std::to_string(deleted) + " deleted, " +
+                  std::to_string(retried) + " retry later");
+        batch.clear();
+        m_attempted.set();
+    }
+}
+
+unsigned int TempFileCleanupService::takeDueBatch(std::vector<Entry>& batch) {
+    LockGuard lock(m_mutex);
+    if (m_stopping) {
+        return 0;
+    }
+    if (m_queue.empty()) {
+        return Event::INFINITE_WAIT;
+    }
+
+    int64_t now = currentUnixMillis();
+    int64_t firstDue = m_queue.top().dueMillis;
+    if (firstDue > now) {
+        return static_cast<unsigned int>(std::min<int64_t>(firstDue - now, RETRY_MAX_MS));
+    }
+
+    // 把窗口内即将到期的文件一起处理，避免连续多次唤醒
+    while (!m_queue.empty() && m_queue.top().dueMillis <= now + BATCH_WINDOW_MS) {
+        batch.push_back(m_queue.top());
+        m_queue.pop();
+    }
+    return 1;
+}
+
+void TempFileCleanupService::pollJournal() {
+    if (m_owner.locked()) {
+        syncJournal(false);
+        return;
+    }
+    // 之前的持有者（常驻实例或另一个一次性进程）退出后由本进程接手
+    if (m_owner.lock(m_journalPath + ".owner", false)) {
+        syncJournal(true);
+    }
+}
+
+void TempFileCleanupService::syncJournal(bool compact) {
+    FileLockGuard fileLock(m_journalPath + ".lock");
+    if (!fileLock.locked()) {
+        LOG_WARNING("Failed to lock cleanup journal: " + m_journalPath);
+        return;
+    }
+
+    size_t lineCount = 0;
+    std::map<std::string, int64_t> pending = readJournal(m_journalPath, lineCount);
+    size_t adopted = 0;
+    for (const auto& item : pending) {
+        if (m_tracked.count(item.first)) {
+            continue;
+        }
+        Entry entry;
+        entry.dueMillis = item.second;
+        entry.path = item.first;
+        entry.attempts = 0;
+        push(entry);
+        adopted++;
+    }
+    if (adopted > 0) {
+        LOG_INFO("Took over " + std::to_string(adopted) + " pending temp file deletion(s) from journal");
+    }
+
+    // 追加的记录明显多于仍待删除的文件时重写，避免常驻实例的 journal 无限增长
+    if (compact || lineCount > pending.size() * 2 + 64) {
+        writeJournal(m_journalPath, pending);
+    }
+}
+
+void TempFileCleanupService::appendJournal(char op, const Entry& entry) {
+    if (m_journalPath.empty()) {
+        return;
+    }
+
+    FileLockGuard fileLock(m_journalPath + ".lock");
+    if (!fileLock.locked()) {
+        LOG_WARNING("Failed to lock cleanup journal: " + m_journalPath);
+        return;
+    }
+    std::ofstream out(std::filesystem::path(m_journalPath), std::ios::binary | std::ios::app);
+    if (!out.is_open()) {
+        LOG_WARNING("Failed to append cleanup journal: " + m_journalPath);
+        return;
+    }
+    if (op == '+') {
+        out << '+' << entry.dueMillis << '\t' << entry.path << '\n';
+    } else {
+        out << "-\t" << entry.path << '\n';
+    }
+}
+
+void TempFileCleanupService::push(const Entry& entry) {
+    m_tracked.insert(entry.path);
+    m_queue.push(entry);
+    m_unattempted++;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "platform.h"
+#include "threading.h"
+#include <cstdint>
+#include <queue>
+#include <set>
+#include <string>
+#include <vector>
+
+// 临时文件清理服务：一个后台线程 + 按到期时间排序的最小堆，替代每个文件一个睡眠线程。
+// - 到期时间相近（BATCH_WINDOW_MS 内）的文件合并为一批删除
+// - 删除失败（GView 仍占用文件）时按指数退避重试
+// - 待删除记录追加写入 journal 文件，程序异常退出后下次启动时继续清理
+// - 多个进程共用同一个 journal：每次读写都持有 <journal>.lock 文件锁；持有 <journal>.owner 的进程
+//   （通常是常驻实例）定期重读 journal，接手其他进程追加的记录并负责压缩
+class TempFileCleanupService : public TempFileScheduler {
+public:
+    static constexpr int64_t BATCH_WINDOW_MS = 1000;     // 批量合并窗口
+    static constexpr int64_t RETRY_BASE_MS = 2000;       // 第一次重试间隔
+    static constexpr int64_t RETRY_MAX_MS = 60000;       // 重试间隔上限
+    static constexpr int MAX_ATTEMPTS = 8;               // 本次运行内的最大尝试次数
+    static constexpr int64_t JOURNAL_POLL_MS = 5000;     // 重读 journal / 尝试接手 journal 的间隔
+
+    TempFileCleanupService();
+    ~TempFileCleanupService() override;
+
+    // 启动后台线程。journalPath 为空时不做持久化；
+    // 否则若没有其他进程持有 journal，载入其中遗留的记录（已到期的立即删除）并压缩 journal。
+    bool start(const std::string& journalPath);
+    // 一次性运行结束前调用：journal 由其他进程持有时记录已交给它，立即返回；
+    // 否则等待已登记的文件都到期并完成第一次删除尝试（仍被占用的留在 journal 中）
+    void finish();
+    // 停止后台线程并释放 journal，未完成的记录保留在 journal 中
+    void stop();
+
+    void scheduleDelete(const std::string& filepath, int waitSeconds) override;
+
+    size_t pendingCount() const;
+
+private:
+    struct Entry {
+        int64_t dueMillis;      // 到期时间（Unix 毫秒，跨进程有效）
+        std::string path;
+        int attempts;
+    };
+    struct LaterFirst {
+        bool operator()(const Entry& a, const Entry& b) const { return a.dueMillis > b.dueMillis; }
+    };
+
+    void run();
+    // 取出一批到期记录；没有到期记录时返回需要等待的毫秒数
+    unsigned int takeDueBatch(std::vector<Entry>& batch);
+    // 以下函数调用时须持有 m_mutex
+    // 未持有 journal 时尝试接手；已持有时重读 journal，接手其他进程追加的记录
+    void pollJournal();
+    // 在文件锁内重读 journal，把尚未跟踪的记录加入队列；compact 为 true 时随后重写 journal
+    void syncJournal(bool compact);
+    void appendJournal(char op, const Entry& entry);
+    void push(const Entry& entry);
+
+    std::priority_queue<Entry, std::vector<Entry>, LaterFirst> m_queue;
+    std::set<std::string> m_tracked;    // 本进程负责的路径（含放弃重试的，避免重读 journal 时再次接手）
+    size_t m_unattempted = 0;           // 还没做过删除尝试的记录数（finish 等待它归零）
+    mutable Mutex m_mutex;
+    Event m_wake;
+    Event m_attempted;                  // 每处理完一批后置位
+    Thread m_thread;
+    bool m_stopping = false;
+    std::string m_journalPath;
+    FileLock m_owner;                   // 持有 <journal>.owner 即负责接手和压缩 journal
+};
+
+// 当前 Unix 时间（毫秒）
+int64_t currentUnixMillis();
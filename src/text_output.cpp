@@ -0,0 +1,50 @@
+#include "text_output.h"
+
+void TextSink::write(std::string_view text) {
+    if (text.size() <= CHUNK_SIZE - m_used) {
+        std::memcpy(m_chunk + m_used, text.data(), text.size());
+        m_used += text.size();
+        return;
+    }
+    // 比剩余空间大的内容直接交给目标，不再拆块复制
+    flush();
+    if (m_string) {
+        m_string->append(text.data(), text.size());
+    } else if (m_stream) {
+        m_stream->write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+    m_written += text.size();
+}
+
+bool TextSink::flush() {
+    if (m_used > 0) {
+        if (m_string) {
+            m_string->append(m_chunk, m_used);
+        } else if (m_stream) {
+            m_stream->write(m_chunk, static_cast<std::streamsize>(m_used));
+        }
+        m_written += m_used;
+        m_used = 0;
+    }
+    return !m_stream || m_stream->good();
+}
+
+TextSinkStreamBuffer::int_type TextSinkStreamBuffer::overflow(int_type ch) {
+    flushChunk();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize TextSinkStreamBuffer::xsputn(const char* s, std::streamsize count) {
+    if (count <= epptr() - pptr()) {
+        std::memcpy(pptr(), s, static_cast<size_t>(count));
+        pbump(static_cast<int>(count));
+    } else {
+        flushChunk();
+        m_sink.write(std::string_view(s, static_cast<size_t>(count)));
+    }
+    return count;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+// 文本写出器共用的格式化工具：
+// - appendText / appendInteger / appendFixed 用 to_chars 直接格式化到调用方的缓冲区
+//   （与 iostream 的 std::fixed/setprecision/setw 输出一致，但没有流的格式化开销）
+// - TextSink 把格式化好的内容先攒在固定大小的块里，块满时整体追加到字符串或写入流
+// - TextSinkStreamBuffer 让沿用 std::ostream 写法的写出器（Gaussian log）也输出到 TextSink
+
+// 定点数最长的文本：符号 + 309 位整数 + 小数点 + 小数位
+const int MAX_FIXED_PRECISION = 15;
+const size_t MAX_FIXED_CHARS = 1 + 309 + 1 + MAX_FIXED_PRECISION;
+
+// 追加 text，返回新的写入位置
+inline char* appendText(char* out, std::string_view text) {
+    std::memcpy(out, text.data(), text.size());
+    return out + text.size();
+}
+
+// 追加 count 个空格
+inline char* appendSpaces(char* out, size_t count) {
+    std::memset(out, ' ', count);
+    return out + count;
+}
+
+// 追加十进制整数
+template <typename Integer>
+char* appendInteger(char* out, Integer value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    return appendText(out, std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+}
+
+// 按 %<width>.<precision>f 格式化（右对齐，超宽时不截断）；precision 不超过 MAX_FIXED_PRECISION，
+// 调用方保证 out 处至少有 max(width, MAX_FIXED_CHARS) 字节
+inline char* appendFixed(char* out, double value, int precision, size_t width) {
+    char digits[MAX_FIXED_CHARS + 8];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, precision);
+    size_t length = static_cast<size_t>(result.ptr - digits);
+    if (length < width) {
+        out = appendSpaces(out, width - length);
+    }
+    return appendText(out, std::string_view(digits, length));
+}
+
+// 最短可往返的十进制表示（注释中的能量、收敛数据写回时使用）
+inline char* appendShortest(char* out, double value) {
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    return appendText(out, std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+}
+
+// 带缓冲的输出目标
+class TextSink {
+public:
+    static constexpr size_t CHUNK_SIZE = 32 * 1024;
+
+    // 追加到 target（不清空原有内容）
+    explicit TextSink(std::string& target) : m_string(&target) {}
+    // 写入 stream（文件等）
+    explicit TextSink(std::ostream& stream) : m_stream(&stream) {}
+    ~TextSink() { flush(); }
+    TextSink(const TextSink&) = delete;
+    TextSink& operator=(const TextSink&) = delete;
+
+    // 取得至少 bytes 字节（不超过 CHUNK_SIZE）的连续写入空间，写完后用 commit 提交
+    char* reserve(size_t bytes) {
+        if (CHUNK_SIZE - m_used < bytes) {
+            flush();
+        }
+        return m_chunk + m_used;
+    }
+    void commit(char* end) { m_used = static_cast<size_t>(end - m_chunk); }
+
+    void write(std::string_view text);
+    void put(char ch) {
+        if (m_used == CHUNK_SIZE) {
+            flush();
+        }
+        m_chunk[m_used++] = ch;
+    }
+
+    // 把块中内容交给目标，返回目标是否仍然正常（流写入失败时为 false）
+    bool flush();
+    size_t bytesWritten() const { return m_written + m_used; }
+
+private:
+    std::string* m_string = nullptr;
+    std::ostream* m_stream = nullptr;
+    size_t m_used = 0;
+    size_t m_written = 0;
+    char m_chunk[CHUNK_SIZE];
+};
+
+// 以 TextSink 为目标的流缓冲区：先写入栈上的小块，满了再整体交给 sink
+class TextSinkStreamBuffer : public std::streambuf {
+public:
+    explicit TextSinkStreamBuffer(TextSink& sink) : m_sink(sink) {
+        setp(m_chunk, m_chunk + sizeof(m_chunk));
+    }
+    ~TextSinkStreamBuffer() override {
+        flushChunk();
+    }
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* s, std::streamsize count) override;
+    int sync() override {
+        flushChunk();
+        return 0;
+    }
+
+private:
+    void flushChunk() {
+        m_sink.write(std::string_view(pbase(), static_cast<size_t>(pptr() - pbase())));
+        setp(m_chunk, m_chunk + sizeof(m_chunk));
+    }
+
+    TextSink& m_sink;
+    char m_chunk[4096];
+};
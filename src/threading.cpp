@@ -0,0 +1,309 @@
+#include "threading.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+// ========== Win32 实现 ==========
+
+struct Mutex::Impl {
+    CRITICAL_SECTION cs;
+};
+
+Mutex::Mutex() : m_impl(new Impl) {
+    InitializeCriticalSection(&m_impl->cs);
+}
+
+Mutex::~Mutex() {
+    DeleteCriticalSection(&m_impl->cs);
+}
+
+void Mutex::lock() {
+    EnterCriticalSection(&m_impl->cs);
+}
+
+void Mutex::unlock() {
+    LeaveCriticalSection(&m_impl->cs);
+}
+
+struct Event::Impl {
+    HANDLE handle = NULL;
+};
+
+Event::Event(bool manualReset) : m_impl(new Impl) {
+    m_impl->handle = CreateEventA(NULL, manualReset ? TRUE : FALSE, FALSE, NULL);
+}
+
+Event::~Event() {
+    if (m_impl->handle) {
+        CloseHandle(m_impl->handle);
+    }
+}
+
+void Event::set() {
+    SetEvent(m_impl->handle);
+}
+
+void Event::reset() {
+    ResetEvent(m_impl->handle);
+}
+
+bool Event::wait(unsigned int timeoutMillis) {
+    DWORD timeout = timeoutMillis == INFINITE_WAIT ? INFINITE : static_cast<DWORD>(timeoutMillis);
+    return WaitForSingleObject(m_impl->handle, timeout) == WAIT_OBJECT_0;
+}
+
+void* Event::nativeHandle() const {
+    return m_impl->handle;
+}
+
+struct Thread::Impl {
+    HANDLE handle = NULL;
+    std::function<void()> fn;
+};
+
+namespace {
+
+DWORD WINAPI threadEntry(LPVOID lpParam) {
+    std::function<void()>* fn = static_cast<std::function<void()>*>(lpParam);
+    (*fn)();
+    return 0;
+}
+
+} // namespace
+
+Thread::Thread() : m_impl(new Impl) {}
+
+Thread::~Thread() {
+    join();
+}
+
+bool Thread::start(std::function<void()> fn) {
+    if (m_impl->handle) {
+        return false;
+    }
+    m_impl->fn = std::move(fn);
+    m_impl->handle = CreateThread(NULL, 0, threadEntry, &m_impl->fn, 0, NULL);
+    return m_impl->handle != NULL;
+}
+
+void Thread::join() {
+    if (m_impl->handle) {
+        WaitForSingleObject(m_impl->handle, INFINITE);
+        CloseHandle(m_impl->handle);
+        m_impl->handle = NULL;
+    }
+}
+
+bool Thread::joinable() const {
+    return m_impl->handle != NULL;
+}
+
+struct FileLock::Impl {
+    HANDLE handle = INVALID_HANDLE_VALUE;
+};
+
+FileLock::FileLock() : m_impl(new Impl) {}
+
+FileLock::~FileLock() {
+    unlock();
+}
+
+bool FileLock::lock(const std::string& path, bool wait) {
+    unlock();
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_ALWAYS,
+                                FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    OVERLAPPED overlapped = {};
+    DWORD flags = LOCKFILE_EXCLUSIVE_LOCK | (wait ? 0 : LOCKFILE_FAIL_IMMEDIATELY);
+    if (!LockFileEx(handle, flags, 0, 1, 0, &overlapped)) {
+        CloseHandle(handle);
+        return false;
+    }
+    m_impl->handle = handle;
+    return true;
+}
+
+void FileLock::unlock() {
+    if (m_impl->handle != INVALID_HANDLE_VALUE) {
+        OVERLAPPED overlapped = {};
+        UnlockFileEx(m_impl->handle, 0, 1, 0, &overlapped);
+        CloseHandle(m_impl->handle);
+        m_impl->handle = INVALID_HANDLE_VALUE;
+    }
+}
+
+bool FileLock::locked() const {
+    return m_impl->handle != INVALID_HANDLE_VALUE;
+}
+
+void sleepMillis(unsigned int milliseconds) {
+    Sleep(milliseconds);
+}
+
+unsigned int hardwareConcurrency() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? static_cast<unsigned int>(info.dwNumberOfProcessors) : 1u;
+}
+
+#else
+
+// ========== 标准库实现 ==========
+
+struct Mutex::Impl {
+    std::mutex mutex;
+};
+
+Mutex::Mutex() : m_impl(new Impl) {}
+
+Mutex::~Mutex() = default;
+
+void Mutex::lock() {
+    m_impl->mutex.lock();
+}
+
+void Mutex::unlock() {
+    m_impl->mutex.unlock();
+}
+
+struct Event::Impl {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool signaled = false;
+    bool manualReset = false;
+};
+
+Event::Event(bool manualReset) : m_impl(new Impl) {
+    m_impl->manualReset = manualReset;
+}
+
+Event::~Event() = default;
+
+void Event::set() {
+    {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        m_impl->signaled = true;
+    }
+    if (m_impl->manualReset) {
+        m_impl->cv.notify_all();
+    } else {
+        m_impl->cv.notify_one();
+    }
+}
+
+void Event::reset() {
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    m_impl->signaled = false;
+}
+
+bool Event::wait(unsigned int timeoutMillis) {
+    std::unique_lock<std::mutex> lock(m_impl->mutex);
+    auto ready = [this]() { return m_impl->signaled; };
+    if (timeoutMillis == INFINITE_WAIT) {
+        m_impl->cv.wait(lock, ready);
+    } else if (!m_impl->cv.wait_for(lock, std::chrono::milliseconds(timeoutMillis), ready)) {
+        return false;
+    }
+    if (!m_impl->manualReset) {
+        m_impl->signaled = false;
+    }
+    return true;
+}
+
+void* Event::nativeHandle() const {
+    return nullptr;
+}
+
+struct Thread::Impl {
+    std::thread thread;
+};
+
+Thread::Thread() : m_impl(new Impl) {}
+
+Thread::~Thread() {
+    join();
+}
+
+bool Thread::start(std::function<void()> fn) {
+    if (m_impl->thread.joinable()) {
+        return false;
+    }
+    m_impl->thread = std::thread(std::move(fn));
+    return true;
+}
+
+void Thread::join() {
+    if (m_impl->thread.joinable()) {
+        m_impl->thread.join();
+    }
+}
+
+bool Thread::joinable() const {
+    return m_impl->thread.joinable();
+}
+
+struct FileLock::Impl {
+    int fd = -1;
+};
+
+FileLock::FileLock() : m_impl(new Impl) {}
+
+FileLock::~FileLock() {
+    unlock();
+}
+
+bool FileLock::lock(const std::string& path, bool wait) {
+    unlock();
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    int result;
+    do {
+        result = ::flock(fd, LOCK_EX | (wait ? 0 : LOCK_NB));
+    } while (result != 0 && errno == EINTR);
+    if (result != 0) {
+        ::close(fd);
+        return false;
+    }
+    m_impl->fd = fd;
+    return true;
+}
+
+void FileLock::unlock() {
+    if (m_impl->fd >= 0) {
+        ::flock(m_impl->fd, LOCK_UN);
+        ::close(m_impl->fd);
+        m_impl->fd = -1;
+    }
+}
+
+bool FileLock::locked() const {
+    return m_impl->fd >= 0;
+}
+
+void sleepMillis(unsigned int milliseconds) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+}
+
+unsigned int hardwareConcurrency() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1u;
+}
+
+#endif
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+// 线程原语的薄封装。
+// MinGW 交叉编译时 std::thread/std::mutex 依赖 winpthreads，这里在 Windows 下直接使用
+// CRITICAL_SECTION / Event / CreateThread，其他平台使用标准库实现。
+
+// 互斥锁
+class Mutex {
+public:
+    Mutex();
+    ~Mutex();
+    Mutex(const Mutex&) = delete;
+    Mutex& operator=(const Mutex&) = delete;
+
+    void lock();
+    void unlock();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// 作用域锁
+class LockGuard {
+public:
+    explicit LockGuard(Mutex& mutex) : m_mutex(mutex) { m_mutex.lock(); }
+    ~LockGuard() { m_mutex.unlock(); }
+    LockGuard(const LockGuard&) = delete;
+    LockGuard& operator=(const LockGuard&) = delete;
+
+private:
+    Mutex& m_mutex;
+};
+
+// 事件（自动复位：一次 wait 成功后自动清除）
+class Event {
+public:
+    static const unsigned int INFINITE_WAIT = 0xFFFFFFFFu;
+
+    explicit Event(bool manualReset = false);
+    ~Event();
+    Event(const Event&) = delete;
+    Event& operator=(const Event&) = delete;
+
+    void set();
+    void reset();
+    // 等待事件，超时返回 false
+    bool wait(unsigned int timeoutMillis = INFINITE_WAIT);
+    // Windows 下返回事件 HANDLE（可与其他内核对象一起 WaitForMultipleObjects），其他平台为 nullptr
+    void* nativeHandle() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// 工作线程
+class Thread {
+public:
+    Thread();
+    ~Thread();
+    Thread(const Thread&) = delete;
+    Thread& operator=(const Thread&) = delete;
+
+    // 启动线程执行 fn，已在运行时返回 false
+    bool start(std::function<void()> fn);
+    // 等待线程结束
+    void join();
+    bool joinable() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// 跨进程的排他文件锁（Windows 下为 LockFileEx，其他平台为 flock）。
+// 锁文件不存在时创建；进程退出时系统自动释放
+class FileLock {
+public:
+    FileLock();
+    ~FileLock();
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+    // 加锁；wait 为 false 时锁被其他进程持有则立即返回 false
+    bool lock(const std::string& path, bool wait = true);
+    void unlock();
+    bool locked() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// 作用域文件锁（加锁失败时 locked() 为 false，调用方决定是否继续）
+class FileLockGuard {
+public:
+    explicit FileLockGuard(const std::string& path) { m_lock.lock(path); }
+    FileLockGuard(const FileLockGuard&) = delete;
+    FileLockGuard& operator=(const FileLockGuard&) = delete;
+
+    bool locked() const { return m_lock.locked(); }
+
+private:
+    FileLock m_lock;
+};
+
+// 让当前线程休眠
+void sleepMillis(unsigned int milliseconds);
+
+// 逻辑处理器个数（至少为 1）
+unsigned int hardwareConcurrency();
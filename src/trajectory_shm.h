@@ -0,0 +1,222 @@
+#pragma once
+
+// 共享内存轨迹：插件分区中写 shared_memory=true 时，xyzTrick 在启动插件前把剪贴板中已解析的轨迹
+// 写入一个命名共享内存段，并在插件命令行末尾追加 --xyztrick-shm=<段名>。插件直接读取坐标数组，
+// 不必再读剪贴板、解析文本。
+//
+// 本头文件同时是给插件作者的只读读取器：只依赖标准库与系统头文件，复制到插件源码中即可使用。
+//
+//   xyztrick::SharedTrajectoryReader reader;
+//   if (reader.open(name)) {                         // name 为 --xyztrick-shm= 之后的部分
+//       for (uint64_t f = 0; f < reader.frameCount(); ++f) {
+//           xyztrick::SharedFrameView frame = reader.frame(f);
+//           // frame.x[i], frame.y[i], frame.z[i], frame.elements[i]（原子序数，未知元素为 0）
+//       }
+//   }
+//
+// 段布局（版本 1，本机字节序，各数组按 8 字节对齐）：
+//   SharedTrajectoryHeader
+//   SharedTrajectoryFrame[frameCount]         每帧的原子范围、晶胞与注释
+//   double x[atomCount], y[atomCount], z[atomCount]   全部帧的原子首尾相接（SoA）
+//   int32_t elements[atomCount]
+//   char comments[commentBytes]               各帧注释（不以 '\0' 结尾）
+// 段保留到插件进程结束（xyzTrick 退出时也会释放）；已打开的读取器在段释放后仍可读取。
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace xyztrick {
+
+const char SHARED_TRAJECTORY_MAGIC[8] = {'X', 'Y', 'Z', 'T', 'R', 'A', 'J', '\0'};
+const uint32_t SHARED_TRAJECTORY_VERSION = 1;
+const char SHARED_TRAJECTORY_ARGUMENT[] = "--xyztrick-shm=";
+
+struct SharedTrajectoryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerBytes;           // sizeof(SharedTrajectoryHeader)
+    uint64_t totalBytes;            // 整个段的有效字节数
+    uint64_t frameCount;
+    uint64_t atomCount;             // 全部帧的原子总数
+    uint64_t framesOffset;          // 以下偏移均相对段起始
+    uint64_t xOffset;
+    uint64_t yOffset;
+    uint64_t zOffset;
+    uint64_t elementsOffset;
+    uint64_t commentsOffset;
+    uint64_t commentBytes;
+};
+
+struct SharedTrajectoryFrame {
+    uint64_t firstAtom;             // 在坐标数组中的起始下标
+    uint64_t atomCount;
+    uint64_t commentOffset;         // 在注释区中的偏移
+    uint64_t commentLength;
+    int32_t cellCount;              // 晶胞平移矢量个数（0~3）
+    int32_t reserved;
+    double cell[3][3];              // Å
+};
+
+// 一帧的只读视图，指针指向共享内存段，读取器关闭后失效
+struct SharedFrameView {
+    uint64_t atomCount = 0;
+    const double* x = nullptr;
+    const double* y = nullptr;
+    const double* z = nullptr;
+    const int32_t* elements = nullptr;
+    int cellCount = 0;
+    const double (*cell)[3] = nullptr;
+    std::string_view comment;
+};
+
+class SharedTrajectoryReader {
+public:
+    SharedTrajectoryReader() = default;
+    ~SharedTrajectoryReader() { close(); }
+    SharedTrajectoryReader(const SharedTrajectoryReader&) = delete;
+    SharedTrajectoryReader& operator=(const SharedTrajectoryReader&) = delete;
+
+    // 打开并映射段（只读），布局不完整或版本不符时返回 false
+    bool open(const std::string& name) {
+        close();
+#ifdef _WIN32
+        m_mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+        if (!m_mapping) {
+            return false;
+        }
+        m_view = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!m_view) {
+            close();
+            return false;
+        }
+        MEMORY_BASIC_INFORMATION info;
+        m_size = VirtualQuery(m_view, &info, sizeof(info)) ? static_cast<size_t>(info.RegionSize) : 0;
+#else
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        m_size = static_cast<size_t>(st.st_size);
+        void* view = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED) {
+            m_size = 0;
+            return false;
+        }
+        m_view = view;
+#endif
+        if (!validate()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (m_view) {
+            UnmapViewOfFile(m_view);
+        }
+        if (m_mapping) {
+            CloseHandle(m_mapping);
+        }
+        m_mapping = NULL;
+#else
+        if (m_view) {
+            munmap(m_view, m_size);
+        }
+#endif
+        m_view = nullptr;
+        m_size = 0;
+    }
+
+    bool isOpen() const { return m_view != nullptr; }
+    const SharedTrajectoryHeader& header() const { return *static_cast<const SharedTrajectoryHeader*>(m_view); }
+    uint64_t frameCount() const { return header().frameCount; }
+    uint64_t atomCount() const { return header().atomCount; }
+
+    // 全部帧首尾相接的坐标与原子序数数组（长度 atomCount()）
+    const double* x() const { return at<double>(header().xOffset); }
+    const double* y() const { return at<double>(header().yOffset); }
+    const double* z() const { return at<double>(header().zOffset); }
+    const int32_t* elements() const { return at<int32_t>(header().elementsOffset); }
+
+    SharedFrameView frame(uint64_t index) const {
+        const SharedTrajectoryFrame& record = at<SharedTrajectoryFrame>(header().framesOffset)[index];
+        SharedFrameView view;
+        view.atomCount = record.atomCount;
+        view.x = x() + record.firstAtom;
+        view.y = y() + record.firstAtom;
+        view.z = z() + record.firstAtom;
+        view.elements = elements() + record.firstAtom;
+        view.cellCount = record.cellCount;
+        view.cell = record.cell;
+        view.comment = std::string_view(at<char>(header().commentsOffset) + record.commentOffset,
+                                        static_cast<size_t>(record.commentLength));
+        return view;
+    }
+
+private:
+    template <typename T>
+    const T* at(uint64_t offset) const {
+        return reinterpret_cast<const T*>(static_cast<const char*>(m_view) + offset);
+    }
+
+    // 区间 [offset, offset + count * size) 位于段内
+    bool fits(uint64_t offset, uint64_t count, uint64_t size, uint64_t limit) const {
+        return offset <= limit && (size == 0 || count <= (limit - offset) / size);
+    }
+
+    bool validate() const {
+        if (m_size < sizeof(SharedTrajectoryHeader)) {
+            return false;
+        }
+        const SharedTrajectoryHeader& h = header();
+        if (std::memcmp(h.magic, SHARED_TRAJECTORY_MAGIC, sizeof(h.magic)) != 0 ||
+            h.version != SHARED_TRAJECTORY_VERSION || h.headerBytes != sizeof(SharedTrajectoryHeader) ||
+            h.totalBytes > m_size) {
+            return false;
+        }
+        const uint64_t limit = h.totalBytes;
+        if (!fits(h.framesOffset, h.frameCount, sizeof(SharedTrajectoryFrame), limit) ||
+            !fits(h.xOffset, h.atomCount, sizeof(double), limit) || !fits(h.yOffset, h.atomCount, sizeof(double), limit) ||
+            !fits(h.zOffset, h.atomCount, sizeof(double), limit) ||
+            !fits(h.elementsOffset, h.atomCount, sizeof(int32_t), limit) || !fits(h.commentsOffset, h.commentBytes, 1, limit)) {
+            return false;
+        }
+        for (uint64_t f = 0; f < h.frameCount; ++f) {
+            const SharedTrajectoryFrame& record = at<SharedTrajectoryFrame>(h.framesOffset)[f];
+            if (record.firstAtom > h.atomCount || record.atomCount > h.atomCount - record.firstAtom ||
+                record.commentOffset > h.commentBytes || record.commentLength > h.commentBytes - record.commentOffset ||
+                record.cellCount < 0 || record.cellCount > 3) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+#ifdef _WIN32
+    HANDLE m_mapping = NULL;
+#endif
+    void* m_view = nullptr;
+    size_t m_size = 0;
+};
+
+} // namespace xyztrick
@@ -0,0 +1,467 @@
+#include "transcode.h"
+#include "logger.h"
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define XYZ_TRANSCODE_SSE2 1
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <iconv.h>
+#endif
+
+namespace {
+
+const char32_t REPLACEMENT_CHAR = 0xFFFD;
+
+#ifdef XYZ_TRANSCODE_SSE2
+constexpr bool SSE2_AVAILABLE = true;
+#else
+constexpr bool SSE2_AVAILABLE = false;
+#endif
+
+// 8 字节中是否全部为 ASCII（SWAR，无 SIMD 时的退路）
+inline bool isAsciiWord(const unsigned char* p) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return (word & 0x8080808080808080ULL) == 0;
+}
+
+// 写入一个码点的 UTF-8 编码，返回新的写指针
+inline char* encodeUtf8(char32_t cp, char* p) {
+    if (cp < 0x80) {
+        *p++ = static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        *p++ = static_cast<char>(0xC0 | (cp >> 6));
+        *p++ = static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *p++ = static_cast<char>(0xE0 | (cp >> 12));
+        *p++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *p++ = static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        *p++ = static_cast<char>(0xF0 | (cp >> 18));
+        *p++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        *p++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *p++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    return p;
+}
+
+template <bool BigEndian>
+inline char16_t loadUnit16(const unsigned char* p) {
+    return BigEndian ? static_cast<char16_t>((p[0] << 8) | p[1])
+                     : static_cast<char16_t>(p[0] | (p[1] << 8));
+}
+
+template <bool BigEndian>
+inline char32_t loadUnit32(const unsigned char* p) {
+    return BigEndian
+        ? (static_cast<char32_t>(p[0]) << 24) | (static_cast<char32_t>(p[1]) << 16) | (static_cast<char32_t>(p[2]) << 8) | p[3]
+        : (static_cast<char32_t>(p[3]) << 24) | (static_cast<char32_t>(p[2]) << 16) | (static_cast<char32_t>(p[1]) << 8) | p[0];
+}
+
+constexpr bool hostIsBigEndian() {
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__)
+    return __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__;
+#else
+    return false;
+#endif
+}
+
+// UTF-16 字节流 -> UTF-8；units 为码元数，dst 至少有 units * 3 字节。
+// 纯 ASCII 块由 Kernel 决定：SSE2 一次 8 个码元，SWAR 一次 4 个码元，Scalar 逐码元
+template <bool BigEndian, Utf16Kernel Kernel>
+char* decodeUtf16(const unsigned char* src, size_t units, char* dst) {
+    size_t i = 0;
+    while (i < units) {
+#ifdef XYZ_TRANSCODE_SSE2
+        if (Kernel == Utf16Kernel::Best && units - i >= 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+            if (BigEndian) {
+                v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            }
+            const __m128i high = _mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xFF80)));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) == 0xFFFF) {
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(v, v));
+                dst += 8;
+                i += 8;
+                continue;
+            }
+        }
+#endif
+        // 4 个码元装入一个 64 位字：码元的高字节与低字节最高位全为 0 即为 ASCII
+        if ((Kernel == Utf16Kernel::Swar || (Kernel == Utf16Kernel::Best && !SSE2_AVAILABLE)) && units - i >= 4) {
+            uint64_t word;
+            std::memcpy(&word, src + i * 2, sizeof(word));
+            const uint64_t mask = (BigEndian != hostIsBigEndian()) ? 0x80FF80FF80FF80FFULL : 0xFF80FF80FF80FF80ULL;
+            if ((word & mask) == 0) {
+                const size_t low = BigEndian ? 1 : 0;
+                dst[0] = static_cast<char>(src[i * 2 + low]);
+                dst[1] = static_cast<char>(src[i * 2 + 2 + low]);
+                dst[2] = static_cast<char>(src[i * 2 + 4 + low]);
+                dst[3] = static_cast<char>(src[i * 2 + 6 + low]);
+                dst += 4;
+                i += 4;
+                continue;
+            }
+        }
+        char32_t cp = loadUnit16<BigEndian>(src + i * 2);
+        ++i;
+        if (cp >= 0xD800 && cp <= 0xDBFF) {
+            if (i < units) {
+                char32_t low = loadUnit16<BigEndian>(src + i * 2);
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    ++i;
+                } else {
+                    cp = REPLACEMENT_CHAR;
+                }
+            } else {
+                cp = REPLACEMENT_CHAR;
+            }
+        } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+            cp = REPLACEMENT_CHAR;
+        }
+        dst = encodeUtf8(cp, dst);
+    }
+    return dst;
+}
+
+template <bool BigEndian>
+char* decodeUtf16With(Utf16Kernel kernel, const unsigned char* src, size_t units, char* dst) {
+    switch (kernel) {
+        case Utf16Kernel::Swar: return decodeUtf16<BigEndian, Utf16Kernel::Swar>(src, units, dst);
+        case Utf16Kernel::Scalar: return decodeUtf16<BigEndian, Utf16Kernel::Scalar>(src, units, dst);
+        default: return decodeUtf16<BigEndian, Utf16Kernel::Best>(src, units, dst);
+    }
+}
+
+template <bool BigEndian>
+char* decodeUtf32(const unsigned char* src, size_t units, char* dst) {
+    for (size_t i = 0; i < units; ++i) {
+        char32_t cp = loadUnit32<BigEndian>(src + i * 4);
+        if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+            cp = REPLACEMENT_CHAR;
+        }
+        dst = encodeUtf8(cp, dst);
+    }
+    return dst;
+}
+
+// 双字节代码页码表：单字节映射 + 以 (lead << 8 | trail) 为下标的双字节映射，0 表示无效
+struct DbcsTable {
+    bool valid = false;
+    bool isLead[256] = {};
+    char16_t single[256] = {};
+    std::vector<char16_t> pairs;
+};
+
+#ifdef _WIN32
+// 用系统编码器解码一个（单或双字节）字符，仅接受 BMP 单码元结果
+bool systemDecodeChar(unsigned int codePage, const unsigned char* bytes, int length, char16_t& out) {
+    wchar_t wide[4];
+    int written = MultiByteToWideChar(codePage, MB_ERR_INVALID_CHARS,
+        reinterpret_cast<const char*>(bytes), length, wide, 4);
+    if (written != 1) {
+        return false;
+    }
+    out = static_cast<char16_t>(wide[0]);
+    return true;
+}
+
+bool buildDbcsTable(unsigned int codePage, DbcsTable& table) {
+    CPINFO info;
+    if (!GetCPInfo(codePage, &info)) {
+        return false;
+    }
+    auto decode = [codePage](const unsigned char* bytes, int length, char16_t& out) {
+        return systemDecodeChar(codePage, bytes, length, out);
+    };
+#else
+const char* iconvNameFor(unsigned int codePage) {
+    switch (codePage) {
+        case 936: return "CP936";
+        case 950: return "BIG5";
+        case 932: return "CP932";
+        case 949: return "CP949";
+        default: return nullptr;
+    }
+}
+
+bool buildDbcsTable(unsigned int codePage, DbcsTable& table) {
+    const char* name = iconvNameFor(codePage);
+    if (name == nullptr) {
+        return false;
+    }
+    iconv_t cd = iconv_open("UTF-16LE", name);
+    if (cd == reinterpret_cast<iconv_t>(-1)) {
+        return false;
+    }
+    auto decode = [cd](const unsigned char* bytes, int length, char16_t& out) {
+        iconv(cd, nullptr, nullptr, nullptr, nullptr);
+        char inBuf[2] = {static_cast<char>(bytes[0]), length > 1 ? static_cast<char>(bytes[1]) : '\0'};
+        char outBuf[8];
+        char* in = inBuf;
+        char* outPtr = outBuf;
+        size_t inLeft = static_cast<size_t>(length);
+        size_t outLeft = sizeof(outBuf);
+        if (iconv(cd, &in, &inLeft, &outPtr, &outLeft) == static_cast<size_t>(-1) || inLeft != 0 ||
+            sizeof(outBuf) - outLeft != 2) {
+            return false;
+        }
+        out = static_cast<char16_t>(static_cast<unsigned char>(outBuf[0]) | (static_cast<unsigned char>(outBuf[1]) << 8));
+        return true;
+    };
+    struct IconvCloser {
+        iconv_t cd;
+        ~IconvCloser() { iconv_close(cd); }
+    } closer{cd};
+#endif
+
+    table.pairs.assign(256 * 256, 0);
+    for (int b = 0; b < 256; ++b) {
+        unsigned char byte = static_cast<unsigned char>(b);
+        if (b < 0x80) {
+            table.single[b] = static_cast<char16_t>(b);
+            continue;
+        }
+        char16_t value = 0;
+        if (decode(&byte, 1, value)) {
+            table.single[b] = value;
+            continue;
+        }
+
+        // 单独无法解码的高位字节视为前导字节，枚举其所有尾字节
+        bool anyPair = false;
+        for (int t = 0x21; t < 0x100; ++t) {
+            unsigned char pair[2] = {byte, static_cast<unsigned char>(t)};
+            char16_t pairValue = 0;
+            if (decode(pair, 2, pairValue) && pairValue != 0) {
+                table.pairs[(static_cast<size_t>(b) << 8) | static_cast<size_t>(t)] = pairValue;
+                anyPair = true;
+            }
+        }
+        table.isLead[b] = anyPair;
+    }
+
+    table.valid = true;
+    return true;
+}
+
+const DbcsTable& dbcsTableFor(unsigned int codePage) {
+    static DbcsTable invalid;
+    auto build = [](unsigned int cp) {
+        DbcsTable table;
+        if (!buildDbcsTable(cp, table)) {
+            LOG_WARNING("Code page table unavailable: " + std::to_string(cp));
+        }
+        return table;
+    };
+
+    switch (codePage) {
+        case 936: { static const DbcsTable t = build(936); return t; }
+        case 950: { static const DbcsTable t = build(950); return t; }
+        case 932: { static const DbcsTable t = build(932); return t; }
+        case 949: { static const DbcsTable t = build(949); return t; }
+        default: return invalid;
+    }
+}
+
+char* decodeDbcs(const DbcsTable& table, const unsigned char* src, size_t size, char* dst) {
+    size_t i = 0;
+    while (i < size) {
+        // ASCII 段按 8 字节整块拷贝
+        if (size - i >= 8 && isAsciiWord(src + i)) {
+            std::memcpy(dst, src + i, 8);
+            dst += 8;
+            i += 8;
+            continue;
+        }
+
+        unsigned char b = src[i];
+        if (b < 0x80) {
+            *dst++ = static_cast<char>(b);
+            ++i;
+        } else if (!table.isLead[b]) {
+            char16_t value = table.single[b];
+            dst = encodeUtf8(value != 0 ? value : REPLACEMENT_CHAR, dst);
+            ++i;
+        } else if (i + 1 < size) {
+            unsigned char trail = src[i + 1];
+            char16_t value = table.pairs[(static_cast<size_t>(b) << 8) | trail];
+            if (value != 0) {
+                dst = encodeUtf8(value, dst);
+                i += 2;
+            } else {
+                // 非法尾字节：若是 ASCII 则保留给下一轮，避免吞掉换行等字符
+                dst = encodeUtf8(REPLACEMENT_CHAR, dst);
+                i += (trail < 0x80) ? 1 : 2;
+            }
+        } else {
+            dst = encodeUtf8(REPLACEMENT_CHAR, dst);
+            ++i;
+        }
+    }
+    return dst;
+}
+
+// 预留 extra 字节后交给 decoder 直接写入，最后收缩到实际长度
+template <typename Decoder>
+void appendDecoded(std::string& out, size_t extra, Decoder decoder) {
+    size_t oldSize = out.size();
+    out.resize(oldSize + extra);
+    char* begin = &out[0] + oldSize;
+    char* end = decoder(begin);
+    out.resize(oldSize + static_cast<size_t>(end - begin));
+}
+
+} // namespace
+
+void appendUtf16BytesToUtf8(const unsigned char* data, size_t size, bool bigEndian, std::string& out,
+                            Utf16Kernel kernel) {
+    size_t units = size / 2;
+    if (units == 0) {
+        return;
+    }
+    appendDecoded(out, units * 3, [&](char* dst) {
+        return bigEndian ? decodeUtf16With<true>(kernel, data, units, dst) : decodeUtf16With<false>(kernel, data, units, dst);
+    });
+}
+
+bool utf16KernelHasSse2() {
+    return SSE2_AVAILABLE;
+}
+
+void appendUtf16ToUtf8(const char16_t* units, size_t count, std::string& out) {
+    appendUtf16BytesToUtf8(reinterpret_cast<const unsigned char*>(units), count * 2, hostIsBigEndian(), out);
+}
+
+void appendUtf32BytesToUtf8(const unsigned char* data, size_t size, bool bigEndian, std::string& out) {
+    size_t units = size / 4;
+    if (units == 0) {
+        return;
+    }
+    appendDecoded(out, units * 4, [&](char* dst) {
+        return bigEndian ? decodeUtf32<true>(data, units, dst) : decodeUtf32<false>(data, units, dst);
+    });
+}
+
+bool appendDbcsToUtf8(const unsigned char* data, size_t size, unsigned int codePage, std::string& out) {
+    const DbcsTable& table = dbcsTableFor(codePage);
+    if (!table.valid) {
+        return false;
+    }
+    if (size == 0) {
+        return true;
+    }
+    appendDecoded(out, size * 3, [&](char* dst) {
+        return decodeDbcs(table, data, size, dst);
+    });
+    return true;
+}
+
+size_t utf8ToUtf16(const char* data, size_t size, char16_t* dst) {
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(data);
+    char16_t* start = dst;
+    size_t i = 0;
+
+    while (i < size) {
+        if (size - i >= 8 && isAsciiWord(src + i)) {
+            for (int k = 0; k < 8; ++k) {
+                dst[k] = src[i + k];
+            }
+            dst += 8;
+            i += 8;
+            continue;
+        }
+
+        unsigned char b = src[i];
+        char32_t cp = REPLACEMENT_CHAR;
+        size_t length = 1;
+
+        if (b < 0x80) {
+            cp = b;
+        } else if ((b & 0xE0) == 0xC0 && i + 1 < size && (src[i + 1] & 0xC0) == 0x80) {
+            cp = ((b & 0x1Fu) << 6) | (src[i + 1] & 0x3Fu);
+            length = 2;
+            if (cp < 0x80) cp = REPLACEMENT_CHAR;
+        } else if ((b & 0xF0) == 0xE0 && i + 2 < size &&
+                   (src[i + 1] & 0xC0) == 0x80 && (src[i + 2] & 0xC0) == 0x80) {
+            cp = ((b & 0x0Fu) << 12) | ((src[i + 1] & 0x3Fu) << 6) | (src[i + 2] & 0x3Fu);
+            length = 3;
+            if (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF)) cp = REPLACEMENT_CHAR;
+        } else if ((b & 0xF8) == 0xF0 && i + 3 < size &&
+                   (src[i + 1] & 0xC0) == 0x80 && (src[i + 2] & 0xC0) == 0x80 && (src[i + 3] & 0xC0) == 0x80) {
+            cp = ((b & 0x07u) << 18) | ((src[i + 1] & 0x3Fu) << 12) | ((src[i + 2] & 0x3Fu) << 6) | (src[i + 3] & 0x3Fu);
+            length = 4;
+            if (cp < 0x10000 || cp > 0x10FFFF) cp = REPLACEMENT_CHAR;
+        }
+
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            *dst++ = static_cast<char16_t>(0xD800 + (cp >> 10));
+            *dst++ = static_cast<char16_t>(0xDC00 + (cp & 0x3FF));
+        } else {
+            *dst++ = static_cast<char16_t>(cp);
+        }
+        i += length;
+    }
+
+    return static_cast<size_t>(dst - start);
+}
+
+unsigned int dbcsCodePageFor(TextEncoding encoding) {
+    switch (encoding) {
+        case TextEncoding::GBK:
+        case TextEncoding::GB2312:
+            return 936;
+        case TextEncoding::BIG5:
+            return 950;
+        case TextEncoding::SHIFT_JIS:
+            return 932;
+        case TextEncoding::EUC_KR:
+            return 949;
+        default:
+            return 0;
+    }
+}
+
+bool transcodeToUtf8(const unsigned char* data, size_t size, TextEncoding encoding, std::string& out) {
+    switch (encoding) {
+        case TextEncoding::UTF8:
+        case TextEncoding::UTF8_BOM: {
+            size_t offset = (size >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF) ? 3 : 0;
+            out.append(reinterpret_cast<const char*>(data + offset), size - offset);
+            return true;
+        }
+        case TextEncoding::UTF16_LE:
+        case TextEncoding::UTF16_BE: {
+            bool bigEndian = (encoding == TextEncoding::UTF16_BE);
+            size_t offset = (size >= 2 && ((bigEndian && data[0] == 0xFE && data[1] == 0xFF) ||
+                                           (!bigEndian && data[0] == 0xFF && data[1] == 0xFE))) ? 2 : 0;
+            appendUtf16BytesToUtf8(data + offset, size - offset, bigEndian, out);
+            return true;
+        }
+        case TextEncoding::UTF32_LE:
+        case TextEncoding::UTF32_BE: {
+            bool bigEndian = (encoding == TextEncoding::UTF32_BE);
+            size_t offset = 0;
+            if (size >= 4 && loadUnit32<false>(data) == (bigEndian ? 0xFFFE0000u : 0x0000FEFFu)) {
+                offset = 4;
+            }
+            appendUtf32BytesToUtf8(data + offset, size - offset, bigEndian, out);
+            return true;
+        }
+        default: {
+            unsigned int codePage = dbcsCodePageFor(encoding);
+            if (codePage == 0) {
+                return false;
+            }
+            return appendDbcsToUtf8(data, size, codePage, out);
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "encoding.h"
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// 可移植的直接转码模块：源编码 -> UTF-8，不经过 std::wstring 中转。
+// 输出缓冲区按最坏情况一次性预分配，解码结果直接写入，最后收缩到实际长度。
+// 非法序列替换为 U+FFFD（与 MultiByteToWideChar 默认行为一致）。
+
+// UTF-16 解码时纯 ASCII 块的处理方式。Best 在编译器支持 SSE2 时一次处理 8 个码元，否则同 Swar；
+// Swar 用 64 位整数一次处理 4 个码元；Scalar 逐码元解码。其余两种只供基准对比（make bench-transcode）
+enum class Utf16Kernel {
+    Best,
+    Swar,
+    Scalar
+};
+
+// UTF-16 (LE/BE) -> UTF-8，结果追加到 out。units 为 16 位码元个数。
+void appendUtf16ToUtf8(const char16_t* units, size_t count, std::string& out);
+void appendUtf16BytesToUtf8(const unsigned char* data, size_t size, bool bigEndian, std::string& out,
+                            Utf16Kernel kernel = Utf16Kernel::Best);
+// Best 是否为 SSE2 内核
+bool utf16KernelHasSse2();
+
+// UTF-32 (LE/BE) -> UTF-8，结果追加到 out。
+void appendUtf32BytesToUtf8(const unsigned char* data, size_t size, bool bigEndian, std::string& out);
+
+// 双字节代码页（GBK/Big5/Shift-JIS/EUC-KR）-> UTF-8，查表解码。
+// 码表在第一次使用时由系统编码器生成一次并缓存（Windows: MultiByteToWideChar，其他平台: iconv）。
+// 返回 false 表示该代码页的码表不可用。
+bool appendDbcsToUtf8(const unsigned char* data, size_t size, unsigned int codePage, std::string& out);
+
+// UTF-8 -> UTF-16，写入调用方预分配的缓冲区（容量至少为 size 个码元）。
+// 返回写入的码元个数（不含结尾 0）。
+size_t utf8ToUtf16(const char* data, size_t size, char16_t* dst);
+
+// 将任意支持的编码转换为 UTF-8（自动跳过 BOM）。
+// 对于 ANSI / 不支持的代码页返回 false，由调用方回退到系统 API。
+bool transcodeToUtf8(const unsigned char* data, size_t size, TextEncoding encoding, std::string& out);
+
+// 编码对应的 Windows 代码页编号（非双字节编码返回 0）
+unsigned int dbcsCodePageFor(TextEncoding encoding);
@@ -0,0 +1,130 @@
+#include "vdw_radii.h"
+#include "config.h"
+#include "core.h"
+#include "logger.h"
+#include "threading.h"
+#include <fstream>
+
+namespace {
+
+struct BuiltinRadius {
+    const char* symbol;
+    double radius;
+};
+
+// Bondi, J. Phys. Chem. 68, 441 (1964)；Be、B、Al、Ca、Ge、Rb、Sr、Sb、Cs、Ba、Bi、Po、At、Rn、Fr、Ra
+// 取 Mantina 等, J. Phys. Chem. A 113, 5806 (2009)
+constexpr BuiltinRadius BUILTIN_RADII[] = {
+    {"H", 1.20},  {"He", 1.40}, {"Li", 1.82}, {"Be", 1.53}, {"B", 1.92},  {"C", 1.70},  {"N", 1.55},
+    {"O", 1.52},  {"F", 1.47},  {"Ne", 1.54}, {"Na", 2.27}, {"Mg", 1.73}, {"Al", 1.84}, {"Si", 2.10},
+    {"P", 1.80},  {"S", 1.80},  {"Cl", 1.75}, {"Ar", 1.88}, {"K", 2.75},  {"Ca", 2.31}, {"Ni", 1.63},
+    {"Cu", 1.40}, {"Zn", 1.39}, {"Ga", 1.87}, {"Ge", 2.11}, {"As", 1.85}, {"Se", 1.90}, {"Br", 1.85},
+    {"Kr", 2.02}, {"Rb", 3.03}, {"Sr", 2.49}, {"Pd", 1.63}, {"Ag", 1.72}, {"Cd", 1.58}, {"In", 1.93},
+    {"Sn", 2.17}, {"Sb", 2.06}, {"Te", 2.06}, {"I", 1.98},  {"Xe", 2.16}, {"Cs", 3.43}, {"Ba", 2.68},
+    {"Pt", 1.75}, {"Au", 1.66}, {"Hg", 1.55}, {"Tl", 1.96}, {"Pb", 2.02}, {"Bi", 2.07}, {"Po", 1.97},
+    {"At", 2.02}, {"Rn", 2.20}, {"Fr", 3.48}, {"Ra", 2.83}, {"U", 1.86},
+};
+
+constexpr char lowerAscii(char ch) {
+    return ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+// 一两个字母的符号 -> 首字母 * 27 + 第二个字母（没有时为 0），其他返回 -1
+constexpr int symbolIndex(std::string_view symbol) {
+    if (symbol.empty() || symbol.size() > 2) {
+        return -1;
+    }
+    const char first = lowerAscii(symbol[0]);
+    if (first < 'a' || first > 'z') {
+        return -1;
+    }
+    int second = 0;
+    if (symbol.size() == 2) {
+        const char ch = lowerAscii(symbol[1]);
+        if (ch < 'a' || ch > 'z') {
+            return -1;
+        }
+        second = ch - 'a' + 1;
+    }
+    return (first - 'a') * 27 + second;
+}
+
+constexpr std::array<double, 26 * 27> buildBuiltinTable() {
+    std::array<double, 26 * 27> table{};
+    for (size_t i = 0; i < table.size(); ++i) {
+        table[i] = DEFAULT_VDW_RADIUS;
+    }
+    for (const BuiltinRadius& entry : BUILTIN_RADII) {
+        table[static_cast<size_t>(symbolIndex(entry.symbol))] = entry.radius;
+    }
+    return table;
+}
+
+constexpr std::array<double, 26 * 27> BUILTIN_TABLE = buildBuiltinTable();
+
+static_assert(BUILTIN_TABLE[symbolIndex("C")] == 1.70, "vdW radius table index");
+static_assert(BUILTIN_TABLE[symbolIndex("CL")] == 1.75, "vdW radius lookup is case-insensitive");
+
+} // namespace
+
+VdwRadii::VdwRadii() : m_radii(BUILTIN_TABLE) {}
+
+double VdwRadii::radius(std::string_view symbol) const {
+    const int index = symbolIndex(symbol);
+    return index < 0 ? DEFAULT_VDW_RADIUS : m_radii[static_cast<size_t>(index)];
+}
+
+bool VdwRadii::set(std::string_view symbol, double radius) {
+    const int index = symbolIndex(symbol);
+    if (index < 0) {
+        return false;
+    }
+    m_radii[static_cast<size_t>(index)] = radius;
+    return true;
+}
+
+int VdwRadii::loadOverrides(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        return -1;
+    }
+    int count = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::string_view tokens[2];
+        std::string_view text = trimView(line);
+        if (text.empty() || text[0] == '#' || splitWhitespaceViews(text, tokens, 2) < 2) {
+            continue;
+        }
+        double radius = 0.0;
+        if (!parseDouble(tokens[1], radius) || radius <= 0.0 || !set(tokens[0], radius)) {
+            LOG_WARNING("Ignoring vdW radius entry in " + path + ": " + std::string(text));
+            continue;
+        }
+        ++count;
+    }
+    return count;
+}
+
+std::shared_ptr<const VdwRadii> configuredVdwRadii() {
+    static Mutex mutex;
+    static std::string loadedPath;
+    static std::shared_ptr<const VdwRadii> radii;
+
+    const std::string path = g_config.vdwRadiiFile.empty() ? "" : resolveConfigPathForFile(g_config.vdwRadiiFile);
+    LockGuard lock(mutex);
+    if (!radii || path != loadedPath) {
+        auto table = std::make_shared<VdwRadii>();
+        if (!path.empty()) {
+            const int count = table->loadOverrides(path);
+            if (count < 0) {
+                LOG_WARNING("Cannot open vdw_radii_file " + path + ", using built-in radii");
+            } else {
+                LOG_INFO("Loaded " + std::to_string(count) + " vdW radii from " + path);
+            }
+        }
+        radii = std::move(table);
+        loadedPath = path;
+    }
+    return radii;
+}
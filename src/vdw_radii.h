@@ -0,0 +1,34 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// 范德华半径（Å），用于 PQR 输出。
+// 内置表在编译期建好：Bondi (1964) 的数值，Bondi 未给出的主族元素取 Mantina 等 (2009)；
+// 表中没有的元素（多数过渡金属、镧系）与无法识别的符号取 DEFAULT_VDW_RADIUS（与 chg_viewer 相同）。
+// 元素符号不区分大小写（"CL"、"cl" 都是 Cl），按首字母与第二个字母直接索引，不查 map。
+
+const double DEFAULT_VDW_RADIUS = 2.0;
+
+class VdwRadii {
+public:
+    // 内置表
+    VdwRadii();
+
+    double radius(std::string_view symbol) const;
+    // 符号不是一两个字母时返回 false
+    bool set(std::string_view symbol, double radius);
+
+    // 读取覆盖文件：每行 "元素 半径"，空行与 # 开头的行跳过（与 chg_viewer 的 vdw_radii.dat 兼容）。
+    // 返回覆盖的项数，文件无法打开时返回 -1
+    int loadOverrides(const std::string& path);
+
+private:
+    std::array<double, 26 * 27> m_radii;
+};
+
+// 当前配置下的半径表：内置表叠加 vdw_radii_file 中的覆盖项。
+// 配置的路径变化时重新读取；可在多个线程中调用，返回的表不会再被修改
+std::shared_ptr<const VdwRadii> configuredVdwRadii();
@@ -0,0 +1,166 @@
+#include "xml_scan.h"
+#include <cstring>
+
+namespace {
+
+bool isXmlSpace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+bool startsWith(std::string_view text, size_t pos, std::string_view prefix) {
+    return text.size() - pos >= prefix.size() && text.compare(pos, prefix.size(), prefix) == 0;
+}
+
+// 标签名在空白、'/'、'>' 处结束
+size_t scanName(std::string_view text, size_t pos) {
+    while (pos < text.size() && !isXmlSpace(text[pos]) && text[pos] != '/' && text[pos] != '>') {
+        ++pos;
+    }
+    return pos;
+}
+
+} // namespace
+
+bool XmlScanner::skipPast(std::string_view terminator) {
+    size_t end = m_text.find(terminator, m_pos);
+    if (end == std::string_view::npos) {
+        m_pos = m_text.size();
+        return false;
+    }
+    m_pos = end + terminator.size();
+    return true;
+}
+
+bool XmlScanner::next(XmlTag& tag) {
+    while (m_pos < m_text.size()) {
+        const char* start = m_text.data() + m_pos;
+        const char* open = static_cast<const char*>(std::memchr(start, '<', m_text.size() - m_pos));
+        if (!open) {
+            m_pos = m_text.size();
+            return false;
+        }
+        m_pos = static_cast<size_t>(open - m_text.data());
+
+        // 注释、CDATA、处理指令、DOCTYPE：整段跳过
+        if (startsWith(m_text, m_pos, "<!--")) {
+            if (!skipPast("-->")) {
+                return false;
+            }
+            continue;
+        }
+        if (startsWith(m_text, m_pos, "<![CDATA[")) {
+            if (!skipPast("]]>")) {
+                return false;
+            }
+            continue;
+        }
+        if (startsWith(m_text, m_pos, "<?")) {
+            if (!skipPast("?>")) {
+                return false;
+            }
+            continue;
+        }
+        if (startsWith(m_text, m_pos, "<!")) {
+            // DOCTYPE 的内部子集 [...] 中可能含有 '>'
+            size_t bracket = m_text.find('[', m_pos);
+            size_t close = m_text.find('>', m_pos);
+            if (!skipPast(bracket < close ? std::string_view("]>") : std::string_view(">"))) {
+                return false;
+            }
+            continue;
+        }
+
+        size_t pos = m_pos + 1;
+        tag.kind = XmlTagKind::Open;
+        if (pos < m_text.size() && m_text[pos] == '/') {
+            tag.kind = XmlTagKind::Close;
+            ++pos;
+        }
+        size_t nameEnd = scanName(m_text, pos);
+        tag.name = m_text.substr(pos, nameEnd - pos);
+
+        // 找结束的 '>'，跳过引号内的内容
+        size_t i = nameEnd;
+        while (i < m_text.size() && m_text[i] != '>') {
+            char ch = m_text[i];
+            if (ch == '"' || ch == '\'') {
+                const char* quote = static_cast<const char*>(
+                    std::memchr(m_text.data() + i + 1, ch, m_text.size() - i - 1));
+                if (!quote) {
+                    m_pos = m_text.size();
+                    return false;
+                }
+                i = static_cast<size_t>(quote - m_text.data());
+            }
+            ++i;
+        }
+        if (i >= m_text.size()) {
+            m_pos = m_text.size();
+            return false;
+        }
+        m_pos = i + 1;
+
+        size_t attributesEnd = i;
+        if (tag.kind == XmlTagKind::Open && attributesEnd > nameEnd && m_text[attributesEnd - 1] == '/') {
+            tag.kind = XmlTagKind::SelfClosing;
+            --attributesEnd;
+        }
+        tag.attributes = m_text.substr(nameEnd, attributesEnd - nameEnd);
+        if (!tag.name.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string_view xmlLocalName(std::string_view name) {
+    size_t colon = name.rfind(':');
+    return colon == std::string_view::npos ? name : name.substr(colon + 1);
+}
+
+bool nextXmlAttribute(std::string_view attributes, size_t& pos, std::string_view& name, std::string_view& value) {
+    while (pos < attributes.size() && isXmlSpace(attributes[pos])) {
+        ++pos;
+    }
+    size_t nameStart = pos;
+    while (pos < attributes.size() && attributes[pos] != '=' && !isXmlSpace(attributes[pos])) {
+        ++pos;
+    }
+    if (pos == nameStart) {
+        return false;
+    }
+    name = attributes.substr(nameStart, pos - nameStart);
+
+    while (pos < attributes.size() && isXmlSpace(attributes[pos])) {
+        ++pos;
+    }
+    if (pos >= attributes.size() || attributes[pos] != '=') {
+        return false;
+    }
+    ++pos;
+    while (pos < attributes.size() && isXmlSpace(attributes[pos])) {
+        ++pos;
+    }
+    if (pos >= attributes.size() || (attributes[pos] != '"' && attributes[pos] != '\'')) {
+        return false;
+    }
+    const char quote = attributes[pos++];
+    size_t valueEnd = attributes.find(quote, pos);
+    if (valueEnd == std::string_view::npos) {
+        return false;
+    }
+    value = attributes.substr(pos, valueEnd - pos);
+    pos = valueEnd + 1;
+    return true;
+}
+
+bool findXmlAttribute(std::string_view attributes, std::string_view name, std::string_view& value) {
+    size_t pos = 0;
+    std::string_view attributeName;
+    while (nextXmlAttribute(attributes, pos, attributeName, value)) {
+        if (attributeName == name) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+// 流式 XML 扫描：直接在调用方的文本上逐个给出标签，标签名与属性都是指向原文的 string_view，
+// 扫描过程不分配内存。只处理读取结构数据需要的子集：
+// - 注释、处理指令（<?xml ...?>）、DOCTYPE 与 CDATA 整段跳过，标签之间的文本不返回
+// - 属性值可以跨行，值中的 '>' 不会提前结束标签；实体（&amp; 等）不解码
+
+enum class XmlTagKind {
+    Open,           // <atom ...>
+    Close,          // </atom>
+    SelfClosing     // <atom .../>
+};
+
+struct XmlTag {
+    XmlTagKind kind = XmlTagKind::Open;
+    std::string_view name;          // 原样的标签名（可能带命名空间前缀，如 cml:atom）
+    std::string_view attributes;    // 标签名之后、'>'（或 '/>'）之前的原文
+};
+
+class XmlScanner {
+public:
+    explicit XmlScanner(std::string_view text) : m_text(text) {}
+
+    // 取下一个标签；文本结束或最后一个标签不完整时返回 false
+    bool next(XmlTag& tag);
+    // 已扫描到的位置（字节偏移）
+    size_t offset() const { return m_pos; }
+
+private:
+    bool skipPast(std::string_view terminator);
+
+    std::string_view m_text;
+    size_t m_pos = 0;
+};
+
+// 去掉命名空间前缀："cml:atom" -> "atom"
+std::string_view xmlLocalName(std::string_view name);
+
+// 从 pos 开始取下一个属性 name="value" 或 name='value'，value 为引号内的原文；
+// 没有更多属性（或属性不完整）时返回 false。用法：
+//   size_t pos = 0; std::string_view name, value;
+//   while (nextXmlAttribute(tag.attributes, pos, name, value)) { ... }
+bool nextXmlAttribute(std::string_view attributes, size_t& pos, std::string_view& name, std::string_view& value);
+
+// 查找名为 name 的属性（区分大小写）
+bool findXmlAttribute(std::string_view attributes, std::string_view name, std::string_view& value);
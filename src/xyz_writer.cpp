@@ -0,0 +1,168 @@
+#include "xyz_writer.h"
+#include "config.h"
+#include "logger.h"
+#include "memory_budget.h"
+#include <algorithm>
+
+namespace {
+
+// 一行坐标（不含元素符号）所需的最大空间：三列各为分隔空格 + 定点数，外加换行
+const size_t XYZ_COORDINATES_CAPACITY = 3 * (1 + MAX_FIXED_CHARS) + 1;
+// 元素符号不长于此值时与坐标一起写入同一块空间
+const size_t INLINE_SYMBOL_CHARS = 16;
+
+int clampPrecision(int precision) {
+    return std::min(std::max(precision, 0), MAX_FIXED_PRECISION);
+}
+
+// 注释行：换行会破坏帧结构，替换为空格
+void writeCommentLine(TextSink& sink, std::string_view comment) {
+    if (comment.find_first_of("\r\n") == std::string_view::npos) {
+        sink.write(comment);
+    } else {
+        for (char ch : comment) {
+            sink.put(ch == '\r' || ch == '\n' ? ' ' : ch);
+        }
+    }
+    sink.put('\n');
+}
+
+// "<符号,左对齐宽 2> <x> <y> <z>\n"，坐标右对齐、宽 precision + 6
+void writeAtomRow(TextSink& sink, std::string_view symbol, double x, double y, double z, int precision,
+                  size_t width) {
+    char* out;
+    if (symbol.size() <= INLINE_SYMBOL_CHARS) {
+        out = sink.reserve(INLINE_SYMBOL_CHARS + XYZ_COORDINATES_CAPACITY);
+        out = appendText(out, symbol);
+    } else {
+        sink.write(symbol);
+        out = sink.reserve(XYZ_COORDINATES_CAPACITY);
+    }
+    if (symbol.size() < 2) {
+        out = appendSpaces(out, 2 - symbol.size());
+    }
+    const double coordinates[3] = {x, y, z};
+    for (double value : coordinates) {
+        *out++ = ' ';
+        out = appendFixed(out, value, precision, width);
+    }
+    *out++ = '\n';
+    sink.commit(out);
+}
+
+void writeXYZFrames(TextSink& sink, const std::vector<Frame>& frames, const XYZWriteOptions& options) {
+    for (const auto& frame : frames) {
+        writeXYZFrame(sink, frame, options);
+    }
+}
+
+} // namespace
+
+XYZWriteOptions xyzWriteOptionsFromConfig() {
+    XYZWriteOptions options;
+    options.precision = clampPrecision(g_config.xyzPrecision);
+    return options;
+}
+
+std::string formatOptimizationComment(const OptimizationInfo& info) {
+    char text[160];
+    char* out = text;
+    auto appendField = [&out, &text](std::string_view key, double value) {
+        if (out != text) {
+            *out++ = ' ';
+        }
+        out = appendText(out, key);
+        *out++ = '=';
+        out = appendShortest(out, value);
+    };
+    if (info.hasEnergy) {
+        appendField("E", info.energy);
+    }
+    // 未解析到的收敛数据为 -1
+    if (info.maxForce >= 0.0) {
+        appendField("MaxF", info.maxForce);
+    }
+    if (info.rmsForce >= 0.0) {
+        appendField("RMSF", info.rmsForce);
+    }
+    if (info.maxDisp >= 0.0) {
+        appendField("MaxD", info.maxDisp);
+    }
+    if (info.rmsDisp >= 0.0) {
+        appendField("RMSD", info.rmsDisp);
+    }
+    return std::string(text, static_cast<size_t>(out - text));
+}
+
+void writeXYZFrame(TextSink& sink, const Atom* atoms, size_t count, std::string_view comment,
+                   const XYZWriteOptions& options, const UnitCell* cell) {
+    const int precision = clampPrecision(options.precision);
+    const size_t width = static_cast<size_t>(precision) + 6;
+    const int cellVectors = cell ? cell->count : 0;
+
+    writeXYZHeader(sink, count + static_cast<size_t>(cellVectors), comment);
+    for (size_t i = 0; i < count; ++i) {
+        writeAtomRow(sink, atoms[i].symbol, atoms[i].x, atoms[i].y, atoms[i].z, precision, width);
+    }
+    for (int v = 0; v < cellVectors; ++v) {
+        writeAtomRow(sink, "Tv", cell->vectors[v][0], cell->vectors[v][1], cell->vectors[v][2], precision, width);
+    }
+}
+
+void writeXYZHeader(TextSink& sink, size_t count, std::string_view comment) {
+    char* out = sink.reserve(24);
+    out = appendInteger(out, count);
+    *out++ = '\n';
+    sink.commit(out);
+    writeCommentLine(sink, comment);
+}
+
+void writeXYZAtomRow(TextSink& sink, std::string_view symbol, double x, double y, double z,
+                     const XYZWriteOptions& options) {
+    const int precision = clampPrecision(options.precision);
+    writeAtomRow(sink, symbol, x, y, z, precision, static_cast<size_t>(precision) + 6);
+}
+
+void writeXYZFrame(TextSink& sink, const Frame& frame, const XYZWriteOptions& options) {
+    if (options.regenerateComments || frame.comment.empty()) {
+        writeXYZFrame(sink, frame.atoms.data(), frame.atoms.size(), formatOptimizationComment(frame.optInfo), options,
+                      &frame.cell);
+    } else {
+        writeXYZFrame(sink, frame.atoms.data(), frame.atoms.size(), frame.comment, options, &frame.cell);
+    }
+}
+
+bool writeXYZ(const std::vector<Frame>& frames, std::string& output, const XYZWriteOptions& options) {
+    output.clear();
+    if (frames.empty()) {
+        LOG_ERROR("No frames to write");
+        return false;
+    }
+
+    try {
+        // 按原子总数一次预留输出缓冲区，计入内存预算
+        size_t totalAtoms = 0;
+        for (const auto& frame : frames) {
+            totalAtoms += frame.atoms.size();
+        }
+        TrackedBytes outputBytes;
+        output.reserve(estimateXYZBytes(totalAtoms, frames.size(), clampPrecision(options.precision)));
+        outputBytes.update(output.capacity());
+        {
+            TextSink sink(output);
+            writeXYZFrames(sink, frames, options);
+        }
+        outputBytes.update(output.capacity());
+
+        LOG_DEBUG("Wrote " + std::to_string(frames.size()) + " frames (" + std::to_string(totalAtoms) +
+                  " atoms) as XYZ");
+        return true;
+    } catch (const MemoryBudgetExceeded&) {
+        output.clear();
+        throw;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception writing XYZ: " + std::string(e.what()));
+        output.clear();
+        return false;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "core.h"
+#include "text_output.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+// XYZ 写出器：
+// - 坐标用 to_chars 格式化到 TextSink 的块缓冲区，百万原子行也只是逐行追加
+// - 支持多帧；每帧注释行保留原注释，原注释为空（或要求重新生成）时根据 optInfo 写出
+//   "E=... MaxF=... RMSF=... MaxD=... RMSD=..."，parseOptimizationInfo 可原样读回
+// - 输出到任意 TextSink；写入文件和多格式选择见 output_writers.h
+
+struct XYZWriteOptions {
+    int precision = 6;                  // 坐标小数位数（0~MAX_FIXED_PRECISION），列宽为 precision + 6
+    bool regenerateComments = false;    // 总是按 optInfo 重新生成注释行（丢弃原注释）
+};
+
+// 按当前配置（xyz_precision）构造写出选项
+XYZWriteOptions xyzWriteOptionsFromConfig();
+
+// 优化信息 -> 注释行文本；没有任何数据时返回空字符串
+std::string formatOptimizationComment(const OptimizationInfo& info);
+
+// 写出一帧（注释中的换行替换为空格）；有晶胞时在原子后追加 Tv 行，计入头部原子数
+void writeXYZFrame(TextSink& sink, const Atom* atoms, size_t count, std::string_view comment,
+                   const XYZWriteOptions& options, const UnitCell* cell = nullptr);
+void writeXYZFrame(TextSink& sink, const Frame& frame, const XYZWriteOptions& options);
+
+// 逐行写出：坐标不在 Atom 数组中的调用方（如库插件返回的轨迹视图）用这两个函数拼出一帧，格式与 writeXYZFrame 相同。
+// count 为该帧的总行数（含 Tv 行）
+void writeXYZHeader(TextSink& sink, size_t count, std::string_view comment);
+void writeXYZAtomRow(TextSink& sink, std::string_view symbol, double x, double y, double z,
+                     const XYZWriteOptions& options);
+
+// 多帧写入 output（先清空，保留已有容量），失败返回 false
+bool writeXYZ(const std::vector<Frame>& frames, std::string& output, const XYZWriteOptions& options = XYZWriteOptions());
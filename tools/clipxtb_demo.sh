@@ -0,0 +1,55 @@
+#!/bin/sh
+# Runs the host build of clipxtb twice on the same water molecule against tools/xtb_stub.sh:
+# the first run calls "xtb", the second is served from the result cache. Then optimizes a batch of
+# four displaced copies (one of them the cached water) on two cores and checks that the three new
+# structures ran as concurrent single-threaded jobs and that the result is sorted by energy.
+# Usage: tools/clipxtb_demo.sh ./plugins/clipxtb
+set -e
+
+plugin="$1"
+tools=$(cd "$(dirname "$0")" && pwd)
+demo=$(mktemp -d "${TMPDIR:-/tmp}/clipxtb_demo.XXXXXX")
+trap 'rm -rf "$demo"' EXIT
+
+cat > "$demo/xtbclip.ini" <<EOF
+xtb_execpath=$tools/xtb_stub.sh
+tmp_path=$demo
+gfn_type=2
+cache_dir=$demo/cache
+cache_max_mb=16
+cores=2
+EOF
+
+export XTB_STUB_CALLS="$demo/calls.txt"
+for run in 1 2; do
+    printf '3\n0 1\nO 0.0 0.0 0.1173\nH 0.0 0.7572 -0.4692\nH 0.0 -0.7572 -0.4692\n' > "$demo/clipboard.xyz"
+    "$plugin" --config="$demo/xtbclip.ini" --clipboard="$demo/clipboard.xyz" > "$demo/run$run.log" 2>&1
+    grep -E "^(Cache|Total energy)" "$demo/run$run.log"
+done
+
+calls=$(wc -l < "$XTB_STUB_CALLS")
+echo "xtb calls: $calls"
+head -2 "$demo/clipboard.xyz"
+if [ "$calls" -ne 1 ] || ! grep -q "^Cache hit" "$demo/run2.log"; then
+    echo "clipxtb demo: second run was not served from the cache" >&2
+    exit 1
+fi
+
+export XTB_STUB_SECONDS=1
+: > "$XTB_STUB_CALLS"
+: > "$demo/clipboard.xyz"
+for shift in 0.3 0.0 -0.2 0.1; do
+    printf '3\n0 1\nO 0.0 0.0 %s\nH 0.0 0.7572 -0.4692\nH 0.0 -0.7572 -0.4692\n' \
+        $(awk -v s="$shift" 'BEGIN { printf "%.4f", 0.1173 + s }') >> "$demo/clipboard.xyz"
+done
+"$plugin" --config="$demo/xtbclip.ini" --clipboard="$demo/clipboard.xyz" > "$demo/batch.log" 2>&1
+grep -E "^(\[|[0-9]+ of|Lowest)" "$demo/batch.log"
+grep "^energy" "$demo/clipboard.xyz"
+seconds=$(sed -n 's/.* in \([0-9.]*\) s, .*/\1/p' "$demo/batch.log")
+if [ "$(wc -l < "$XTB_STUB_CALLS")" -ne 3 ] || grep -qv "OMP_NUM_THREADS=1$" "$XTB_STUB_CALLS" ||
+   [ "$(grep -c "^energy" "$demo/clipboard.xyz")" -ne 4 ] ||
+   ! grep "^energy" "$demo/clipboard.xyz" | awk '{ print $2 }' | sort -c -n ||
+   ! awk -v s="$seconds" 'BEGIN { exit !(s < 2.9) }'; then
+    echo "clipxtb demo: batch was not split, parallel or sorted as expected" >&2
+    exit 1
+fi
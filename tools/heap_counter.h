@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+
+// 无界面驱动的堆分配计数：heap_counter.cpp 替换全局 operator new / delete 并累计分配次数。
+// 替换函数放在单独的编译单元里，调用方看不到也无法内联其中的 malloc / free，
+// 编译器因此不会把内联后的 free 与未内联的 operator new 当成不配对的分配与释放。
+size_t heapAllocationCount();
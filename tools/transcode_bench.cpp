@@ -0,0 +1,280 @@
+// 转码吞吐量基准（make bench-transcode，主机编译器）：合成文本编码为 UTF-16LE/BE、UTF-32LE/BE、
+// GBK、Big5、Shift-JIS 后，分别计时直接转码（transcodeToUtf8）、convertToUtf8、decodeTextBuffer
+// 与改用直接转码之前的宽字符串两跳路径，按输入字节数给出 MB/s，并核对各路径输出一致；
+// UTF-16 另外对比 SSE2 / SWAR / 逐码元三种 ASCII 块内核。
+//
+// 用法: transcode_bench [每种文本的 MB 数，默认 16] [迭代次数，默认 5]
+// 任一路径的输出与宽字符串路径不一致时退出码为 1
+
+#include "encoding.h"
+#include "transcode.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iconv.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 合成文本的一种组成：ASCII 原子行之间每隔 interval 行插入一行中日文共用汉字注释
+struct TextProfile {
+    const char* name;
+    size_t interval;
+};
+
+// 三种双字节代码页都能表示的汉字（GBK / Big5 / Shift-JIS 同形）
+const char* const CJK_LINE = "\xe5\x88\x86\xe5\xad\x90 \xe8\x83\xbd\xe9\x87\x8f \xe5\x8e\x9f\xe5\xad\x90 "
+                             "\xe5\x88\x86\xe5\xad\x90\xe8\x83\xbd\xe9\x87\x8f\xe5\x8e\x9f\xe5\xad\x90 ";
+
+std::string makeText(size_t bytes, size_t interval) {
+    std::string text;
+    text.reserve(bytes + 256);
+    char line[96];
+    for (size_t i = 0; text.size() < bytes; ++i) {
+        if (i % interval == 0) {
+            text += CJK_LINE;
+            text += std::to_string(i) + "\n";
+        }
+        int n = std::snprintf(line, sizeof(line), "%-2s %14.6f %14.6f %14.6f\n", (i % 3 == 0) ? "C" : (i % 3 == 1 ? "H" : "O"),
+                              0.001 * static_cast<double>(i % 10007), 1.5 * static_cast<double>(i % 97), -0.25 * static_cast<double>(i % 13));
+        text.append(line, static_cast<size_t>(n));
+    }
+    return text;
+}
+
+const iconv_t INVALID_ICONV = reinterpret_cast<iconv_t>(-1);
+
+// iconv 转换；out 为空指针时只计算输出字节数（对应 MultiByteToWideChar 的求长度调用）
+bool iconvConvert(iconv_t cd, const char* data, size_t size, std::string* out, size_t& produced) {
+    iconv(cd, nullptr, nullptr, nullptr, nullptr);
+    char* in = const_cast<char*>(data);
+    size_t inLeft = size;
+    produced = 0;
+    char scratch[65536];
+    while (inLeft > 0) {
+        char* dst = scratch;
+        size_t dstLeft = sizeof(scratch);
+        if (out) {
+            dst = &(*out)[0] + produced;
+            dstLeft = out->size() - produced;
+        }
+        char* before = dst;
+        size_t result = iconv(cd, &in, &inLeft, &dst, &dstLeft);
+        produced += static_cast<size_t>(dst - before);
+        if (result == static_cast<size_t>(-1) && (errno != E2BIG || out)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 改用直接转码之前 convertToUtf8 的做法：源编码 -> 宽字符串 -> UTF-8，两跳各先求长度再转换。
+// 原实现用 MultiByteToWideChar / WideCharToMultiByte，这里用 iconv 的 WCHAR_T 对应
+class WideStringRoute {
+public:
+    explicit WideStringRoute(const char* sourceName)
+        : m_toWide(iconv_open("WCHAR_T", sourceName)), m_toUtf8(iconv_open("UTF-8", "WCHAR_T")) {}
+    ~WideStringRoute() {
+        if (m_toWide != INVALID_ICONV) {
+            iconv_close(m_toWide);
+        }
+        if (m_toUtf8 != INVALID_ICONV) {
+            iconv_close(m_toUtf8);
+        }
+    }
+    WideStringRoute(const WideStringRoute&) = delete;
+    WideStringRoute& operator=(const WideStringRoute&) = delete;
+
+    bool valid() const { return m_toWide != INVALID_ICONV && m_toUtf8 != INVALID_ICONV; }
+
+    bool convert(const std::vector<unsigned char>& buffer, std::string& utf8) {
+        const char* data = reinterpret_cast<const char*>(buffer.data());
+        size_t wideBytes = 0;
+        if (!iconvConvert(m_toWide, data, buffer.size(), nullptr, wideBytes)) {
+            return false;
+        }
+        std::wstring wide(wideBytes / sizeof(wchar_t), L'\0');
+        std::string wideView(reinterpret_cast<char*>(&wide[0]), wideBytes);
+        size_t written = 0;
+        if (!iconvConvert(m_toWide, data, buffer.size(), &wideView, written)) {
+            return false;
+        }
+        size_t utf8Bytes = 0;
+        if (!iconvConvert(m_toUtf8, wideView.data(), written, nullptr, utf8Bytes)) {
+            return false;
+        }
+        utf8.assign(utf8Bytes, '\0');
+        return iconvConvert(m_toUtf8, wideView.data(), written, &utf8, written);
+    }
+
+private:
+    iconv_t m_toWide;
+    iconv_t m_toUtf8;
+};
+
+struct Subject {
+    const char* name;
+    TextEncoding encoding;
+    const char* iconvName;      // 合成输入与宽字符路径使用的 iconv 编码名
+    const unsigned char* bom;
+    size_t bomSize;
+};
+
+const unsigned char BOM_UTF16LE[] = {0xFF, 0xFE};
+const unsigned char BOM_UTF16BE[] = {0xFE, 0xFF};
+const unsigned char BOM_UTF32LE[] = {0xFF, 0xFE, 0x00, 0x00};
+const unsigned char BOM_UTF32BE[] = {0x00, 0x00, 0xFE, 0xFF};
+
+const Subject SUBJECTS[] = {
+    {"UTF-16LE", TextEncoding::UTF16_LE, "UTF-16LE", BOM_UTF16LE, sizeof(BOM_UTF16LE)},
+    {"UTF-16BE", TextEncoding::UTF16_BE, "UTF-16BE", BOM_UTF16BE, sizeof(BOM_UTF16BE)},
+    {"UTF-32LE", TextEncoding::UTF32_LE, "UTF-32LE", BOM_UTF32LE, sizeof(BOM_UTF32LE)},
+    {"UTF-32BE", TextEncoding::UTF32_BE, "UTF-32BE", BOM_UTF32BE, sizeof(BOM_UTF32BE)},
+    {"GBK", TextEncoding::GBK, "CP936", nullptr, 0},
+    {"Big5", TextEncoding::BIG5, "BIG5", nullptr, 0},
+    {"Shift-JIS", TextEncoding::SHIFT_JIS, "CP932", nullptr, 0},
+};
+
+bool encodeText(const std::string& utf8, const Subject& subject, std::vector<unsigned char>& buffer) {
+    iconv_t cd = iconv_open(subject.iconvName, "UTF-8");
+    if (cd == INVALID_ICONV) {
+        return false;
+    }
+    std::string encoded(utf8.size() * 4, '\0');
+    size_t produced = 0;
+    bool ok = iconvConvert(cd, utf8.data(), utf8.size(), &encoded, produced);
+    iconv_close(cd);
+    if (!ok) {
+        return false;
+    }
+    buffer.assign(subject.bom, subject.bom + subject.bomSize);
+    buffer.insert(buffer.end(), encoded.begin(), encoded.begin() + static_cast<std::ptrdiff_t>(produced));
+    return true;
+}
+
+double medianMillis(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    return samples.empty() ? 0.0 : samples[samples.size() / 2];
+}
+
+// 计时 iterations 次，按中位数给出输入吞吐量；输出与 expected 不一致时记为失败。
+// 默认每次从空字符串开始（与调用方相同，含输出缓冲区的分配与缺页）；warm 时保留上一次的容量，只计解码本身
+bool measure(const char* label, size_t inputBytes, int iterations, const std::string& expected,
+             const std::function<bool(std::string&)>& run, double* megabytesPerSecond = nullptr, bool warm = false) {
+    std::vector<double> samples;
+    std::string output;
+    bool ok = true;
+    for (int i = 0; i < iterations && ok; ++i) {
+        output.clear();
+        if (!warm) {
+            output.shrink_to_fit();
+        }
+        auto start = std::chrono::steady_clock::now();
+        ok = run(output);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        samples.push_back(std::chrono::duration<double, std::milli>(elapsed).count());
+    }
+    if (ok && output != expected) {
+        ok = false;
+    }
+    const double millis = std::max(medianMillis(samples), 0.001);
+    const double rate = static_cast<double>(inputBytes) / (1024.0 * 1024.0) / (millis / 1000.0);
+    if (megabytesPerSecond) {
+        *megabytesPerSecond = rate;
+    }
+    char line[160];
+    std::snprintf(line, sizeof(line), "  %-30s %9.1f MB/s  (p50 %.2f ms)%s", label, rate, millis, ok ? "" : "  OUTPUT MISMATCH");
+    std::cout << line << std::endl;
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t megabytes = argc > 1 ? std::max<size_t>(1, std::strtoull(argv[1], nullptr, 10)) : 16;
+    const int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+    const TextProfile PROFILES[] = {
+        {"xyz", 1000},          // 剪贴板中常见的内容：几乎全是 ASCII，每帧一行汉字注释
+        {"cjk", 1},             // 汉字与 ASCII 行交替，ASCII 块快速路径较少命中
+    };
+    const size_t targetBytes = megabytes * 1024 * 1024;
+    std::cout << "Transcoding benchmark: " << megabytes << " MB of UTF-8 text per profile, " << iterations
+              << " iteration(s), MB/s of encoded input at p50" << std::endl;
+    std::cout << "UTF-16 Best kernel: " << (utf16KernelHasSse2() ? "SSE2" : "SWAR (no SSE2 in this build)") << std::endl;
+
+    bool allOk = true;
+    for (const TextProfile& profile : PROFILES) {
+        const std::string text = makeText(targetBytes, profile.interval);
+        std::cout << "\nprofile " << profile.name << ":" << std::endl;
+        for (const Subject& subject : SUBJECTS) {
+            std::vector<unsigned char> buffer;
+            if (!encodeText(text, subject, buffer)) {
+                std::cout << subject.name << ": iconv cannot encode, skipped" << std::endl;
+                continue;
+            }
+            std::cout << subject.name << " (" << buffer.size() / 1024 << " KB):" << std::endl;
+            // 旧实现把 BOM 作为 U+FEFF 带入文本，这里跳过 BOM，以便与新路径比较输出
+            WideStringRoute wideRoute(subject.iconvName);
+            const std::vector<unsigned char> withoutBom(buffer.begin() + static_cast<std::ptrdiff_t>(subject.bomSize), buffer.end());
+            if (wideRoute.valid()) {
+                allOk &= measure("wide-string route", buffer.size(), iterations, text,
+                                 [&](std::string& out) { return wideRoute.convert(withoutBom, out); });
+            }
+            allOk &= measure("transcodeToUtf8", buffer.size(), iterations, text, [&](std::string& out) {
+                return transcodeToUtf8(buffer.data(), buffer.size(), subject.encoding, out);
+            });
+            allOk &= measure("convertToUtf8", buffer.size(), iterations, text, [&](std::string& out) {
+                out = convertToUtf8(buffer, subject.encoding);
+                return !out.empty();
+            });
+            // decodeTextBuffer 自行检测编码：只有检测结果正确时计时（无 BOM 的双字节文本按 ANSI，即 GBK 解码）
+            const TextEncoding detected = decodeTextBuffer(buffer).encoding;
+            const bool detectedRight = detected == subject.encoding ||
+                                       (subject.encoding == TextEncoding::GBK && detected == TextEncoding::ANSI);
+            if (detectedRight) {
+                allOk &= measure("decodeTextBuffer", buffer.size(), iterations, text, [&](std::string& out) {
+                    out = decodeTextBuffer(buffer).content;
+                    return true;
+                });
+            } else {
+                std::cout << "  decodeTextBuffer               not timed: input is detected as "
+                          << encodingToString(detected) << std::endl;
+            }
+            if (subject.encoding == TextEncoding::UTF16_LE || subject.encoding == TextEncoding::UTF16_BE) {
+                const bool bigEndian = subject.encoding == TextEncoding::UTF16_BE;
+                const struct {
+                    const char* name;
+                    Utf16Kernel kernel;
+                } kernels[] = {
+                    {utf16KernelHasSse2() ? "SSE2" : "Best", Utf16Kernel::Best},
+                    {"SWAR", Utf16Kernel::Swar},
+                    {"scalar", Utf16Kernel::Scalar},
+                };
+                double rates[2][3] = {};
+                for (int warm = 0; warm < 2; ++warm) {
+                    for (int k = 0; k < 3; ++k) {
+                        const std::string label = std::string("kernel ") + kernels[k].name + (warm ? ", warm output" : ", fresh output");
+                        allOk &= measure(label.c_str(), buffer.size(), iterations, text, [&](std::string& out) {
+                            appendUtf16BytesToUtf8(buffer.data() + subject.bomSize, buffer.size() - subject.bomSize, bigEndian,
+                                                   out, kernels[k].kernel);
+                            return true;
+                        }, &rates[warm][k], warm != 0);
+                    }
+                }
+                char verdict[160];
+                std::snprintf(verdict, sizeof(verdict), "  %s vs SWAR / scalar: %.2fx / %.2fx fresh, %.2fx / %.2fx warm",
+                              kernels[0].name, rates[0][0] / rates[0][1], rates[0][0] / rates[0][2], rates[1][0] / rates[1][1],
+                              rates[1][0] / rates[1][2]);
+                std::cout << verdict << std::endl;
+            }
+        }
+    }
+    std::cout << (allOk ? "\nAll outputs match the wide-string route." : "\nSome outputs differ, see OUTPUT MISMATCH above.")
+              << std::endl;
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,25 @@
+#!/bin/sh
+# Stand-in for xtb when exercising clipxtb without a real installation (see make clipxtb-demo).
+# Called like xtb: xtb_stub.sh <structure.xyz> --opt [flags...] in the working directory.
+# Writes xtbopt.xyz with the input coordinates and a fake energy derived from them, prints a
+# TOTAL ENERGY line, and appends one line per call to $XTB_STUB_CALLS when it is set.
+# $XTB_STUB_SECONDS makes each call take that long.
+
+input="$1"
+if [ ! -f "$input" ]; then
+    echo "xtb_stub: cannot read $input" >&2
+    exit 1
+fi
+
+if [ -n "$XTB_STUB_CALLS" ]; then
+    echo "$* OMP_NUM_THREADS=${OMP_NUM_THREADS:-unset}" >> "$XTB_STUB_CALLS"
+fi
+if [ -n "$XTB_STUB_SECONDS" ]; then
+    sleep "$XTB_STUB_SECONDS"
+fi
+
+energy=$(awk 'NR > 2 && NF >= 4 { sum += $2 + 2 * $3 + 3 * $4; n++ } END { printf "%.12f", -1.0 * n - 0.001 * sum }' "$input")
+awk -v e="$energy" 'NR == 1 { print; next } NR == 2 { printf " energy: %s gnorm: 0.000100000000 xtb: stub\n", e; next } { print }' "$input" > xtbopt.xyz
+
+echo "          | TOTAL ENERGY             $energy Eh   |"
+echo "normal termination of xtb_stub"
@@ -0,0 +1,406 @@
+// 无界面驱动：在 Linux 上用内存平台实现运行两个热键流程并输出延迟百分位
+//
+// 用法: xyz_headless <xyz或chg文件> [迭代次数] [gaussian_clipboard文件]
+//   - 文件内容放入内存剪贴板，重复执行 processClipboardXYZToGView
+//   - 输入为 XYZ 轨迹时，再把解析出的各帧重复写成每种已注册格式，XYZ 输出读回核对往返结果
+//   - 给出 Clipboard.frg 时再重复执行 processGViewClipboardToXYZ
+//   - 输入写成 --synthetic=原子数[x帧数][p] 时生成合成轨迹（如 --synthetic=1000000 为百万原子单帧基准），
+//     带 p 后缀时每帧附带三条 Tv 晶胞矢量
+//   - 帧带三维晶胞时，在副本上计时周期性包裹与展开
+//   - 对比把轨迹交给外部插件的两种方式：共享内存段（trajectory_shm.h）与剪贴板 XYZ 文本
+//   - 任意位置给出 --plugin=命令 时，把该命令作为常驻插件启动，重复调用并统计往返延迟
+//     （首次调用含进程启动；如 --plugin=plugins/resident_center，见 make plugin-demo）
+//   - 任意位置给出 --plugin-library=路径 时，把该共享库作为库插件加载，同样重复调用并统计延迟
+
+#include "platform.h"
+#include "platform_memory.h"
+#include "clipboard_watcher.h"
+#include "pipeline.h"
+#include "config.h"
+#include "converter.h"
+#include "output_writers.h"
+#include "periodic.h"
+#include "plugin_executor.h"
+#include "plugin_host.h"
+#include "shared_trajectory.h"
+#include "trajectory_shm.h"
+#include "xyz_writer.h"
+#include "core.h"
+#include "heap_counter.h"
+#include "logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+bool readWholeFile(const std::string& path, std::string& content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::ostringstream oss;
+    oss << file.rdbuf();
+    content = oss.str();
+    return true;
+}
+
+// 生成合成 XYZ 轨迹：atoms 个原子（C/H/O 交替）排成立方格点，每帧整体平移一点。
+// periodic 时附加刚好容纳格点的立方晶胞（Tv 行），平移后的原子逐渐越过边界
+std::string makeSyntheticXYZ(size_t atoms, size_t frames, bool periodic) {
+    static const char* const SYMBOLS[] = {"C", "H", "O"};
+    std::string content;
+    content.reserve(frames * (atoms * 48 + 64));
+    size_t side = 1;
+    while (side * side * side < atoms) {
+        ++side;
+    }
+    char line[96];
+    const double box = 1.5 * static_cast<double>(side);
+    for (size_t f = 0; f < frames; ++f) {
+        content += std::to_string(periodic ? atoms + 3 : atoms) + "\n";
+        content += "synthetic frame " + std::to_string(f + 1) + " E=" + std::to_string(-100.0 - 0.001 * f) + "\n";
+        for (size_t i = 0; i < atoms; ++i) {
+            double x = 1.5 * static_cast<double>(i % side) + 0.01 * f;
+            double y = 1.5 * static_cast<double>((i / side) % side);
+            double z = 1.5 * static_cast<double>(i / (side * side));
+            int n = std::snprintf(line, sizeof(line), "%-2s %14.6f %14.6f %14.6f\n", SYMBOLS[i % 3], x, y, z);
+            content.append(line, static_cast<size_t>(n));
+        }
+        for (int v = 0; periodic && v < 3; ++v) {
+            int n = std::snprintf(line, sizeof(line), "Tv %14.6f %14.6f %14.6f\n", v == 0 ? box : 0.0,
+                                  v == 1 ? box : 0.0, v == 2 ? box : 0.0);
+            content.append(line, static_cast<size_t>(n));
+        }
+    }
+    return content;
+}
+
+// 执行 iterations 次流程并统计延迟，返回成功次数（prepare 在计时之前执行）
+template <typename Prepare, typename Fn>
+int runPipeline(const char* name, int iterations, Clock& clock, Prepare&& prepare, Fn&& fn, LatencyStats& stats) {
+    int succeeded = 0;
+    size_t firstAllocations = 0;
+    size_t lastAllocations = 0;
+    for (int i = 0; i < iterations; ++i) {
+        prepare();
+        size_t allocationsBefore = heapAllocationCount();
+        uint64_t start = clock.nowMicros();
+        bool ok = fn();
+        stats.add(clock.nowMicros() - start);
+        lastAllocations = heapAllocationCount() - allocationsBefore;
+        if (i == 0) {
+            firstAllocations = lastAllocations;
+        }
+        if (ok) {
+            ++succeeded;
+        }
+    }
+    std::cout << name << ": " << succeeded << "/" << iterations << " ok, " << stats.summary() << std::endl;
+    std::cout << "  heap allocations per run: first=" << firstAllocations << " steady=" << lastAllocations << std::endl;
+    return succeeded;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    std::string pluginCommand;
+    std::string pluginLibrary;
+    const std::string pluginPrefix = "--plugin=";
+    const std::string libraryPrefix = "--plugin-library=";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, pluginPrefix.size(), pluginPrefix) == 0) {
+            pluginCommand = arg.substr(pluginPrefix.size());
+        } else if (arg.compare(0, libraryPrefix.size(), libraryPrefix) == 0) {
+            pluginLibrary = arg.substr(libraryPrefix.size());
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (args.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <xyz-or-chg-file | --synthetic=ATOMS[xFRAMES][p]> [iterations] [gaussian-clipboard-file] [--plugin=COMMAND] [--plugin-library=PATH]" << std::endl;
+        return 2;
+    }
+
+    std::string inputPath = args[0];
+    int iterations = args.size() > 1 ? std::max(1, std::atoi(args[1].c_str())) : 100;
+    std::string clipboardFile = args.size() > 2 ? args[2] : "";
+
+    std::string content;
+    const std::string syntheticPrefix = "--synthetic=";
+    if (inputPath.compare(0, syntheticPrefix.size(), syntheticPrefix) == 0) {
+        std::string spec = inputPath.substr(syntheticPrefix.size());
+        size_t atoms = std::strtoull(spec.c_str(), nullptr, 10);
+        size_t frames = 1;
+        size_t xPos = spec.find('x');
+        if (xPos != std::string::npos) {
+            frames = std::max<size_t>(1, std::strtoull(spec.c_str() + xPos + 1, nullptr, 10));
+        }
+        if (atoms == 0) {
+            std::cerr << "Invalid synthetic size: " << spec << std::endl;
+            return 2;
+        }
+        content = makeSyntheticXYZ(atoms, frames, !spec.empty() && spec.back() == 'p');
+        std::cout << "synthetic input: " << frames << " frame(s) x " << atoms << " atoms, "
+                  << content.size() / (1024 * 1024) << " MB" << std::endl;
+    } else if (!readWholeFile(inputPath, content)) {
+        std::cerr << "Cannot read " << inputPath << std::endl;
+        return 1;
+    }
+
+    g_logger.setLogToFile(false);
+    g_logger.setLogToConsole(false);
+
+    // 内存平台
+    SteadyClock clock;
+    MemoryClipboard clipboard;
+    FakeProcessLauncher launcher;
+    RecordingTempFileScheduler tempFiles;
+    RecordingNotifier notifier;
+    g_platform.clipboard = &clipboard;
+    g_platform.launcher = &launcher;
+    g_platform.clock = &clock;
+    g_platform.tempFiles = &tempFiles;
+    g_platform.notifier = &notifier;
+
+    std::filesystem::path tempDir = std::filesystem::temp_directory_path() / "xyz_headless";
+    g_config.tempDir = tempDir.string();
+    g_config.gviewPath = "gview";
+    g_config.maxClipboardChars = calculateMaxChars(g_config.maxMemoryMB);
+
+    int failures = 0;
+
+    LatencyStats forward;
+    int ok = runPipeline("xyz->gview", iterations, clock, []() {}, [&]() {
+        clipboard.setText(content);
+        bool result = processClipboardXYZToGView();
+        tempFiles.flush();
+        return result;
+    }, forward);
+    failures += iterations - ok;
+
+    // 多格式写出：只解析一次，每种格式格式化到复用的字符串；XYZ 输出再读回核对帧数与原子数
+    std::vector<Frame> frames = readMultiXYZ(content);
+    if (!frames.empty()) {
+        size_t totalAtoms = 0;
+        for (const auto& frame : frames) {
+            totalAtoms += frame.atoms.size();
+        }
+        std::string converted;
+        for (const auto& writer : outputWriters()) {
+            std::string name = "frames->" + writer.name;
+            LatencyStats written;
+            ok = runPipeline(name.c_str(), iterations, clock, []() {}, [&]() {
+                return writeFrames(writer, frames, converted);
+            }, written);
+            failures += iterations - ok;
+            std::cout << "  output: " << converted.size() / 1024 << " KB" << std::endl;
+            if (writer.name != "xyz") {
+                continue;
+            }
+
+            std::vector<Frame> reread = readMultiXYZ(converted);
+            size_t rereadAtoms = 0;
+            for (const auto& frame : reread) {
+                rereadAtoms += frame.atoms.size();
+            }
+            bool roundTrip = reread.size() == frames.size() && rereadAtoms == totalAtoms &&
+                             reread.back().cell.count == frames.back().cell.count;
+            std::cout << "  round trip: " << reread.size() << " frames, " << rereadAtoms << " atoms "
+                      << (roundTrip ? "ok" : "MISMATCH") << std::endl;
+            if (!roundTrip) {
+                ++failures;
+            }
+        }
+
+        std::filesystem::create_directories(tempDir);
+        uint64_t start = clock.nowMicros();
+        if (!exportFrames(frames, "pdb", (tempDir / "export.pdb").string())) {
+            ++failures;
+        }
+        std::cout << "  file export (pdb): " << (clock.nowMicros() - start) / 1000.0 << " ms" << std::endl;
+
+        // 交给外部插件：共享内存段（发布 + 读取方遍历全部坐标）与剪贴板文本（写成 XYZ + 读取方解析）
+        SharedTrajectorySegment segment;
+        const std::string segmentName = newSharedTrajectoryName();
+        LatencyStats shared;
+        ok = runPipeline("handoff via shared memory", iterations, clock, []() {}, [&]() {
+            xyztrick::SharedTrajectoryReader reader;
+            if (!segment.publish(segmentName, frames) || !reader.open(segmentName)) {
+                return false;
+            }
+            const double* x = reader.x();
+            const double* y = reader.y();
+            const double* z = reader.z();
+            double checksum = 0.0;
+            for (uint64_t i = 0; i < reader.atomCount(); ++i) {
+                checksum += x[i] + y[i] + z[i];
+            }
+            return reader.atomCount() == totalAtoms && reader.frameCount() == frames.size() && std::isfinite(checksum);
+        }, shared);
+        failures += iterations - ok;
+        std::cout << "  segment: " << segment.size() / 1024 << " KB" << std::endl;
+        segment.close();
+        LatencyStats text;
+        std::string handoffText;
+        ok = runPipeline("handoff via clipboard text", iterations, clock, []() {}, [&]() {
+            if (!writeXYZ(frames, handoffText, xyzWriteOptionsFromConfig())) {
+                return false;
+            }
+            std::vector<Frame> parsed = readMultiXYZ(handoffText);
+            double checksum = 0.0;
+            size_t parsedAtoms = 0;
+            for (const auto& frame : parsed) {
+                for (const Atom& atom : frame.atoms) {
+                    checksum += atom.x + atom.y + atom.z;
+                }
+                parsedAtoms += frame.atoms.size();
+            }
+            return parsedAtoms == totalAtoms && parsed.size() == frames.size() && std::isfinite(checksum);
+        }, text);
+        failures += iterations - ok;
+        std::cout << "  text: " << handoffText.size() / 1024 << " KB, shared memory is "
+                  << text.percentileMillis(50) / std::max(shared.percentileMillis(50), 1e-6) << "x faster (p50)"
+                  << std::endl;
+
+        // 周期性包裹/展开：每次在帧的副本上执行（复制不计时）
+        if (frames.front().cell.periodic3D()) {
+            std::vector<Frame> working;
+            for (PeriodicMode mode : {PeriodicMode::Wrap, PeriodicMode::Unwrap}) {
+                std::string name = std::string("periodic ") + periodicModeName(mode);
+                LatencyStats periodic;
+                ok = runPipeline(name.c_str(), iterations, clock, [&]() { working = frames; }, [&]() {
+                    return applyPeriodicMode(working, mode) == working.size();
+                }, periodic);
+                failures += iterations - ok;
+                std::cout << "  " << periodic.percentileMillis(50) * 1e6 / static_cast<double>(totalAtoms)
+                          << " ns per atom-frame (p50)" << std::endl;
+            }
+        }
+    }
+
+    if (!pluginCommand.empty()) {
+        // 常驻插件：第一次调用含进程启动与握手，之后只有管道往返与插件自身的处理
+        LatencyStats firstCall;
+        ok = runPipeline("resident plugin (first call)", 1, clock, [&]() { clipboard.setText(content); }, [&]() {
+            return runResidentPluginCall("headless", pluginCommand);
+        }, firstCall);
+        failures += 1 - ok;
+        LatencyStats resident;
+        ok = runPipeline("resident plugin", iterations, clock, [&]() { clipboard.setText(content); }, [&]() {
+            return runResidentPluginCall("headless", pluginCommand);
+        }, resident);
+        failures += iterations - ok;
+        std::cout << "  plugin result: " << clipboard.text().size() / 1024 << " KB written to clipboard" << std::endl;
+    }
+
+    if (!pluginLibrary.empty()) {
+        // 库插件：第一次调用含共享库加载，之后只有剪贴板解析、插件处理与结果格式化
+        LatencyStats firstCall;
+        ok = runPipeline("plugin library (first call)", 1, clock, [&]() { clipboard.setText(content); }, [&]() {
+            return runLibraryPluginCall("headless-library", pluginLibrary);
+        }, firstCall);
+        failures += 1 - ok;
+        LatencyStats library;
+        ok = runPipeline("plugin library", iterations, clock, [&]() { clipboard.setText(content); }, [&]() {
+            return runLibraryPluginCall("headless-library", pluginLibrary);
+        }, library);
+        failures += iterations - ok;
+        std::cout << "  plugin result: " << clipboard.text().size() / 1024 << " KB written to clipboard" << std::endl;
+    }
+
+    {
+        // 普通插件的执行管理：模拟进程运行 50 ms，上限 1 个。连续触发时 coalesce 合并为最多两次运行，
+        // queue 依次运行全部触发
+        FakeProcessLauncher slowLauncher(&clock);
+        slowLauncher.setRunBehavior(50, 0);
+        g_platform.launcher = &slowLauncher;
+        const int triggers = 5;
+        uint64_t start = clock.nowMicros();
+        for (const bool coalesce : {true, false}) {
+            const std::string name = coalesce ? "headless-coalesce" : "headless-queue";
+            PluginRunLimits limits;
+            limits.coalesce = coalesce;
+            for (int i = 0; i < triggers; ++i) {
+                g_pluginExecutor.submit(name, "plugin " + std::to_string(i), limits);
+            }
+        }
+        PluginRunStats merged = g_pluginExecutor.stats("headless-coalesce");
+        PluginRunStats queued = g_pluginExecutor.stats("headless-queue");
+        while ((merged.running + merged.queued + queued.running + queued.queued) > 0 &&
+               clock.nowMicros() - start < 10000000) {
+            clock.sleepMillis(10);
+            merged = g_pluginExecutor.stats("headless-coalesce");
+            queued = g_pluginExecutor.stats("headless-queue");
+        }
+        const bool executorOk = merged.runs >= 1 && merged.runs <= 2 && merged.runs + merged.coalesced == triggers &&
+                                queued.runs == triggers && queued.exitCodes[0] == triggers;
+        std::cout << "plugin executor: " << (clock.nowMicros() - start) / 1000.0 << " ms, " << merged.runs
+                  << " coalesced run(s), " << queued.runs << " queued run(s) " << (executorOk ? "ok" : "MISMATCH")
+                  << std::endl;
+        std::cout << g_pluginExecutor.report();
+        if (!executorOk) {
+            ++failures;
+        }
+        g_platform.launcher = &launcher;
+    }
+    shutdownPlugins();
+
+    if (!clipboardFile.empty()) {
+        // 在临时目录中的副本上模拟 GView 改写 Clipboard.frg（长度交替变化，保证文件状态改变）
+        std::string frgContent;
+        if (!readWholeFile(clipboardFile, frgContent)) {
+            std::cerr << "Cannot read " << clipboardFile << std::endl;
+            return 1;
+        }
+        std::filesystem::create_directories(tempDir);
+        std::filesystem::path frgPath = tempDir / "Clipboard.frg";
+        g_config.gaussianClipboardPath = frgPath.string();
+        size_t rewrites = 0;
+        auto rewriteClipboardFile = [&]() {
+            std::ofstream out(frgPath, std::ios::binary | std::ios::trunc);
+            out << frgContent;
+            if (++rewrites % 2 == 0) {
+                out << "\n";
+            }
+        };
+
+        // 每次按键前文件都刚被改写，且没有监视线程：按键时同步解析
+        LatencyStats uncached;
+        ok = runPipeline("gview->xyz (reparse on press)", iterations, clock, rewriteClipboardFile, []() {
+            return processGViewClipboardToXYZ();
+        }, uncached);
+        failures += iterations - ok;
+
+        // 监视线程在改写后完成后台解析，按键只复制缓存结果
+        g_clipboardWatcher.start(frgPath.string());
+        const int watchedIterations = std::min(iterations, 20);
+        LatencyStats watched;
+        ok = runPipeline("gview->xyz (watched)", watchedIterations, clock, [&]() {
+            // 改写后等后台解析完成（不计入按键延迟）
+            size_t parsed = g_clipboardWatcher.backgroundParses();
+            rewriteClipboardFile();
+            while (g_clipboardWatcher.backgroundParses() == parsed) {
+                clock.sleepMillis(5);
+            }
+        }, []() {
+            return processGViewClipboardToXYZ();
+        }, watched);
+        failures += watchedIterations - ok;
+        g_clipboardWatcher.stop();
+        std::cout << "  watcher: " << g_clipboardWatcher.backgroundParses() << " background parses, "
+                  << g_clipboardWatcher.cacheHits() << " cache hits, " << g_clipboardWatcher.cacheMisses()
+                  << " misses" << std::endl;
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(tempDir, ec);
+    return failures == 0 ? 0 : 1;
+}